@@ -0,0 +1,83 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "arena.h"
+
+void arena_init(Arena* arena, size_t chunk_size) {
+    arena->head = NULL;
+    arena->chunk_size = chunk_size ? chunk_size : ARENA_DEFAULT_CHUNK;
+    arena->total_bytes = 0;
+}
+
+static ArenaChunk* arena_new_chunk(Arena* arena, size_t min_size) {
+    size_t size = arena->chunk_size;
+    while (size < min_size) {
+        size *= 2;
+    }
+
+    ArenaChunk* chunk = malloc(sizeof(ArenaChunk) + size + ARENA_ALIGN);
+    if (!chunk) {
+        perror("Ошибка выделения памяти");
+        exit(1);
+    }
+    uintptr_t data = (uintptr_t)chunk->data;
+    chunk->base = (char*)((data + ARENA_ALIGN - 1) & ~(uintptr_t)(ARENA_ALIGN - 1));
+    chunk->next = arena->head;
+    chunk->size = size;
+    chunk->used = 0;
+    arena->head = chunk;
+    arena->total_bytes += size;
+    return chunk;
+}
+
+void* arena_alloc_slow(Arena* arena, size_t size) {
+    ArenaChunk* chunk = arena_new_chunk(arena, size);
+    chunk->used = size;
+    return chunk->base;
+}
+
+void* arena_calloc(Arena* arena, size_t size) {
+    void* ptr = arena_alloc(arena, size);
+    memset(ptr, 0, size);
+    return ptr;
+}
+
+char* arena_strndup(Arena* arena, const char* str, size_t len) {
+    char* copy = arena_alloc(arena, len + 1);
+    memcpy(copy, str, len);
+    copy[len] = '\0';
+    return copy;
+}
+
+ArenaMark arena_mark(Arena* arena) {
+    ArenaMark mark;
+    mark.chunk = arena->head;
+    mark.used = arena->head ? arena->head->used : 0;
+    return mark;
+}
+
+void arena_reset(Arena* arena, ArenaMark mark) {
+    while (arena->head && arena->head != mark.chunk) {
+        if (!mark.chunk && !arena->head->next) {
+            break;
+        }
+        ArenaChunk* next = arena->head->next;
+        arena->total_bytes -= arena->head->size;
+        free(arena->head);
+        arena->head = next;
+    }
+    if (arena->head) {
+        arena->head->used = mark.chunk ? mark.used : 0;
+    }
+}
+
+void arena_free(Arena* arena) {
+    while (arena->head) {
+        ArenaChunk* next = arena->head->next;
+        free(arena->head);
+        arena->head = next;
+    }
+    arena->total_bytes = 0;
+}
@@ -0,0 +1,48 @@
+#ifndef MIKA_ARENA_H
+#define MIKA_ARENA_H
+
+#include <stddef.h>
+
+#define ARENA_DEFAULT_CHUNK (64 * 1024)
+#define ARENA_ALIGN 16
+
+typedef struct ArenaChunk {
+    struct ArenaChunk* next;
+    size_t size;
+    size_t used;
+    char* base;
+    char data[];
+} ArenaChunk;
+
+typedef struct {
+    ArenaChunk* head;
+    size_t chunk_size;
+    size_t total_bytes;
+} Arena;
+
+typedef struct {
+    ArenaChunk* chunk;
+    size_t used;
+} ArenaMark;
+
+void arena_init(Arena* arena, size_t chunk_size);
+void* arena_alloc_slow(Arena* arena, size_t size);
+void* arena_calloc(Arena* arena, size_t size);
+char* arena_strndup(Arena* arena, const char* str, size_t len);
+ArenaMark arena_mark(Arena* arena);
+void arena_reset(Arena* arena, ArenaMark mark);
+void arena_free(Arena* arena);
+
+static inline void* arena_alloc(Arena* arena, size_t size) {
+    ArenaChunk* chunk = arena->head;
+    if (chunk) {
+        size_t offset = (chunk->used + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+        if (offset + size <= chunk->size) {
+            chunk->used = offset + size;
+            return chunk->base + offset;
+        }
+    }
+    return arena_alloc_slow(arena, size);
+}
+
+#endif
@@ -0,0 +1,196 @@
+#ifndef MIKA_AST_H
+#define MIKA_AST_H
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lexer.h"
+
+enum {
+    STORAGE_STATIC = 1,
+    STORAGE_EXTERN = 2,
+    STORAGE_INLINE = 4,
+    STORAGE_HOT = 8,
+    STORAGE_COLD = 16
+};
+
+typedef struct {
+    const char* name;
+    int is_var;
+    int is_const;
+    int pointers;
+    int storage;
+    int records;
+} TypeRef;
+
+typedef enum {
+    NODE_INT,
+    NODE_FLOAT,
+    NODE_STRING,
+    NODE_CHAR,
+    NODE_BOOL,
+    NODE_IDENT,
+    NODE_UNARY,
+    NODE_POSTFIX,
+    NODE_BINARY,
+    NODE_ASSIGN,
+    NODE_TERNARY,
+    NODE_CALL,
+    NODE_INDEX,
+    NODE_MEMBER,
+    NODE_CAST,
+    NODE_SIZEOF,
+    NODE_INIT_LIST,
+
+    NODE_BLOCK,
+    NODE_DECL,
+    NODE_VAR,
+    NODE_EXPR_STMT,
+    NODE_IF,
+    NODE_WHILE,
+    NODE_DO,
+    NODE_FOR,
+    NODE_PARALLEL_FOR,
+    NODE_SWITCH,
+    NODE_CASE,
+    NODE_RETURN,
+    NODE_BREAK,
+    NODE_CONTINUE,
+    NODE_EMPTY,
+
+    NODE_FUNCTION,
+    NODE_PARAM,
+    NODE_DIRECTIVE,
+    NODE_RAW,
+    NODE_RECORD
+} NodeKind;
+
+typedef struct Node Node;
+
+struct Node {
+    NodeKind kind;
+    int line;
+    Node* next;
+    union {
+        struct { const char* text; size_t len; long long value; } lit;
+        struct { TokenKind op; Node* operand; } unary;
+        struct { TokenKind op; Node* lhs; Node* rhs; } binary;
+        struct { Node* cond; Node* then_branch; Node* else_branch; } cond;
+        struct { Node* callee; Node* args; } call;
+        struct { Node* base; Node* index; } index;
+        struct { Node* base; const char* name; int arrow; } member;
+        struct { TypeRef type; Node* expr; } cast;
+        struct { Node* items; } list;
+        struct { TypeRef type; Node* vars; } decl;
+        struct { const char* name; TypeRef type; Node* dims; Node* init; } var;
+        struct { Node* init; Node* cond; Node* step; Node* body; Node* clauses; } loop;
+        struct { Node* value; } ret;
+        struct { const char* name; TypeRef ret; Node* params; Node* body; int variadic; int mika_syntax; } func;
+        struct { const char* name; Node* fields; int aos; } record;
+    } u;
+};
+
+enum {
+    PREC_COMMA = 1,
+    PREC_ASSIGN,
+    PREC_TERNARY,
+    PREC_OROR,
+    PREC_ANDAND,
+    PREC_BITOR,
+    PREC_BITXOR,
+    PREC_BITAND,
+    PREC_EQUALITY,
+    PREC_RELATIONAL,
+    PREC_SHIFT,
+    PREC_ADDITIVE,
+    PREC_MULTIPLICATIVE,
+    PREC_UNARY,
+    PREC_POSTFIX,
+    PREC_PRIMARY
+};
+
+static inline int binary_precedence(TokenKind op) {
+    switch (op) {
+        case TOK_COMMA: return PREC_COMMA;
+        case TOK_OROR: return PREC_OROR;
+        case TOK_ANDAND: return PREC_ANDAND;
+        case TOK_PIPE: return PREC_BITOR;
+        case TOK_CARET: return PREC_BITXOR;
+        case TOK_AMP: return PREC_BITAND;
+        case TOK_EQ: case TOK_NE: return PREC_EQUALITY;
+        case TOK_LT: case TOK_GT: case TOK_LE: case TOK_GE: return PREC_RELATIONAL;
+        case TOK_SHL: case TOK_SHR: return PREC_SHIFT;
+        case TOK_PLUS: case TOK_MINUS: return PREC_ADDITIVE;
+        case TOK_STAR: case TOK_SLASH: case TOK_PERCENT: return PREC_MULTIPLICATIVE;
+        default: return 0;
+    }
+}
+
+static inline int is_assign_op(TokenKind op) {
+    return op >= TOK_ASSIGN && op <= TOK_SHR_ASSIGN;
+}
+
+static inline int node_is_ident(const Node* node, const char* name) {
+    size_t i = 0;
+    if (!node || node->kind != NODE_IDENT) return 0;
+    for (; i < node->u.lit.len && name[i]; i++) {
+        if (node->u.lit.text[i] != name[i]) return 0;
+    }
+    return i == node->u.lit.len && name[i] == '\0';
+}
+
+static inline int node_count(const Node* list) {
+    int count = 0;
+    for (; list; list = list->next) count++;
+    return count;
+}
+
+/* a + b + c ... разбирается в ((a + b) + c): каждое звено добавляет
+   дереву уровень. Проходы, которым нужен порядок слева направо, берут
+   звенья одного приоритета массивом (links[0] — вершина) и идут по нему
+   циклом: рекурсия по lhs переполняла стек на длинных выражениях. */
+typedef struct {
+    const Node** links;
+    size_t count;
+    const Node* inline_links[16];
+} BinaryChain;
+
+/* 0 — не хватило памяти на длинную цепочку */
+static inline int binary_chain_init(BinaryChain* chain, const Node* top) {
+    int prec = binary_precedence(top->u.binary.op);
+    size_t capacity = sizeof(chain->inline_links) / sizeof(chain->inline_links[0]);
+
+    chain->links = chain->inline_links;
+    chain->count = 0;
+    for (const Node* link = top; link->kind == NODE_BINARY && binary_precedence(link->u.binary.op) == prec;
+         link = link->u.binary.lhs) {
+        if (chain->count == capacity) {
+            const Node** links = malloc(capacity * 2 * sizeof(*links));
+            if (!links) {
+                if (chain->links != chain->inline_links) free(chain->links);
+                chain->links = chain->inline_links;
+                return 0;
+            }
+            memcpy(links, chain->links, capacity * sizeof(*links));
+            if (chain->links != chain->inline_links) free(chain->links);
+            chain->links = links;
+            capacity *= 2;
+        }
+        chain->links[chain->count++] = link;
+    }
+    return 1;
+}
+
+/* Самый левый операнд цепочки */
+static inline const Node* binary_chain_first(const BinaryChain* chain) {
+    return chain->links[chain->count - 1]->u.binary.lhs;
+}
+
+static inline void binary_chain_free(BinaryChain* chain) {
+    if (chain->links != chain->inline_links) {
+        free(chain->links);
+    }
+}
+
+#endif
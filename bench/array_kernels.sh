@@ -0,0 +1,112 @@
+#!/bin/sh
+# Векторные операции рантайма (array_sum, array_dot, array_add, ...) против
+# тех же циклов, написанных на Mika и собранных mikac -O2. Ядра запускаются
+# на каждом уровне, который позволяет процессор (MIKA_SIMD).
+# Использование: array_kernels.sh [длина_массива [повторов]]
+
+set -e
+
+here=$(cd "$(dirname "$0")" && pwd)
+root=$(cd "$here/.." && pwd)
+mikac=${MIKAC:-$root/mikac}
+length=${1:-4096}
+rounds=${2:-100000}
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+cat > "$work/loops.mk" <<'MK'
+#include <System>
+
+function main() {
+    var n = input();
+    var rounds = input();
+    int* a = array_create(n);
+    int* b = array_create(n);
+    int* c = array_create(n);
+    var check = 0;
+    for (var i = 0; i < n; i++) {
+        a[i] = (i * 7919) % 1001 - 500;
+        b[i] = (i * 104729) % 97 - 40;
+    }
+    for (var r = 0; r < rounds; r++) {
+        for (var i = 0; i < n; i++) c[i] = r;
+        for (var i = 0; i < n; i++) c[i] = c[i] + a[i] + b[i];
+        var sum = 0;
+        for (var i = 0; i < n; i++) sum += c[i];
+        var dot = 0;
+        for (var i = 0; i < n; i++) dot += a[i] * c[i];
+        var low = c[0];
+        var high = c[0];
+        for (var i = 1; i < n; i++) {
+            if (c[i] < low) low = c[i];
+            if (c[i] > high) high = c[i];
+        }
+        check = (check + sum + dot + low + high) % 1000003;
+    }
+    print("%d\n", check);
+    return 0;
+}
+MK
+
+cat > "$work/kernels.mk" <<'MK'
+#include <System>
+
+function main() {
+    var n = input();
+    var rounds = input();
+    int* a = array_create(n);
+    int* b = array_create(n);
+    int* c = array_create(n);
+    var check = 0;
+    for (var i = 0; i < n; i++) {
+        a[i] = (i * 7919) % 1001 - 500;
+        b[i] = (i * 104729) % 97 - 40;
+    }
+    for (var r = 0; r < rounds; r++) {
+        array_fill(c, r);
+        array_add(c, c, a);
+        array_add(c, c, b);
+        var sum = array_sum(c);
+        var dot = array_dot(a, c);
+        check = (check + sum + dot + array_min(c) + array_max(c)) % 1000003;
+    }
+    print("%d\n", check);
+    return 0;
+}
+MK
+
+printf "%s\n%s\n" "$length" "$rounds" > "$work/input"
+"$mikac" --no-cache -o "$work/loops" "$work/loops.mk" > /dev/null
+"$mikac" --no-cache -o "$work/kernels" "$work/kernels.mk" > /dev/null
+
+now() {
+    date +%s.%N
+}
+
+measure() {
+    best=""
+    for run in 1 2 3; do
+        start=$(now)
+        "$1" < "$work/input" > "$work/out"
+        end=$(now)
+        elapsed=$(echo "$end $start" | awk '{ printf "%.4f", $1 - $2 }')
+        best=$(echo "$elapsed ${best:-$elapsed}" | awk '{ print ($1 < $2) ? $1 : $2 }')
+    done
+    echo "$best"
+}
+
+base=$(measure "$work/loops")
+expected=$(cat "$work/out")
+printf "Массив: %d элементов, %d повторов\n" "$length" "$rounds"
+printf "%-14s %8s с\n" "циклы Mika" "$base"
+
+for level in scalar sse2 avx2 avx512; do
+    time=$(MIKA_SIMD=$level measure "$work/kernels")
+    if [ "$(cat "$work/out")" != "$expected" ]; then
+        echo "Результаты не совпадают на уровне $level" >&2
+        exit 1
+    fi
+    awk -v level="$level" -v time="$time" -v base="$base" 'BEGIN {
+        printf "%-14s %8.4f с  x%.2f\n", "ядра " level, time, base / time
+    }'
+done
@@ -0,0 +1,55 @@
+/* Запускает программу N раз подряд и печатает среднее время от exec до
+   выхода в микросекундах. stdin и stdout программы — /dev/null.
+   Использование: exec_loop <N> <программа> [аргументы...] */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3 || atoi(argv[1]) < 1) {
+        fprintf(stderr, "Использование: %s <N> <программа> [аргументы...]\n", argv[0]);
+        return 2;
+    }
+    int runs = atoi(argv[1]);
+    int null = open("/dev/null", O_RDWR);
+    if (null < 0) {
+        perror("/dev/null");
+        return 2;
+    }
+
+    double start = now();
+    for (int i = 0; i < runs; i++) {
+        /* vfork: время копирования адресного пространства родителя не
+           должно попадать в замер */
+        pid_t pid = vfork();
+        if (pid < 0) {
+            perror("vfork");
+            return 2;
+        }
+        if (pid == 0) {
+            dup2(null, STDIN_FILENO);
+            dup2(null, STDOUT_FILENO);
+            execv(argv[2], &argv[2]);
+            _exit(127);
+        }
+        int status;
+        if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) == 127) {
+            fprintf(stderr, "%s: запуск не удался\n", argv[2]);
+            return 2;
+        }
+    }
+    printf("%.1f\n", (now() - start) / runs * 1e6);
+    return 0;
+}
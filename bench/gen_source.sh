@@ -0,0 +1,35 @@
+#!/bin/sh
+# Генератор большого синтетического исходника Mika для замеров транслятора.
+# Использование: gen_source.sh <число_функций> > big.mk
+
+count=${1:-10000}
+
+awk -v count="$count" 'BEGIN {
+    print "#include <System>"
+    print ""
+    print "var total = 0;"
+    print ""
+    for (i = 0; i < count; i++) {
+        printf "function step_%d(int a, int b) {\n", i
+        printf "    var x = a * %d + b; // шаг %d\n", i % 97, i
+        printf "    var y = power(x %% 7, 3) - absolute(b - %d);\n", i % 13
+        printf "    for (var k = 0; k < %d; k++) {\n", i % 5 + 1
+        printf "        if (x > y && k %% 2 == 0) {\n"
+        printf "            x = x - y / (k + 1);\n"
+        printf "        } else {\n"
+        printf "            y += x ^ k;\n"
+        printf "        }\n"
+        printf "    }\n"
+        printf "    total += x + y;\n"
+        printf "    return x > y ? x : y;\n"
+        printf "}\n\n"
+    }
+    print "function main() {"
+    print "    var acc = 0;"
+    for (i = 0; i < count; i += 97) {
+        printf "    acc += step_%d(acc %% 101, %d);\n", i, i
+    }
+    print "    print(\"%d %d\\n\", acc, total);"
+    print "    return 993;"
+    print "}"
+}'
@@ -0,0 +1,78 @@
+#!/bin/sh
+# Скорость чтения целых чисел через input(): буферизованный рантайм против
+# пути printf(" ") + scanf("%d") из первого коммита репозитория.
+# Использование: io_throughput.sh [число_чисел]
+
+set -e
+
+here=$(cd "$(dirname "$0")" && pwd)
+root=$(cd "$here/.." && pwd)
+mikac=${MIKAC:-$root/mikac}
+count=${1:-10000000}
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+cat > "$work/sum.mk" <<'MK'
+#include <System>
+
+function main() {
+    var n = input();
+    var sum = 0;
+    for (var i = 0; i < n; i++) {
+        sum = (sum + input()) % 1000003;
+    }
+    print("%d\n", sum);
+    return 993;
+}
+MK
+
+awk -v count="$count" 'BEGIN {
+    srand(1)
+    print count
+    for (i = 0; i < count; i++) {
+        printf "%d%s", int(rand() * 2000000) - 1000000, (i % 10 == 9) ? "\n" : " "
+    }
+    print ""
+}' > "$work/numbers.in"
+bytes=$(wc -c < "$work/numbers.in")
+
+"$mikac" --no-cache -o "$work/buffered" "$work/sum.mk" > /dev/null
+
+base=$(git -C "$root" rev-list --max-parents=0 HEAD)
+mkdir -p "$work/legacy/mika"
+git -C "$root" show "$base:mika_std.h" > "$work/legacy/mika/mika_std.h"
+git -C "$root" show "$base:mika_std.c" > "$work/legacy/mika_std.c"
+"$root/mika2c" -o "$work/sum.c" "$work/sum.mk" > /dev/null
+${CC:-gcc} -O2 -w -Dmika_print=printf -I"$work/legacy" -I"$work/legacy/mika" \
+    -o "$work/legacy_scanf" "$work/sum.c" "$work/legacy/mika_std.c"
+
+now() {
+    date +%s.%N
+}
+
+measure() {
+    best=""
+    for run in 1 2 3; do
+        start=$(now)
+        "$1" < "$work/numbers.in" > "$work/$(basename "$1").out"
+        end=$(now)
+        elapsed=$(echo "$end $start" | awk '{ printf "%.4f", $1 - $2 }')
+        best=$(echo "$elapsed ${best:-$elapsed}" | awk '{ print ($1 < $2) ? $1 : $2 }')
+    done
+    echo "$best"
+}
+
+new_time=$(measure "$work/buffered")
+old_time=$(measure "$work/legacy_scanf")
+
+if [ "$(tr -d ' ' < "$work/buffered.out")" != "$(tr -d ' ' < "$work/legacy_scanf.out")" ]; then
+    echo "Результаты не совпадают" >&2
+    exit 1
+fi
+
+awk -v bytes="$bytes" -v count="$count" -v new="$new_time" -v old="$old_time" 'BEGIN {
+    mb = bytes / 1048576
+    printf "Ввод:              %d чисел, %.2f МБ\n", count, mb
+    printf "input() (буфер):   %.4f с  %8.1f МБ/с\n", new, mb / new
+    printf "input() (scanf):   %.4f с  %8.1f МБ/с\n", old, mb / old
+}'
@@ -0,0 +1,53 @@
+#!/bin/sh
+# Время выполнения программ из bench/programs при разных режимах сборки mikac:
+# -O0 (прежнее поведение, без оптимизации), -O2, -O3, -O2 --lto и -O2 --pgo.
+# Использование: opt_levels.sh [программа ...]
+
+set -e
+
+here=$(cd "$(dirname "$0")" && pwd)
+root=$(cd "$here/.." && pwd)
+mikac=${MIKAC:-$root/mikac}
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+if [ $# -eq 0 ]; then
+    set -- sieve collatz matmul fib
+fi
+
+now() {
+    date +%s.%N
+}
+
+measure() {
+    best=""
+    for run in 1 2 3; do
+        start=$(now)
+        "$1" < "$2" > /dev/null
+        end=$(now)
+        elapsed=$(echo "$end $start" | awk '{ printf "%.4f", $1 - $2 }')
+        best=$(echo "$elapsed ${best:-$elapsed}" | awk '{ print ($1 < $2) ? $1 : $2 }')
+    done
+    echo "$best"
+}
+
+printf "%-10s %8s %8s %8s %8s %8s\n" "программа" "-O0" "-O2" "-O3" "LTO" "PGO"
+for name in "$@"; do
+    src="$here/programs/$name.mk"
+    input="$here/programs/$name.in"
+    line=$(printf "%-10s" "$name")
+
+    for mode in O0 O2 O3 lto pgo; do
+        case $mode in
+            O0) flags="-O 0" ;;
+            O2) flags="-O 2" ;;
+            O3) flags="-O 3" ;;
+            lto) flags="-O 2 --lto" ;;
+            pgo) flags="-O 2 --pgo=$input" ;;
+        esac
+        # shellcheck disable=SC2086
+        "$mikac" --no-cache $flags -o "$work/$name-$mode" "$src" > /dev/null
+        line="$line $(printf "%8s" "$(measure "$work/$name-$mode" "$input")")"
+    done
+    echo "$line"
+done
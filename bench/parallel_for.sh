@@ -0,0 +1,88 @@
+#!/bin/sh
+# Масштабирование parallel for: одна и та же программа с MIKA_THREADS от 1
+# до числа ядер. Результат при любом числе потоков должен совпадать.
+# Использование: parallel_for.sh [верхняя_граница [число_потоков ...]]
+
+set -e
+
+here=$(cd "$(dirname "$0")" && pwd)
+root=$(cd "$here/.." && pwd)
+mikac=${MIKAC:-$root/mikac}
+limit=${1:-2000000}
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+if [ $# -gt 1 ]; then
+    shift
+else
+    cores=$(getconf _NPROCESSORS_ONLN)
+    set -- 1
+    threads=2
+    while [ "$threads" -le "$cores" ]; do
+        set -- "$@" "$threads"
+        threads=$((threads * 2))
+    done
+fi
+
+cat > "$work/collatz.mk" <<'MK'
+#include <System>
+
+// Суммарная длина и самая длинная последовательность Коллатца до n
+function main() {
+    var n = input();
+    var total = 0;
+    var longest = 0;
+    parallel(sum: total, max: longest) for (var i = 1; i <= n; i++) {
+        long long x = i;
+        var steps = 0;
+        while (x != 1) {
+            if (x % 2 == 0) {
+                x = x / 2;
+            } else {
+                x = 3 * x + 1;
+            }
+            steps++;
+        }
+        total += steps;
+        if (steps > longest) longest = steps;
+    }
+    print("%d %d\n", total, longest);
+    return 993;
+}
+MK
+
+echo "$limit" > "$work/input"
+"$mikac" --no-cache -o "$work/collatz" "$work/collatz.mk" > /dev/null
+
+now() {
+    date +%s.%N
+}
+
+measure() {
+    best=""
+    for run in 1 2 3; do
+        start=$(now)
+        MIKA_THREADS=$1 "$work/collatz" < "$work/input" > "$work/out"
+        end=$(now)
+        elapsed=$(echo "$end $start" | awk '{ printf "%.4f", $1 - $2 }')
+        best=$(echo "$elapsed ${best:-$elapsed}" | awk '{ print ($1 < $2) ? $1 : $2 }')
+    done
+    echo "$best"
+}
+
+printf "Коллатц до %d\n" "$limit"
+base=""
+expected=""
+for threads in "$@"; do
+    time=$(measure "$threads")
+    if [ -z "$expected" ]; then
+        expected=$(cat "$work/out")
+        base=$time
+    elif [ "$(cat "$work/out")" != "$expected" ]; then
+        echo "Результат при $threads потоках не совпадает" >&2
+        exit 1
+    fi
+    awk -v threads="$threads" -v time="$time" -v base="$base" 'BEGIN {
+        printf "%3d потоков  %8.4f с  x%.2f\n", threads, time, base / time
+    }'
+done
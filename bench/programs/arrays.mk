@@ -0,0 +1,62 @@
+#include <System>
+
+// Динамические массивы: push/pop, индексация и сортировка слиянием
+function merge_sort(int* a, int* tmp, var from, var to) {
+    if (to - from < 2) return 0;
+    var mid = (from + to) / 2;
+    merge_sort(a, tmp, from, mid);
+    merge_sort(a, tmp, mid, to);
+    var i = from;
+    var j = mid;
+    var k = from;
+    while (i < mid && j < to) {
+        if (a[i] <= a[j]) {
+            tmp[k] = a[i];
+            i++;
+        } else {
+            tmp[k] = a[j];
+            j++;
+        }
+        k++;
+    }
+    while (i < mid) {
+        tmp[k] = a[i];
+        i++;
+        k++;
+    }
+    while (j < to) {
+        tmp[k] = a[j];
+        j++;
+        k++;
+    }
+    for (var t = from; t < to; t++) {
+        a[t] = tmp[t];
+    }
+    return 0;
+}
+
+function main() {
+    var n = input();
+    var rounds = input();
+    var check = 0;
+
+    for (var r = 0; r < rounds; r++) {
+        int* values = array_create(0);
+        int* tmp = array_create(n);
+        var seed = r + 1;
+        for (var i = 0; i < n; i++) {
+            seed = (seed * 75 + 74) % 65537;
+            push(values, seed);
+        }
+        merge_sort(values, tmp, 0, len(values));
+        check = (check + values[0] + values[n / 2] + values[n - 1]) % 1000003;
+        while (len(values) > n / 2) {
+            check = (check + pop(values)) % 1000003;
+        }
+        array_free(values);
+        array_free(tmp);
+    }
+
+    print("контрольная сумма: %d\n", check);
+    return 993;
+}
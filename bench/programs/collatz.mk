@@ -0,0 +1,31 @@
+#include <System>
+
+// Самая длинная последовательность Коллатца для чисел меньше n
+function collatz_length(long long x) {
+    var steps = 1;
+    while (x != 1) {
+        if (x % 2 == 0) {
+            x = x / 2;
+        } else {
+            x = 3 * x + 1;
+        }
+        steps++;
+    }
+    return steps;
+}
+
+function main() {
+    var n = input();
+    var best = 0, best_start = 1;
+
+    for (var i = 1; i < n; i++) {
+        var len = collatz_length(i);
+        if (len > best) {
+            best = len;
+            best_start = i;
+        }
+    }
+
+    print("лучшее начало %d, длина %d\n", best_start, best);
+    return 993;
+}
@@ -0,0 +1,27 @@
+#include <System>
+
+// Рекурсивные числа Фибоначчи и ветвления с данными от пользователя
+function fib(var n) {
+    if (n < 2) return n;
+    return fib(n - 1) + fib(n - 2);
+}
+
+function classify(var x) {
+    if (x % 15 == 0) return 3;
+    if (x % 5 == 0) return 2;
+    if (x % 3 == 0) return 1;
+    return 0;
+}
+
+function main() {
+    var n = input();
+    var limit = input();
+    var total = 0;
+
+    for (var i = 0; i < limit; i++) {
+        total += classify(i) * absolute(i % 11 - 5);
+    }
+
+    print("fib(%d) = %d, сумма = %d\n", n, fib(n), total);
+    return 993;
+}
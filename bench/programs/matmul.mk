@@ -0,0 +1,35 @@
+#include <System>
+
+// Умножение целочисленных матриц n x n
+function main() {
+    var n = input();
+    int* a = array_create(n * n);
+    int* b = array_create(n * n);
+    int* c = array_create(n * n);
+
+    for (var i = 0; i < n * n; i++) {
+        a[i] = i % 7 - 3;
+        b[i] = i % 5 - 2;
+        c[i] = 0;
+    }
+
+    for (var i = 0; i < n; i++) {
+        for (var k = 0; k < n; k++) {
+            var aik = a[i * n + k];
+            for (var j = 0; j < n; j++) {
+                c[i * n + j] += aik * b[k * n + j];
+            }
+        }
+    }
+
+    var checksum = 0;
+    for (var i = 0; i < n * n; i++) {
+        checksum = (checksum * 31 + c[i] % 1000) % 1000003;
+    }
+
+    print("контрольная сумма: %d\n", checksum);
+    array_free(a);
+    array_free(b);
+    array_free(c);
+    return 993;
+}
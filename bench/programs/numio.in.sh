@@ -0,0 +1,11 @@
+#!/bin/sh
+# Вход для numio.mk: число строк и столько же случайных чисел.
+
+awk -v count="${1:-2000000}" 'BEGIN {
+    srand(7)
+    print count
+    for (i = 0; i < count; i++) {
+        printf "%d%s", int(rand() * 2000000) - 1000000, (i % 10 == 9) ? "\n" : " "
+    }
+    print ""
+}'
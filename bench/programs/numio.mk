@@ -0,0 +1,13 @@
+#include <System>
+
+// Тяжёлый ввод-вывод: читаем числа и печатаем строку на каждое из них
+function main() {
+    var n = input();
+    var sum = 0;
+    for (var i = 0; i < n; i++) {
+        var x = input();
+        sum = (sum + x) % 1000003;
+        print("%d %d\n", x % 1000, sum);
+    }
+    return 993;
+}
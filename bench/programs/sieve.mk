@@ -0,0 +1,32 @@
+#include <System>
+
+// Решето Эратосфена: количество простых чисел до n
+function main() {
+    var n = input();
+    var rounds = input();
+    var count = 0;
+    int* sieve = array_create(n + 1);
+
+    for (var r = 0; r < rounds; r++) {
+        for (var i = 0; i <= n; i++) {
+            sieve[i] = 1;
+        }
+        sieve[0] = 0;
+        sieve[1] = 0;
+        for (var i = 2; i * i <= n; i++) {
+            if (sieve[i]) {
+                for (var j = i * i; j <= n; j += i) {
+                    sieve[j] = 0;
+                }
+            }
+        }
+        count = 0;
+        for (var i = 0; i <= n; i++) {
+            count += sieve[i];
+        }
+    }
+
+    print("простых до %d: %d\n", n, count);
+    array_free(sieve);
+    return 993;
+}
@@ -0,0 +1,31 @@
+#include <System>
+
+// Строки: сборка построителем, подстроки, сравнение и длина
+function main() {
+    var rounds = input();
+    var words = input();
+    var check = 0;
+    string needle = "gamma delta";
+
+    for (var r = 0; r < rounds; r++) {
+        string_builder b;
+        for (var i = 0; i < words; i++) {
+            if ((i + r) % 3 == 0) {
+                append(b, "alpha ");
+            } else if ((i + r) % 3 == 1) {
+                append(b, "beta gamma ");
+            } else {
+                append(b, "delta ");
+            }
+        }
+        string text = to_string(b);
+        var from = r % 40;
+        string part = substring(text, from, from + 11);
+        check = (check + len(text) + len(part) * 7 + string_compare(part, needle)) % 1000003;
+        string_free(part);
+        string_free(text);
+    }
+
+    print("контрольная сумма: %d\n", check);
+    return 993;
+}
@@ -0,0 +1,51 @@
+#!/bin/sh
+# Время запуска: тривиальная программа, обычная сборка против --fast-start
+# (статический файл без PIE). Меряется exec-to-exit, лучшее из трёх серий.
+# Использование: startup.sh [число_запусков_в_серии]
+
+set -e
+
+here=$(cd "$(dirname "$0")" && pwd)
+root=$(cd "$here/.." && pwd)
+mikac=${MIKAC:-$root/mikac}
+runs=${1:-2000}
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+${CC:-gcc} -O2 -o "$work/exec_loop" "$here/exec_loop.c"
+
+cat > "$work/hello.mk" <<'MK'
+#include <System>
+
+function main() {
+    print("привет\n");
+    return 0;
+}
+MK
+
+measure() {
+    best=""
+    for series in 1 2 3; do
+        time=$("$work/exec_loop" "$runs" "$1")
+        best=$(echo "$time ${best:-$time}" | awk '{ print ($1 < $2) ? $1 : $2 }')
+    done
+    echo "$best"
+}
+
+"$mikac" --no-cache -o "$work/default" "$work/hello.mk" > /dev/null
+"$mikac" --no-cache --fast-start -o "$work/fast" "$work/hello.mk" > /dev/null
+if [ "$("$work/default")" != "$("$work/fast")" ]; then
+    echo "Вывод --fast-start не совпадает" >&2
+    exit 1
+fi
+
+base=""
+printf "%-12s %10s %10s\n" "сборка" "мкс/запуск" "размер"
+for build in default fast; do
+    time=$(measure "$work/$build")
+    base=${base:-$time}
+    size=$(wc -c < "$work/$build")
+    awk -v build="$build" -v time="$time" -v base="$base" -v size="$size" 'BEGIN {
+        printf "%-12s %10.1f %10d  x%.2f\n", build, time, size, base / time
+    }'
+done
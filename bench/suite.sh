@@ -0,0 +1,137 @@
+#!/bin/sh
+# Набор замеров для make bench:
+#   - пропускная способность mika2c на большом синтетическом исходнике;
+#   - время полной сборки mikac (без кэша) каждой программы из programs/;
+#   - время работы собранных программ и, если perf_event_open доступен,
+#     аппаратные счётчики (циклы, инструкции, промахи кэша и переходов).
+# Результаты пишутся в results/latest.tsv и сравниваются с baseline.tsv:
+# замедление больше BENCH_TOLERANCE процентов (по умолчанию 10) или другой
+# вывод программы считается регрессией, и скрипт завершается с ошибкой.
+# Использование: suite.sh [--save-baseline]
+
+set -e
+
+here=$(cd "$(dirname "$0")" && pwd)
+root=$(cd "$here/.." && pwd)
+mikac=${MIKAC:-$root/mikac}
+mika2c=${MIKA2C:-$root/mika2c}
+runs=${BENCH_RUNS:-3}
+functions=${BENCH_FUNCTIONS:-20000}
+tolerance=${BENCH_TOLERANCE:-10}
+baseline=${BENCH_BASELINE:-$here/baseline.tsv}
+results=$here/results
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+mkdir -p "$results"
+latest=$results/latest.tsv
+: > "$latest"
+
+${CC:-gcc} -O2 -o "$work/perf_counters" "$here/perf_counters.c"
+
+now() {
+    date +%s.%N
+}
+
+# record <метрика> <значение> <lower|higher|exact|info>
+record() {
+    printf "%s\t%s\t%s\n" "$1" "$2" "$3" >> "$latest"
+}
+
+best_of() {
+    sort -g | head -n 1
+}
+
+# Трансляция
+"$here/gen_source.sh" "$functions" > "$work/big.mk"
+bytes=$(wc -c < "$work/big.mk")
+for run in $(seq "$runs"); do
+    start=$(now)
+    "$mika2c" -o "$work/big.c" "$work/big.mk" > /dev/null
+    end=$(now)
+    echo "$end $start" | awk '{ printf "%.6f\n", $1 - $2 }'
+done | best_of > "$work/translate"
+record translate.seconds "$(cat "$work/translate")" lower
+record translate.mb_per_s "$(awk -v b="$bytes" '{ printf "%.1f", b / 1048576 / $1 }' "$work/translate")" higher
+
+# Сборка и запуск программ
+for src in "$here"/programs/*.mk; do
+    name=$(basename "$src" .mk)
+    input=$here/programs/$name.in
+    if [ ! -f "$input" ] && [ -x "$here/programs/$name.in.sh" ]; then
+        "$here/programs/$name.in.sh" > "$work/$name.in"
+        input=$work/$name.in
+    fi
+
+    for run in $(seq "$runs"); do
+        start=$(now)
+        "$mikac" --no-cache -o "$work/$name" "$src" > /dev/null
+        end=$(now)
+        echo "$end $start" | awk '{ printf "%.6f\n", $1 - $2 }'
+    done | best_of > "$work/build"
+    record "build.$name.seconds" "$(cat "$work/build")" lower
+
+    # Берём лучший по времени запуск вместе с его счётчиками
+    : > "$work/runs"
+    for run in $(seq "$runs"); do
+        "$work/perf_counters" "$input" "$work/$name.out" "$work/$name" > "$work/stats" || true
+        tr '\n' ' ' < "$work/stats" >> "$work/runs"
+        echo >> "$work/runs"
+    done
+    sort -k2 -g "$work/runs" | head -n 1 | awk -v name="$name" '{
+        for (i = 1; i < NF; i += 2) {
+            metric = $i
+            sub(/_s$/, "_seconds", metric)
+            kind = (metric == "wall_seconds" || metric == "instructions") ? "lower" : "info"
+            printf "run.%s.%s\t%s\t%s\n", name, metric, $(i + 1), kind
+        }
+    }' >> "$latest"
+    record "run.$name.output" "$(cksum < "$work/$name.out" | awk '{ print $1 }')" exact
+done
+
+if [ "$1" = "--save-baseline" ]; then
+    cp "$latest" "$baseline"
+    echo "Базовые результаты сохранены в $baseline"
+fi
+
+if [ ! -f "$baseline" ]; then
+    echo "Базовых результатов нет: сохраните их через make bench-baseline"
+fi
+
+awk -F '\t' -v tolerance="$tolerance" -v baseline="$baseline" '
+    BEGIN {
+        while ((getline line < baseline) > 0) {
+            split(line, field, "\t")
+            base[field[1]] = field[2]
+        }
+    }
+    {
+        old = base[$1]
+        status = ""
+        change = ""
+        if (old == "") {
+            status = "новая"
+        } else if ($3 == "exact") {
+            status = ($2 == old) ? "ok" : "РЕГРЕССИЯ"
+        } else if (old + 0 != 0) {
+            delta = ($2 - old) / old * 100
+            change = sprintf("%+.1f%%", delta)
+            if (($3 == "lower" && delta > tolerance) || ($3 == "higher" && delta < -tolerance)) {
+                status = "РЕГРЕССИЯ"
+            } else if ($3 == "info") {
+                status = ""
+            } else {
+                status = "ok"
+            }
+        }
+        if (status == "РЕГРЕССИЯ") regressions++
+        printf "%-36s %14s %14s %9s  %s\n", $1, old, $2, change, status
+    }
+    END {
+        if (regressions > 0) {
+            printf "Регрессий: %d (допуск %s%%)\n", regressions, tolerance
+            exit 1
+        }
+        print "Регрессий нет"
+    }
+' "$latest"
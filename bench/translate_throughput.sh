@@ -0,0 +1,49 @@
+#!/bin/sh
+# Пропускная способность mika2c (МБ/с) в сравнении с построчным транслятором
+# из первого коммита репозитория.
+# Использование: translate_throughput.sh [число_функций] [старый_mika2c]
+
+set -e
+
+here=$(cd "$(dirname "$0")" && pwd)
+root=$(cd "$here/.." && pwd)
+count=${1:-20000}
+legacy=${2:-}
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+if [ -z "$legacy" ]; then
+    base=$(git -C "$root" rev-list --max-parents=0 HEAD)
+    git -C "$root" show "$base:mika2c.c" > "$work/legacy_mika2c.c"
+    ${CC:-gcc} -O2 -D_POSIX_C_SOURCE=200809L -w -o "$work/legacy_mika2c" "$work/legacy_mika2c.c"
+    legacy="$work/legacy_mika2c"
+fi
+
+"$here/gen_source.sh" "$count" > "$work/big.mk"
+bytes=$(wc -c < "$work/big.mk")
+
+now() {
+    date +%s.%N
+}
+
+measure() {
+    best=""
+    for run in 1 2 3; do
+        start=$(now)
+        "$@" > /dev/null
+        end=$(now)
+        elapsed=$(echo "$end $start" | awk '{ printf "%.6f", $1 - $2 }')
+        best=$(echo "$elapsed ${best:-$elapsed}" | awk '{ print ($1 < $2) ? $1 : $2 }')
+    done
+    echo "$best"
+}
+
+new_time=$(measure "$root/mika2c" -o "$work/new.c" "$work/big.mk")
+old_time=$(measure "$legacy" "$work/big.mk")
+
+awk -v bytes="$bytes" -v new="$new_time" -v old="$old_time" 'BEGIN {
+    mb = bytes / 1048576
+    printf "Исходник:          %.2f МБ\n", mb
+    printf "mika2c (AST):      %.4f с  %8.1f МБ/с\n", new, mb / new
+    printf "mika2c (строчный): %.4f с  %8.1f МБ/с\n", old, mb / old
+}'
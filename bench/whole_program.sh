@@ -0,0 +1,90 @@
+#!/bin/sh
+# Раздельная сборка модулей против --whole-program: одна и та же программа
+# из нескольких модулей, вывод обеих сборок должен совпадать.
+# Использование: whole_program.sh [число_итераций]
+
+set -e
+
+here=$(cd "$(dirname "$0")" && pwd)
+root=$(cd "$here/.." && pwd)
+mikac=${MIKAC:-$root/mikac}
+limit=${1:-200000000}
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+cat > "$work/shapes.mk" <<'MK'
+#include <System>
+
+// Маленькие функции, которые вызываются из горячего цикла другого модуля
+function dist2(var x, var y) {
+    return x * x + y * y;
+}
+
+function clamp(var v, var lo, var hi) {
+    if (v < lo) return lo;
+    if (v > hi) return hi;
+    return v;
+}
+
+function report(var v) {
+    print("отладка: %d\n", v);
+    return v;
+}
+MK
+
+cat > "$work/main.mk" <<'MK'
+#include <System>
+
+function dist2(var x, var y);
+function clamp(var v, var lo, var hi);
+
+function main() {
+    var n = input();
+    long long total = 0;
+    for (var i = 0; i < n; i++) {
+        total += clamp(dist2(i % 1000, i % 37), 100, 500000);
+    }
+    print("%lld\n", total);
+    return 0;
+}
+MK
+echo "$limit" > "$work/modules.in"
+
+now() {
+    date +%s.%N
+}
+
+measure() {
+    best=""
+    for run in 1 2 3; do
+        start=$(now)
+        "$1" < "$2" > "$1.out"
+        end=$(now)
+        elapsed=$(echo "$end $start" | awk '{ printf "%.4f", $1 - $2 }')
+        best=$(echo "$elapsed ${best:-$elapsed}" | awk '{ print ($1 < $2) ? $1 : $2 }')
+    done
+    echo "$best"
+}
+
+compare() {
+    name=$1
+    input=$2
+    shift 2
+    "$mikac" --no-cache -o "$work/$name-split" "$@" > /dev/null
+    "$mikac" --no-cache --whole-program -o "$work/$name-whole" "$@" > /dev/null
+    split=$(measure "$work/$name-split" "$input")
+    whole=$(measure "$work/$name-whole" "$input")
+    if ! cmp -s "$work/$name-split.out" "$work/$name-whole.out"; then
+        echo "$name: вывод --whole-program не совпадает" >&2
+        exit 1
+    fi
+    awk -v name="$name" -v separate="$split" -v whole="$whole" 'BEGIN {
+        printf "%-10s %8.4f с  %8.4f с  x%.2f\n", name, separate, whole, separate / whole
+    }'
+}
+
+printf "%-10s %10s  %10s\n" "программа" "раздельно" "целиком"
+compare modules "$work/modules.in" "$work/main.mk" "$work/shapes.mk"
+for name in fib arrays sieve matmul; do
+    compare "$name" "$here/programs/$name.in" "$here/programs/$name.mk"
+done
@@ -0,0 +1,891 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include "build.h"
+#include "cache.h"
+#include "translate.h"
+
+typedef enum {
+    UNIT_PENDING,
+    UNIT_READY,
+    UNIT_COMPILING,
+    UNIT_DONE,
+    UNIT_FAILED
+} UnitState;
+
+typedef struct {
+    const char* input;
+    char* object;
+    char* c_file;
+    char* dep_file;
+    DependencyList deps;
+    int rebuilt;
+    char key[HASH_HEX_SIZE];
+    int cacheable;
+    UnitState state;
+    char* code;
+    size_t code_len;
+    size_t written;
+    pid_t pid;
+    int fd;
+    double started;
+} BuildUnit;
+
+typedef struct {
+    CompileContext* ctx;
+    const RuntimeLibrary* runtime;
+    BuildCache cache;
+    int use_cache;
+    BuildUnit* units;
+    int count;
+    int next;
+    int ready;
+    int running;
+    int finished;
+    int failed;
+    int persistent;
+    int rebuilt;
+    struct pollfd* poll_fds;
+    BuildUnit** poll_owners;
+    char stamp[HASH_HEX_SIZE];
+    char temp_dir[PATH_MAX];
+} BuildGraph;
+
+/* ---------- Общие помощники ---------- */
+
+char* replace_extension(const char* path, const char* ext) {
+    const char* dot = strrchr(path, '.');
+    const char* slash = strrchr(path, '/');
+    size_t base_len = (dot && (!slash || dot > slash)) ? (size_t)(dot - path) : strlen(path);
+    char* result = malloc(base_len + strlen(ext) + 1);
+    if (!result) {
+        return NULL;
+    }
+    memcpy(result, path, base_len);
+    strcpy(result + base_len, ext);
+    return result;
+}
+
+int translate_input(const CompileContext* ctx, const char* input, DependencyList* deps, FILE* output) {
+    TranslateOptions options = {0};
+    options.input_name = input;
+    options.deps = deps;
+    options.line_directives = 1;
+    options.instrument = ctx->instrument;
+    return translate_file(input, &options, output, NULL);
+}
+
+static void hash_compiler_identity(Hasher* hasher, const char* name) {
+    const char* path_env = getenv("PATH");
+    char path[PATH_MAX];
+    struct stat st;
+
+    hasher_update_string(hasher, name);
+    for (const char* dir = path_env; dir && *dir; ) {
+        const char* end = strchr(dir, ':');
+        int dir_len = end ? (int)(end - dir) : (int)strlen(dir);
+        int len = snprintf(path, sizeof(path), "%.*s/%s", dir_len, dir, name);
+        if (len > 0 && (size_t)len < sizeof(path) && stat(path, &st) == 0 && S_ISREG(st.st_mode)) {
+            hasher_update_string(hasher, path);
+            hasher_update_u64(hasher, (uint64_t)st.st_size);
+            hasher_update_u64(hasher, (uint64_t)st.st_mtime);
+            return;
+        }
+        dir = end ? end + 1 : NULL;
+    }
+}
+
+static void hash_toolchain(Hasher* hasher, const CompileContext* ctx, const RuntimeLibrary* runtime, int link) {
+    char header[PATH_MAX];
+    struct stat st;
+
+    hasher_update_u64(hasher, (uint64_t)link);
+    hasher_update_u64(hasher, (uint64_t)ctx->debug);
+    hasher_update_u64(hasher, (uint64_t)ctx->native);
+    hasher_update_string(hasher, ctx->opt_flag);
+    hasher_update_u64(hasher, (uint64_t)ctx->lto);
+    hasher_update_u64(hasher, (uint64_t)ctx->fast_start);
+    hasher_update_u64(hasher, (uint64_t)ctx->arena);
+    hasher_update_u64(hasher, (uint64_t)ctx->instrument);
+    hasher_update_u64(hasher, (uint64_t)ctx->pgo_phase);
+
+    int len = snprintf(header, sizeof(header), "%s/mika/mika_std.h",
+                       runtime->include_dir[0] ? runtime->include_dir : "/usr/local/include");
+    if (len < 0 || (size_t)len >= sizeof(header) || hasher_update_file(hasher, header) != 0) {
+        hasher_update_string(hasher, "missing");
+    }
+    if (link) {
+        hasher_update_string(hasher, runtime->library);
+        if (stat(runtime->library, &st) == 0) {
+            hasher_update_u64(hasher, (uint64_t)st.st_size);
+            hasher_update_u64(hasher, (uint64_t)st.st_mtime);
+        }
+    }
+    hash_compiler_identity(hasher, "gcc");
+}
+
+int compute_build_key(const CompileContext* ctx, const char* input, int link,
+                      const RuntimeLibrary* runtime, char key[HASH_HEX_SIZE]) {
+    Hasher hasher;
+
+    hasher_init(&hasher);
+    hasher_update_string(&hasher, "mikac-build");
+    hasher_update_string(&hasher, MIKA_VERSION);
+    hasher_update_string(&hasher, input);
+    if (hash_source_tree(&hasher, input) != 0) {
+        return -1;
+    }
+    hash_toolchain(&hasher, ctx, runtime, link);
+
+    hasher_hex(&hasher, key);
+    return 0;
+}
+
+void add_common_flags(ArgList* args, const CompileContext* ctx, const RuntimeLibrary* runtime,
+                      char* include_flag, size_t size) {
+    args_add(args, ctx->opt_flag);
+    if (ctx->debug) {
+        args_add(args, "-g");
+    }
+    if (ctx->lto) {
+        args_add(args, "-flto");
+    }
+    if (ctx->pgo_phase == PGO_GENERATE) {
+        args_add(args, "-fprofile-generate");
+    } else if (ctx->pgo_phase == PGO_USE) {
+        args_add(args, "-fprofile-use");
+        args_add(args, "-fprofile-correction");
+        args_add(args, "-Wno-missing-profile");
+    }
+    if (ctx->native) {
+        args_add(args, "-march=native");
+    }
+    if (ctx->arena) {
+        args_add(args, "-DMIKA_ARENA");
+    }
+    /* статический исполняемый файл без PIE: нет динамического загрузчика
+       и перемещений при старте, неиспользуемые функции рантайма выброшены */
+    if (ctx->fast_start) {
+        args_add(args, "-DMIKA_FAST_START");
+        args_add(args, "-ffunction-sections");
+        args_add(args, "-fdata-sections");
+        args_add(args, "-fno-pie");
+        args_add(args, "-no-pie");
+        args_add(args, "-static");
+        args_add(args, "-Wl,--gc-sections");
+    }
+    if (runtime->include_dir[0]) {
+        snprintf(include_flag, size, "-I%s", runtime->include_dir);
+        args_add(args, include_flag);
+    }
+    args_add(args, "-I/usr/local/include");
+}
+
+void add_quote_dir(ArgList* args, const char* input, char* dir, size_t size) {
+    const char* slash = strrchr(input, '/');
+    if (!slash) {
+        return;
+    }
+    int len = snprintf(dir, size, "%.*s", slash == input ? 1 : (int)(slash - input), input);
+    if (len > 0 && (size_t)len < size) {
+        args_add(args, "-iquote");
+        args_add(args, dir);
+    }
+}
+
+/* ---------- Инкрементальная сборка ---------- */
+
+static int newer_than(const struct stat* a, const struct stat* b) {
+    if (a->st_mtim.tv_sec != b->st_mtim.tv_sec) {
+        return a->st_mtim.tv_sec > b->st_mtim.tv_sec;
+    }
+    return a->st_mtim.tv_nsec > b->st_mtim.tv_nsec;
+}
+
+static int unit_up_to_date(BuildGraph* graph, BuildUnit* unit) {
+    struct stat object, dep;
+    char stamp[HASH_HEX_SIZE];
+    DependencyList deps;
+    int fresh = 0;
+
+    if (stat(unit->object, &object) != 0) {
+        return 0;
+    }
+
+    deps_init(&deps);
+    if (deps_read_file(&deps, unit->dep_file, stamp, sizeof(stamp)) == 0 &&
+        strcmp(stamp, graph->stamp) == 0 && deps.count > 0) {
+        fresh = 1;
+        for (int i = 0; i < deps.count && fresh; i++) {
+            fresh = stat(deps.paths[i], &dep) == 0 && !newer_than(&dep, &object);
+        }
+    }
+    deps_free(&deps);
+    return fresh;
+}
+
+static void write_unit_deps(BuildGraph* graph, BuildUnit* unit) {
+    if (!graph->persistent) {
+        return;
+    }
+    if (unit->code == NULL && unit->deps.count == 0) {
+        deps_scan_file(&unit->deps, unit->input);
+    }
+    if (deps_write_file(&unit->deps, unit->dep_file, unit->object, unit->input, graph->stamp) != 0 &&
+        graph->ctx->verbose) {
+        printf("   ⚠️  Не удалось записать %s\n", unit->dep_file);
+    }
+}
+
+/* ---------- Граф сборки ---------- */
+
+static void unit_release(BuildUnit* unit) {
+    free(unit->code);
+    unit->code = NULL;
+    if (unit->fd >= 0) {
+        close(unit->fd);
+        unit->fd = -1;
+    }
+}
+
+static void unit_fail(BuildGraph* graph, BuildUnit* unit, const char* stage) {
+    fprintf(stderr, "❌ %s: ошибка на этапе %s\n", unit->input, stage);
+    unit_release(unit);
+    unit->state = UNIT_FAILED;
+    graph->failed++;
+    graph->finished++;
+}
+
+static void unit_done(BuildGraph* graph, BuildUnit* unit) {
+    write_unit_deps(graph, unit);
+    unit_release(unit);
+    unit->state = UNIT_DONE;
+    graph->finished++;
+}
+
+static int write_c_file(const char* path, const char* code, size_t len) {
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        return -1;
+    }
+    int failed = fwrite(code, 1, len, file) != len;
+    return (fclose(file) != 0 || failed) ? -1 : 0;
+}
+
+static void translate_unit(BuildGraph* graph, BuildUnit* unit) {
+    CompileContext* ctx = graph->ctx;
+
+    if (graph->persistent && unit_up_to_date(graph, unit)) {
+        if (ctx->verbose) {
+            printf("✔️  %s: не изменился, пропускаем\n", unit->input);
+        }
+        unit->state = UNIT_DONE;
+        graph->finished++;
+        return;
+    }
+    unit->rebuilt = 1;
+    graph->rebuilt++;
+
+    unit->cacheable = graph->use_cache &&
+                      compute_build_key(ctx, unit->input, 0, graph->runtime, unit->key) == 0;
+    int hit = unit->cacheable && build_cache_fetch(&graph->cache, unit->key, unit->object);
+    if (hit) {
+        telemetry_mark_cached(ctx->telemetry, (int)(unit - graph->units));
+    }
+    if (hit && ctx->verbose) {
+        printf("⚡ %s: объектный файл найден в кэше\n", unit->input);
+    }
+    if (hit && !ctx->keep_files) {
+        unit_done(graph, unit);
+        return;
+    }
+
+    if (ctx->verbose) {
+        printf("🚀 %s: трансляция Mika -> C\n", unit->input);
+    }
+
+    StageClock clock;
+    telemetry_start(&clock);
+    FILE* stream = open_memstream(&unit->code, &unit->code_len);
+    if (!stream) {
+        unit_fail(graph, unit, "трансляции Mika -> C");
+        return;
+    }
+    int failed = translate_input(ctx, unit->input, &unit->deps, stream) != 0;
+    failed |= fclose(stream) != 0;
+    telemetry_stop(ctx->telemetry, (int)(unit - graph->units), STAGE_TRANSLATE, &clock, TIME_SELF);
+    if (failed) {
+        unit_fail(graph, unit, "трансляции Mika -> C");
+        return;
+    }
+
+    if (ctx->keep_files && write_c_file(unit->c_file, unit->code, unit->code_len) != 0) {
+        perror("❌ Не удалось создать C файл");
+        unit_fail(graph, unit, "трансляции Mika -> C");
+        return;
+    }
+    if (hit) {
+        unit_done(graph, unit);
+        return;
+    }
+
+    unit->state = UNIT_READY;
+    graph->ready++;
+}
+
+static void start_compile(BuildGraph* graph, BuildUnit* unit) {
+    CompileContext* ctx = graph->ctx;
+    char include_flag[PATH_MAX + 2];
+    ArgList args = {0};
+
+    args_add(&args, "gcc");
+    args_add(&args, "-x");
+    args_add(&args, "c");
+    args_add(&args, "-");
+    args_add(&args, "-c");
+    args_add(&args, "-o");
+    args_add(&args, unit->object);
+    char quote_dir[PATH_MAX];
+    add_quote_dir(&args, unit->input, quote_dir, sizeof(quote_dir));
+    add_common_flags(&args, ctx, graph->runtime, include_flag, sizeof(include_flag));
+
+    graph->ready--;
+    unit->started = telemetry_now();
+    unit->pid = spawn_process(&args, &unit->fd, ctx->verbose);
+    args_free(&args);
+    if (unit->pid < 0) {
+        unit->fd = -1;
+        unit_fail(graph, unit, "компиляции C кода");
+        return;
+    }
+    fcntl(unit->fd, F_SETFL, fcntl(unit->fd, F_GETFL) | O_NONBLOCK);
+    unit->written = 0;
+    unit->state = UNIT_COMPILING;
+    graph->running++;
+}
+
+static void pump_unit(BuildUnit* unit) {
+    while (unit->written < unit->code_len) {
+        ssize_t put = write(unit->fd, unit->code + unit->written, unit->code_len - unit->written);
+        if (put < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return;
+            break;
+        }
+        unit->written += (size_t)put;
+    }
+    close(unit->fd);
+    unit->fd = -1;
+}
+
+static void finish_compile(BuildGraph* graph, pid_t pid, int status, const struct rusage* usage) {
+    for (int i = 0; i < graph->count; i++) {
+        BuildUnit* unit = &graph->units[i];
+        if (unit->state != UNIT_COMPILING || unit->pid != pid) {
+            continue;
+        }
+
+        graph->running--;
+        telemetry_add_process(graph->ctx->telemetry, i, STAGE_COMPILE, telemetry_now() - unit->started, usage);
+        int ok = WIFEXITED(status) && WEXITSTATUS(status) == 0 && unit->written == unit->code_len;
+        if (graph->ctx->verbose) {
+            printf(ok ? "   ✅ %s: скомпилирован\n" : "   ❌ %s: ошибка компиляции\n", unit->input);
+        }
+        if (!ok) {
+            unit_fail(graph, unit, "компиляции C кода");
+            return;
+        }
+        if (unit->cacheable) {
+            build_cache_store(&graph->cache, unit->key, unit->object);
+        }
+        unit_done(graph, unit);
+        return;
+    }
+}
+
+static void pump_and_reap(BuildGraph* graph, int block) {
+    struct pollfd* fds = graph->poll_fds;
+    BuildUnit** owners = graph->poll_owners;
+    int nfds = 0;
+
+    for (int i = 0; i < graph->count; i++) {
+        BuildUnit* unit = &graph->units[i];
+        if (unit->state == UNIT_COMPILING && unit->fd >= 0) {
+            fds[nfds].fd = unit->fd;
+            fds[nfds].events = POLLOUT;
+            fds[nfds].revents = 0;
+            owners[nfds++] = unit;
+        }
+    }
+
+    if (nfds > 0 && poll(fds, (nfds_t)nfds, block ? 50 : 0) > 0) {
+        for (int i = 0; i < nfds; i++) {
+            if (fds[i].revents) {
+                pump_unit(owners[i]);
+            }
+        }
+    }
+
+    struct rusage usage;
+    int status;
+    pid_t pid;
+    int reaped = 0;
+    while (graph->running > 0 && (pid = reap_process(-1, &status, WNOHANG, &usage)) > 0) {
+        finish_compile(graph, pid, status, &usage);
+        reaped++;
+    }
+    if (block && nfds == 0 && reaped == 0 && graph->running > 0) {
+        pid = reap_process(-1, &status, 0, &usage);
+        if (pid > 0) {
+            finish_compile(graph, pid, status, &usage);
+        }
+    }
+}
+
+static void run_graph(BuildGraph* graph) {
+    int jobs = graph->ctx->jobs > 0 ? graph->ctx->jobs : 1;
+
+    while (graph->finished < graph->count) {
+        for (int i = 0; i < graph->count && graph->running < jobs; i++) {
+            if (graph->units[i].state == UNIT_READY) {
+                start_compile(graph, &graph->units[i]);
+            }
+        }
+
+        int can_translate = graph->next < graph->count && graph->ready < jobs;
+        if (!can_translate && graph->running == 0 && graph->ready == 0) {
+            break;
+        }
+
+        pump_and_reap(graph, !can_translate);
+        if (can_translate) {
+            translate_unit(graph, &graph->units[graph->next++]);
+        }
+    }
+}
+
+static int output_up_to_date(BuildGraph* graph) {
+    struct stat output, input;
+
+    if (!graph->persistent || graph->rebuilt > 0 || stat(graph->ctx->output_file, &output) != 0) {
+        return 0;
+    }
+    if (stat(graph->runtime->library, &input) != 0 || newer_than(&input, &output)) {
+        return 0;
+    }
+    for (int i = 0; i < graph->count; i++) {
+        if (stat(graph->units[i].object, &input) != 0 || newer_than(&input, &output)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int link_project(BuildGraph* graph) {
+    CompileContext* ctx = graph->ctx;
+    char key[HASH_HEX_SIZE];
+    int cacheable = graph->use_cache;
+
+    if (output_up_to_date(graph)) {
+        if (ctx->verbose) {
+            printf("✔️  %s: не изменился, линковка не нужна\n", ctx->output_file);
+        }
+        return 0;
+    }
+
+    if (cacheable) {
+        Hasher hasher;
+        hasher_init(&hasher);
+        hasher_update_string(&hasher, "mikac-link");
+        hasher_update_string(&hasher, MIKA_VERSION);
+        for (int i = 0; i < graph->count && cacheable; i++) {
+            cacheable = graph->units[i].cacheable;
+            hasher_update_string(&hasher, graph->units[i].key);
+        }
+        hash_toolchain(&hasher, ctx, graph->runtime, 1);
+        hasher_hex(&hasher, key);
+    }
+
+    if (cacheable && build_cache_fetch(&graph->cache, key, ctx->output_file)) {
+        if (ctx->verbose) {
+            printf("⚡ Исполняемый файл найден в кэше сборки: %s\n", key);
+        }
+        return 0;
+    }
+
+    if (ctx->verbose) {
+        printf("\n🔗 Линковка: %d объектных файлов -> %s\n", graph->count, ctx->output_file);
+    }
+
+    char include_flag[PATH_MAX + 2];
+    ArgList args = {0};
+    args_add(&args, "gcc");
+    for (int i = 0; i < graph->count; i++) {
+        args_add(&args, graph->units[i].object);
+    }
+    args_add(&args, graph->runtime->library);
+    args_add(&args, "-pthread");
+    args_add(&args, "-o");
+    args_add(&args, ctx->output_file);
+    add_common_flags(&args, ctx, graph->runtime, include_flag, sizeof(include_flag));
+
+    struct rusage usage;
+    double started = telemetry_now();
+    pid_t pid = spawn_process(&args, NULL, ctx->verbose);
+    args_free(&args);
+    int status = pid < 0 ? -1 : wait_process_usage(pid, ctx->verbose, &usage);
+    if (status >= 0) {
+        telemetry_add_process(ctx->telemetry, -1, STAGE_LINK, telemetry_now() - started, &usage);
+    }
+    if (status != 0) {
+        fprintf(stderr, "❌ Ошибка на этапе линковки\n");
+        return -1;
+    }
+    if (cacheable) {
+        build_cache_store(&graph->cache, key, ctx->output_file);
+    }
+    return 0;
+}
+
+static int assign_objects(BuildGraph* graph) {
+    CompileContext* ctx = graph->ctx;
+    int temporary = !ctx->compile_only && !ctx->keep_files;
+
+    if (temporary && ctx->object_dir) {
+        snprintf(graph->temp_dir, sizeof(graph->temp_dir), "%s", ctx->object_dir);
+    } else if (temporary) {
+        const char* tmp = getenv("TMPDIR");
+        int len = snprintf(graph->temp_dir, sizeof(graph->temp_dir), "%s/mikac-XXXXXX",
+                           tmp && *tmp ? tmp : "/tmp");
+        if (len < 0 || (size_t)len >= sizeof(graph->temp_dir) || !mkdtemp(graph->temp_dir)) {
+            perror("❌ Не удалось создать временный каталог");
+            graph->temp_dir[0] = '\0';
+            return -1;
+        }
+    }
+
+    for (int i = 0; i < graph->count; i++) {
+        BuildUnit* unit = &graph->units[i];
+        unit->input = ctx->input_files[i];
+        unit->fd = -1;
+        unit->state = UNIT_PENDING;
+
+        if (temporary) {
+            const char* slash = strrchr(unit->input, '/');
+            char* base = replace_extension(slash ? slash + 1 : unit->input, "");
+            size_t size = strlen(graph->temp_dir) + (base ? strlen(base) : 0) + 32;
+            unit->object = malloc(size);
+            if (base && unit->object) {
+                snprintf(unit->object, size, "%s/%d_%s.o", graph->temp_dir, i, base);
+            }
+            free(base);
+        } else if (ctx->compile_only && ctx->output_file && graph->count == 1) {
+            unit->object = strdup(ctx->output_file);
+        } else {
+            unit->object = replace_extension(unit->input, ".o");
+        }
+        if (ctx->keep_files) {
+            unit->c_file = replace_extension(unit->input, ".c");
+        }
+        if (graph->persistent && unit->object) {
+            unit->dep_file = replace_extension(unit->object, ".d");
+        }
+        if (!unit->object || (ctx->keep_files && !unit->c_file) || (graph->persistent && !unit->dep_file)) {
+            fprintf(stderr, "❌ Ошибка выделения памяти\n");
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static void cleanup_graph(BuildGraph* graph) {
+    for (int i = 0; graph->units && i < graph->count; i++) {
+        BuildUnit* unit = &graph->units[i];
+        if (unit->pid > 0 && unit->state == UNIT_COMPILING) {
+            kill(unit->pid, SIGTERM);
+            waitpid(unit->pid, NULL, 0);
+        }
+        unit_release(unit);
+        if (graph->temp_dir[0] && unit->object && !graph->ctx->incremental) {
+            unlink(unit->object);
+        }
+        deps_free(&unit->deps);
+        free(unit->object);
+        free(unit->c_file);
+        free(unit->dep_file);
+    }
+    if (graph->temp_dir[0] && !graph->ctx->object_dir) {
+        rmdir(graph->temp_dir);
+    }
+    free(graph->units);
+    free(graph->poll_fds);
+    free(graph->poll_owners);
+}
+
+int build_project(CompileContext* ctx, const RuntimeLibrary* runtime) {
+    BuildGraph graph;
+    memset(&graph, 0, sizeof(graph));
+    graph.ctx = ctx;
+    graph.runtime = runtime;
+    graph.count = ctx->input_count;
+    graph.use_cache = ctx->use_cache && !ctx->pgo_phase && build_cache_init(&graph.cache, ctx->verbose) == 0;
+    graph.units = calloc((size_t)graph.count, sizeof(BuildUnit));
+    graph.poll_fds = malloc((size_t)graph.count * sizeof(struct pollfd));
+    graph.poll_owners = malloc((size_t)graph.count * sizeof(BuildUnit*));
+    graph.persistent = (ctx->compile_only || ctx->keep_files || ctx->incremental) && !ctx->pgo_phase;
+
+    Hasher hasher;
+    hasher_init(&hasher);
+    hasher_update_string(&hasher, MIKA_VERSION);
+    hash_toolchain(&hasher, ctx, runtime, 0);
+    hasher_hex(&hasher, graph.stamp);
+
+    int result = 1;
+    if (!graph.units || !graph.poll_fds || !graph.poll_owners) {
+        fprintf(stderr, "❌ Ошибка выделения памяти\n");
+        goto done;
+    }
+    if (assign_objects(&graph) != 0) {
+        goto done;
+    }
+
+    if (ctx->verbose) {
+        printf("\n🧵 Сборка %d файлов, параллельных задач: %d\n", graph.count, ctx->jobs > 0 ? ctx->jobs : 1);
+    }
+    run_graph(&graph);
+
+    if (graph.failed > 0) {
+        fprintf(stderr, "❌ Сборка не удалась: ошибки в %d из %d файлов\n", graph.failed, graph.count);
+        goto done;
+    }
+
+    if (ctx->compile_only) {
+        printf("✅ Успешно: скомпилировано файлов: %d\n", graph.count);
+        result = 0;
+        goto done;
+    }
+
+    if (link_project(&graph) != 0) {
+        goto done;
+    }
+    if (ctx->pgo_phase != PGO_GENERATE) {
+        printf("✅ Успешно: %d файлов -> %s\n", graph.count, ctx->output_file);
+    }
+    result = 0;
+
+done:
+    cleanup_graph(&graph);
+    return result;
+}
+
+/* ---------- Сборка всей программы ---------- */
+
+extern const char mika_std_library_source[];
+
+static int build_call_graph(CompileContext* ctx, CallGraph* graph) {
+    StageClock clock;
+
+    callgraph_init(graph);
+    telemetry_start(&clock);
+    for (int i = 0; i < ctx->input_count; i++) {
+        if (callgraph_add_module(graph, ctx->input_files[i]) != 0) {
+            return -1;
+        }
+    }
+    callgraph_finish(graph);
+    telemetry_stop(ctx->telemetry, -1, STAGE_TRANSLATE, &clock, TIME_SELF);
+
+    if (ctx->verbose) {
+        int hints[4] = {0};
+        for (int i = 0; i < graph->count; i++) {
+            hints[graph->functions[i].hint]++;
+        }
+        printf("\n🕸  Граф вызовов: функций %d, вызовов %d; inline: %d, hot: %d, cold: %d\n", graph->count,
+               graph->edge_count, hints[CALL_HINT_INLINE], hints[CALL_HINT_HOT], hints[CALL_HINT_COLD]);
+    }
+    return 0;
+}
+
+static int whole_program_key(const CompileContext* ctx, const RuntimeLibrary* runtime, char key[HASH_HEX_SIZE]) {
+    Hasher hasher;
+    char unit[HASH_HEX_SIZE];
+
+    hasher_init(&hasher);
+    hasher_update_string(&hasher, "mikac-whole");
+    hasher_update_string(&hasher, MIKA_VERSION);
+    for (int i = 0; i < ctx->input_count; i++) {
+        if (compute_build_key(ctx, ctx->input_files[i], 1, runtime, unit) != 0) {
+            return -1;
+        }
+        hasher_update_string(&hasher, unit);
+    }
+    hasher_update_string(&hasher, mika_std_library_source);
+    hasher_hex(&hasher, key);
+    return 0;
+}
+
+/* Рантайм идёт первым: ему нужен _POSIX_C_SOURCE до первого системного
+   заголовка, а #include <mika/mika_std.h> в модулях дальше пропускается
+   по стражу заголовка. */
+static int translate_program(CompileContext* ctx, const CallGraph* graph, FILE* output) {
+    fprintf(output, "#line 1 \"mika_std.c\"\n%s", mika_std_library_source);
+
+    for (int i = 0; i < ctx->input_count; i++) {
+        TranslateOptions options = {0};
+        StageClock clock;
+
+        options.input_name = ctx->input_files[i];
+        options.line_directives = 1;
+        options.instrument = ctx->instrument;
+        options.program = graph;
+        telemetry_start(&clock);
+        int failed = translate_file(ctx->input_files[i], &options, output, NULL) != 0;
+        telemetry_stop(ctx->telemetry, i, STAGE_TRANSLATE, &clock, TIME_SELF);
+        if (failed) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int compile_program(CompileContext* ctx, const RuntimeLibrary* runtime, const char* c_file,
+                           const char* code, size_t len) {
+    char include_flag[PATH_MAX + 2];
+    char runtime_dir[PATH_MAX];
+    char (*dirs)[PATH_MAX] = calloc((size_t)ctx->input_count, PATH_MAX);
+    ArgList args = {0};
+    int result = -1;
+
+    if (!dirs) {
+        fprintf(stderr, "❌ Ошибка выделения памяти\n");
+        return -1;
+    }
+    args_add(&args, "gcc");
+    args_add(&args, "-x");
+    args_add(&args, "c");
+    args_add(&args, c_file ? c_file : "-");
+    args_add(&args, "-o");
+    args_add(&args, ctx->output_file);
+    for (int i = 0; i < ctx->input_count; i++) {
+        int added = args.argc;
+        add_quote_dir(&args, ctx->input_files[i], dirs[i], PATH_MAX);
+        for (int j = 0; j < i && args.argc > added; j++) {
+            if (strcmp(dirs[j], dirs[i]) == 0) {
+                args.argc = added;
+                args.argv[added] = NULL;
+            }
+        }
+    }
+    int dir_len = snprintf(runtime_dir, sizeof(runtime_dir), "%s/mika",
+                           runtime->include_dir[0] ? runtime->include_dir : "/usr/local/include");
+    if (dir_len > 0 && (size_t)dir_len < sizeof(runtime_dir)) {
+        args_add(&args, "-iquote");
+        args_add(&args, runtime_dir);
+    }
+    add_common_flags(&args, ctx, runtime, include_flag, sizeof(include_flag));
+    args_add(&args, "-fwhole-program");
+    args_add(&args, "-pthread");
+
+    struct rusage usage;
+    double started = telemetry_now();
+    int stdin_fd = -1;
+    pid_t pid = spawn_process(&args, c_file ? NULL : &stdin_fd, ctx->verbose);
+    if (pid < 0) {
+        goto done;
+    }
+    if (!c_file) {
+        FILE* stream = fdopen(stdin_fd, "w");
+        if (!stream) {
+            close(stdin_fd);
+        } else {
+            fwrite(code, 1, len, stream);
+            fclose(stream);
+        }
+    }
+    int status = wait_process_usage(pid, ctx->verbose, &usage);
+    if (status >= 0) {
+        telemetry_add_process(ctx->telemetry, -1, STAGE_COMPILE_LINK, telemetry_now() - started, &usage);
+    }
+    if (status != 0) {
+        fprintf(stderr, "❌ Ошибка компиляции или линковки\n");
+        goto done;
+    }
+    result = 0;
+
+done:
+    args_free(&args);
+    free(dirs);
+    return result;
+}
+
+int build_whole_program(CompileContext* ctx, const RuntimeLibrary* runtime) {
+    CallGraph graph;
+    BuildCache cache;
+    char key[HASH_HEX_SIZE];
+    char* code = NULL;
+    size_t len = 0;
+    char* c_file = NULL;
+    int result = 1;
+
+    int cacheable = ctx->use_cache && !ctx->keep_files && build_cache_init(&cache, ctx->verbose) == 0 &&
+                    whole_program_key(ctx, runtime, key) == 0;
+    if (cacheable && build_cache_fetch(&cache, key, ctx->output_file)) {
+        if (ctx->verbose) {
+            printf("\n⚡ Найдено в кэше сборки: %s\n", key);
+        }
+        printf("✅ Успешно: %d файлов -> %s\n", ctx->input_count, ctx->output_file);
+        return 0;
+    }
+
+    if (build_call_graph(ctx, &graph) != 0) {
+        goto done;
+    }
+
+    FILE* stream = open_memstream(&code, &len);
+    if (!stream) {
+        perror("❌ Не удалось выделить буфер трансляции");
+        goto done;
+    }
+    int failed = translate_program(ctx, &graph, stream) != 0;
+    if (fclose(stream) != 0 || failed) {
+        fprintf(stderr, "❌ Ошибка на этапе трансляции Mika -> C\n");
+        goto done;
+    }
+
+    if (ctx->keep_files) {
+        c_file = replace_extension(ctx->output_file, ".c");
+        if (!c_file || write_c_file(c_file, code, len) != 0) {
+            fprintf(stderr, "❌ Не удалось записать %s\n", c_file ? c_file : ctx->output_file);
+            goto done;
+        }
+    }
+    if (ctx->verbose) {
+        printf("\n🔗 Компиляция всей программы одной единицей (модулей: %d + рантайм) -> %s\n", ctx->input_count,
+               ctx->output_file);
+    }
+    if (compile_program(ctx, runtime, c_file, code, len) != 0) {
+        goto done;
+    }
+
+    if (cacheable && build_cache_store(&cache, key, ctx->output_file) != 0 && ctx->verbose) {
+        printf("   ⚠️  Не удалось сохранить результат в кэш\n");
+    }
+    printf("✅ Успешно: %d файлов -> %s\n", ctx->input_count, ctx->output_file);
+    result = 0;
+
+done:
+    callgraph_free(&graph);
+    free(code);
+    free(c_file);
+    return result;
+}
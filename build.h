@@ -0,0 +1,54 @@
+#ifndef MIKA_BUILD_H
+#define MIKA_BUILD_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+#include "deps.h"
+#include "hash.h"
+#include "process.h"
+#include "runtime.h"
+#include "telemetry.h"
+
+typedef struct {
+    char* input_file;
+    char** input_files;
+    int input_count;
+    char* output_file;
+    int verbose;
+    int debug;
+    int keep_files;
+    int compile_only;
+    int native;
+    int use_cache;
+    int cache_stats;
+    int jobs;
+    const char* opt_flag;
+    int lto;
+    int whole_program;
+    int fast_start;
+    int arena;
+    int instrument;
+    const char* pgo_training;
+    int pgo_phase;
+    const char* object_dir;
+    int incremental;
+    int time_report;
+    const char* report_json;
+    BuildTelemetry* telemetry;
+} CompileContext;
+
+#define PGO_GENERATE 1
+#define PGO_USE 2
+
+char* replace_extension(const char* path, const char* ext);
+int translate_input(const CompileContext* ctx, const char* input, DependencyList* deps, FILE* output);
+int compute_build_key(const CompileContext* ctx, const char* input, int link,
+                      const RuntimeLibrary* runtime, char key[HASH_HEX_SIZE]);
+void add_common_flags(ArgList* args, const CompileContext* ctx, const RuntimeLibrary* runtime,
+                      char* include_flag, size_t size);
+void add_quote_dir(ArgList* args, const char* input, char* dir, size_t size);
+int build_project(CompileContext* ctx, const RuntimeLibrary* runtime);
+int build_whole_program(CompileContext* ctx, const RuntimeLibrary* runtime);
+
+#endif
@@ -0,0 +1,2487 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <limits.h>
+
+#include "bytecode.h"
+
+#define MIKA_SUCCESS_CODE 993
+#define BYTECODE_MAX_LOCALS 1024
+#define BYTECODE_MAX_ARGS 64
+
+typedef struct {
+    const char* name;
+    ValueType type;
+    int reg;
+} Local;
+
+typedef struct {
+    const char* name;
+    ValueType type;
+    int slot;
+} Global;
+
+/* Вызов функции до её объявления: типы аргументов сверяются в конце. */
+typedef struct {
+    int function;
+    int line;
+    int count;
+    ValueType* args;
+} PendingCall;
+
+typedef struct {
+    const char** names;
+    int* values;
+    int count;
+    int cap;
+} NameTable;
+
+typedef struct Loop {
+    struct Loop* outer;
+    int breaks;
+    int continues;
+    int is_switch;
+} Loop;
+
+typedef struct SwitchCases {
+    struct SwitchCases* outer;
+    const Node** nodes;
+    int* jumps;
+    int count;
+} SwitchCases;
+
+struct BytecodeCompiler {
+    Program* program;
+    const char* filename;
+    int errors;
+    int function;
+    int top;
+    Local locals[BYTECODE_MAX_LOCALS];
+    int local_count;
+    Loop* loop;
+    SwitchCases* cases;
+    Global* globals;
+    int global_count;
+    int global_cap;
+    NameTable function_names;
+    NameTable global_names;
+    PendingCall* pending;
+    int pending_count;
+    int pending_cap;
+};
+
+typedef struct {
+    int reg;
+    ValueType type;
+} Operand;
+
+typedef enum {
+    LVALUE_LOCAL,
+    LVALUE_GLOBAL,
+    LVALUE_ELEMENT
+} LvalueKind;
+
+typedef struct {
+    LvalueKind kind;
+    ValueType type;
+    int reg;
+    int base;
+    int index;
+} Lvalue;
+
+typedef enum {
+    BUILTIN_NATIVE,
+    BUILTIN_UPDATE,
+    BUILTIN_PRINT,
+    BUILTIN_LEN,
+    BUILTIN_PUSH,
+    BUILTIN_POP,
+    BUILTIN_VIEW,
+    BUILTIN_SLICE,
+    BUILTIN_STRING_LENGTH,
+    BUILTIN_STRING_COMPARE,
+    BUILTIN_STRING_FREE
+} BuiltinKind;
+
+/* BUILTIN_UPDATE: первый аргумент передаётся по адресу — функция меняет
+   его копию в области аргументов, и копия записывается обратно. */
+typedef struct {
+    const char* name;
+    BuiltinKind kind;
+    NativeId native;
+    ValueType ret;
+    int arity;
+    ValueType params[3];
+} Builtin;
+
+static const Builtin builtins[] = {
+    {"print", BUILTIN_PRINT, 0, TYPE_INT, -1, {0}},
+    {"input", BUILTIN_NATIVE, NATIVE_INPUT, TYPE_INT, 0, {0}},
+    {"power", BUILTIN_NATIVE, NATIVE_POWER, TYPE_INT, 2, {TYPE_INT, TYPE_INT}},
+    {"absolute", BUILTIN_NATIVE, NATIVE_ABSOLUTE, TYPE_INT, 1, {TYPE_INT}},
+    {"flush_output", BUILTIN_NATIVE, NATIVE_FLUSH_OUTPUT, TYPE_VOID, 0, {0}},
+    {"len", BUILTIN_LEN, 0, TYPE_INT, 1, {0}},
+    {"array_length", BUILTIN_LEN, 0, TYPE_INT, 1, {0}},
+    {"push", BUILTIN_PUSH, 0, TYPE_VOID, 2, {0}},
+    {"pop", BUILTIN_POP, 0, TYPE_INT, 1, {0}},
+    {"reserve", BUILTIN_UPDATE, NATIVE_ARRAY_RESERVE, TYPE_VOID, 2, {TYPE_ARRAY, TYPE_INT}},
+    {"array_create", BUILTIN_NATIVE, NATIVE_ARRAY_CREATE, TYPE_ARRAY, 1, {TYPE_INT}},
+    {"array_free", BUILTIN_NATIVE, NATIVE_ARRAY_FREE, TYPE_VOID, 1, {TYPE_ARRAY}},
+    {"array_size", BUILTIN_NATIVE, NATIVE_ARRAY_SIZE, TYPE_INT, 2, {TYPE_ARRAY, TYPE_INT}},
+    {"array_view", BUILTIN_VIEW, 0, TYPE_SLICE, 1, {TYPE_ARRAY}},
+    {"array_slice", BUILTIN_SLICE, 0, TYPE_SLICE, 3, {0}},
+    {"slice_range", BUILTIN_NATIVE, NATIVE_SLICE_RANGE, TYPE_SLICE, 3, {TYPE_SLICE, TYPE_INT, TYPE_INT}},
+    {"array_sum", BUILTIN_NATIVE, NATIVE_ARRAY_SUM, TYPE_INT, 1, {TYPE_SLICE}},
+    {"array_min", BUILTIN_NATIVE, NATIVE_ARRAY_MIN, TYPE_INT, 1, {TYPE_SLICE}},
+    {"array_max", BUILTIN_NATIVE, NATIVE_ARRAY_MAX, TYPE_INT, 1, {TYPE_SLICE}},
+    {"array_fill", BUILTIN_NATIVE, NATIVE_ARRAY_FILL, TYPE_VOID, 2, {TYPE_SLICE, TYPE_INT}},
+    {"array_copy", BUILTIN_NATIVE, NATIVE_ARRAY_COPY, TYPE_VOID, 2, {TYPE_SLICE, TYPE_SLICE}},
+    {"array_dot", BUILTIN_NATIVE, NATIVE_ARRAY_DOT, TYPE_INT, 2, {TYPE_SLICE, TYPE_SLICE}},
+    {"array_add", BUILTIN_NATIVE, NATIVE_ARRAY_ADD, TYPE_VOID, 3, {TYPE_SLICE, TYPE_SLICE, TYPE_SLICE}},
+    {"array_sub", BUILTIN_NATIVE, NATIVE_ARRAY_SUB, TYPE_VOID, 3, {TYPE_SLICE, TYPE_SLICE, TYPE_SLICE}},
+    {"array_mul", BUILTIN_NATIVE, NATIVE_ARRAY_MUL, TYPE_VOID, 3, {TYPE_SLICE, TYPE_SLICE, TYPE_SLICE}},
+    {"array_simd_level", BUILTIN_NATIVE, NATIVE_ARRAY_SIMD_LEVEL, TYPE_CSTRING, 0, {0}},
+    {"mika_thread_count", BUILTIN_NATIVE, NATIVE_THREAD_COUNT, TYPE_INT, 0, {0}},
+    {"arena_enter", BUILTIN_NATIVE, NATIVE_ARENA_ENTER, TYPE_VOID, 0, {0}},
+    {"arena_leave", BUILTIN_NATIVE, NATIVE_ARENA_LEAVE, TYPE_VOID, 0, {0}},
+    {"string_length", BUILTIN_STRING_LENGTH, 0, TYPE_INT, 1, {0}},
+    {"string_compare", BUILTIN_STRING_COMPARE, 0, TYPE_INT, 2, {0}},
+    {"string_copy", BUILTIN_UPDATE, NATIVE_STRING_ASSIGN, TYPE_VOID, 2, {TYPE_STRING, TYPE_STRING}},
+    {"substring", BUILTIN_NATIVE, NATIVE_SUBSTRING, TYPE_STRING, 3, {TYPE_STRING, TYPE_INT, TYPE_INT}},
+    {"input_line", BUILTIN_NATIVE, NATIVE_INPUT_LINE, TYPE_STRING, 0, {0}},
+    {"append", BUILTIN_UPDATE, NATIVE_BUILDER_APPEND, TYPE_VOID, 2, {TYPE_BUILDER, TYPE_STRING}},
+    {"to_string", BUILTIN_UPDATE, NATIVE_BUILDER_FINISH, TYPE_STRING, 1, {TYPE_BUILDER}},
+    {"string_free", BUILTIN_STRING_FREE, 0, TYPE_VOID, 1, {0}},
+    {"abs", BUILTIN_NATIVE, NATIVE_ABS, TYPE_INT, 1, {TYPE_INT}},
+    {"rand", BUILTIN_NATIVE, NATIVE_RAND, TYPE_INT, 0, {0}},
+    {"srand", BUILTIN_NATIVE, NATIVE_SRAND, TYPE_VOID, 1, {TYPE_INT}},
+    {"exit", BUILTIN_NATIVE, NATIVE_EXIT, TYPE_VOID, 1, {TYPE_INT}},
+    {"sqrt", BUILTIN_NATIVE, NATIVE_SQRT, TYPE_DOUBLE, 1, {TYPE_DOUBLE}},
+    {"pow", BUILTIN_NATIVE, NATIVE_POW, TYPE_DOUBLE, 2, {TYPE_DOUBLE, TYPE_DOUBLE}},
+    {"sin", BUILTIN_NATIVE, NATIVE_SIN, TYPE_DOUBLE, 1, {TYPE_DOUBLE}},
+    {"cos", BUILTIN_NATIVE, NATIVE_COS, TYPE_DOUBLE, 1, {TYPE_DOUBLE}},
+    {"tan", BUILTIN_NATIVE, NATIVE_TAN, TYPE_DOUBLE, 1, {TYPE_DOUBLE}},
+    {"atan", BUILTIN_NATIVE, NATIVE_ATAN, TYPE_DOUBLE, 1, {TYPE_DOUBLE}},
+    {"atan2", BUILTIN_NATIVE, NATIVE_ATAN2, TYPE_DOUBLE, 2, {TYPE_DOUBLE, TYPE_DOUBLE}},
+    {"exp", BUILTIN_NATIVE, NATIVE_EXP, TYPE_DOUBLE, 1, {TYPE_DOUBLE}},
+    {"log", BUILTIN_NATIVE, NATIVE_LOG, TYPE_DOUBLE, 1, {TYPE_DOUBLE}},
+    {"log10", BUILTIN_NATIVE, NATIVE_LOG10, TYPE_DOUBLE, 1, {TYPE_DOUBLE}},
+    {"floor", BUILTIN_NATIVE, NATIVE_FLOOR, TYPE_DOUBLE, 1, {TYPE_DOUBLE}},
+    {"ceil", BUILTIN_NATIVE, NATIVE_CEIL, TYPE_DOUBLE, 1, {TYPE_DOUBLE}},
+    {"fabs", BUILTIN_NATIVE, NATIVE_FABS, TYPE_DOUBLE, 1, {TYPE_DOUBLE}},
+    {"fmod", BUILTIN_NATIVE, NATIVE_FMOD, TYPE_DOUBLE, 2, {TYPE_DOUBLE, TYPE_DOUBLE}},
+};
+
+static void compile_error(BytecodeCompiler* c, int line, const char* fmt, ...) {
+    va_list args;
+    fprintf(stderr, "%s:%d: ошибка: ", c->filename, line);
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
+    fputc('\n', stderr);
+    c->errors++;
+}
+
+static void unsupported(BytecodeCompiler* c, int line, const char* what) {
+    compile_error(c, line, "%s не поддерживается в mika run; соберите программу через mikac", what);
+}
+
+static void* grow_array(void* data, int* cap, int needed, size_t size) {
+    if (needed <= *cap) {
+        return data;
+    }
+    int capacity = *cap > 0 ? *cap : 16;
+    while (capacity < needed) {
+        capacity *= 2;
+    }
+    data = realloc(data, (size_t)capacity * size);
+    if (!data) {
+        perror("Ошибка выделения памяти");
+        exit(1);
+    }
+    *cap = capacity;
+    return data;
+}
+
+/* ---------- Имена ---------- */
+
+static unsigned name_hash(const char* text, size_t len) {
+    unsigned hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ (unsigned char)text[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static int name_equals(const char* name, const char* text, size_t len) {
+    return strncmp(name, text, len) == 0 && name[len] == '\0';
+}
+
+static int names_find(const NameTable* table, const char* text, size_t len) {
+    if (table->cap == 0) {
+        return -1;
+    }
+    unsigned mask = (unsigned)table->cap - 1;
+    for (unsigned i = name_hash(text, len) & mask; table->names[i]; i = (i + 1) & mask) {
+        if (name_equals(table->names[i], text, len)) {
+            return table->values[i];
+        }
+    }
+    return -1;
+}
+
+static void names_add(NameTable* table, const char* name, int value) {
+    if ((table->count + 1) * 2 > table->cap) {
+        NameTable grown = {NULL, NULL, 0, table->cap > 0 ? table->cap * 2 : 64};
+        grown.names = calloc((size_t)grown.cap, sizeof(*grown.names));
+        grown.values = calloc((size_t)grown.cap, sizeof(*grown.values));
+        if (!grown.names || !grown.values) {
+            perror("Ошибка выделения памяти");
+            exit(1);
+        }
+        for (int i = 0; i < table->cap; i++) {
+            if (table->names[i]) {
+                names_add(&grown, table->names[i], table->values[i]);
+            }
+        }
+        free(table->names);
+        free(table->values);
+        *table = grown;
+    }
+    unsigned mask = (unsigned)table->cap - 1;
+    unsigned i = name_hash(name, strlen(name)) & mask;
+    while (table->names[i]) {
+        i = (i + 1) & mask;
+    }
+    table->names[i] = name;
+    table->values[i] = value;
+    table->count++;
+}
+
+static const char* ident_text(const Node* node, size_t* len) {
+    *len = node->u.lit.len;
+    return node->u.lit.text;
+}
+
+/* ---------- Программа ---------- */
+
+void program_init(Program* program) {
+    memset(program, 0, sizeof(*program));
+    arena_init(&program->arena, ARENA_DEFAULT_CHUNK);
+    program->init = -1;
+    program->main = -1;
+}
+
+void program_free(Program* program) {
+    for (int i = 0; i < program->function_count; i++) {
+        free(program->functions[i].code);
+    }
+    free(program->functions);
+    free(program->constants);
+    free(program->formats);
+    arena_free(&program->arena);
+}
+
+int type_slots(ValueType type) {
+    switch (type) {
+        case TYPE_VOID: return 0;
+        case TYPE_STRING: return 3;
+        case TYPE_SLICE: case TYPE_BUILDER: return 2;
+        default: return 1;
+    }
+}
+
+const char* type_name(ValueType type) {
+    switch (type) {
+        case TYPE_VOID: return "void";
+        case TYPE_INT: return "int";
+        case TYPE_LONG: return "long long";
+        case TYPE_DOUBLE: return "double";
+        case TYPE_CHAR: return "char";
+        case TYPE_SHORT: return "short";
+        case TYPE_BOOL: return "bool";
+        case TYPE_FLOAT: return "float";
+        case TYPE_ARRAY: return "int*";
+        case TYPE_SLICE: return "slice";
+        case TYPE_STRING: return "string";
+        case TYPE_BUILDER: return "string_builder";
+        case TYPE_CSTRING: return "const char*";
+    }
+    return "?";
+}
+
+/* char, short и bool: в выражениях это int, сужаются только при записи. */
+static int is_narrow(ValueType type) {
+    return type == TYPE_CHAR || type == TYPE_SHORT || type == TYPE_BOOL;
+}
+
+static int is_integer(ValueType type) {
+    return type == TYPE_INT || type == TYPE_LONG || is_narrow(type);
+}
+
+static int is_floating(ValueType type) {
+    return type == TYPE_DOUBLE || type == TYPE_FLOAT;
+}
+
+static int is_numeric(ValueType type) {
+    return is_integer(type) || is_floating(type);
+}
+
+static ValueType promote(ValueType a, ValueType b) {
+    if (a == TYPE_DOUBLE || b == TYPE_DOUBLE) return TYPE_DOUBLE;
+    if (a == TYPE_FLOAT || b == TYPE_FLOAT) return TYPE_FLOAT;
+    if (a == TYPE_LONG || b == TYPE_LONG) return TYPE_LONG;
+    return TYPE_INT;
+}
+
+/* Значение уже лежит в ячейке как значение типа to: сужать нечего. */
+static int fits_as(ValueType from, ValueType to) {
+    return from == to || (is_integer(from) && (to == TYPE_INT || to == TYPE_LONG) && from != TYPE_LONG) ||
+           (from == TYPE_FLOAT && to == TYPE_DOUBLE);
+}
+
+static ValueType resolve_type(BytecodeCompiler* c, int line, const TypeRef* type, const Node* dims) {
+    const char* name = type->is_var ? "int" : type->name;
+
+    if (type->storage & STORAGE_EXTERN) {
+        unsupported(c, line, "extern");
+        return TYPE_INT;
+    }
+    if (dims) {
+        if (dims->next || type->pointers > 0 ||
+            (!type->is_var && strcmp(name, "int") != 0 && strcmp(name, "i32") != 0)) {
+            unsupported(c, line, "массив с такими элементами или размерностью");
+        }
+        return TYPE_ARRAY;
+    }
+    if (type->pointers == 1 && (type->is_var || strcmp(name, "int") == 0)) {
+        return TYPE_ARRAY;
+    }
+    if (type->pointers == 1 && strcmp(name, "char") == 0 && type->is_const) {
+        return TYPE_CSTRING;
+    }
+    if (type->pointers > 0) {
+        unsupported(c, line, "указатель этого типа");
+        return TYPE_INT;
+    }
+    if (strcmp(name, "slice") == 0 || strcmp(name, "MikaSlice") == 0) return TYPE_SLICE;
+    if (strcmp(name, "string") == 0 || strcmp(name, "MikaString") == 0) return TYPE_STRING;
+    if (strcmp(name, "string_builder") == 0 || strcmp(name, "MikaStringBuilder") == 0) return TYPE_BUILDER;
+    if (strcmp(name, "void") == 0) return TYPE_VOID;
+    if (strcmp(name, "i8") == 0 || strcmp(name, "int8_t") == 0) return TYPE_CHAR;
+    if (strcmp(name, "i16") == 0 || strcmp(name, "int16_t") == 0) return TYPE_SHORT;
+    if (strcmp(name, "i32") == 0) return TYPE_INT;
+    if (strcmp(name, "i64") == 0) return TYPE_LONG;
+    if (strcmp(name, "f32") == 0) return TYPE_FLOAT;
+    if (strcmp(name, "f64") == 0) return TYPE_DOUBLE;
+    if (strstr(name, "unsigned") || strncmp(name, "uint", 4) == 0 || strcmp(name, "size_t") == 0 ||
+        (name[0] == 'u' && name[1] >= '0' && name[1] <= '9')) {
+        unsupported(c, line, "беззнаковый тип");
+        return TYPE_INT;
+    }
+    if (strstr(name, "double")) return TYPE_DOUBLE;
+    if (strstr(name, "float")) return TYPE_FLOAT;
+    if (strstr(name, "long") || strcmp(name, "int64_t") == 0 || strcmp(name, "ssize_t") == 0) return TYPE_LONG;
+    if (strstr(name, "short")) return TYPE_SHORT;
+    if (strstr(name, "char")) return TYPE_CHAR;
+    if (strstr(name, "bool")) return TYPE_BOOL;
+    if (strstr(name, "int") || strstr(name, "signed")) {
+        return TYPE_INT;
+    }
+    compile_error(c, line, "тип '%s' не поддерживается в mika run; соберите программу через mikac", name);
+    return TYPE_INT;
+}
+
+/* ---------- Генерация ---------- */
+
+static Function* current(BytecodeCompiler* c) {
+    return &c->program->functions[c->function];
+}
+
+static int emit(BytecodeCompiler* c, Opcode op, int a, int b, int cc) {
+    Function* fn = current(c);
+    fn->code = grow_array(fn->code, &fn->code_cap, fn->code_len + 1, sizeof(Instr));
+    Instr* instr = &fn->code[fn->code_len];
+    instr->op = op;
+    instr->a = a;
+    instr->b = b;
+    instr->c = cc;
+    return fn->code_len++;
+}
+
+static int here(BytecodeCompiler* c) {
+    return current(c)->code_len;
+}
+
+static int alloc_regs(BytecodeCompiler* c, int count) {
+    int reg = c->top;
+    c->top += count;
+    if (c->top > current(c)->nregs) {
+        current(c)->nregs = c->top;
+    }
+    return reg;
+}
+
+static int dest(BytecodeCompiler* c, int target, ValueType type) {
+    return target >= 0 ? target : alloc_regs(c, type_slots(type));
+}
+
+static int add_constant(BytecodeCompiler* c, Slot value) {
+    Program* program = c->program;
+    program->constants = grow_array(program->constants, &program->constant_cap,
+                                    program->constant_count + 1, sizeof(Slot));
+    program->constants[program->constant_count] = value;
+    return program->constant_count++;
+}
+
+static void emit_move(BytecodeCompiler* c, int to, int from, ValueType type) {
+    int slots = type_slots(type);
+    if (to == from || slots == 0) {
+        return;
+    }
+    if (slots == 1) {
+        emit(c, OP_MOVE, to, from, 0);
+    } else {
+        emit(c, OP_COPY, to, from, slots);
+    }
+}
+
+static Operand operand(int reg, ValueType type) {
+    Operand op;
+    op.reg = reg;
+    op.type = type;
+    return op;
+}
+
+static Operand move_to(BytecodeCompiler* c, Operand value, int target) {
+    if (target >= 0 && value.reg != target) {
+        emit_move(c, target, value.reg, value.type);
+        value.reg = target;
+    }
+    return value;
+}
+
+/* Переходы без известной цели связаны в цепочку через поле смещения. */
+static int32_t* jump_offset(Instr* instr) {
+    switch (instr->op) {
+        case OP_JUMP: case OP_JZ: case OP_JNZ:
+            return &instr->b;
+        default:
+            return &instr->c;
+    }
+}
+
+static void emit_jump(BytecodeCompiler* c, Opcode op, int a, int b, int* list) {
+    int at = emit(c, op, a, b, 0);
+    *jump_offset(&current(c)->code[at]) = *list;
+    *list = at;
+}
+
+static void emit_jump_to(BytecodeCompiler* c, Opcode op, int a, int b, int target) {
+    int at = emit(c, op, a, b, 0);
+    *jump_offset(&current(c)->code[at]) = target - at;
+}
+
+static void patch(BytecodeCompiler* c, int list, int target) {
+    while (list >= 0) {
+        int32_t* offset = jump_offset(&current(c)->code[list]);
+        int next = *offset;
+        *offset = target - list;
+        list = next;
+    }
+}
+
+/* ---------- Литералы ---------- */
+
+static int hex_digit(char ch) {
+    if (ch >= '0' && ch <= '9') return ch - '0';
+    if (ch >= 'a' && ch <= 'f') return ch - 'a' + 10;
+    if (ch >= 'A' && ch <= 'F') return ch - 'A' + 10;
+    return -1;
+}
+
+static int read_escape(const char** cursor, const char* end) {
+    const char* p = *cursor;
+    int value = 0;
+
+    switch (*p) {
+        case 'n': value = '\n'; p++; break;
+        case 't': value = '\t'; p++; break;
+        case 'r': value = '\r'; p++; break;
+        case 'a': value = '\a'; p++; break;
+        case 'b': value = '\b'; p++; break;
+        case 'f': value = '\f'; p++; break;
+        case 'v': value = '\v'; p++; break;
+        case 'x':
+            p++;
+            while (p < end && hex_digit(*p) >= 0) {
+                value = value * 16 + hex_digit(*p++);
+            }
+            break;
+        default:
+            if (*p >= '0' && *p <= '7') {
+                for (int i = 0; i < 3 && p < end && *p >= '0' && *p <= '7'; i++) {
+                    value = value * 8 + (*p++ - '0');
+                }
+            } else {
+                value = (unsigned char)*p++;
+            }
+            break;
+    }
+    *cursor = p;
+    return value & 0xff;
+}
+
+/* Склеивает соседние литералы "a" "b" и раскрывает escape-последовательности. */
+static char* unescape_string(BytecodeCompiler* c, const Node* node, size_t* out_len) {
+    const char* p = node->u.lit.text;
+    const char* end = p + node->u.lit.len;
+    char* out = arena_alloc(&c->program->arena, node->u.lit.len + 1);
+    size_t len = 0;
+
+    while (p < end) {
+        if (*p == '/' && p + 1 < end && p[1] == '/') {
+            while (p < end && *p != '\n') p++;
+            continue;
+        }
+        if (*p == '/' && p + 1 < end && p[1] == '*') {
+            p += 2;
+            while (p + 1 < end && !(p[0] == '*' && p[1] == '/')) p++;
+            p += 2;
+            continue;
+        }
+        if (*p != '"') {
+            p++;
+            continue;
+        }
+        p++;
+        while (p < end && *p != '"') {
+            if (*p == '\\' && p + 1 < end) {
+                p++;
+                out[len++] = (char)read_escape(&p, end);
+            } else {
+                out[len++] = *p++;
+            }
+        }
+        p++;
+    }
+    out[len] = '\0';
+    *out_len = len;
+    return out;
+}
+
+static int char_value(const Node* node) {
+    const char* p = node->u.lit.text + 1;
+    const char* end = node->u.lit.text + node->u.lit.len - 1;
+    int count = 0;
+    unsigned value = 0;
+
+    while (p < end) {
+        int byte;
+        if (*p == '\\' && p + 1 < end) {
+            p++;
+            byte = read_escape(&p, end);
+        } else {
+            byte = (unsigned char)*p++;
+        }
+        value = (value << 8) | (unsigned)byte;
+        count++;
+    }
+    return count == 1 ? (signed char)value : (int)value;
+}
+
+/* Суффикс L или значение за пределами int делают литерал long long. */
+static ValueType int_literal_type(const Node* node) {
+    int is_long = node->u.lit.value > INT_MAX;
+    for (size_t i = 0; i < node->u.lit.len; i++) {
+        is_long |= node->u.lit.text[i] == 'l' || node->u.lit.text[i] == 'L';
+    }
+    return is_long ? TYPE_LONG : TYPE_INT;
+}
+
+static int constant_value(const Node* node, long long* value) {
+    if (node->kind == NODE_UNARY && (node->u.unary.op == TOK_MINUS || node->u.unary.op == TOK_PLUS)) {
+        if (!constant_value(node->u.unary.operand, value)) {
+            return 0;
+        }
+        if (node->u.unary.op == TOK_MINUS) {
+            *value = -*value;
+        }
+        return *value >= INT_MIN && *value <= INT_MAX;
+    }
+    if (node->kind == NODE_INT) {
+        if (int_literal_type(node) != TYPE_INT) {
+            return 0;
+        }
+        *value = node->u.lit.value;
+        return 1;
+    }
+    if (node->kind == NODE_CHAR) {
+        *value = char_value(node);
+        return 1;
+    }
+    if (node->kind == NODE_BOOL) {
+        *value = node->u.lit.value;
+        return 1;
+    }
+    return 0;
+}
+
+/* ---------- Области видимости ---------- */
+
+static int find_local(BytecodeCompiler* c, const Node* ident) {
+    for (int i = c->local_count - 1; i >= 0; i--) {
+        if (c->locals[i].name && node_is_ident(ident, c->locals[i].name)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static const Global* find_global(BytecodeCompiler* c, const Node* ident) {
+    size_t len;
+    const char* text = ident_text(ident, &len);
+    int index = names_find(&c->global_names, text, len);
+    return index < 0 ? NULL : &c->globals[index];
+}
+
+static void declare_local(BytecodeCompiler* c, int line, const char* name, ValueType type, int reg) {
+    if (c->local_count >= BYTECODE_MAX_LOCALS) {
+        compile_error(c, line, "слишком много локальных переменных");
+        return;
+    }
+    c->locals[c->local_count].name = name;
+    c->locals[c->local_count].type = type;
+    c->locals[c->local_count].reg = reg;
+    c->local_count++;
+}
+
+static const Builtin* find_builtin(const Node* callee) {
+    if (callee->kind != NODE_IDENT) {
+        return NULL;
+    }
+    for (size_t i = 0; i < sizeof(builtins) / sizeof(builtins[0]); i++) {
+        if (node_is_ident(callee, builtins[i].name)) {
+            return &builtins[i];
+        }
+    }
+    return NULL;
+}
+
+static int new_function(BytecodeCompiler* c, const char* name, size_t len, int line) {
+    Program* program = c->program;
+    program->functions = grow_array(program->functions, &program->function_cap,
+                                    program->function_count + 1, sizeof(Function));
+    Function* fn = &program->functions[program->function_count];
+    memset(fn, 0, sizeof(*fn));
+    fn->name = arena_strndup(&program->arena, name, len);
+    fn->line = line;
+    fn->ret = TYPE_INT;
+    fn->param_count = -1;
+    names_add(&c->function_names, fn->name, program->function_count);
+    return program->function_count++;
+}
+
+static int function_index(BytecodeCompiler* c, const Node* ident) {
+    size_t len;
+    const char* text = ident_text(ident, &len);
+    int index = names_find(&c->function_names, text, len);
+    return index >= 0 ? index : new_function(c, text, len, ident->line);
+}
+
+/* ---------- Типы выражений ---------- */
+
+static ValueType infer_type(BytecodeCompiler* c, const Node* node);
+
+/* Цепочка a + b + c ... идёт сверху вниз циклом: type копит типы правых
+   операндов пройденных звеньев, запятая на вершине отдаёт тип своего
+   правого операнда как есть. */
+static ValueType infer_chain_type(BytecodeCompiler* c, const Node* node) {
+    ValueType type = TYPE_INT;
+    int top = 1;
+
+    for (; node->kind == NODE_BINARY; node = node->u.binary.lhs, top = 0) {
+        switch (node->u.binary.op) {
+            case TOK_COMMA:
+                return top ? infer_type(c, node->u.binary.rhs) : promote(type, infer_type(c, node->u.binary.rhs));
+            case TOK_ANDAND: case TOK_OROR: case TOK_EQ: case TOK_NE:
+            case TOK_LT: case TOK_LE: case TOK_GT: case TOK_GE:
+                return promote(type, TYPE_INT);
+            case TOK_SHL: case TOK_SHR:
+                break;
+            default:
+                type = promote(type, infer_type(c, node->u.binary.rhs));
+                break;
+        }
+    }
+    return promote(type, infer_type(c, node));
+}
+
+static ValueType infer_type(BytecodeCompiler* c, const Node* node) {
+    switch (node->kind) {
+        case NODE_INT:
+            return int_literal_type(node);
+        case NODE_FLOAT:
+            return TYPE_DOUBLE;
+        case NODE_CHAR: case NODE_BOOL:
+            return TYPE_INT;
+        case NODE_STRING:
+            return TYPE_CSTRING;
+        case NODE_IDENT: {
+            int local = find_local(c, node);
+            if (local >= 0) return c->locals[local].type;
+            const Global* global = find_global(c, node);
+            if (global) return global->type;
+            return node_is_ident(node, "NULL") ? TYPE_ARRAY : TYPE_INT;
+        }
+        case NODE_UNARY:
+            if (node->u.unary.op == TOK_BANG) return TYPE_INT;
+            if (node->u.unary.op == TOK_INC || node->u.unary.op == TOK_DEC) {
+                return infer_type(c, node->u.unary.operand);
+            }
+            return promote(infer_type(c, node->u.unary.operand), TYPE_INT);
+        case NODE_POSTFIX:
+            return infer_type(c, node->u.unary.operand);
+        case NODE_BINARY:
+            return infer_chain_type(c, node);
+        case NODE_ASSIGN:
+            return infer_type(c, node->u.binary.lhs);
+        case NODE_TERNARY: {
+            ValueType then_type = infer_type(c, node->u.cond.then_branch);
+            ValueType else_type = infer_type(c, node->u.cond.else_branch);
+            if (is_numeric(then_type) && is_numeric(else_type)) {
+                return promote(then_type, else_type);
+            }
+            return then_type == TYPE_CSTRING && else_type == TYPE_STRING ? TYPE_STRING : then_type;
+        }
+        case NODE_CALL: {
+            const Node* callee = node->u.call.callee;
+            const Builtin* builtin = find_builtin(callee);
+            if (builtin) return builtin->ret;
+            if (callee->kind == NODE_IDENT) {
+                size_t len;
+                const char* text = ident_text(callee, &len);
+                int index = names_find(&c->function_names, text, len);
+                if (index >= 0 && c->program->functions[index].param_count >= 0) {
+                    return c->program->functions[index].ret;
+                }
+            }
+            return TYPE_INT;
+        }
+        case NODE_MEMBER:
+            return strcmp(node->u.member.name, "data") == 0 ? TYPE_ARRAY : TYPE_INT;
+        case NODE_CAST:
+            return resolve_type(c, node->line, &node->u.cast.type, NULL);
+        case NODE_SIZEOF:
+            return TYPE_LONG;
+        default:
+            return TYPE_INT;
+    }
+}
+
+/* ---------- Выражения ---------- */
+
+static Operand expr(BytecodeCompiler* c, const Node* node, int target);
+static void statement(BytecodeCompiler* c, const Node* node);
+
+static Operand error_operand(BytecodeCompiler* c, int target) {
+    return operand(target >= 0 ? target : alloc_regs(c, 1), TYPE_INT);
+}
+
+static Operand string_from_literal(BytecodeCompiler* c, const Node* node, int target) {
+    size_t len;
+    Slot text;
+    text.s = unescape_string(c, node, &len);
+    int dst = dest(c, target, TYPE_STRING);
+    emit(c, OP_STRLIT, dst, add_constant(c, text), (int)len);
+    return operand(dst, TYPE_STRING);
+}
+
+/* Неявное преобразование как в C; строковый литерал становится
+   MikaString так же, как MIKA_STRING_LITERAL в трансляторе. */
+static Operand coerce(BytecodeCompiler* c, int line, Operand value, ValueType type, int target) {
+    if (fits_as(value.type, type)) {
+        value = move_to(c, value, target);
+        value.type = type;
+        return value;
+    }
+
+    int dst;
+    switch (type) {
+        case TYPE_INT:
+            if (value.type == TYPE_LONG || is_floating(value.type)) {
+                dst = dest(c, target, type);
+                emit(c, value.type == TYPE_LONG ? OP_TRUNC : OP_D2I, dst, value.reg, 0);
+                return operand(dst, type);
+            }
+            break;
+        case TYPE_LONG:
+            if (is_floating(value.type)) {
+                dst = dest(c, target, type);
+                emit(c, OP_D2L, dst, value.reg, 0);
+                return operand(dst, type);
+            }
+            break;
+        case TYPE_DOUBLE:
+            if (is_integer(value.type)) {
+                dst = dest(c, target, type);
+                emit(c, OP_I2D, dst, value.reg, 0);
+                return operand(dst, type);
+            }
+            break;
+        case TYPE_CHAR: case TYPE_SHORT: case TYPE_BOOL:
+            if (type == TYPE_BOOL && is_floating(value.type)) {
+                dst = dest(c, target, type);
+                emit(c, OP_D2B, dst, value.reg, 0);
+                return operand(dst, type);
+            }
+            if (is_numeric(value.type)) {
+                if (is_floating(value.type)) {
+                    value = coerce(c, line, value, TYPE_INT, -1);
+                }
+                dst = dest(c, target, type);
+                emit(c, type == TYPE_CHAR ? OP_I2C : type == TYPE_SHORT ? OP_I2S : OP_I2B, dst, value.reg, 0);
+                return operand(dst, type);
+            }
+            break;
+        case TYPE_FLOAT:
+            if (is_numeric(value.type)) {
+                dst = dest(c, target, type);
+                emit(c, is_integer(value.type) ? OP_I2F : OP_D2F, dst, value.reg, 0);
+                return operand(dst, type);
+            }
+            break;
+        case TYPE_SLICE:
+            if (value.type == TYPE_ARRAY) {
+                dst = dest(c, target, type);
+                emit(c, OP_VIEW, dst, value.reg, 0);
+                return operand(dst, type);
+            }
+            break;
+        case TYPE_STRING:
+            if (value.type == TYPE_CSTRING) {
+                dst = dest(c, target, type);
+                emit(c, OP_NATIVE, dst, NATIVE_STRING_FROM, value.reg);
+                return operand(dst, type);
+            }
+            break;
+        default:
+            break;
+    }
+    compile_error(c, line, "нельзя преобразовать %s в %s", type_name(value.type), type_name(type));
+    return operand(value.reg, type);
+}
+
+static Operand expr_as(BytecodeCompiler* c, const Node* node, ValueType type, int target) {
+    if (type == TYPE_STRING && node->kind == NODE_STRING) {
+        return string_from_literal(c, node, target);
+    }
+    return coerce(c, node->line, expr(c, node, target), type, target);
+}
+
+/* Как в трансляторе: новую строку дают только вызовы, а переменная, срез
+   или строка C лишь заимствуют буфер и при записи копируются. */
+static int borrows_string(BytecodeCompiler* c, const Node* value) {
+    if (value->kind == NODE_TERNARY) {
+        return borrows_string(c, value->u.cond.then_branch) || borrows_string(c, value->u.cond.else_branch);
+    }
+    if (value->kind == NODE_STRING) {
+        return 0;
+    }
+    return value->kind != NODE_CALL || node_is_ident(value->u.call.callee, "substring") ||
+           infer_type(c, value) != TYPE_STRING;
+}
+
+static int resolve_lvalue(BytecodeCompiler* c, const Node* node, Lvalue* lv) {
+    if (node->kind == NODE_IDENT) {
+        int local = find_local(c, node);
+        if (local >= 0) {
+            lv->kind = LVALUE_LOCAL;
+            lv->type = c->locals[local].type;
+            lv->reg = c->locals[local].reg;
+            return 1;
+        }
+        const Global* global = find_global(c, node);
+        if (global) {
+            lv->kind = LVALUE_GLOBAL;
+            lv->type = global->type;
+            lv->reg = global->slot;
+            return 1;
+        }
+        compile_error(c, node->line, "неизвестное имя '%.*s'", (int)node->u.lit.len, node->u.lit.text);
+        return 0;
+    }
+    if (node->kind == NODE_INDEX) {
+        Operand base = expr(c, node->u.index.base, -1);
+        if (base.type != TYPE_ARRAY && base.type != TYPE_SLICE) {
+            compile_error(c, node->line, "индексировать можно только массив или срез, а не %s", type_name(base.type));
+            return 0;
+        }
+        Operand index = expr(c, node->u.index.index, -1);
+        if (!is_integer(index.type)) {
+            compile_error(c, node->line, "индекс должен быть целым числом");
+            return 0;
+        }
+        lv->kind = LVALUE_ELEMENT;
+        lv->type = TYPE_INT;
+        lv->base = base.reg;
+        lv->index = index.reg;
+        return 1;
+    }
+    compile_error(c, node->line, "выражение нельзя изменить присваиванием");
+    return 0;
+}
+
+static Operand load_lvalue(BytecodeCompiler* c, const Lvalue* lv, int target) {
+    int dst;
+    switch (lv->kind) {
+        case LVALUE_LOCAL:
+            return move_to(c, operand(lv->reg, lv->type), target);
+        case LVALUE_GLOBAL:
+            dst = dest(c, target, lv->type);
+            emit(c, OP_GETG, dst, lv->reg, type_slots(lv->type));
+            return operand(dst, lv->type);
+        case LVALUE_ELEMENT:
+            dst = dest(c, target, TYPE_INT);
+            emit(c, OP_LOADX, dst, lv->base, lv->index);
+            return operand(dst, TYPE_INT);
+    }
+    return operand(0, TYPE_INT);
+}
+
+static void store_lvalue(BytecodeCompiler* c, const Lvalue* lv, Operand value) {
+    switch (lv->kind) {
+        case LVALUE_LOCAL:
+            emit_move(c, lv->reg, value.reg, lv->type);
+            break;
+        case LVALUE_GLOBAL:
+            emit(c, OP_SETG, lv->reg, value.reg, type_slots(lv->type));
+            break;
+        case LVALUE_ELEMENT:
+            emit(c, OP_STOREX, lv->base, lv->index, value.reg);
+            break;
+    }
+}
+
+static Operand arith(BytecodeCompiler* c, int line, TokenKind op, Operand lhs, Operand rhs, int target) {
+    static const struct { TokenKind op; Opcode ops[3]; } table[] = {
+        {TOK_PLUS, {OP_ADD, OP_LADD, OP_DADD}}, {TOK_MINUS, {OP_SUB, OP_LSUB, OP_DSUB}},
+        {TOK_STAR, {OP_MUL, OP_LMUL, OP_DMUL}}, {TOK_SLASH, {OP_DIV, OP_LDIV, OP_DDIV}},
+        {TOK_PERCENT, {OP_MOD, OP_LMOD, OP_COUNT}}, {TOK_AMP, {OP_AND, OP_AND, OP_COUNT}},
+        {TOK_PIPE, {OP_OR, OP_OR, OP_COUNT}}, {TOK_CARET, {OP_XOR, OP_XOR, OP_COUNT}},
+        {TOK_SHL, {OP_SHL, OP_LSHL, OP_COUNT}}, {TOK_SHR, {OP_SHR, OP_LSHR, OP_COUNT}},
+    };
+
+    if (!is_numeric(lhs.type) || !is_numeric(rhs.type)) {
+        compile_error(c, line, "арифметика над %s и %s не поддерживается", type_name(lhs.type), type_name(rhs.type));
+        return error_operand(c, target);
+    }
+    int shift = op == TOK_SHL || op == TOK_SHR;
+    ValueType type = shift ? promote(lhs.type, TYPE_INT) : promote(lhs.type, rhs.type);
+    for (size_t i = 0; i < sizeof(table) / sizeof(table[0]); i++) {
+        if (table[i].op != op) {
+            continue;
+        }
+        Opcode code = table[i].ops[type == TYPE_INT ? 0 : type == TYPE_LONG ? 1 : 2];
+        if (code == OP_COUNT || (shift && !is_integer(rhs.type))) {
+            compile_error(c, line, "операция '%s' требует целых чисел", token_kind_name(op));
+            return error_operand(c, target);
+        }
+        if (is_floating(type)) {
+            lhs = coerce(c, line, lhs, type, -1);
+            rhs = coerce(c, line, rhs, type, -1);
+        }
+        int dst = dest(c, target, type);
+        emit(c, code, dst, lhs.reg, rhs.reg);
+        if (type == TYPE_FLOAT) {
+            /* операция над float в double, затем округление: для + - * /
+               результат тот же, что у арифметики float */
+            emit(c, OP_D2F, dst, dst, 0);
+        }
+        return operand(dst, type);
+    }
+    compile_error(c, line, "неизвестная операция '%s'", token_kind_name(op));
+    return error_operand(c, target);
+}
+
+static TokenKind compound_op(TokenKind op) {
+    switch (op) {
+        case TOK_PLUS_ASSIGN: return TOK_PLUS;
+        case TOK_MINUS_ASSIGN: return TOK_MINUS;
+        case TOK_STAR_ASSIGN: return TOK_STAR;
+        case TOK_SLASH_ASSIGN: return TOK_SLASH;
+        case TOK_PERCENT_ASSIGN: return TOK_PERCENT;
+        case TOK_AMP_ASSIGN: return TOK_AMP;
+        case TOK_PIPE_ASSIGN: return TOK_PIPE;
+        case TOK_CARET_ASSIGN: return TOK_CARET;
+        case TOK_SHL_ASSIGN: return TOK_SHL;
+        case TOK_SHR_ASSIGN: return TOK_SHR;
+        default: return TOK_ASSIGN;
+    }
+}
+
+/* value + delta в dst: для int есть ADDK, остальным нужна константа. */
+static void add_constant_to(BytecodeCompiler* c, int dst, int src, ValueType type, int delta) {
+    if (type == TYPE_INT || is_narrow(type)) {
+        emit(c, OP_ADDK, dst, src, delta);
+        if (is_narrow(type)) {
+            coerce(c, 0, operand(dst, TYPE_INT), type, dst);
+        }
+        return;
+    }
+    int tmp = alloc_regs(c, 1);
+    if (is_floating(type)) {
+        Slot value;
+        value.d = delta;
+        emit(c, OP_LOADK, tmp, add_constant(c, value), 0);
+        emit(c, OP_DADD, dst, src, tmp);
+        if (type == TYPE_FLOAT) {
+            emit(c, OP_D2F, dst, dst, 0);
+        }
+    } else {
+        emit(c, OP_LOADI, tmp, delta, 0);
+        emit(c, OP_LADD, dst, src, tmp);
+    }
+}
+
+static Operand compile_assign(BytecodeCompiler* c, const Node* node, int target) {
+    Lvalue lv;
+    TokenKind op = compound_op(node->u.binary.op);
+    long long constant;
+
+    if (!resolve_lvalue(c, node->u.binary.lhs, &lv)) {
+        return error_operand(c, target);
+    }
+    if (op == TOK_ASSIGN && lv.type == TYPE_STRING && borrows_string(c, node->u.binary.rhs)) {
+        int slots = type_slots(TYPE_STRING);
+        int base = alloc_regs(c, 2 * slots);
+        load_lvalue(c, &lv, base);
+        expr_as(c, node->u.binary.rhs, TYPE_STRING, base + slots);
+        emit(c, OP_NATIVE, base, NATIVE_STRING_ASSIGN, base);
+        store_lvalue(c, &lv, operand(base, TYPE_STRING));
+        return move_to(c, operand(base, TYPE_STRING), target);
+    }
+    if (op == TOK_ASSIGN) {
+        Operand value;
+        if (lv.kind == LVALUE_LOCAL) {
+            value = expr_as(c, node->u.binary.rhs, lv.type, lv.reg);
+        } else {
+            value = expr_as(c, node->u.binary.rhs, lv.type, -1);
+            store_lvalue(c, &lv, value);
+        }
+        return move_to(c, value, target);
+    }
+
+    if (!is_numeric(lv.type)) {
+        compile_error(c, node->line, "составное присваивание для %s не поддерживается", type_name(lv.type));
+        return error_operand(c, target);
+    }
+    if (lv.kind == LVALUE_LOCAL && lv.type == TYPE_INT && (op == TOK_PLUS || op == TOK_MINUS) &&
+        constant_value(node->u.binary.rhs, &constant) && constant > INT_MIN) {
+        emit(c, OP_ADDK, lv.reg, lv.reg, (int)(op == TOK_PLUS ? constant : -constant));
+        return move_to(c, operand(lv.reg, lv.type), target);
+    }
+    Operand current_value = load_lvalue(c, &lv, -1);
+    Operand rhs = expr(c, node->u.binary.rhs, -1);
+    ValueType type = op == TOK_SHL || op == TOK_SHR ? promote(lv.type, TYPE_INT) : promote(lv.type, rhs.type);
+    int dst = lv.kind == LVALUE_LOCAL && type == lv.type ? lv.reg : -1;
+    Operand result = arith(c, node->line, op, current_value, rhs, dst);
+    result = coerce(c, node->line, result, lv.type, lv.kind == LVALUE_LOCAL ? lv.reg : -1);
+    if (lv.kind != LVALUE_LOCAL) {
+        store_lvalue(c, &lv, result);
+    }
+    return move_to(c, result, target);
+}
+
+static Operand compile_increment(BytecodeCompiler* c, const Node* node, int postfix, int target, int want) {
+    Lvalue lv;
+    int delta = node->u.unary.op == TOK_INC ? 1 : -1;
+
+    if (!resolve_lvalue(c, node->u.unary.operand, &lv)) {
+        return error_operand(c, target);
+    }
+    if (!is_numeric(lv.type)) {
+        compile_error(c, node->line, "++ и -- для %s не поддерживаются", type_name(lv.type));
+        return error_operand(c, target);
+    }
+    if (lv.kind == LVALUE_LOCAL) {
+        Operand old = operand(lv.reg, lv.type);
+        if (postfix && want) {
+            old = move_to(c, old, dest(c, target, lv.type));
+        }
+        add_constant_to(c, lv.reg, lv.reg, lv.type, delta);
+        return postfix ? old : move_to(c, operand(lv.reg, lv.type), target);
+    }
+    Operand value = load_lvalue(c, &lv, postfix ? -1 : target);
+    int updated = postfix ? alloc_regs(c, 1) : value.reg;
+    add_constant_to(c, updated, value.reg, lv.type, delta);
+    store_lvalue(c, &lv, operand(updated, lv.type));
+    return move_to(c, postfix ? value : operand(updated, lv.type), target);
+}
+
+static void jump_if(BytecodeCompiler* c, const Node* node, int sense, int* list);
+
+static int is_comparison(TokenKind op) {
+    return op == TOK_EQ || op == TOK_NE || op == TOK_LT || op == TOK_LE || op == TOK_GT || op == TOK_GE;
+}
+
+static Operand compile_comparison(BytecodeCompiler* c, const Node* node, Operand lhs, int mark, int target) {
+    TokenKind op = node->u.binary.op;
+    Operand rhs = expr(c, node->u.binary.rhs, -1);
+    int swap = op == TOK_GT || op == TOK_GE;
+    Opcode code;
+
+    if (is_floating(lhs.type) || is_floating(rhs.type)) {
+        if (!is_numeric(lhs.type) || !is_numeric(rhs.type)) {
+            compile_error(c, node->line, "нельзя сравнивать %s и %s", type_name(lhs.type), type_name(rhs.type));
+            return error_operand(c, target);
+        }
+        ValueType type = promote(lhs.type, rhs.type);
+        lhs = coerce(c, node->line, lhs, type, -1);
+        rhs = coerce(c, node->line, rhs, type, -1);
+        code = op == TOK_EQ ? OP_DEQ : op == TOK_NE ? OP_DNE : op == TOK_LT || op == TOK_GT ? OP_DLT : OP_DLE;
+    } else {
+        int pointers = lhs.type == TYPE_ARRAY || lhs.type == TYPE_CSTRING;
+        if ((!is_integer(lhs.type) && !pointers) || (is_integer(lhs.type) != is_integer(rhs.type) && !pointers) ||
+            (pointers && rhs.type != lhs.type)) {
+            compile_error(c, node->line, "нельзя сравнивать %s и %s", type_name(lhs.type), type_name(rhs.type));
+            return error_operand(c, target);
+        }
+        code = op == TOK_EQ ? OP_EQ : op == TOK_NE ? OP_NE : op == TOK_LT || op == TOK_GT ? OP_LT : OP_LE;
+    }
+    c->top = mark;
+    int dst = dest(c, target, TYPE_INT);
+    emit(c, code, dst, swap ? rhs.reg : lhs.reg, swap ? lhs.reg : rhs.reg);
+    return operand(dst, TYPE_INT);
+}
+
+/* && и || как значение: переходы и загрузка 0 или 1. */
+static Operand compile_logical(BytecodeCompiler* c, const Node* node, int target) {
+    int dst = dest(c, target, TYPE_INT);
+    int falses = -1;
+    int done = -1;
+    jump_if(c, node, 0, &falses);
+    emit(c, OP_LOADI, dst, 1, 0);
+    emit_jump(c, OP_JUMP, 0, 0, &done);
+    patch(c, falses, here(c));
+    emit(c, OP_LOADI, dst, 0, 0);
+    patch(c, done, here(c));
+    return operand(dst, TYPE_INT);
+}
+
+/* Звено цепочки, левый операнд которого уже вычислен; mark — вершина
+   регистров до левого операнда всей цепочки. */
+static Operand compile_link(BytecodeCompiler* c, const Node* node, Operand lhs, int mark, int target) {
+    TokenKind op = node->u.binary.op;
+    long long constant;
+
+    if (op == TOK_COMMA) {
+        c->top = mark;
+        return expr(c, node->u.binary.rhs, target);
+    }
+    if (is_comparison(op)) {
+        return compile_comparison(c, node, lhs, mark, target);
+    }
+    if ((op == TOK_PLUS || op == TOK_MINUS) && lhs.type == TYPE_INT &&
+        constant_value(node->u.binary.rhs, &constant) && constant > INT_MIN) {
+        c->top = mark;
+        int dst = dest(c, target, TYPE_INT);
+        emit(c, OP_ADDK, dst, lhs.reg, (int)(op == TOK_PLUS ? constant : -constant));
+        return operand(dst, TYPE_INT);
+    }
+    Operand rhs = expr(c, node->u.binary.rhs, -1);
+    if (target < 0 && is_numeric(lhs.type) && is_numeric(rhs.type) && lhs.type == rhs.type) {
+        c->top = mark;
+    }
+    return arith(c, node->line, op, lhs, rhs, target);
+}
+
+/* a + b + c ... компилируется циклом по звеньям: рекурсия по левому
+   операнду переполняла стек на длинных выражениях. */
+static Operand compile_binary(BytecodeCompiler* c, const Node* node, int target) {
+    BinaryChain chain;
+    int mark = c->top;
+
+    if (node->u.binary.op == TOK_ANDAND || node->u.binary.op == TOK_OROR) {
+        return compile_logical(c, node, target);
+    }
+    if (!binary_chain_init(&chain, node)) {
+        perror("Ошибка выделения памяти");
+        exit(1);
+    }
+    Operand value = expr(c, binary_chain_first(&chain), -1);
+    for (size_t i = chain.count; i > 0; i--) {
+        value = compile_link(c, chain.links[i - 1], value, mark, i == 1 ? target : -1);
+    }
+    binary_chain_free(&chain);
+    return value;
+}
+
+static Operand compile_unary(BytecodeCompiler* c, const Node* node, int target) {
+    TokenKind op = node->u.unary.op;
+
+    if (op == TOK_INC || op == TOK_DEC) {
+        return compile_increment(c, node, 0, target, 1);
+    }
+    if (op == TOK_STAR || op == TOK_AMP) {
+        unsupported(c, node->line, op == TOK_STAR ? "разыменование указателя" : "взятие адреса");
+        return error_operand(c, target);
+    }
+
+    int mark = c->top;
+    Operand value = expr(c, node->u.unary.operand, -1);
+    if (op == TOK_BANG) {
+        c->top = mark;
+        int dst = dest(c, target, TYPE_INT);
+        if (is_floating(value.type)) {
+            Slot zero;
+            zero.d = 0.0;
+            int tmp = alloc_regs(c, 1);
+            emit(c, OP_LOADK, tmp, add_constant(c, zero), 0);
+            emit(c, OP_DEQ, dst, value.reg, tmp);
+        } else if (type_slots(value.type) == 1) {
+            emit(c, OP_LNOT, dst, value.reg, 0);
+        } else {
+            compile_error(c, node->line, "оператор ! не применим к %s", type_name(value.type));
+        }
+        return operand(dst, TYPE_INT);
+    }
+    if (!is_numeric(value.type) || (op == TOK_TILDE && is_floating(value.type))) {
+        compile_error(c, node->line, "оператор '%s' не применим к %s", token_kind_name(op), type_name(value.type));
+        return error_operand(c, target);
+    }
+    value.type = promote(value.type, TYPE_INT);
+    if (op == TOK_PLUS) {
+        return move_to(c, value, target);
+    }
+    c->top = mark;
+    int dst = dest(c, target, value.type);
+    if (op == TOK_TILDE) {
+        emit(c, OP_NOT, dst, value.reg, 0);
+    } else {
+        emit(c, value.type == TYPE_INT ? OP_NEG : value.type == TYPE_LONG ? OP_LNEG : OP_DNEG, dst, value.reg, 0);
+    }
+    return operand(dst, value.type);
+}
+
+static Operand compile_ternary(BytecodeCompiler* c, const Node* node, int target) {
+    ValueType type = infer_type(c, node);
+    int dst = dest(c, target, type);
+    int mark = c->top;
+    int falses = -1;
+    int done = -1;
+
+    jump_if(c, node->u.cond.cond, 0, &falses);
+    expr_as(c, node->u.cond.then_branch, type, dst);
+    c->top = mark;
+    emit_jump(c, OP_JUMP, 0, 0, &done);
+    patch(c, falses, here(c));
+    expr_as(c, node->u.cond.else_branch, type, dst);
+    c->top = mark;
+    patch(c, done, here(c));
+    return operand(dst, type);
+}
+
+/* Аргументы подряд с регистра base, каждый в своём типе. */
+static int compile_args(BytecodeCompiler* c, const Node* args, const ValueType* types, int count) {
+    int slots = 0;
+    for (int i = 0; i < count; i++) {
+        slots += type_slots(types[i]);
+    }
+    int base = alloc_regs(c, slots);
+    int offset = 0;
+    for (int i = 0; i < count; i++, args = args->next) {
+        int mark = c->top;
+        expr_as(c, args, types[i], base + offset);
+        c->top = mark;
+        offset += type_slots(types[i]);
+    }
+    return base;
+}
+
+static int check_arity(BytecodeCompiler* c, const Node* call, const char* name, int arity) {
+    if (node_count(call->u.call.args) != arity) {
+        compile_error(c, call->line, "%s() ожидает аргументов: %d", name, arity);
+        return 0;
+    }
+    return 1;
+}
+
+static Operand emit_native(BytecodeCompiler* c, NativeId native, ValueType ret, const Node* args,
+                           const ValueType* types, int count, int target) {
+    int mark = c->top;
+    int base = compile_args(c, args, types, count);
+    c->top = mark;
+    int dst = ret == TYPE_VOID ? mark : dest(c, target, ret);
+    emit(c, OP_NATIVE, dst, native, base);
+    return operand(dst, ret);
+}
+
+/* Первый аргумент передаётся по адресу: функция меняет его копию среди
+   аргументов, после вызова копия возвращается на место. */
+static Operand emit_update(BytecodeCompiler* c, const Node* call, NativeId native, ValueType ret,
+                           const ValueType* types, int count, int target) {
+    Lvalue lv;
+    const Node* args = call->u.call.args;
+
+    if (!resolve_lvalue(c, args, &lv)) {
+        return error_operand(c, target);
+    }
+    if (lv.type != types[0]) {
+        compile_error(c, call->line, "ожидался аргумент типа %s, а не %s", type_name(types[0]), type_name(lv.type));
+        return error_operand(c, target);
+    }
+    int base = alloc_regs(c, type_slots(types[0]));
+    load_lvalue(c, &lv, base);
+    compile_args(c, args->next, types + 1, count - 1);
+    int dst = ret == TYPE_VOID ? base : dest(c, target, ret);
+    emit(c, OP_NATIVE, dst, native, base);
+    store_lvalue(c, &lv, operand(base, lv.type));
+    return operand(dst, ret);
+}
+
+static const char* print_conversions = "diuoxXfFeEgGaAcsSp";
+
+static Operand compile_print(BytecodeCompiler* c, const Node* call, int target) {
+    const Node* format = call->u.call.args;
+    Program* program = c->program;
+
+    if (!format || format->kind != NODE_STRING) {
+        compile_error(c, call->line, "print() ожидает строковый литерал формата первым аргументом");
+        return error_operand(c, target);
+    }
+
+    ValueType types[BYTECODE_MAX_ARGS];
+    int offsets[BYTECODE_MAX_ARGS];
+    int count = 0;
+    int slots = 0;
+    for (const Node* arg = format->next; arg; arg = arg->next) {
+        if (count == BYTECODE_MAX_ARGS) {
+            compile_error(c, call->line, "слишком много аргументов print()");
+            return error_operand(c, target);
+        }
+        /* как в printf: char, short и bool уходят как int, float — как double */
+        types[count] = infer_type(c, arg);
+        if (is_narrow(types[count])) types[count] = TYPE_INT;
+        if (types[count] == TYPE_FLOAT) types[count] = TYPE_DOUBLE;
+        if (types[count] == TYPE_VOID || types[count] == TYPE_SLICE || types[count] == TYPE_BUILDER) {
+            compile_error(c, arg->line, "print() не умеет печатать %s", type_name(types[count]));
+            return error_operand(c, target);
+        }
+        offsets[count] = slots;
+        slots += type_slots(types[count]);
+        count++;
+    }
+
+    size_t len;
+    char* text = unescape_string(c, format, &len);
+    PrintPart* parts = arena_alloc(&program->arena, sizeof(PrintPart) * (len / 2 + 2));
+    int part_count = 0;
+    int used = 0;
+    size_t start = 0;
+    int has_conversion = 0;
+    PrintPart part = {NULL, 0, TYPE_VOID, -1, 0, {0, 0}};
+
+    for (size_t i = 0; i < len; i++) {
+        if (text[i] != '%') {
+            continue;
+        }
+        if (text[i + 1] == '%') {
+            i++;
+            continue;
+        }
+        size_t spec = i;
+        size_t p = i + 1;
+        int stars = 0;
+        int star_args[2] = {0, 0};
+        while (p < len && strchr("-+ #0", text[p])) p++;
+        for (int step = 0; step < 2; step++) {
+            if (text[p] == '*') {
+                if (stars < 2) star_args[stars] = used;
+                stars++;
+                used++;
+                p++;
+            }
+            while (text[p] >= '0' && text[p] <= '9') p++;
+            if (step == 0 && text[p] == '.') p++;
+        }
+        size_t length = p;
+        while (p < len && strchr("hlLqjzt", text[p])) p++;
+        char conversion = text[p];
+        int takes_arg = conversion && strchr(print_conversions, conversion) != NULL;
+
+        if (has_conversion) {
+            part.text = arena_strndup(&program->arena, text + start, spec - start);
+            parts[part_count++] = part;
+            start = spec;
+        }
+        part.spec = (int)(spec - start);
+        part.stars = stars;
+        part.star_args[0] = star_args[0];
+        part.star_args[1] = star_args[1];
+        part.type = TYPE_VOID;
+        part.arg = -1;
+        has_conversion = 1;
+        if (takes_arg) {
+            part.type = used < count ? types[used] : TYPE_VOID;
+            part.arg = used;
+            used++;
+            if (conversion == 's' && p == length && part.type == TYPE_STRING) {
+                text[p] = 'S';
+            }
+        }
+        if (used > count) {
+            compile_error(c, call->line, "в формате print() больше преобразований, чем аргументов");
+            return error_operand(c, target);
+        }
+        for (int s = 0; s < stars && s < 2; s++) {
+            if (!is_integer(types[star_args[s]])) {
+                compile_error(c, call->line, "ширина и точность * в print() должны быть целыми");
+            }
+        }
+        i = p;
+    }
+    part.text = arena_strndup(&program->arena, text + start, len - start);
+    parts[part_count++] = part;
+
+    /* Номера аргументов превращаются в смещения ячеек от base. */
+    for (int i = 0; i < part_count; i++) {
+        if (parts[i].arg >= 0) parts[i].arg = offsets[parts[i].arg];
+        for (int s = 0; s < parts[i].stars && s < 2; s++) {
+            parts[i].star_args[s] = offsets[parts[i].star_args[s]];
+        }
+    }
+
+    program->formats = grow_array(program->formats, &program->format_cap, program->format_count + 1,
+                                  sizeof(PrintFormat));
+    program->formats[program->format_count].parts = parts;
+    program->formats[program->format_count].count = part_count;
+
+    int mark = c->top;
+    int base = compile_args(c, format->next, types, count);
+    c->top = mark;
+    int dst = dest(c, target, TYPE_INT);
+    emit(c, OP_PRINT, dst, program->format_count++, base);
+    return operand(dst, TYPE_INT);
+}
+
+static Operand compile_builtin(BytecodeCompiler* c, const Builtin* builtin, const Node* call, int target) {
+    const Node* args = call->u.call.args;
+    int mark = c->top;
+
+    if (builtin->kind == BUILTIN_PRINT) {
+        return compile_print(c, call, target);
+    }
+    if (!check_arity(c, call, builtin->name, builtin->arity)) {
+        return error_operand(c, target);
+    }
+
+    switch (builtin->kind) {
+        case BUILTIN_NATIVE:
+            return emit_native(c, builtin->native, builtin->ret, args, builtin->params, builtin->arity, target);
+        case BUILTIN_UPDATE:
+            return emit_update(c, call, builtin->native, builtin->ret, builtin->params, builtin->arity, target);
+        case BUILTIN_LEN: {
+            Operand value = expr(c, args, -1);
+            c->top = mark;
+            int dst = dest(c, target, TYPE_INT);
+            switch (value.type) {
+                case TYPE_ARRAY:
+                    emit(c, OP_LEN, dst, value.reg, 0);
+                    break;
+                case TYPE_SLICE:
+                    emit(c, OP_FIELD, dst, value.reg, FIELD_SLICE_LENGTH);
+                    break;
+                case TYPE_STRING:
+                    emit(c, OP_FIELD, dst, value.reg, FIELD_STRING_LENGTH);
+                    break;
+                case TYPE_CSTRING:
+                    emit(c, OP_NATIVE, dst, NATIVE_STRLEN, value.reg);
+                    break;
+                default:
+                    compile_error(c, call->line, "len() не применим к %s", type_name(value.type));
+            }
+            return operand(dst, TYPE_INT);
+        }
+        case BUILTIN_PUSH: {
+            Lvalue lv;
+            if (!resolve_lvalue(c, args, &lv) || lv.type != TYPE_ARRAY) {
+                compile_error(c, call->line, "push() ожидает переменную-массив");
+                return error_operand(c, target);
+            }
+            Operand array = load_lvalue(c, &lv, -1);
+            Operand value = expr_as(c, args->next, TYPE_INT, -1);
+            emit(c, OP_PUSH, array.reg, value.reg, 0);
+            if (lv.kind != LVALUE_LOCAL) {
+                store_lvalue(c, &lv, array);
+            }
+            return operand(mark, TYPE_VOID);
+        }
+        case BUILTIN_POP: {
+            Operand array = expr_as(c, args, TYPE_ARRAY, -1);
+            c->top = mark;
+            int dst = dest(c, target, TYPE_INT);
+            emit(c, OP_POP, dst, array.reg, 0);
+            return operand(dst, TYPE_INT);
+        }
+        case BUILTIN_VIEW:
+            return expr_as(c, args, TYPE_SLICE, target);
+        case BUILTIN_SLICE: {
+            static const ValueType from_array[] = {TYPE_ARRAY, TYPE_INT, TYPE_INT};
+            static const ValueType from_slice[] = {TYPE_SLICE, TYPE_INT, TYPE_INT};
+            int slice = infer_type(c, args) == TYPE_SLICE;
+            return emit_native(c, slice ? NATIVE_SLICE_RANGE : NATIVE_ARRAY_SLICE, TYPE_SLICE, args,
+                               slice ? from_slice : from_array, 3, target);
+        }
+        case BUILTIN_STRING_LENGTH: {
+            Operand value = expr(c, args, -1);
+            c->top = mark;
+            int dst = dest(c, target, TYPE_INT);
+            if (value.type == TYPE_STRING) {
+                emit(c, OP_FIELD, dst, value.reg, FIELD_STRING_LENGTH);
+            } else if (value.type == TYPE_CSTRING) {
+                emit(c, OP_NATIVE, dst, NATIVE_STRLEN, value.reg);
+            } else {
+                compile_error(c, call->line, "string_length() ожидает строку");
+            }
+            return operand(dst, TYPE_INT);
+        }
+        case BUILTIN_STRING_COMPARE: {
+            static const ValueType strings[] = {TYPE_STRING, TYPE_STRING};
+            static const ValueType pointers[] = {TYPE_CSTRING, TYPE_CSTRING};
+            int mika = infer_type(c, args) == TYPE_STRING || infer_type(c, args->next) == TYPE_STRING;
+            return emit_native(c, mika ? NATIVE_STRING_COMPARE : NATIVE_STRCMP, TYPE_INT, args,
+                               mika ? strings : pointers, 2, target);
+        }
+        case BUILTIN_STRING_FREE: {
+            ValueType type = infer_type(c, args);
+            if (type != TYPE_STRING && type != TYPE_BUILDER) {
+                compile_error(c, call->line, "string_free() ожидает строку или построитель строк");
+                return error_operand(c, target);
+            }
+            return emit_update(c, call, type == TYPE_STRING ? NATIVE_STRING_FREE : NATIVE_BUILDER_FREE,
+                               TYPE_VOID, &type, 1, target);
+        }
+        default:
+            break;
+    }
+    return error_operand(c, target);
+}
+
+static void add_pending(BytecodeCompiler* c, int function, int line, const ValueType* types, int count) {
+    c->pending = grow_array(c->pending, &c->pending_cap, c->pending_count + 1, sizeof(PendingCall));
+    PendingCall* call = &c->pending[c->pending_count++];
+    call->function = function;
+    call->line = line;
+    call->count = count;
+    call->args = arena_alloc(&c->program->arena, sizeof(ValueType) * (size_t)(count + 1));
+    memcpy(call->args, types, sizeof(ValueType) * (size_t)count);
+}
+
+static Operand compile_call(BytecodeCompiler* c, const Node* call, int target) {
+    const Node* callee = call->u.call.callee;
+
+    if (callee->kind != NODE_IDENT) {
+        unsupported(c, call->line, "вызов через выражение");
+        return error_operand(c, target);
+    }
+    const Builtin* builtin = find_builtin(callee);
+    if (builtin && names_find(&c->function_names, callee->u.lit.text, callee->u.lit.len) < 0) {
+        return compile_builtin(c, builtin, call, target);
+    }
+    if (find_local(c, callee) >= 0 || find_global(c, callee)) {
+        unsupported(c, call->line, "вызов переменной");
+        return error_operand(c, target);
+    }
+
+    int index = function_index(c, callee);
+    int count = node_count(call->u.call.args);
+    ValueType types[BYTECODE_MAX_ARGS];
+    Function* fn = &c->program->functions[index];
+    ValueType ret = fn->ret;
+
+    if (count > BYTECODE_MAX_ARGS) {
+        compile_error(c, call->line, "слишком много аргументов");
+        return error_operand(c, target);
+    }
+    if (fn->param_count >= 0) {
+        if (fn->param_count != count) {
+            compile_error(c, call->line, "%s() ожидает аргументов: %d", fn->name, fn->param_count);
+            return error_operand(c, target);
+        }
+        memcpy(types, fn->params, sizeof(ValueType) * (size_t)count);
+    } else {
+        const Node* arg = call->u.call.args;
+        for (int i = 0; i < count; i++, arg = arg->next) {
+            types[i] = infer_type(c, arg);
+        }
+        add_pending(c, index, call->line, types, count);
+        ret = TYPE_INT;
+    }
+
+    int mark = c->top;
+    int base = compile_args(c, call->u.call.args, types, count);
+    c->top = mark;
+    int dst = ret == TYPE_VOID ? mark : dest(c, target, ret);
+    emit(c, OP_CALL, dst, index, base);
+    return operand(dst, ret);
+}
+
+static Operand compile_ident(BytecodeCompiler* c, const Node* node, int target) {
+    int local = find_local(c, node);
+    if (local >= 0) {
+        return move_to(c, operand(c->locals[local].reg, c->locals[local].type), target);
+    }
+    const Global* global = find_global(c, node);
+    if (global) {
+        int dst = dest(c, target, global->type);
+        emit(c, OP_GETG, dst, global->slot, type_slots(global->type));
+        return operand(dst, global->type);
+    }
+    if (node_is_ident(node, "NULL")) {
+        int dst = dest(c, target, TYPE_ARRAY);
+        emit(c, OP_LOADI, dst, 0, 0);
+        return operand(dst, TYPE_ARRAY);
+    }
+    compile_error(c, node->line, "неизвестное имя '%.*s'", (int)node->u.lit.len, node->u.lit.text);
+    return error_operand(c, target);
+}
+
+static Operand expr(BytecodeCompiler* c, const Node* node, int target) {
+    long long constant;
+    int dst;
+
+    if (constant_value(node, &constant)) {
+        dst = dest(c, target, TYPE_INT);
+        emit(c, OP_LOADI, dst, (int)constant, 0);
+        return operand(dst, TYPE_INT);
+    }
+
+    switch (node->kind) {
+        case NODE_INT: {
+            Slot value;
+            value.i = node->u.lit.value;
+            dst = dest(c, target, TYPE_LONG);
+            emit(c, OP_LOADK, dst, add_constant(c, value), 0);
+            return operand(dst, TYPE_LONG);
+        }
+        case NODE_FLOAT: {
+            Slot value;
+            char text[64];
+            size_t len = node->u.lit.len < sizeof(text) - 1 ? node->u.lit.len : sizeof(text) - 1;
+            memcpy(text, node->u.lit.text, len);
+            text[len] = '\0';
+            value.d = strtod(text, NULL);
+            dst = dest(c, target, TYPE_DOUBLE);
+            emit(c, OP_LOADK, dst, add_constant(c, value), 0);
+            return operand(dst, TYPE_DOUBLE);
+        }
+        case NODE_STRING: {
+            Slot value;
+            size_t len;
+            value.s = unescape_string(c, node, &len);
+            dst = dest(c, target, TYPE_CSTRING);
+            emit(c, OP_LOADK, dst, add_constant(c, value), 0);
+            return operand(dst, TYPE_CSTRING);
+        }
+        case NODE_IDENT:
+            return compile_ident(c, node, target);
+        case NODE_UNARY:
+            return compile_unary(c, node, target);
+        case NODE_POSTFIX:
+            return compile_increment(c, node, 1, target, 1);
+        case NODE_BINARY:
+            return compile_binary(c, node, target);
+        case NODE_ASSIGN:
+            return compile_assign(c, node, target);
+        case NODE_TERNARY:
+            return compile_ternary(c, node, target);
+        case NODE_CALL:
+            return compile_call(c, node, target);
+        case NODE_INDEX: {
+            Lvalue lv;
+            int mark = c->top;
+            if (!resolve_lvalue(c, node, &lv)) {
+                return error_operand(c, target);
+            }
+            c->top = mark;
+            return load_lvalue(c, &lv, target);
+        }
+        case NODE_MEMBER: {
+            int mark = c->top;
+            Operand base = expr(c, node->u.member.base, -1);
+            const char* name = node->u.member.name;
+            if (node->u.member.arrow) {
+                unsupported(c, node->line, "оператор ->");
+                return error_operand(c, target);
+            }
+            if (base.type == TYPE_SLICE && strcmp(name, "data") == 0) {
+                return move_to(c, operand(base.reg, TYPE_ARRAY), target);
+            }
+            if (strcmp(name, "length") != 0 ||
+                (base.type != TYPE_SLICE && base.type != TYPE_STRING && base.type != TYPE_BUILDER)) {
+                compile_error(c, node->line, "у %s нет поля '%s'", type_name(base.type), name);
+                return error_operand(c, target);
+            }
+            c->top = mark;
+            dst = dest(c, target, TYPE_INT);
+            emit(c, OP_FIELD, dst, base.reg, base.type == TYPE_STRING ? FIELD_STRING_LENGTH :
+                 base.type == TYPE_SLICE ? FIELD_SLICE_LENGTH : FIELD_BUILDER_LENGTH);
+            return operand(dst, TYPE_INT);
+        }
+        case NODE_CAST: {
+            ValueType type = resolve_type(c, node->line, &node->u.cast.type, NULL);
+            if (type == TYPE_VOID) {
+                expr(c, node->u.cast.expr, -1);
+                return operand(dest(c, target, TYPE_INT), TYPE_VOID);
+            }
+            return expr_as(c, node->u.cast.expr, type, target);
+        }
+        case NODE_SIZEOF: {
+            if (node->u.cast.expr) {
+                unsupported(c, node->line, "sizeof от выражения");
+                return error_operand(c, target);
+            }
+            const TypeRef* type = &node->u.cast.type;
+            int size = type->pointers > 0 ? 8 : 4;
+            if (type->pointers == 0 && !type->is_var) {
+                const char* name = type->name;
+                if (strstr(name, "long") || strstr(name, "double") || strstr(name, "64")) size = 8;
+                else if (strstr(name, "short") || strstr(name, "16")) size = 2;
+                else if (strstr(name, "char") || strstr(name, "bool") || strstr(name, "8")) size = 1;
+            }
+            dst = dest(c, target, TYPE_LONG);
+            emit(c, OP_LOADI, dst, size, 0);
+            return operand(dst, TYPE_LONG);
+        }
+        case NODE_INIT_LIST:
+            compile_error(c, node->line, "список инициализации допустим только при объявлении массива");
+            return error_operand(c, target);
+        default:
+            compile_error(c, node->line, "ожидалось выражение");
+            return error_operand(c, target);
+    }
+}
+
+/* ---------- Условия ---------- */
+
+static TokenKind branch_comparison(TokenKind op, int sense) {
+    static const TokenKind inverse[][2] = {
+        {TOK_EQ, TOK_NE}, {TOK_NE, TOK_EQ}, {TOK_LT, TOK_GE}, {TOK_GE, TOK_LT}, {TOK_LE, TOK_GT}, {TOK_GT, TOK_LE},
+    };
+    if (!sense) {
+        for (size_t i = 0; i < sizeof(inverse) / sizeof(inverse[0]); i++) {
+            if (inverse[i][0] == op) {
+                return inverse[i][1];
+            }
+        }
+    }
+    return op;
+}
+
+/* Переход по списку list, если истинность условия равна sense. */
+static void jump_if(BytecodeCompiler* c, const Node* node, int sense, int* list) {
+    long long constant;
+    int mark = c->top;
+
+    if (constant_value(node, &constant)) {
+        if ((constant != 0) == sense) {
+            emit_jump(c, OP_JUMP, 0, 0, list);
+        }
+        return;
+    }
+    if (node->kind == NODE_UNARY && node->u.unary.op == TOK_BANG) {
+        jump_if(c, node->u.unary.operand, !sense, list);
+        return;
+    }
+    if (node->kind == NODE_BINARY && (node->u.binary.op == TOK_ANDAND || node->u.binary.op == TOK_OROR)) {
+        /* a && b && c ...: все операнды, кроме правого у вершины, прыгают
+           одинаково, поэтому цепочка идёт циклом */
+        BinaryChain chain;
+        int flat = (node->u.binary.op == TOK_ANDAND) != sense;
+        int skip = -1;
+        int* inner = flat ? list : &skip;
+        int inner_sense = flat ? sense : !sense;
+
+        if (!binary_chain_init(&chain, node)) {
+            perror("Ошибка выделения памяти");
+            exit(1);
+        }
+        jump_if(c, binary_chain_first(&chain), inner_sense, inner);
+        for (size_t i = chain.count; i > 1; i--) {
+            jump_if(c, chain.links[i - 1]->u.binary.rhs, inner_sense, inner);
+        }
+        jump_if(c, node->u.binary.rhs, sense, list);
+        binary_chain_free(&chain);
+        if (!flat) {
+            patch(c, skip, here(c));
+        }
+        return;
+    }
+    if (node->kind == NODE_BINARY && is_comparison(node->u.binary.op) &&
+        is_integer(infer_type(c, node->u.binary.lhs)) && is_integer(infer_type(c, node->u.binary.rhs))) {
+        TokenKind op = branch_comparison(node->u.binary.op, sense);
+        Operand lhs = expr(c, node->u.binary.lhs, -1);
+        if (constant_value(node->u.binary.rhs, &constant)) {
+            Opcode code = op == TOK_EQ ? OP_JEQK : op == TOK_NE ? OP_JNEK : op == TOK_LT ? OP_JLTK :
+                          op == TOK_LE ? OP_JLEK : op == TOK_GT ? OP_JGTK : OP_JGEK;
+            emit_jump(c, code, lhs.reg, (int)constant, list);
+        } else {
+            Operand rhs = expr(c, node->u.binary.rhs, -1);
+            int swap = op == TOK_GT || op == TOK_GE;
+            Opcode code = op == TOK_EQ ? OP_JEQ : op == TOK_NE ? OP_JNE : op == TOK_LT || op == TOK_GT ? OP_JLT : OP_JLE;
+            emit_jump(c, code, swap ? rhs.reg : lhs.reg, swap ? lhs.reg : rhs.reg, list);
+        }
+        c->top = mark;
+        return;
+    }
+
+    Operand value = expr(c, node, -1);
+    if (is_floating(value.type)) {
+        Slot zero;
+        zero.d = 0.0;
+        int tmp = alloc_regs(c, 1);
+        emit(c, OP_LOADK, tmp, add_constant(c, zero), 0);
+        emit(c, OP_DNE, tmp, value.reg, tmp);
+        value.reg = tmp;
+    } else if (type_slots(value.type) != 1) {
+        compile_error(c, node->line, "%s нельзя использовать как условие", type_name(value.type));
+    }
+    emit_jump(c, sense ? OP_JNZ : OP_JZ, value.reg, 0, list);
+    c->top = mark;
+}
+
+/* ---------- Операторы ---------- */
+
+static void compile_array(BytecodeCompiler* c, const Node* var, int reg, int global) {
+    const Node* dim = var->u.var.dims;
+    const Node* init = var->u.var.init;
+    int mark = c->top;
+    int count = 0;
+
+    if (init && init->kind != NODE_INIT_LIST) {
+        compile_error(c, var->line, "массив инициализируется списком в фигурных скобках");
+        return;
+    }
+    count = init ? node_count(init->u.list.items) : 0;
+
+    int size = alloc_regs(c, 1);
+    if (dim->kind == NODE_EMPTY) {
+        if (!init) {
+            compile_error(c, var->line, "у массива '%s' не указан размер", var->u.var.name);
+            return;
+        }
+        emit(c, OP_LOADI, size, count, 0);
+    } else {
+        long long constant;
+        if (init && (!constant_value(dim, &constant) || constant < count)) {
+            compile_error(c, var->line, "слишком много элементов в инициализации массива '%s'", var->u.var.name);
+            return;
+        }
+        expr_as(c, dim, TYPE_INT, size);
+    }
+    emit(c, OP_NEWARRAY, reg, size, global ? -1 : current(c)->array_base + current(c)->array_count++);
+
+    int index = 0;
+    for (const Node* item = init ? init->u.list.items : NULL; item; item = item->next, index++) {
+        int item_mark = c->top;
+        Operand value = expr_as(c, item, TYPE_INT, -1);
+        int position = alloc_regs(c, 1);
+        emit(c, OP_LOADI, position, index, 0);
+        emit(c, OP_STOREX, reg, position, value.reg);
+        c->top = item_mark;
+    }
+    c->top = mark;
+}
+
+/* Тип var по инициализатору, как в трансляторе: число по правилам
+   арифметики C, строка или срез; переменные одного объявления получают
+   общий тип. TYPE_VOID — объявление не var. */
+static ValueType var_declaration_type(BytecodeCompiler* c, const Node* decl) {
+    ValueType result = TYPE_VOID;
+    int same = 1;
+    int numeric = 1;
+
+    if (!decl->u.decl.type.is_var) {
+        return TYPE_VOID;
+    }
+    for (const Node* var = decl->u.decl.vars; var; var = var->next) {
+        int scalar = !var->u.var.dims && var->u.var.type.pointers == 0;
+        ValueType type = scalar && var->u.var.init ? infer_type(c, var->u.var.init) : TYPE_INT;
+        if (is_narrow(type) || (!is_numeric(type) && type != TYPE_STRING && type != TYPE_SLICE)) {
+            type = TYPE_INT;
+        }
+        same = same && (result == TYPE_VOID || type == result);
+        numeric = numeric && scalar && is_numeric(type);
+        result = result == TYPE_VOID ? type : is_numeric(result) && is_numeric(type) ? promote(result, type) : result;
+    }
+    if (!same && !numeric) {
+        compile_error(c, decl->line, "переменные одного объявления var получили разные типы, объявите их отдельно");
+        return TYPE_INT;
+    }
+    return result;
+}
+
+static void compile_local(BytecodeCompiler* c, const Node* var, ValueType inferred) {
+    ValueType type = inferred != TYPE_VOID && !var->u.var.dims && var->u.var.type.pointers == 0 ? inferred :
+                     resolve_type(c, var->line, &var->u.var.type, var->u.var.dims);
+
+    if (var->u.var.type.storage & STORAGE_STATIC) {
+        unsupported(c, var->line, "static локальная переменная");
+    }
+    if (type == TYPE_VOID) {
+        compile_error(c, var->line, "переменная '%s' не может иметь тип void", var->u.var.name);
+        return;
+    }
+    int reg = alloc_regs(c, type_slots(type));
+    if (var->u.var.dims) {
+        compile_array(c, var, reg, 0);
+    } else if (var->u.var.init) {
+        int mark = c->top;
+        expr_as(c, var->u.var.init, type, reg);
+        if (type == TYPE_STRING && borrows_string(c, var->u.var.init)) {
+            emit(c, OP_NATIVE, reg, NATIVE_STRING_COPY, reg);
+        }
+        c->top = mark;
+    } else {
+        for (int i = 0; i < type_slots(type); i++) {
+            emit(c, OP_LOADI, reg + i, 0, 0);
+        }
+    }
+    declare_local(c, var->line, var->u.var.name, type, reg);
+}
+
+static void compile_global(BytecodeCompiler* c, const Node* var, ValueType inferred) {
+    ValueType type = inferred != TYPE_VOID && !var->u.var.dims && var->u.var.type.pointers == 0 ? inferred :
+                     resolve_type(c, var->line, &var->u.var.type, var->u.var.dims);
+    size_t len = strlen(var->u.var.name);
+
+    if (type == TYPE_VOID) {
+        compile_error(c, var->line, "переменная '%s' не может иметь тип void", var->u.var.name);
+        return;
+    }
+    if (names_find(&c->global_names, var->u.var.name, len) >= 0) {
+        compile_error(c, var->line, "повторное объявление '%s'", var->u.var.name);
+        return;
+    }
+    int slot = c->program->global_slots;
+    c->program->global_slots += type_slots(type);
+
+    c->top = 0;
+    if (var->u.var.dims) {
+        int reg = alloc_regs(c, 1);
+        compile_array(c, var, reg, 1);
+        emit(c, OP_SETG, slot, reg, 1);
+    } else if (var->u.var.init) {
+        Operand value = expr_as(c, var->u.var.init, type, -1);
+        if (type == TYPE_STRING && borrows_string(c, var->u.var.init)) {
+            emit(c, OP_NATIVE, value.reg, NATIVE_STRING_COPY, value.reg);
+        }
+        emit(c, OP_SETG, slot, value.reg, type_slots(type));
+    }
+    c->top = 0;
+
+    c->globals = grow_array(c->globals, &c->global_cap, c->global_count + 1, sizeof(Global));
+    c->globals[c->global_count].name = arena_strndup(&c->program->arena, var->u.var.name, len);
+    c->globals[c->global_count].type = type;
+    c->globals[c->global_count].slot = slot;
+    names_add(&c->global_names, c->globals[c->global_count].name, c->global_count);
+    c->global_count++;
+}
+
+static void compile_loop_body(BytecodeCompiler* c, Loop* loop, const Node* body, int is_switch) {
+    loop->outer = c->loop;
+    loop->is_switch = is_switch;
+    loop->breaks = -1;
+    loop->continues = -1;
+    c->loop = loop;
+    statement(c, body);
+    c->loop = loop->outer;
+}
+
+static void compile_switch(BytecodeCompiler* c, const Node* node) {
+    const Node* body = node->u.loop.body;
+    const Node* items = body->kind == NODE_BLOCK ? body->u.list.items : body;
+    SwitchCases cases;
+    Loop loop;
+    int mark = c->top;
+    int fallback = -1;
+    long long value;
+
+    Operand subject = expr(c, node->u.loop.cond, -1);
+    if (!is_integer(subject.type)) {
+        compile_error(c, node->line, "switch ожидает целое значение");
+    }
+
+    /* Метки case видны только на верхнем уровне тела: для каждой
+       сравнение с константой, промах — на default или за switch. */
+    cases.count = 0;
+    for (const Node* item = items; item; item = body->kind == NODE_BLOCK ? item->next : NULL) {
+        cases.count += item->kind == NODE_CASE;
+    }
+    cases.nodes = malloc(sizeof(*cases.nodes) * (size_t)(cases.count + 1));
+    cases.jumps = malloc(sizeof(*cases.jumps) * (size_t)(cases.count + 1));
+    if (!cases.nodes || !cases.jumps) {
+        perror("Ошибка выделения памяти");
+        exit(1);
+    }
+    cases.count = 0;
+    int default_index = -1;
+    for (const Node* item = items; item; item = body->kind == NODE_BLOCK ? item->next : NULL) {
+        if (item->kind != NODE_CASE) {
+            continue;
+        }
+        cases.nodes[cases.count] = item;
+        cases.jumps[cases.count] = -1;
+        if (!item->u.ret.value) {
+            default_index = cases.count;
+        } else if (constant_value(item->u.ret.value, &value)) {
+            emit_jump(c, OP_JEQK, subject.reg, (int)value, &cases.jumps[cases.count]);
+        } else {
+            compile_error(c, item->line, "значение case должно быть целой константой");
+        }
+        cases.count++;
+    }
+    emit_jump(c, OP_JUMP, 0, 0, default_index >= 0 ? &cases.jumps[default_index] : &fallback);
+    c->top = mark;
+
+    cases.outer = c->cases;
+    c->cases = &cases;
+    compile_loop_body(c, &loop, body, 1);
+    c->cases = cases.outer;
+    patch(c, fallback, here(c));
+    patch(c, loop.breaks, here(c));
+
+    free(cases.nodes);
+    free(cases.jumps);
+}
+
+/* return без значения и выход через конец тела возвращают нули. */
+static void return_default(BytecodeCompiler* c) {
+    ValueType ret = current(c)->ret;
+    int reg = alloc_regs(c, type_slots(ret));
+    for (int i = 0; i < type_slots(ret); i++) {
+        emit(c, OP_LOADI, reg + i, 0, 0);
+    }
+    emit(c, OP_RET, reg, type_slots(ret), 0);
+}
+
+static void compile_return(BytecodeCompiler* c, const Node* node) {
+    const Node* value = node->u.ret.value;
+    ValueType ret = current(c)->ret;
+
+    if (!value) {
+        return_default(c);
+        return;
+    }
+    if (ret == TYPE_VOID) {
+        compile_error(c, node->line, "функция %s не возвращает значения", current(c)->name);
+        return;
+    }
+    /* как в трансляторе: return 993 означает успешное завершение */
+    if (value->kind == NODE_INT && value->u.lit.value == MIKA_SUCCESS_CODE) {
+        int reg = alloc_regs(c, 1);
+        emit(c, OP_LOADI, reg, 0, 0);
+        emit(c, OP_RET, reg, 1, 0);
+        return;
+    }
+    Operand result = expr_as(c, value, ret, -1);
+    emit(c, OP_RET, result.reg, type_slots(ret), 0);
+}
+
+static void statement(BytecodeCompiler* c, const Node* node) {
+    int mark = c->top;
+    int locals = c->local_count;
+
+    switch (node->kind) {
+        case NODE_BLOCK:
+            for (const Node* item = node->u.list.items; item; item = item->next) {
+                statement(c, item);
+            }
+            c->local_count = locals;
+            c->top = mark;
+            return;
+        case NODE_DECL: {
+            ValueType inferred = var_declaration_type(c, node);
+            for (const Node* var = node->u.decl.vars; var; var = var->next) {
+                compile_local(c, var, inferred);
+            }
+            return;
+        }
+        case NODE_EXPR_STMT: {
+            const Node* value = node->u.ret.value;
+            if (value->kind == NODE_POSTFIX ||
+                (value->kind == NODE_UNARY && (value->u.unary.op == TOK_INC || value->u.unary.op == TOK_DEC))) {
+                compile_increment(c, value, value->kind == NODE_POSTFIX, -1, 0);
+            } else {
+                expr(c, value, -1);
+            }
+            break;
+        }
+        case NODE_IF: {
+            int falses = -1;
+            jump_if(c, node->u.cond.cond, 0, &falses);
+            statement(c, node->u.cond.then_branch);
+            if (node->u.cond.else_branch) {
+                int done = -1;
+                emit_jump(c, OP_JUMP, 0, 0, &done);
+                patch(c, falses, here(c));
+                statement(c, node->u.cond.else_branch);
+                patch(c, done, here(c));
+            } else {
+                patch(c, falses, here(c));
+            }
+            break;
+        }
+        case NODE_WHILE: case NODE_FOR: case NODE_PARALLEL_FOR: {
+            /* Условие в конце цикла: на итерацию один переход. parallel for
+               выполняется последовательно — редукции дают тот же результат. */
+            Loop loop;
+            int test = -1;
+            if (node->u.loop.init) {
+                if (node->u.loop.init->kind == NODE_DECL) {
+                    statement(c, node->u.loop.init);
+                } else {
+                    expr(c, node->u.loop.init, -1);
+                    c->top = mark;
+                }
+            }
+            int body_mark = c->top;
+            emit_jump(c, OP_JUMP, 0, 0, &test);
+            int body = here(c);
+            compile_loop_body(c, &loop, node->u.loop.body, 0);
+            c->top = body_mark;
+            patch(c, loop.continues, here(c));
+            if (node->u.loop.step) {
+                const Node* step = node->u.loop.step;
+                if (step->kind == NODE_POSTFIX ||
+                    (step->kind == NODE_UNARY && (step->u.unary.op == TOK_INC || step->u.unary.op == TOK_DEC))) {
+                    compile_increment(c, step, 1, -1, 0);
+                } else {
+                    expr(c, step, -1);
+                }
+                c->top = body_mark;
+            }
+            patch(c, test, here(c));
+            if (node->u.loop.cond) {
+                int again = -1;
+                jump_if(c, node->u.loop.cond, 1, &again);
+                patch(c, again, body);
+            } else {
+                emit_jump_to(c, OP_JUMP, 0, 0, body);
+            }
+            patch(c, loop.breaks, here(c));
+            c->local_count = locals;
+            break;
+        }
+        case NODE_DO: {
+            Loop loop;
+            int body = here(c);
+            int again = -1;
+            compile_loop_body(c, &loop, node->u.loop.body, 0);
+            c->top = mark;
+            patch(c, loop.continues, here(c));
+            jump_if(c, node->u.loop.cond, 1, &again);
+            patch(c, again, body);
+            patch(c, loop.breaks, here(c));
+            break;
+        }
+        case NODE_SWITCH:
+            compile_switch(c, node);
+            break;
+        case NODE_CASE: {
+            SwitchCases* cases = c->cases;
+            int found = 0;
+            for (int i = 0; cases && i < cases->count && !found; i++) {
+                if (cases->nodes[i] == node) {
+                    patch(c, cases->jumps[i], here(c));
+                    found = 1;
+                }
+            }
+            if (!found) {
+                compile_error(c, node->line, "case вне switch или во вложенном блоке");
+            }
+            break;
+        }
+        case NODE_RETURN:
+            compile_return(c, node);
+            break;
+        case NODE_BREAK: case NODE_CONTINUE: {
+            Loop* loop = c->loop;
+            if (node->kind == NODE_CONTINUE) {
+                while (loop && loop->is_switch) loop = loop->outer;
+            }
+            if (!loop) {
+                compile_error(c, node->line, "%s вне цикла", node->kind == NODE_BREAK ? "break" : "continue");
+                break;
+            }
+            emit_jump(c, OP_JUMP, 0, 0, node->kind == NODE_BREAK ? &loop->breaks : &loop->continues);
+            break;
+        }
+        case NODE_EMPTY:
+            break;
+        case NODE_DIRECTIVE:
+            unsupported(c, node->line, "директива препроцессора внутри функции");
+            break;
+        default:
+            compile_error(c, node->line, "ожидался оператор");
+            break;
+    }
+    c->top = mark;
+}
+
+/* ---------- Верхний уровень ---------- */
+
+static void compile_directive(BytecodeCompiler* c, const Node* node) {
+    const char* p = node->u.lit.text + 1;
+    const char* end = node->u.lit.text + node->u.lit.len;
+
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+    if ((size_t)(end - p) >= 6 && memcmp(p, "pragma", 6) == 0) {
+        return;
+    }
+    if ((size_t)(end - p) < 7 || memcmp(p, "include", 7) != 0) {
+        unsupported(c, node->line, "эта директива препроцессора");
+        return;
+    }
+    p += 7;
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+    while (end > p && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r')) end--;
+    size_t len = (size_t)(end - p);
+    if ((len == 8 && memcmp(p, "<System>", 8) == 0) || (len == 6 && memcmp(p, "<Math>", 6) == 0) ||
+        (len == 6 && memcmp(p, "<Time>", 6) == 0)) {
+        return;
+    }
+    if (len == 7 && memcmp(p, "<Arena>", 7) == 0) {
+        c->program->arena_mode = 1;
+        return;
+    }
+    unsupported(c, node->line, "#include файлов C");
+}
+
+static int declare_function(BytecodeCompiler* c, const Node* func) {
+    const char* name = func->u.func.name;
+    size_t len = strlen(name);
+    int count = node_count(func->u.func.params);
+    ValueType ret = func->u.func.ret.is_var ? TYPE_INT :
+                    resolve_type(c, func->line, &func->u.func.ret, NULL);
+    ValueType* params = arena_alloc(&c->program->arena, sizeof(ValueType) * (size_t)(count + 1));
+    int i = 0;
+
+    if (func->u.func.variadic) {
+        unsupported(c, func->line, "функция с переменным числом аргументов");
+    }
+    for (const Node* param = func->u.func.params; param; param = param->next) {
+        params[i++] = resolve_type(c, param->line, &param->u.var.type, param->u.var.dims);
+    }
+
+    int index = names_find(&c->function_names, name, len);
+    if (index < 0) {
+        index = new_function(c, name, len, func->line);
+    }
+    Function* fn = &c->program->functions[index];
+    if (fn->param_count >= 0) {
+        int same = fn->param_count == count && fn->ret == ret;
+        for (int p = 0; same && p < count; p++) {
+            same = fn->params[p] == params[p];
+        }
+        if (!same) {
+            compile_error(c, func->line, "объявление %s() не совпадает с предыдущим", name);
+        }
+    }
+    fn->param_count = count;
+    fn->params = params;
+    fn->ret = ret;
+    return index;
+}
+
+/* Регистры-владельцы локальных массивов лежат сразу за аргументами, ниже
+   всех временных: кадр вызываемой функции их не перекрывает. */
+static int count_arrays(const Node* node) {
+    int count = 0;
+
+    switch (node->kind) {
+        case NODE_BLOCK:
+            for (const Node* item = node->u.list.items; item; item = item->next) {
+                count += count_arrays(item);
+            }
+            break;
+        case NODE_DECL:
+            for (const Node* var = node->u.decl.vars; var; var = var->next) {
+                count += var->u.var.dims != NULL;
+            }
+            break;
+        case NODE_IF:
+            count += count_arrays(node->u.cond.then_branch);
+            if (node->u.cond.else_branch) {
+                count += count_arrays(node->u.cond.else_branch);
+            }
+            break;
+        case NODE_WHILE: case NODE_DO: case NODE_FOR: case NODE_PARALLEL_FOR: case NODE_SWITCH:
+            if (node->kind != NODE_SWITCH && node->u.loop.init) {
+                count += count_arrays(node->u.loop.init);
+            }
+            count += count_arrays(node->u.loop.body);
+            break;
+        default:
+            break;
+    }
+    return count;
+}
+
+static void compile_function(BytecodeCompiler* c, const Node* func) {
+    int index = declare_function(c, func);
+    Function* fn = &c->program->functions[index];
+
+    if (!func->u.func.body) {
+        return;
+    }
+    if (fn->defined) {
+        compile_error(c, func->line, "повторное определение функции %s()", fn->name);
+        return;
+    }
+    if (strcmp(fn->name, "main") == 0 && fn->param_count > 0) {
+        unsupported(c, func->line, "main с аргументами");
+    }
+    fn->defined = 1;
+    fn->line = func->line;
+
+    c->function = index;
+    c->top = 0;
+    c->local_count = 0;
+    c->loop = NULL;
+    c->cases = NULL;
+    int i = 0;
+    for (const Node* param = func->u.func.params; param; param = param->next, i++) {
+        int reg = alloc_regs(c, type_slots(fn->params[i]));
+        declare_local(c, param->line, param->u.var.name, fn->params[i], reg);
+    }
+    fn = current(c);
+    fn->arg_slots = c->top;
+    fn->array_base = alloc_regs(c, count_arrays(func->u.func.body));
+
+    statement(c, func->u.func.body);
+    return_default(c);
+    c->local_count = 0;
+    c->function = c->program->init;
+    c->top = 0;
+}
+
+BytecodeCompiler* bytecode_compiler_new(Program* program, const char* filename) {
+    BytecodeCompiler* c = calloc(1, sizeof(BytecodeCompiler));
+    if (!c) {
+        perror("Ошибка выделения памяти");
+        return NULL;
+    }
+    c->program = program;
+    c->filename = filename;
+    program->init = new_function(c, "<init>", 6, 0);
+    program->functions[program->init].defined = 1;
+    program->functions[program->init].param_count = 0;
+    program->functions[program->init].ret = TYPE_VOID;
+    c->function = program->init;
+    return c;
+}
+
+int bytecode_compile_item(BytecodeCompiler* c, const Node* item) {
+    int errors = c->errors;
+
+    switch (item->kind) {
+        case NODE_DIRECTIVE:
+            compile_directive(c, item);
+            break;
+        case NODE_FUNCTION:
+            compile_function(c, item);
+            break;
+        case NODE_DECL:
+            c->function = c->program->init;
+            c->local_count = 0;
+            ValueType inferred = var_declaration_type(c, item);
+            for (const Node* var = item->u.decl.vars; var; var = var->next) {
+                compile_global(c, var, inferred);
+            }
+            break;
+        case NODE_RAW:
+            unsupported(c, item->line, "объявление типа (typedef, struct, enum, union)");
+            break;
+        case NODE_RECORD:
+            unsupported(c, item->line, "record");
+            break;
+        default:
+            compile_error(c, item->line, "ожидалось объявление функции или переменной");
+            break;
+    }
+    return c->errors == errors ? 0 : -1;
+}
+
+int bytecode_finish(BytecodeCompiler* c) {
+    Program* program = c->program;
+
+    for (int i = 0; i < c->pending_count; i++) {
+        const PendingCall* call = &c->pending[i];
+        const Function* fn = &program->functions[call->function];
+        int same = fn->param_count == call->count && (fn->ret == TYPE_INT || is_narrow(fn->ret) || fn->ret == TYPE_VOID);
+        for (int p = 0; same && p < call->count; p++) {
+            same = fits_as(call->args[p], fn->params[p]);
+        }
+        if (fn->defined && !same) {
+            compile_error(c, call->line, "%s() вызвана до объявления с другими типами; объявите её выше вызова",
+                          fn->name);
+        }
+    }
+    for (int i = 0; i < program->function_count; i++) {
+        if (!program->functions[i].defined) {
+            compile_error(c, program->functions[i].line, "функция %s() не определена", program->functions[i].name);
+        }
+    }
+
+    int main_index = names_find(&c->function_names, "main", 4);
+    if (main_index < 0) {
+        compile_error(c, 0, "не найдена функция main()");
+    }
+    program->main = main_index;
+
+    c->function = program->init;
+    c->top = 0;
+    emit(c, OP_RET, 0, 0, 0);
+    return c->errors > 0 ? -1 : 0;
+}
+
+void bytecode_compiler_free(BytecodeCompiler* c) {
+    if (!c) {
+        return;
+    }
+    free(c->globals);
+    free(c->pending);
+    free(c->function_names.names);
+    free(c->function_names.values);
+    free(c->global_names.names);
+    free(c->global_names.values);
+    free(c);
+}
+
+/* ---------- Дизассемблер ---------- */
+
+void program_dump(const Program* program, FILE* out) {
+#define OPCODE_NAME(name) #name,
+    static const char* names[] = { OPCODES(OPCODE_NAME) };
+#undef OPCODE_NAME
+
+    for (int i = 0; i < program->function_count; i++) {
+        const Function* fn = &program->functions[i];
+        fprintf(out, "%s: регистров %d, аргументов %d, возвращает %s\n",
+                fn->name, fn->nregs, fn->arg_slots, type_name(fn->ret));
+        for (int at = 0; at < fn->code_len; at++) {
+            const Instr* instr = &fn->code[at];
+            fprintf(out, "  %4d  %-8s %d %d %d", at, names[instr->op], instr->a, instr->b, instr->c);
+            if (instr->op == OP_CALL) {
+                fprintf(out, "  ; %s", program->functions[instr->b].name);
+            } else if (instr->op >= OP_JUMP && instr->op <= OP_JGEK) {
+                const int32_t* offset = instr->op <= OP_JNZ ? &instr->b : &instr->c;
+                fprintf(out, "  ; -> %d", at + *offset);
+            }
+            fputc('\n', out);
+        }
+    }
+}
@@ -0,0 +1,162 @@
+#ifndef MIKA_BYTECODE_H
+#define MIKA_BYTECODE_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "arena.h"
+#include "ast.h"
+
+/* Регистровый байт-код для `mika run`. Регистр — ячейка в 8 байт; int
+   хранится знаково расширенным до 64 бит, поэтому int и long long
+   сравниваются одними инструкциями. Строка занимает три ячейки
+   (MikaString), построитель и срез — по две. char, short и bool лежат
+   как int, float — как double, но при записи значение сужается так же,
+   как в C. */
+
+typedef union {
+    int64_t i;
+    double d;
+    void* p;
+    const char* s;
+} Slot;
+
+typedef enum {
+    TYPE_VOID,
+    TYPE_INT,
+    TYPE_LONG,
+    TYPE_DOUBLE,
+    TYPE_CHAR,
+    TYPE_SHORT,
+    TYPE_BOOL,
+    TYPE_FLOAT,
+    TYPE_ARRAY,
+    TYPE_SLICE,
+    TYPE_STRING,
+    TYPE_BUILDER,
+    TYPE_CSTRING
+} ValueType;
+
+/* a, b, c — регистры, непосредственные значения или смещения переходов
+   (относительно самой инструкции). */
+#define OPCODES(X) \
+    X(MOVE) X(COPY) X(LOADI) X(LOADK) X(GETG) X(SETG) \
+    X(ADD) X(SUB) X(MUL) X(DIV) X(MOD) X(ADDK) \
+    X(LADD) X(LSUB) X(LMUL) X(LDIV) X(LMOD) \
+    X(DADD) X(DSUB) X(DMUL) X(DDIV) \
+    X(AND) X(OR) X(XOR) X(SHL) X(SHR) X(LSHL) X(LSHR) \
+    X(NEG) X(LNEG) X(DNEG) X(NOT) X(LNOT) \
+    X(EQ) X(NE) X(LT) X(LE) X(DEQ) X(DNE) X(DLT) X(DLE) \
+    X(TRUNC) X(I2D) X(D2I) X(D2L) X(I2C) X(I2S) X(I2B) X(D2B) X(I2F) X(D2F) \
+    X(JUMP) X(JZ) X(JNZ) X(JEQ) X(JNE) X(JLT) X(JLE) \
+    X(JEQK) X(JNEK) X(JLTK) X(JLEK) X(JGTK) X(JGEK) \
+    X(LOADX) X(STOREX) X(LEN) X(PUSH) X(POP) X(NEWARRAY) X(VIEW) X(FIELD) X(STRLIT) \
+    X(CALL) X(NATIVE) X(PRINT) X(RET)
+
+#define OPCODE_ENUM(name) OP_##name,
+typedef enum {
+    OPCODES(OPCODE_ENUM)
+    OP_COUNT
+} Opcode;
+#undef OPCODE_ENUM
+
+/* Встроенные функции рантайма: вызываются из интерпретатора теми же
+   функциями mika_std.c, что и в скомпилированной программе. */
+#define NATIVES(X) \
+    X(INPUT) X(POWER) X(ABSOLUTE) X(FLUSH_OUTPUT) \
+    X(ARRAY_CREATE) X(ARRAY_FREE) X(ARRAY_SIZE) X(ARRAY_RESERVE) X(ARRAY_SLICE) X(SLICE_RANGE) \
+    X(ARRAY_SUM) X(ARRAY_MIN) X(ARRAY_MAX) X(ARRAY_FILL) X(ARRAY_COPY) X(ARRAY_DOT) \
+    X(ARRAY_ADD) X(ARRAY_SUB) X(ARRAY_MUL) X(ARRAY_SIMD_LEVEL) X(THREAD_COUNT) \
+    X(ARENA_ENTER) X(ARENA_LEAVE) \
+    X(STRING_FROM) X(SUBSTRING) X(STRING_COMPARE) X(STRCMP) X(STRLEN) X(STRING_ASSIGN) \
+    X(STRING_COPY) X(STRING_FREE) X(BUILDER_APPEND) X(BUILDER_FINISH) X(BUILDER_FREE) X(INPUT_LINE) \
+    X(ABS) X(RAND) X(SRAND) X(EXIT) \
+    X(SQRT) X(POW) X(SIN) X(COS) X(TAN) X(ATAN) X(ATAN2) X(EXP) X(LOG) X(LOG10) \
+    X(FLOOR) X(CEIL) X(FABS) X(FMOD)
+
+#define NATIVE_ENUM(name) NATIVE_##name,
+typedef enum {
+    NATIVES(NATIVE_ENUM)
+    NATIVE_COUNT
+} NativeId;
+#undef NATIVE_ENUM
+
+/* Поля, которые читает FIELD. */
+typedef enum {
+    FIELD_STRING_LENGTH,
+    FIELD_SLICE_LENGTH,
+    FIELD_BUILDER_LENGTH
+} FieldId;
+
+typedef struct {
+    int32_t op;
+    int32_t a;
+    int32_t b;
+    int32_t c;
+} Instr;
+
+typedef struct {
+    const char* name;
+    int defined;
+    int line;
+    ValueType ret;
+    int param_count;
+    ValueType* params;
+    int arg_slots;
+    Instr* code;
+    int code_len;
+    int code_cap;
+    int nregs;
+    int array_base;
+    int array_count;
+} Function;
+
+/* Одна часть формата print: литерал и не больше одного преобразования.
+   Ширина и точность через * подставляются числами перед вызовом. */
+typedef struct {
+    const char* text;
+    int spec;
+    ValueType type;
+    int arg;
+    int stars;
+    int star_args[2];
+} PrintPart;
+
+typedef struct {
+    PrintPart* parts;
+    int count;
+} PrintFormat;
+
+typedef struct {
+    Arena arena;
+    Function* functions;
+    int function_count;
+    int function_cap;
+    Slot* constants;
+    int constant_count;
+    int constant_cap;
+    PrintFormat* formats;
+    int format_count;
+    int format_cap;
+    int global_slots;
+    int threaded;
+    int init;
+    int main;
+    int arena_mode;
+} Program;
+
+typedef struct BytecodeCompiler BytecodeCompiler;
+
+BytecodeCompiler* bytecode_compiler_new(Program* program, const char* filename);
+int bytecode_compile_item(BytecodeCompiler* compiler, const Node* item);
+int bytecode_finish(BytecodeCompiler* compiler);
+void bytecode_compiler_free(BytecodeCompiler* compiler);
+
+void program_init(Program* program);
+void program_free(Program* program);
+void program_dump(const Program* program, FILE* out);
+
+int type_slots(ValueType type);
+const char* type_name(ValueType type);
+
+#endif
@@ -0,0 +1,387 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "cache.h"
+#include "deps.h"
+
+typedef struct {
+    char* path;
+    unsigned long long size;
+    time_t mtime;
+} CacheEntry;
+
+int make_directories(char* path) {
+    for (char* p = path + 1; *p; p++) {
+        if (*p == '/') {
+            *p = '\0';
+            int failed = mkdir(path, 0755) != 0 && errno != EEXIST;
+            *p = '/';
+            if (failed) {
+                return -1;
+            }
+        }
+    }
+    return (mkdir(path, 0755) != 0 && errno != EEXIST) ? -1 : 0;
+}
+
+int cache_directory(char* buffer, size_t size) {
+    const char* dir = getenv("MIKA_CACHE_DIR");
+    const char* home = getenv("HOME");
+    const char* xdg = getenv("XDG_CACHE_HOME");
+    int len;
+
+    if (dir && *dir) {
+        len = snprintf(buffer, size, "%s", dir);
+    } else if (xdg && *xdg) {
+        len = snprintf(buffer, size, "%s/mika", xdg);
+    } else if (home && *home) {
+        len = snprintf(buffer, size, "%s/.cache/mika", home);
+    } else {
+        len = snprintf(buffer, size, "/tmp/mika-cache-%ld", (long)getuid());
+    }
+    if (len < 0 || (size_t)len >= size) {
+        return -1;
+    }
+    if (make_directories(buffer) != 0) {
+        fprintf(stderr, "❌ Не удалось создать каталог кэша %s: %s\n", buffer, strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+static unsigned long long parse_size(const char* text) {
+    char* end;
+    unsigned long long value = strtoull(text, &end, 10);
+    switch (*end) {
+        case 'k': case 'K': return value << 10;
+        case 'm': case 'M': return value << 20;
+        case 'g': case 'G': return value << 30;
+        default: return value;
+    }
+}
+
+int build_cache_init(BuildCache* cache, int verbose) {
+    cache->verbose = verbose;
+    cache->max_size = CACHE_DEFAULT_MAX_SIZE;
+
+    const char* limit = getenv("MIKA_CACHE_SIZE");
+    if (limit && *limit) {
+        cache->max_size = parse_size(limit);
+    }
+    return cache_directory(cache->dir, sizeof(cache->dir));
+}
+
+static int cache_path(const BuildCache* cache, const char* suffix, char* buffer, size_t size) {
+    int len = snprintf(buffer, size, "%s%s", cache->dir, suffix);
+    return (len < 0 || (size_t)len >= size) ? -1 : 0;
+}
+
+static int entry_path(const BuildCache* cache, const char* key, char* buffer, size_t size, int create_dir) {
+    int len = snprintf(buffer, size, "%s/objects/%.2s", cache->dir, key);
+    if (len < 0 || (size_t)len >= size) {
+        return -1;
+    }
+    if (create_dir && make_directories(buffer) != 0) {
+        return -1;
+    }
+    len = snprintf(buffer + len, size - (size_t)len, "/%s", key + 2);
+    return (len < 0 || (size_t)len >= size) ? -1 : 0;
+}
+
+/* ---------- Исходники ---------- */
+
+static char* read_whole_file(const char* path, size_t* out_len) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fileno(file), &st) != 0) {
+        fclose(file);
+        return NULL;
+    }
+
+    size_t len = (size_t)st.st_size;
+    char* data = malloc(len + 1);
+    if (data && fread(data, 1, len, file) != len) {
+        free(data);
+        data = NULL;
+    }
+    fclose(file);
+    if (data) {
+        data[len] = '\0';
+        *out_len = len;
+    }
+    return data;
+}
+
+int hash_source_tree(Hasher* hasher, const char* path) {
+    DependencyList deps;
+    deps_init(&deps);
+
+    int result = hasher_update_file(hasher, path);
+    if (result == 0) {
+        hasher_update_u64(hasher, (uint64_t)(deps_scan_file(&deps, path) != 0));
+        for (int i = 0; i < deps.count; i++) {
+            hasher_update_string(hasher, deps.paths[i]);
+            if (hasher_update_file(hasher, deps.paths[i]) != 0) {
+                hasher_update_string(hasher, "missing");
+            }
+        }
+    }
+    deps_free(&deps);
+    return result;
+}
+
+/* ---------- Копирование и статистика ---------- */
+
+static int copy_file(const char* src, const char* dst, unsigned long long* copied) {
+    char tmp[PATH_MAX];
+    int in = open(src, O_RDONLY);
+    if (in < 0) {
+        return -1;
+    }
+
+    struct stat st;
+    int len = snprintf(tmp, sizeof(tmp), "%s.tmpXXXXXX", dst);
+    if (fstat(in, &st) != 0 || len < 0 || (size_t)len >= sizeof(tmp)) {
+        close(in);
+        return -1;
+    }
+
+    int out = mkstemp(tmp);
+    if (out < 0) {
+        close(in);
+        return -1;
+    }
+
+    char buffer[64 * 1024];
+    unsigned long long total = 0;
+    ssize_t got;
+    int failed = fchmod(out, st.st_mode & 0777) != 0;
+    while (!failed && (got = read(in, buffer, sizeof(buffer))) != 0) {
+        if (got < 0) {
+            if (errno == EINTR) continue;
+            failed = 1;
+            break;
+        }
+        for (ssize_t done = 0; done < got; ) {
+            ssize_t put = write(out, buffer + done, (size_t)(got - done));
+            if (put < 0) {
+                if (errno == EINTR) continue;
+                failed = 1;
+                break;
+            }
+            done += put;
+        }
+        total += (unsigned long long)got;
+    }
+
+    close(in);
+    if (close(out) != 0 || failed || rename(tmp, dst) != 0) {
+        unlink(tmp);
+        return -1;
+    }
+    if (copied) {
+        *copied = total;
+    }
+    return 0;
+}
+
+static void parse_stats(const char* text, CacheStats* stats) {
+    memset(stats, 0, sizeof(*stats));
+    for (const char* line = text; line && *line; ) {
+        sscanf(line, "hits %llu", &stats->hits);
+        sscanf(line, "misses %llu", &stats->misses);
+        sscanf(line, "bytes_saved %llu", &stats->bytes_saved);
+        sscanf(line, "size %llu", &stats->size);
+        sscanf(line, "entries %llu", &stats->entries);
+        line = strchr(line, '\n');
+        if (line) line++;
+    }
+}
+
+static int compare_entries(const void* lhs, const void* rhs) {
+    const CacheEntry* a = lhs;
+    const CacheEntry* b = rhs;
+    return (a->mtime > b->mtime) - (a->mtime < b->mtime);
+}
+
+static void evict(BuildCache* cache, CacheStats* stats) {
+    char objects[PATH_MAX];
+    DIR* top = cache_path(cache, "/objects", objects, sizeof(objects)) == 0 ? opendir(objects) : NULL;
+    if (!top) {
+        return;
+    }
+
+    CacheEntry* entries = NULL;
+    size_t count = 0, capacity = 0;
+    unsigned long long total = 0;
+    struct dirent* bucket;
+
+    while ((bucket = readdir(top)) != NULL) {
+        if (bucket->d_name[0] == '.') continue;
+
+        char bucket_path[PATH_MAX];
+        int bucket_len = snprintf(bucket_path, sizeof(bucket_path), "%s/%s", objects, bucket->d_name);
+        if (bucket_len < 0 || (size_t)bucket_len >= sizeof(bucket_path)) continue;
+        DIR* dir = opendir(bucket_path);
+        if (!dir) continue;
+
+        struct dirent* item;
+        while ((item = readdir(dir)) != NULL) {
+            if (item->d_name[0] == '.' || strstr(item->d_name, ".tmp")) continue;
+
+            char path[PATH_MAX];
+            struct stat st;
+            int len = snprintf(path, sizeof(path), "%s/%s", bucket_path, item->d_name);
+            if (len < 0 || (size_t)len >= sizeof(path) || stat(path, &st) != 0) continue;
+
+            if (count == capacity) {
+                capacity = capacity ? capacity * 2 : 256;
+                CacheEntry* grown = realloc(entries, capacity * sizeof(CacheEntry));
+                if (!grown) break;
+                entries = grown;
+            }
+            entries[count].path = strdup(path);
+            entries[count].size = (unsigned long long)st.st_size;
+            entries[count].mtime = st.st_mtime;
+            total += entries[count].size;
+            count++;
+        }
+        closedir(dir);
+    }
+    closedir(top);
+
+    qsort(entries, count, sizeof(CacheEntry), compare_entries);
+
+    unsigned long long target = cache->max_size / 10 * 9;
+    size_t removed = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (total > target && entries[i].path && unlink(entries[i].path) == 0) {
+            total -= entries[i].size;
+            removed++;
+        }
+        free(entries[i].path);
+    }
+    free(entries);
+
+    if (cache->verbose && removed > 0) {
+        printf("   🧹 Кэш: удалено старых записей: %zu\n", removed);
+    }
+    stats->size = total;
+    stats->entries = count - removed;
+}
+
+static int update_stats(BuildCache* cache, const CacheStats* delta) {
+    char path[PATH_MAX];
+    int fd = cache_path(cache, "/stats", path, sizeof(path)) == 0 ? open(path, O_RDWR | O_CREAT, 0644) : -1;
+    if (fd < 0) {
+        return -1;
+    }
+
+    struct flock lock = {0};
+    lock.l_type = F_WRLCK;
+    lock.l_whence = SEEK_SET;
+    while (fcntl(fd, F_SETLKW, &lock) != 0) {
+        if (errno != EINTR) {
+            close(fd);
+            return -1;
+        }
+    }
+
+    char text[512];
+    ssize_t got = pread(fd, text, sizeof(text) - 1, 0);
+    text[got > 0 ? got : 0] = '\0';
+
+    CacheStats stats;
+    parse_stats(text, &stats);
+    stats.hits += delta->hits;
+    stats.misses += delta->misses;
+    stats.bytes_saved += delta->bytes_saved;
+    stats.size += delta->size;
+    stats.entries += delta->entries;
+
+    if (stats.size > cache->max_size) {
+        evict(cache, &stats);
+    }
+
+    int len = snprintf(text, sizeof(text),
+        "hits %llu\nmisses %llu\nbytes_saved %llu\nsize %llu\nentries %llu\n",
+        stats.hits, stats.misses, stats.bytes_saved, stats.size, stats.entries);
+    int failed = ftruncate(fd, 0) != 0 || pwrite(fd, text, (size_t)len, 0) != len;
+    close(fd);
+    return failed ? -1 : 0;
+}
+
+/* ---------- Кэш сборки ---------- */
+
+int build_cache_fetch(BuildCache* cache, const char* key, const char* output) {
+    char path[PATH_MAX];
+    CacheStats delta = {0};
+    unsigned long long size = 0;
+
+    if (entry_path(cache, key, path, sizeof(path), 0) != 0 || copy_file(path, output, &size) != 0) {
+        delta.misses = 1;
+        update_stats(cache, &delta);
+        return 0;
+    }
+
+    utimensat(AT_FDCWD, path, NULL, 0);
+    delta.hits = 1;
+    delta.bytes_saved = size;
+    update_stats(cache, &delta);
+    return 1;
+}
+
+int build_cache_store(BuildCache* cache, const char* key, const char* output) {
+    char path[PATH_MAX];
+    CacheStats delta = {0};
+    struct stat st;
+
+    if (entry_path(cache, key, path, sizeof(path), 1) != 0) {
+        return -1;
+    }
+    int existed = stat(path, &st) == 0;
+    if (copy_file(output, path, &delta.size) != 0) {
+        return -1;
+    }
+    if (existed) {
+        delta.size -= (unsigned long long)st.st_size;
+    } else {
+        delta.entries = 1;
+    }
+    return update_stats(cache, &delta);
+}
+
+int build_cache_read_stats(BuildCache* cache, CacheStats* stats) {
+    char path[PATH_MAX];
+    size_t len;
+    char* text = cache_path(cache, "/stats", path, sizeof(path)) == 0 ? read_whole_file(path, &len) : NULL;
+    parse_stats(text ? text : "", stats);
+    free(text);
+    return 0;
+}
+
+void build_cache_print_stats(BuildCache* cache) {
+    CacheStats stats;
+    build_cache_read_stats(cache, &stats);
+
+    unsigned long long lookups = stats.hits + stats.misses;
+    printf("📊 Статистика кэша сборки Mika\n");
+    printf("   Каталог:         %s\n", cache->dir);
+    printf("   Попадания:       %llu\n", stats.hits);
+    printf("   Промахи:         %llu\n", stats.misses);
+    printf("   Доля попаданий:  %.1f%%\n", lookups ? 100.0 * (double)stats.hits / (double)lookups : 0.0);
+    printf("   Сэкономлено:     %llu байт\n", stats.bytes_saved);
+    printf("   Размер кэша:     %llu из %llu байт (записей: %llu)\n", stats.size, cache->max_size, stats.entries);
+}
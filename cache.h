@@ -0,0 +1,35 @@
+#ifndef MIKA_CACHE_H
+#define MIKA_CACHE_H
+
+#include <stddef.h>
+#include <limits.h>
+
+#include "hash.h"
+
+#define CACHE_DEFAULT_MAX_SIZE (1024ULL * 1024 * 1024)
+
+typedef struct {
+    char dir[PATH_MAX];
+    unsigned long long max_size;
+    int verbose;
+} BuildCache;
+
+typedef struct {
+    unsigned long long hits;
+    unsigned long long misses;
+    unsigned long long bytes_saved;
+    unsigned long long size;
+    unsigned long long entries;
+} CacheStats;
+
+int cache_directory(char* buffer, size_t size);
+int make_directories(char* path);
+
+int build_cache_init(BuildCache* cache, int verbose);
+int hash_source_tree(Hasher* hasher, const char* path);
+int build_cache_fetch(BuildCache* cache, const char* key, const char* output);
+int build_cache_store(BuildCache* cache, const char* key, const char* output);
+int build_cache_read_stats(BuildCache* cache, CacheStats* stats);
+void build_cache_print_stats(BuildCache* cache);
+
+#endif
@@ -0,0 +1,354 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "callgraph.h"
+#include "arena.h"
+#include "parser.h"
+#include "source.h"
+
+void callgraph_init(CallGraph* graph) {
+    memset(graph, 0, sizeof(*graph));
+}
+
+void callgraph_free(CallGraph* graph) {
+    for (int i = 0; i < graph->count; i++) {
+        free(graph->functions[i].name);
+    }
+    free(graph->functions);
+    free(graph->slots);
+    free(graph->edges);
+    callgraph_init(graph);
+}
+
+/* ---------- Таблица имён ---------- */
+
+static unsigned hash_name(const char* name, size_t len) {
+    unsigned hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ (unsigned char)name[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static int find_slot(const CallGraph* graph, const char* name, size_t len) {
+    unsigned mask = (unsigned)graph->slot_count - 1;
+    unsigned slot = hash_name(name, len) & mask;
+
+    for (;;) {
+        int index = graph->slots[slot];
+        if (index < 0) {
+            return (int)slot;
+        }
+        const char* known = graph->functions[index].name;
+        if (strncmp(known, name, len) == 0 && known[len] == '\0') {
+            return (int)slot;
+        }
+        slot = (slot + 1) & mask;
+    }
+}
+
+static int grow_slots(CallGraph* graph) {
+    int count = graph->slot_count ? graph->slot_count * 2 : 256;
+    int* slots = malloc((size_t)count * sizeof(int));
+    if (!slots) {
+        return -1;
+    }
+    for (int i = 0; i < count; i++) {
+        slots[i] = -1;
+    }
+    free(graph->slots);
+    graph->slots = slots;
+    graph->slot_count = count;
+    for (int i = 0; i < graph->count; i++) {
+        const char* name = graph->functions[i].name;
+        graph->slots[find_slot(graph, name, strlen(name))] = i;
+    }
+    return 0;
+}
+
+static int intern(CallGraph* graph, const char* name, size_t len) {
+    if (graph->count * 2 >= graph->slot_count && grow_slots(graph) != 0) {
+        return -1;
+    }
+    int slot = find_slot(graph, name, len);
+    if (graph->slots[slot] >= 0) {
+        return graph->slots[slot];
+    }
+
+    if (graph->count == graph->capacity) {
+        int capacity = graph->capacity ? graph->capacity * 2 : 64;
+        CallGraphFunction* grown = realloc(graph->functions, (size_t)capacity * sizeof(CallGraphFunction));
+        if (!grown) {
+            return -1;
+        }
+        graph->functions = grown;
+        graph->capacity = capacity;
+    }
+    CallGraphFunction* function = &graph->functions[graph->count];
+    memset(function, 0, sizeof(*function));
+    function->name = malloc(len + 1);
+    if (!function->name) {
+        return -1;
+    }
+    memcpy(function->name, name, len);
+    function->name[len] = '\0';
+    graph->slots[slot] = graph->count;
+    return graph->count++;
+}
+
+const CallGraphFunction* callgraph_find(const CallGraph* graph, const char* name) {
+    if (graph->slot_count == 0) {
+        return NULL;
+    }
+    int index = graph->slots[find_slot(graph, name, strlen(name))];
+    return index >= 0 ? &graph->functions[index] : NULL;
+}
+
+/* ---------- Обход модулей ---------- */
+
+typedef struct {
+    CallGraph* graph;
+    int caller;
+    int size;
+    int failed;
+} Walker;
+
+static void add_edge(Walker* walker, const Node* callee, int in_loop) {
+    CallGraph* graph = walker->graph;
+    int index = intern(graph, callee->u.lit.text, callee->u.lit.len);
+
+    if (index < 0) {
+        walker->failed = 1;
+        return;
+    }
+    if (graph->edge_count == graph->edge_capacity) {
+        int capacity = graph->edge_capacity ? graph->edge_capacity * 2 : 256;
+        CallGraphEdge* grown = realloc(graph->edges, (size_t)capacity * sizeof(CallGraphEdge));
+        if (!grown) {
+            walker->failed = 1;
+            return;
+        }
+        graph->edges = grown;
+        graph->edge_capacity = capacity;
+    }
+    graph->edges[graph->edge_count].caller = walker->caller;
+    graph->edges[graph->edge_count].callee = index;
+    graph->edges[graph->edge_count].in_loop = in_loop;
+    graph->edge_count++;
+}
+
+/* Обходит список узлов; размер функции — число узлов её тела. */
+static void walk(Walker* walker, const Node* node, int in_loop) {
+    for (; node; node = node->next) {
+        walker->size++;
+        switch (node->kind) {
+            case NODE_UNARY: case NODE_POSTFIX:
+                walk(walker, node->u.unary.operand, in_loop);
+                break;
+            case NODE_BINARY: case NODE_ASSIGN: {
+                /* левая цепочка a + b + c ... — циклом: важны только
+                   размер и рёбра, порядок обхода не нужен */
+                const Node* link = node;
+                while (link->u.binary.lhs->kind == NODE_BINARY) {
+                    walk(walker, link->u.binary.rhs, in_loop);
+                    link = link->u.binary.lhs;
+                    walker->size++;
+                }
+                walk(walker, link->u.binary.lhs, in_loop);
+                walk(walker, link->u.binary.rhs, in_loop);
+                break;
+            }
+            case NODE_TERNARY: case NODE_IF:
+                walk(walker, node->u.cond.cond, in_loop);
+                walk(walker, node->u.cond.then_branch, in_loop);
+                walk(walker, node->u.cond.else_branch, in_loop);
+                break;
+            case NODE_CALL:
+                if (node->u.call.callee->kind == NODE_IDENT) {
+                    add_edge(walker, node->u.call.callee, in_loop);
+                } else {
+                    walk(walker, node->u.call.callee, in_loop);
+                }
+                walk(walker, node->u.call.args, in_loop);
+                break;
+            case NODE_INDEX:
+                walk(walker, node->u.index.base, in_loop);
+                walk(walker, node->u.index.index, in_loop);
+                break;
+            case NODE_MEMBER:
+                walk(walker, node->u.member.base, in_loop);
+                break;
+            case NODE_CAST: case NODE_SIZEOF:
+                walk(walker, node->u.cast.expr, in_loop);
+                break;
+            case NODE_INIT_LIST: case NODE_BLOCK:
+                walk(walker, node->u.list.items, in_loop);
+                break;
+            case NODE_DECL:
+                walk(walker, node->u.decl.vars, in_loop);
+                break;
+            case NODE_VAR: case NODE_PARAM:
+                walk(walker, node->u.var.dims, in_loop);
+                walk(walker, node->u.var.init, in_loop);
+                break;
+            case NODE_WHILE: case NODE_DO: case NODE_FOR: case NODE_PARALLEL_FOR:
+                walk(walker, node->u.loop.init, in_loop);
+                walk(walker, node->u.loop.cond, 1);
+                walk(walker, node->u.loop.step, 1);
+                walk(walker, node->u.loop.body, 1);
+                break;
+            case NODE_SWITCH:
+                walk(walker, node->u.loop.cond, in_loop);
+                walk(walker, node->u.loop.body, in_loop);
+                break;
+            case NODE_RETURN: case NODE_EXPR_STMT: case NODE_CASE:
+                walk(walker, node->u.ret.value, in_loop);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+static int add_function(CallGraph* graph, const char* path, const Node* func) {
+    const char* name = func->u.func.name;
+    int index = intern(graph, name, strlen(name));
+    if (index < 0) {
+        return -1;
+    }
+    if (!func->u.func.body) {
+        return 0;
+    }
+
+    CallGraphFunction* function = &graph->functions[index];
+    if (function->defined) {
+        fprintf(stderr, "%s:%d: ошибка: функция %s уже определена в %s\n", path, func->line, name,
+                function->module);
+        return -1;
+    }
+    function->defined = 1;
+    function->module = path;
+
+    Walker walker = {graph, index, 0, 0};
+    walk(&walker, func->u.func.body, 0);
+    graph->functions[index].size = walker.size;
+    return walker.failed ? -1 : 0;
+}
+
+int callgraph_add_module(CallGraph* graph, const char* path) {
+    SourceFile source;
+    Arena arena;
+    Parser parser;
+    Node* item;
+    int status = 0;
+
+    if (source_open(&source, path) != 0) {
+        return -1;
+    }
+    arena_init(&arena, ARENA_DEFAULT_CHUNK);
+    parser_init(&parser, &arena, source.data, source.len, path);
+
+    ArenaMark start = arena_mark(&arena);
+    while (status == 0 && (item = parse_item(&parser, &status)) != NULL) {
+        if (item->kind == NODE_FUNCTION && add_function(graph, path, item) != 0) {
+            status = -1;
+        }
+        arena_reset(&arena, start);
+    }
+
+    arena_free(&arena);
+    source_close(&source);
+    return status;
+}
+
+/* ---------- Подсказки ---------- */
+
+/* Помечает всё, что вызывается из функций очереди, прямо или косвенно. */
+static void mark_from(const int* first, const int* targets, char* marks, int* queue, int count) {
+    int head = 0;
+    while (head < count) {
+        int function = queue[head++];
+        for (int i = first[function]; i < first[function + 1]; i++) {
+            int callee = targets[i];
+            if (!marks[callee]) {
+                marks[callee] = 1;
+                queue[count++] = callee;
+            }
+        }
+    }
+}
+
+/* Недостижимое из main — холодное (мёртвый код или обратные вызовы);
+   вызываемое из цикла и всё, что оно вызывает, — горячее. Маленькие
+   горячие функции помечаются inline. */
+void callgraph_finish(CallGraph* graph) {
+    int count = graph->count;
+    int* first = calloc((size_t)count + 1, sizeof(int));
+    int* fill = malloc(((size_t)count + 1) * sizeof(int));
+    int* targets = malloc(((size_t)graph->edge_count + 1) * sizeof(int));
+    int* queue = malloc(((size_t)count + 1) * sizeof(int));
+    char* reachable = calloc((size_t)count + 1, 1);
+    char* hot = calloc((size_t)count + 1, 1);
+
+    if (!first || !fill || !targets || !queue || !reachable || !hot) {
+        goto done;
+    }
+
+    for (int i = 0; i < graph->edge_count; i++) {
+        const CallGraphEdge* edge = &graph->edges[i];
+        first[edge->caller + 1]++;
+        graph->functions[edge->callee].calls++;
+        graph->functions[edge->callee].loop_calls += edge->in_loop;
+    }
+    for (int i = 0; i < count; i++) {
+        first[i + 1] += first[i];
+    }
+    memcpy(fill, first, (size_t)count * sizeof(int));
+    for (int i = 0; i < graph->edge_count; i++) {
+        targets[fill[graph->edges[i].caller]++] = graph->edges[i].callee;
+    }
+
+    const CallGraphFunction* entry = callgraph_find(graph, "main");
+    int root = entry && entry->defined ? (int)(entry - graph->functions) : -1;
+    if (root >= 0) {
+        reachable[root] = 1;
+        queue[0] = root;
+        mark_from(first, targets, reachable, queue, 1);
+    } else {
+        memset(reachable, 1, (size_t)count);
+    }
+
+    int seeds = 0;
+    for (int i = 0; i < graph->edge_count; i++) {
+        const CallGraphEdge* edge = &graph->edges[i];
+        if (edge->in_loop && reachable[edge->caller] && !hot[edge->callee]) {
+            hot[edge->callee] = 1;
+            queue[seeds++] = edge->callee;
+        }
+    }
+    mark_from(first, targets, hot, queue, seeds);
+
+    for (int i = 0; i < count; i++) {
+        CallGraphFunction* function = &graph->functions[i];
+        if (!function->defined || i == root) {
+            function->hint = CALL_HINT_NONE;
+        } else if (!reachable[i]) {
+            function->hint = CALL_HINT_COLD;
+        } else if (hot[i]) {
+            function->hint = function->size <= CALLGRAPH_INLINE_SIZE ? CALL_HINT_INLINE : CALL_HINT_HOT;
+        } else {
+            function->hint = CALL_HINT_NONE;
+        }
+    }
+
+done:
+    free(first);
+    free(fill);
+    free(targets);
+    free(queue);
+    free(reachable);
+    free(hot);
+}
@@ -0,0 +1,49 @@
+#ifndef MIKA_CALLGRAPH_H
+#define MIKA_CALLGRAPH_H
+
+/* Граф вызовов всей программы для сборки --whole-program: какие функции
+   определены в модулях, кто кого вызывает и из циклов ли. */
+
+#define CALLGRAPH_INLINE_SIZE 60
+
+typedef enum {
+    CALL_HINT_NONE,
+    CALL_HINT_INLINE,
+    CALL_HINT_HOT,
+    CALL_HINT_COLD
+} CallHint;
+
+typedef struct {
+    char* name;
+    const char* module;
+    int defined;
+    int size;
+    int calls;
+    int loop_calls;
+    CallHint hint;
+} CallGraphFunction;
+
+typedef struct {
+    int caller;
+    int callee;
+    int in_loop;
+} CallGraphEdge;
+
+typedef struct {
+    CallGraphFunction* functions;
+    int count;
+    int capacity;
+    int* slots;
+    int slot_count;
+    CallGraphEdge* edges;
+    int edge_count;
+    int edge_capacity;
+} CallGraph;
+
+void callgraph_init(CallGraph* graph);
+int callgraph_add_module(CallGraph* graph, const char* path);
+void callgraph_finish(CallGraph* graph);
+const CallGraphFunction* callgraph_find(const CallGraph* graph, const char* name);
+void callgraph_free(CallGraph* graph);
+
+#endif
@@ -0,0 +1,526 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "codegen.h"
+
+static void emit_expr(Emitter* em, const Node* node, int min_prec);
+static void emit_statement(Emitter* em, const Node* node);
+
+void emitter_init(Emitter* em, FILE* out, const char* source) {
+    em->out = out;
+    em->indent = 0;
+    em->prev_kind = -1;
+    em->prev_definition = 0;
+    em->failed = 0;
+    em->source = source;
+    em->line = 0;
+    em->counted = 0;
+    em->used = 0;
+}
+
+static size_t count_newlines(const char* text, size_t len) {
+    size_t lines = 0;
+    const char* end = text + len;
+    for (const char* nl = text; (nl = memchr(nl, '\n', (size_t)(end - nl))) != NULL; nl++) {
+        lines++;
+    }
+    return lines;
+}
+
+/* Строки вывода считаются не в каждом put, а одним проходом по ещё не
+   просмотренной части буфера — перед #line и перед сбросом буфера. */
+static void count_lines(Emitter* em) {
+    if (em->line > 0) {
+        em->line += (int)count_newlines(em->buf + em->counted, em->used - em->counted);
+    }
+    em->counted = em->used;
+}
+
+int emitter_flush(Emitter* em) {
+    count_lines(em);
+    if (em->used > 0 && fwrite(em->buf, 1, em->used, em->out) != em->used) {
+        em->failed = 1;
+    }
+    em->used = 0;
+    em->counted = 0;
+    return em->failed ? -1 : 0;
+}
+
+static void put_large(Emitter* em, const char* text, size_t len) {
+    emitter_flush(em);
+    if (len > EMIT_BUFFER_SIZE) {
+        if (em->line > 0) {
+            em->line += (int)count_newlines(text, len);
+        }
+        if (fwrite(text, 1, len, em->out) != len) {
+            em->failed = 1;
+        }
+        return;
+    }
+    memcpy(em->buf, text, len);
+    em->used = len;
+}
+
+static inline void put_len(Emitter* em, const char* text, size_t len) {
+    if (em->used + len > EMIT_BUFFER_SIZE) {
+        put_large(em, text, len);
+        return;
+    }
+    memcpy(em->buf + em->used, text, len);
+    em->used += len;
+}
+
+#define put(em, text) put_len((em), (text), strlen(text))
+
+void emitter_write(Emitter* em, const char* text, size_t len) {
+    put_len(em, text, len);
+}
+
+/* Директива #line перед строкой, если она разошлась с исходником .mk */
+static void emit_line_mapping(Emitter* em, const Node* node) {
+    if (!em->source || node->line <= 0) {
+        return;
+    }
+    count_lines(em);
+    if (em->line == node->line) {
+        return;
+    }
+    char number[32];
+    em->line = 0;
+    put_len(em, number, (size_t)snprintf(number, sizeof(number), "#line %d \"", node->line));
+    for (const char* c = em->source; *c; c++) {
+        if (*c == '"' || *c == '\\') put(em, "\\");
+        put_len(em, c, 1);
+    }
+    put(em, "\"\n");
+    em->counted = em->used;
+    em->line = node->line;
+}
+
+typedef struct {
+    const char* text;
+    size_t len;
+} SpacedOperator;
+
+#define SPACED(text) {text, sizeof(text) - 1}
+
+static const SpacedOperator spaced_operator[TOK_COUNT] = {
+    [TOK_COMMA] = SPACED(", "),
+    [TOK_PLUS] = SPACED(" + "), [TOK_MINUS] = SPACED(" - "), [TOK_STAR] = SPACED(" * "), [TOK_SLASH] = SPACED(" / "),
+    [TOK_PERCENT] = SPACED(" % "), [TOK_AMP] = SPACED(" & "), [TOK_PIPE] = SPACED(" | "), [TOK_CARET] = SPACED(" ^ "),
+    [TOK_LT] = SPACED(" < "), [TOK_GT] = SPACED(" > "), [TOK_LE] = SPACED(" <= "), [TOK_GE] = SPACED(" >= "),
+    [TOK_EQ] = SPACED(" == "), [TOK_NE] = SPACED(" != "), [TOK_ANDAND] = SPACED(" && "), [TOK_OROR] = SPACED(" || "),
+    [TOK_SHL] = SPACED(" << "), [TOK_SHR] = SPACED(" >> "),
+    [TOK_ASSIGN] = SPACED(" = "), [TOK_PLUS_ASSIGN] = SPACED(" += "), [TOK_MINUS_ASSIGN] = SPACED(" -= "),
+    [TOK_STAR_ASSIGN] = SPACED(" *= "), [TOK_SLASH_ASSIGN] = SPACED(" /= "), [TOK_PERCENT_ASSIGN] = SPACED(" %= "),
+    [TOK_AMP_ASSIGN] = SPACED(" &= "), [TOK_PIPE_ASSIGN] = SPACED(" |= "), [TOK_CARET_ASSIGN] = SPACED(" ^= "),
+    [TOK_SHL_ASSIGN] = SPACED(" <<= "), [TOK_SHR_ASSIGN] = SPACED(" >>= "),
+};
+
+#undef SPACED
+
+static void put_operator(Emitter* em, TokenKind op) {
+    put_len(em, spaced_operator[op].text, spaced_operator[op].len);
+}
+
+static void put_indent(Emitter* em) {
+    static const char spaces[] = "                                ";
+    size_t width = (size_t)em->indent * 4;
+    while (width > 0) {
+        size_t chunk = width < sizeof(spaces) - 1 ? width : sizeof(spaces) - 1;
+        put_len(em, spaces, chunk);
+        width -= chunk;
+    }
+}
+
+static void emit_type(Emitter* em, const TypeRef* type, int with_pointers) {
+    if (type->storage & STORAGE_HOT) put(em, "__attribute__((hot)) ");
+    if (type->storage & STORAGE_COLD) put(em, "__attribute__((cold)) ");
+    if (type->storage & STORAGE_STATIC) put(em, "static ");
+    if (type->storage & STORAGE_EXTERN) put(em, "extern ");
+    if (type->storage & STORAGE_INLINE) put(em, "inline ");
+    if (type->is_const) put(em, "const ");
+    put(em, type->name);
+    if (with_pointers) {
+        for (int i = 0; i < type->pointers; i++) {
+            put(em, "*");
+        }
+    }
+}
+
+static int node_precedence(const Node* node) {
+    switch (node->kind) {
+        case NODE_BINARY: return binary_precedence(node->u.binary.op);
+        case NODE_ASSIGN: return PREC_ASSIGN;
+        case NODE_TERNARY: return PREC_TERNARY;
+        case NODE_UNARY: case NODE_CAST: case NODE_SIZEOF: return PREC_UNARY;
+        case NODE_CALL: case NODE_INDEX: case NODE_MEMBER: case NODE_POSTFIX: return PREC_POSTFIX;
+        default: return PREC_PRIMARY;
+    }
+}
+
+static void emit_args(Emitter* em, const Node* args) {
+    for (const Node* arg = args; arg; arg = arg->next) {
+        emit_expr(em, arg, PREC_ASSIGN);
+        if (arg->next) put(em, ", ");
+    }
+}
+
+/* Звенья одного приоритета не берутся в скобки: левый операнд и все
+   правые печатаются подряд */
+static void emit_binary(Emitter* em, const Node* node, int prec) {
+    BinaryChain chain;
+
+    if (!binary_chain_init(&chain, node)) {
+        perror("Ошибка выделения памяти");
+        em->failed = 1;
+        return;
+    }
+    emit_expr(em, binary_chain_first(&chain), prec);
+    for (size_t i = chain.count; i > 0; i--) {
+        put_operator(em, chain.links[i - 1]->u.binary.op);
+        emit_expr(em, chain.links[i - 1]->u.binary.rhs, prec + 1);
+    }
+    binary_chain_free(&chain);
+}
+
+static void emit_expr(Emitter* em, const Node* node, int min_prec) {
+    int prec = node_precedence(node);
+    int parens = prec < min_prec;
+
+    if (parens) put(em, "(");
+
+    switch (node->kind) {
+        case NODE_INT: case NODE_FLOAT: case NODE_STRING: case NODE_CHAR:
+        case NODE_BOOL: case NODE_IDENT:
+            put_len(em, node->u.lit.text, node->u.lit.len);
+            break;
+        case NODE_UNARY: {
+            const char* op = token_kind_name(node->u.unary.op);
+            const Node* operand = node->u.unary.operand;
+            put(em, op);
+            if (operand->kind == NODE_UNARY && token_kind_name(operand->u.unary.op)[0] == op[0]) {
+                put(em, " ");
+            }
+            emit_expr(em, operand, PREC_UNARY);
+            break;
+        }
+        case NODE_POSTFIX:
+            emit_expr(em, node->u.unary.operand, PREC_POSTFIX);
+            put(em, token_kind_name(node->u.unary.op));
+            break;
+        case NODE_BINARY:
+            emit_binary(em, node, prec);
+            break;
+        case NODE_ASSIGN:
+            emit_expr(em, node->u.binary.lhs, PREC_UNARY);
+            put_operator(em, node->u.binary.op);
+            emit_expr(em, node->u.binary.rhs, PREC_ASSIGN);
+            break;
+        case NODE_TERNARY:
+            emit_expr(em, node->u.cond.cond, PREC_OROR);
+            put(em, " ? ");
+            emit_expr(em, node->u.cond.then_branch, PREC_COMMA);
+            put(em, " : ");
+            emit_expr(em, node->u.cond.else_branch, PREC_TERNARY);
+            break;
+        case NODE_CALL:
+            emit_expr(em, node->u.call.callee, PREC_POSTFIX);
+            put(em, "(");
+            emit_args(em, node->u.call.args);
+            put(em, ")");
+            break;
+        case NODE_INDEX:
+            emit_expr(em, node->u.index.base, PREC_POSTFIX);
+            put(em, "[");
+            emit_expr(em, node->u.index.index, PREC_COMMA);
+            put(em, "]");
+            break;
+        case NODE_MEMBER:
+            emit_expr(em, node->u.member.base, PREC_POSTFIX);
+            put(em, node->u.member.arrow ? "->" : ".");
+            put(em, node->u.member.name);
+            break;
+        case NODE_CAST:
+            put(em, "(");
+            emit_type(em, &node->u.cast.type, 1);
+            put(em, ")");
+            emit_expr(em, node->u.cast.expr, PREC_UNARY);
+            break;
+        case NODE_SIZEOF:
+            put(em, "sizeof(");
+            if (node->u.cast.expr) {
+                emit_expr(em, node->u.cast.expr, PREC_COMMA);
+            } else {
+                emit_type(em, &node->u.cast.type, 1);
+            }
+            put(em, ")");
+            break;
+        case NODE_INIT_LIST:
+            put(em, "{");
+            for (const Node* item = node->u.list.items; item; item = item->next) {
+                emit_expr(em, item, PREC_ASSIGN);
+                if (item->next) put(em, ", ");
+            }
+            put(em, "}");
+            break;
+        default:
+            break;
+    }
+
+    if (parens) put(em, ")");
+}
+
+static void emit_declarator(Emitter* em, const Node* var, int base_pointers, int attach) {
+    int extra = var->u.var.type.pointers - base_pointers;
+    if (!attach && (extra > 0 || var->u.var.name)) put(em, " ");
+    for (int i = 0; i < extra; i++) put(em, "*");
+    if (attach && var->u.var.name) put(em, " ");
+    if (var->u.var.name) put(em, var->u.var.name);
+    for (const Node* dim = var->u.var.dims; dim; dim = dim->next) {
+        put(em, "[");
+        if (dim->kind != NODE_EMPTY) emit_expr(em, dim, PREC_COMMA);
+        put(em, "]");
+    }
+    if (var->kind == NODE_VAR && var->u.var.init) {
+        put(em, " = ");
+        emit_expr(em, var->u.var.init, PREC_ASSIGN);
+    }
+}
+
+static void emit_decl_inline(Emitter* em, const Node* decl) {
+    const Node* vars = decl->u.decl.vars;
+    int single = vars && !vars->next;
+
+    emit_type(em, &decl->u.decl.type, 0);
+    for (const Node* var = vars; var; var = var->next) {
+        emit_declarator(em, var, 0, single);
+        if (var->next) put(em, ",");
+    }
+    put(em, ";");
+}
+
+static void emit_params(Emitter* em, const Node* func) {
+    const Node* params = func->u.func.params;
+    put(em, "(");
+    if (!params && !func->u.func.variadic) {
+        put(em, "void");
+    }
+    for (const Node* param = params; param; param = param->next) {
+        TypeRef base = param->u.var.type;
+        base.pointers = 0;
+        emit_type(em, &base, 0);
+        emit_declarator(em, param, 0, 1);
+        if (param->next) put(em, ", ");
+    }
+    if (func->u.func.variadic) {
+        put(em, params ? ", ..." : "...");
+    }
+    put(em, ")");
+}
+
+static void emit_directive(Emitter* em, const Node* node) {
+    put_len(em, node->u.lit.text, node->u.lit.len);
+    put(em, "\n");
+}
+
+static void emit_body(Emitter* em, const Node* body) {
+    if (body->kind == NODE_BLOCK) {
+        put(em, " ");
+        emit_statement(em, body);
+    } else {
+        put(em, "\n");
+        emit_line_mapping(em, body);
+        em->indent++;
+        put_indent(em);
+        emit_statement(em, body);
+        em->indent--;
+    }
+}
+
+static void emit_block(Emitter* em, const Node* block) {
+    int in_case = 0;
+
+    put(em, "{\n");
+    em->indent++;
+    for (const Node* item = block->u.list.items; item; item = item->next) {
+        if (item->kind == NODE_DIRECTIVE) {
+            emit_directive(em, item);
+            continue;
+        }
+        if (item->kind == NODE_CASE && in_case) {
+            em->indent--;
+        }
+        emit_line_mapping(em, item);
+        put_indent(em);
+        emit_statement(em, item);
+        put(em, "\n");
+        if (item->kind == NODE_CASE && !(item->next && item->next->kind == NODE_CASE)) {
+            em->indent++;
+            in_case = 1;
+        } else if (item->kind == NODE_CASE) {
+            in_case = 0;
+        }
+    }
+    if (in_case) {
+        em->indent--;
+    }
+    em->indent--;
+    put_indent(em);
+    put(em, "}");
+}
+
+static void emit_statement(Emitter* em, const Node* node) {
+    switch (node->kind) {
+        case NODE_BLOCK:
+            emit_block(em, node);
+            break;
+        case NODE_DECL:
+            emit_decl_inline(em, node);
+            break;
+        case NODE_EXPR_STMT:
+            emit_expr(em, node->u.ret.value, PREC_COMMA);
+            put(em, ";");
+            break;
+        case NODE_IF:
+            put(em, "if (");
+            emit_expr(em, node->u.cond.cond, PREC_COMMA);
+            put(em, ")");
+            emit_body(em, node->u.cond.then_branch);
+            if (node->u.cond.else_branch) {
+                const Node* other = node->u.cond.else_branch;
+                if (node->u.cond.then_branch->kind == NODE_BLOCK) {
+                    put(em, " else");
+                } else {
+                    put(em, "\n");
+                    put_indent(em);
+                    put(em, "else");
+                }
+                if (other->kind == NODE_IF) {
+                    put(em, " ");
+                    emit_statement(em, other);
+                } else {
+                    emit_body(em, other);
+                }
+            }
+            break;
+        case NODE_WHILE:
+            put(em, "while (");
+            emit_expr(em, node->u.loop.cond, PREC_COMMA);
+            put(em, ")");
+            emit_body(em, node->u.loop.body);
+            break;
+        case NODE_DO:
+            put(em, "do");
+            emit_body(em, node->u.loop.body);
+            if (node->u.loop.body->kind == NODE_BLOCK) {
+                put(em, " ");
+            } else {
+                put(em, "\n");
+                put_indent(em);
+            }
+            put(em, "while (");
+            emit_expr(em, node->u.loop.cond, PREC_COMMA);
+            put(em, ");");
+            break;
+        case NODE_FOR:
+            put(em, "for (");
+            if (node->u.loop.init && node->u.loop.init->kind == NODE_DECL) {
+                emit_decl_inline(em, node->u.loop.init);
+            } else {
+                if (node->u.loop.init) emit_expr(em, node->u.loop.init, PREC_COMMA);
+                put(em, ";");
+            }
+            if (node->u.loop.cond) {
+                put(em, " ");
+                emit_expr(em, node->u.loop.cond, PREC_COMMA);
+            }
+            put(em, ";");
+            if (node->u.loop.step) {
+                put(em, " ");
+                emit_expr(em, node->u.loop.step, PREC_COMMA);
+            }
+            put(em, ")");
+            emit_body(em, node->u.loop.body);
+            break;
+        case NODE_SWITCH:
+            put(em, "switch (");
+            emit_expr(em, node->u.loop.cond, PREC_COMMA);
+            put(em, ")");
+            emit_body(em, node->u.loop.body);
+            break;
+        case NODE_CASE:
+            if (node->u.ret.value) {
+                put(em, "case ");
+                emit_expr(em, node->u.ret.value, PREC_TERNARY);
+                put(em, ":");
+            } else {
+                put(em, "default:");
+            }
+            break;
+        case NODE_RETURN:
+            put(em, "return");
+            if (node->u.ret.value) {
+                put(em, " ");
+                emit_expr(em, node->u.ret.value, PREC_COMMA);
+            }
+            put(em, ";");
+            break;
+        case NODE_BREAK:
+            put(em, "break;");
+            break;
+        case NODE_CONTINUE:
+            put(em, "continue;");
+            break;
+        case NODE_EMPTY:
+            put(em, ";");
+            break;
+        default:
+            break;
+    }
+}
+
+static void emit_function(Emitter* em, const Node* func) {
+    emit_type(em, &func->u.func.ret, 1);
+    put(em, " ");
+    put(em, func->u.func.name);
+    emit_params(em, func);
+    if (func->u.func.body) {
+        put(em, " ");
+        emit_block(em, func->u.func.body);
+        put(em, "\n");
+    } else {
+        put(em, ";\n");
+    }
+}
+
+void emit_item(Emitter* em, const Node* item) {
+    int is_definition = item->kind == NODE_FUNCTION && item->u.func.body;
+    if (em->prev_kind >= 0 && (is_definition || em->prev_definition || (int)item->kind != em->prev_kind)) {
+        put(em, "\n");
+    }
+
+    switch (item->kind) {
+        case NODE_DIRECTIVE:
+            emit_directive(em, item);
+            break;
+        case NODE_RAW:
+            emit_line_mapping(em, item);
+            put_len(em, item->u.lit.text, item->u.lit.len);
+            put(em, "\n");
+            break;
+        case NODE_FUNCTION:
+            emit_line_mapping(em, item);
+            emit_function(em, item);
+            break;
+        case NODE_DECL:
+            emit_line_mapping(em, item);
+            emit_decl_inline(em, item);
+            put(em, "\n");
+            break;
+        default:
+            break;
+    }
+    em->prev_kind = (int)item->kind;
+    em->prev_definition = is_definition;
+}
@@ -0,0 +1,28 @@
+#ifndef MIKA_CODEGEN_H
+#define MIKA_CODEGEN_H
+
+#include <stdio.h>
+
+#include "ast.h"
+
+#define EMIT_BUFFER_SIZE (256 * 1024)
+
+typedef struct {
+    FILE* out;
+    int indent;
+    int prev_kind;
+    int prev_definition;
+    int failed;
+    const char* source;
+    int line;
+    size_t counted;
+    size_t used;
+    char buf[EMIT_BUFFER_SIZE];
+} Emitter;
+
+void emitter_init(Emitter* em, FILE* out, const char* source);
+void emitter_write(Emitter* em, const char* text, size_t len);
+void emit_item(Emitter* em, const Node* item);
+int emitter_flush(Emitter* em);
+
+#endif
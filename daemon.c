@@ -0,0 +1,329 @@
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <limits.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+#include "daemon.h"
+#include "cache.h"
+#include "translate.h"
+
+/* Запрос: длина (uint32) вместе с дескрипторами stdout и stderr клиента
+   в SCM_RIGHTS, затем строки через '\0': версия протокола, каталог,
+   аргументы. Ответ — код выхода (int32). */
+#define DAEMON_PROTOCOL "mikac-daemon-1 " MIKA_VERSION
+
+static volatile sig_atomic_t daemon_stop = 0;
+
+static void on_stop_signal(int sig) {
+    (void)sig;
+    daemon_stop = 1;
+}
+
+int daemon_socket_path(char* buffer, size_t size) {
+    const char* path = getenv("MIKA_DAEMON_SOCKET");
+    char cache[PATH_MAX];
+    int len;
+
+    if (path && *path) {
+        len = snprintf(buffer, size, "%s", path);
+    } else {
+        if (cache_directory(cache, sizeof(cache)) != 0) {
+            return -1;
+        }
+        len = snprintf(buffer, size, "%s/mikac.sock", cache);
+    }
+    if (len < 0 || (size_t)len >= size || (size_t)len >= sizeof(((struct sockaddr_un*)0)->sun_path)) {
+        fprintf(stderr, "❌ Слишком длинный путь к сокету демона (задайте MIKA_DAEMON_SOCKET)\n");
+        return -1;
+    }
+    return 0;
+}
+
+static void socket_address(struct sockaddr_un* addr, const char* path) {
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    snprintf(addr->sun_path, sizeof(addr->sun_path), "%s", path);
+}
+
+static int connect_socket(const char* path) {
+    struct sockaddr_un addr;
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    socket_address(&addr, path);
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static int write_all(int fd, const void* data, size_t len) {
+    const char* p = data;
+    while (len > 0) {
+        ssize_t put = write(fd, p, len);
+        if (put < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += put;
+        len -= (size_t)put;
+    }
+    return 0;
+}
+
+static int read_all(int fd, void* data, size_t len) {
+    char* p = data;
+    while (len > 0) {
+        ssize_t got = read(fd, p, len);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) {
+            return -1;
+        }
+        p += got;
+        len -= (size_t)got;
+    }
+    return 0;
+}
+
+/* ---------- Клиент ---------- */
+
+int daemon_forward(const char* path, int argc, char** argv, int* status) {
+    char cwd[PATH_MAX];
+    char* request = NULL;
+    size_t len = 0;
+    int result = -1;
+
+    int fd = connect_socket(path);
+    if (fd < 0) {
+        return -1;
+    }
+    if (!getcwd(cwd, sizeof(cwd))) {
+        perror("❌ Не удалось определить текущий каталог");
+        goto done;
+    }
+
+    FILE* stream = open_memstream(&request, &len);
+    if (!stream) {
+        goto done;
+    }
+    fwrite(DAEMON_PROTOCOL, 1, sizeof(DAEMON_PROTOCOL), stream);
+    fwrite(cwd, 1, strlen(cwd) + 1, stream);
+    for (int i = 0; i < argc; i++) {
+        fwrite(argv[i], 1, strlen(argv[i]) + 1, stream);
+    }
+    if (fclose(stream) != 0 || len > DAEMON_MAX_REQUEST) {
+        goto done;
+    }
+
+    uint32_t header = (uint32_t)len;
+    int fds[2] = {STDOUT_FILENO, STDERR_FILENO};
+    char control[CMSG_SPACE(sizeof(fds))];
+    struct iovec iov = {&header, sizeof(header)};
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    memset(control, 0, sizeof(control));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+    memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+    fflush(stdout);
+    fflush(stderr);
+    if (sendmsg(fd, &msg, MSG_NOSIGNAL) != (ssize_t)sizeof(header) || write_all(fd, request, len) != 0) {
+        goto done;
+    }
+
+    int32_t code;
+    if (read_all(fd, &code, sizeof(code)) != 0) {
+        fprintf(stderr, "❌ Демон сборки прервал запрос\n");
+        *status = 1;
+    } else {
+        *status = code;
+    }
+    result = 0;
+
+done:
+    free(request);
+    close(fd);
+    return result;
+}
+
+/* ---------- Сервер ---------- */
+
+static int receive_request(int conn, char** request, int fds[2]) {
+    uint32_t header;
+    char control[CMSG_SPACE(sizeof(int) * 2)];
+    struct iovec iov = {&header, sizeof(header)};
+    struct msghdr msg;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    ssize_t got;
+    do {
+        got = recvmsg(conn, &msg, MSG_CMSG_CLOEXEC);
+    } while (got < 0 && errno == EINTR);
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    if (got != (ssize_t)sizeof(header) || !cmsg || cmsg->cmsg_type != SCM_RIGHTS ||
+        cmsg->cmsg_len != CMSG_LEN(sizeof(int) * 2)) {
+        return -1;
+    }
+    memcpy(fds, CMSG_DATA(cmsg), sizeof(int) * 2);
+    if (header == 0 || header > DAEMON_MAX_REQUEST) {
+        return -1;
+    }
+
+    *request = malloc(header + 1);
+    if (!*request || read_all(conn, *request, header) != 0) {
+        return -1;
+    }
+    (*request)[header] = '\0';
+    return (int)header;
+}
+
+static int serve_connection(int conn, DaemonHandler handler, void* data) {
+    char* request = NULL;
+    int fds[2] = {-1, -1};
+    char** argv = NULL;
+    int argc = 0;
+    int32_t code = 1;
+
+    int len = receive_request(conn, &request, fds);
+    if (len < 0 || strcmp(request, DAEMON_PROTOCOL) != 0) {
+        if (fds[1] >= 0) {
+            dprintf(fds[1], "❌ Демон сборки другой версии, остановите его и запустите заново\n");
+        }
+        goto done;
+    }
+
+    char* cwd = request + strlen(request) + 1;
+    char* first = cwd + strlen(cwd) + 1;
+    int count = 0;
+    for (char* p = first; p < request + len; p += strlen(p) + 1) {
+        count++;
+    }
+    argv = malloc(((size_t)count + 1) * sizeof(char*));
+    if (!argv) {
+        goto done;
+    }
+    for (char* p = first; p < request + len; p += strlen(p) + 1) {
+        argv[argc++] = p;
+    }
+    argv[argc] = NULL;
+    if (argc == 0 || chdir(cwd) != 0) {
+        dprintf(fds[1], "❌ Демон сборки не смог перейти в каталог %s\n", cwd);
+        goto done;
+    }
+    if (dup2(fds[0], STDOUT_FILENO) < 0 || dup2(fds[1], STDERR_FILENO) < 0) {
+        goto done;
+    }
+
+    code = handler(argc, argv, data);
+    fflush(stdout);
+    fflush(stderr);
+
+done:
+    write_all(conn, &code, sizeof(code));
+    if (fds[0] >= 0) close(fds[0]);
+    if (fds[1] >= 0) close(fds[1]);
+    free(argv);
+    free(request);
+    close(conn);
+    return 0;
+}
+
+int daemon_serve(const char* path, DaemonHandler handler, void* data) {
+    struct sockaddr_un addr;
+    struct sigaction action;
+    int result = 1;
+
+    int other = connect_socket(path);
+    if (other >= 0) {
+        close(other);
+        fprintf(stderr, "❌ Демон сборки уже запущен: %s\n", path);
+        return 1;
+    }
+    unlink(path);
+
+    int listener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listener < 0) {
+        perror("❌ Не удалось создать сокет");
+        return 1;
+    }
+    socket_address(&addr, path);
+    mode_t mask = umask(077);
+    int bound = bind(listener, (struct sockaddr*)&addr, sizeof(addr));
+    umask(mask);
+    if (bound != 0 || listen(listener, 16) != 0) {
+        perror("❌ Не удалось открыть сокет демона");
+        close(listener);
+        return 1;
+    }
+
+    /* без SA_RESTART: accept прерывается сигналом остановки */
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = on_stop_signal;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    printf("🛰  Демон сборки слушает %s (Ctrl+C — остановить)\n", path);
+    fflush(stdout);
+
+    while (!daemon_stop) {
+        int conn = accept(listener, NULL, NULL);
+        if (conn < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            perror("❌ Ошибка приёма соединения");
+            goto done;
+        }
+
+        /* Каждая сборка — в копии прогретого процесса: состояние демона
+           не меняется, сборки разных проектов идут параллельно. */
+        pid_t pid = fork();
+        if (pid == 0) {
+            close(listener);
+            signal(SIGINT, SIG_DFL);
+            signal(SIGTERM, SIG_DFL);
+            serve_connection(conn, handler, data);
+            _exit(0);
+        }
+        if (pid < 0) {
+            perror("❌ Не удалось запустить сборку");
+        }
+        close(conn);
+        while (waitpid(-1, NULL, WNOHANG) > 0) {
+        }
+    }
+    result = 0;
+
+done:
+    close(listener);
+    unlink(path);
+    while (waitpid(-1, NULL, 0) > 0) {
+    }
+    return result;
+}
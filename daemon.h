@@ -0,0 +1,17 @@
+#ifndef MIKA_DAEMON_H
+#define MIKA_DAEMON_H
+
+#include <stddef.h>
+
+#define DAEMON_MAX_REQUEST (64 * 1024)
+
+/* Обработчик запроса выполняется в отдельном процессе, порождённом от
+   демона: stdout и stderr уже указывают на терминал клиента, текущий
+   каталог — каталог клиента. Возвращает код выхода для клиента. */
+typedef int (*DaemonHandler)(int argc, char** argv, void* data);
+
+int daemon_socket_path(char* buffer, size_t size);
+int daemon_serve(const char* path, DaemonHandler handler, void* data);
+int daemon_forward(const char* path, int argc, char** argv, int* status);
+
+#endif
@@ -0,0 +1,222 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "deps.h"
+
+void deps_init(DependencyList* deps) {
+    deps->paths = NULL;
+    deps->count = 0;
+    deps->capacity = 0;
+}
+
+void deps_free(DependencyList* deps) {
+    for (int i = 0; i < deps->count; i++) {
+        free(deps->paths[i]);
+    }
+    free(deps->paths);
+    deps_init(deps);
+}
+
+int deps_add(DependencyList* deps, const char* path) {
+    for (int i = 0; i < deps->count; i++) {
+        if (strcmp(deps->paths[i], path) == 0) {
+            return 0;
+        }
+    }
+
+    if (deps->count == deps->capacity) {
+        int capacity = deps->capacity ? deps->capacity * 2 : 16;
+        char** grown = realloc(deps->paths, (size_t)capacity * sizeof(char*));
+        if (!grown) {
+            return -1;
+        }
+        deps->paths = grown;
+        deps->capacity = capacity;
+    }
+
+    char* copy = strdup(path);
+    if (!copy) {
+        return -1;
+    }
+    deps->paths[deps->count++] = copy;
+    return 1;
+}
+
+int deps_resolve(const char* from_file, const char* name, size_t name_len, char* out, size_t size) {
+    struct stat st;
+    const char* slash = strrchr(from_file, '/');
+    int len;
+
+    if (name_len == 0) {
+        return -1;
+    }
+    if (name[0] != '/' && slash) {
+        len = snprintf(out, size, "%.*s/%.*s", (int)(slash - from_file), from_file, (int)name_len, name);
+        if (len > 0 && (size_t)len < size && stat(out, &st) == 0 && S_ISREG(st.st_mode)) {
+            return 0;
+        }
+    }
+
+    len = snprintf(out, size, "%.*s", (int)name_len, name);
+    if (len > 0 && (size_t)len < size && stat(out, &st) == 0 && S_ISREG(st.st_mode)) {
+        return 0;
+    }
+    return -1;
+}
+
+static int scan_file(DependencyList* deps, const char* path, int depth);
+
+static int add_include(DependencyList* deps, const char* from_file, const char* name, size_t name_len, int depth) {
+    char resolved[4096];
+
+    if (deps_resolve(from_file, name, name_len, resolved, sizeof(resolved)) != 0) {
+        return -1;
+    }
+    int added = deps_add(deps, resolved);
+    if (added <= 0) {
+        return added;
+    }
+    return depth < DEPS_MAX_DEPTH ? scan_file(deps, resolved, depth + 1) : 0;
+}
+
+static int scan_file(DependencyList* deps, const char* path, int depth) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        return -1;
+    }
+
+    char line[4096];
+    int result = 0;
+    while (fgets(line, sizeof(line), file)) {
+        const char* p = line;
+        while (*p == ' ' || *p == '\t') p++;
+        if (*p++ != '#') continue;
+        while (*p == ' ' || *p == '\t') p++;
+        if (strncmp(p, "include", 7) != 0) continue;
+        p += 7;
+        while (*p == ' ' || *p == '\t') p++;
+        if (*p++ != '"') continue;
+
+        const char* end = strchr(p, '"');
+        if (end && add_include(deps, path, p, (size_t)(end - p), depth) < 0) {
+            result = -1;
+        }
+    }
+    fclose(file);
+    return result;
+}
+
+int deps_add_include(DependencyList* deps, const char* from_file, const char* name, size_t name_len) {
+    return add_include(deps, from_file, name, name_len, 0);
+}
+
+int deps_scan_file(DependencyList* deps, const char* path) {
+    return scan_file(deps, path, 0);
+}
+
+static void write_escaped(FILE* file, const char* path) {
+    for (const char* p = path; *p; p++) {
+        if (*p == ' ' || *p == '#') {
+            fputc('\\', file);
+        } else if (*p == '$') {
+            fputc('$', file);
+        }
+        fputc(*p, file);
+    }
+}
+
+int deps_write_file(const DependencyList* deps, const char* dep_file, const char* target,
+                    const char* input, const char* stamp) {
+    char tmp[4096];
+    int len = snprintf(tmp, sizeof(tmp), "%s.tmp", dep_file);
+    if (len < 0 || (size_t)len >= sizeof(tmp)) {
+        return -1;
+    }
+
+    FILE* file = fopen(tmp, "w");
+    if (!file) {
+        return -1;
+    }
+
+    if (stamp) {
+        fprintf(file, "# mikac %s\n", stamp);
+    }
+    write_escaped(file, target);
+    fputs(":", file);
+    if (input) {
+        fputs(" ", file);
+        write_escaped(file, input);
+    }
+    for (int i = 0; i < deps->count; i++) {
+        fputs(" \\\n  ", file);
+        write_escaped(file, deps->paths[i]);
+    }
+    fputs("\n", file);
+    for (int i = 0; i < deps->count; i++) {
+        fputs("\n", file);
+        write_escaped(file, deps->paths[i]);
+        fputs(":\n", file);
+    }
+
+    if (fclose(file) != 0 || rename(tmp, dep_file) != 0) {
+        remove(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+int deps_read_file(DependencyList* deps, const char* dep_file, char* stamp, size_t stamp_size) {
+    FILE* file = fopen(dep_file, "r");
+    if (!file) {
+        return -1;
+    }
+    if (stamp && stamp_size > 0) {
+        stamp[0] = '\0';
+    }
+
+    char word[4096];
+    size_t len = 0;
+    int c, escaped = 0, seen_colon = 0, done = 0;
+
+    while (!done && (c = fgetc(file)) != EOF) {
+        if (c == '#' && len == 0 && !escaped) {
+            char line[256], value[256];
+            if (fgets(line, sizeof(line), file) && stamp &&
+                sscanf(line, " mikac %255s", value) == 1) {
+                snprintf(stamp, stamp_size, "%s", value);
+            }
+            continue;
+        }
+        if (escaped) {
+            escaped = 0;
+            if (c == '\n') continue;
+        } else if (c == '\\') {
+            escaped = 1;
+            continue;
+        } else if (c == ' ' || c == '\t' || c == '\n') {
+            if (len > 0) {
+                word[len] = '\0';
+                if (!seen_colon && word[len - 1] == ':') {
+                    seen_colon = 1;
+                } else if (seen_colon) {
+                    deps_add(deps, word);
+                }
+                len = 0;
+            }
+            if (c == '\n' && seen_colon) {
+                done = 1;
+            }
+            continue;
+        }
+        if (len + 1 < sizeof(word)) {
+            word[len++] = (char)c;
+        }
+    }
+
+    fclose(file);
+    return seen_colon ? 0 : -1;
+}
@@ -0,0 +1,24 @@
+#ifndef MIKA_DEPS_H
+#define MIKA_DEPS_H
+
+#include <stddef.h>
+
+#define DEPS_MAX_DEPTH 16
+
+typedef struct {
+    char** paths;
+    int count;
+    int capacity;
+} DependencyList;
+
+void deps_init(DependencyList* deps);
+void deps_free(DependencyList* deps);
+int deps_add(DependencyList* deps, const char* path);
+int deps_resolve(const char* from_file, const char* name, size_t name_len, char* out, size_t size);
+int deps_add_include(DependencyList* deps, const char* from_file, const char* name, size_t name_len);
+int deps_scan_file(DependencyList* deps, const char* path);
+int deps_write_file(const DependencyList* deps, const char* dep_file, const char* target,
+                    const char* input, const char* stamp);
+int deps_read_file(DependencyList* deps, const char* dep_file, char* stamp, size_t stamp_size);
+
+#endif
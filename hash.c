@@ -0,0 +1,90 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <string.h>
+
+#include "hash.h"
+
+#define FNV_OFFSET 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+#define MIX_PRIME 0x9e3779b97f4a7c15ULL
+
+void hasher_init(Hasher* hasher) {
+    hasher->a = FNV_OFFSET;
+    hasher->b = 0x6a09e667f3bcc908ULL;
+}
+
+static inline uint64_t rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+void hasher_update(Hasher* hasher, const void* data, size_t len) {
+    const unsigned char* p = data;
+    uint64_t a = hasher->a;
+    uint64_t b = hasher->b;
+
+    while (len >= 8) {
+        uint64_t word;
+        memcpy(&word, p, 8);
+        a = (a ^ word) * FNV_PRIME;
+        b = rotl64(b ^ (word * MIX_PRIME), 31) * 5 + 0x52dce729;
+        p += 8;
+        len -= 8;
+    }
+    while (len--) {
+        a = (a ^ *p) * FNV_PRIME;
+        b = rotl64(b ^ (*p * MIX_PRIME), 29) * 7 + 0x38495ab5;
+        p++;
+    }
+
+    hasher->a = a;
+    hasher->b = b;
+}
+
+void hasher_update_string(Hasher* hasher, const char* text) {
+    size_t len = strlen(text);
+    hasher_update_u64(hasher, len);
+    hasher_update(hasher, text, len);
+}
+
+void hasher_update_u64(Hasher* hasher, uint64_t value) {
+    unsigned char bytes[8];
+    for (int i = 0; i < 8; i++) {
+        bytes[i] = (unsigned char)(value >> (i * 8));
+    }
+    hasher_update(hasher, bytes, sizeof(bytes));
+}
+
+int hasher_update_file(Hasher* hasher, const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        return -1;
+    }
+
+    char buffer[64 * 1024];
+    size_t got;
+    uint64_t total = 0;
+    while ((got = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        hasher_update(hasher, buffer, got);
+        total += got;
+    }
+    int failed = ferror(file);
+    fclose(file);
+    hasher_update_u64(hasher, total);
+    return failed ? -1 : 0;
+}
+
+static uint64_t finalize(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+void hasher_hex(const Hasher* hasher, char out[HASH_HEX_SIZE]) {
+    uint64_t a = finalize(hasher->a ^ rotl64(hasher->b, 17));
+    uint64_t b = finalize(hasher->b + hasher->a);
+    snprintf(out, HASH_HEX_SIZE, "%016llx%016llx", (unsigned long long)a, (unsigned long long)b);
+}
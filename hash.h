@@ -0,0 +1,21 @@
+#ifndef MIKA_HASH_H
+#define MIKA_HASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define HASH_HEX_SIZE 33
+
+typedef struct {
+    uint64_t a;
+    uint64_t b;
+} Hasher;
+
+void hasher_init(Hasher* hasher);
+void hasher_update(Hasher* hasher, const void* data, size_t len);
+void hasher_update_string(Hasher* hasher, const char* text);
+void hasher_update_u64(Hasher* hasher, uint64_t value);
+int hasher_update_file(Hasher* hasher, const char* path);
+void hasher_hex(const Hasher* hasher, char out[HASH_HEX_SIZE]);
+
+#endif
@@ -0,0 +1,401 @@
+#include <string.h>
+
+#include "lexer.h"
+
+enum {
+    CH_SPACE = 1,
+    CH_IDENT_START = 2,
+    CH_DIGIT = 4
+};
+
+static unsigned char char_class[256];
+static int tables_ready = 0;
+
+static const struct {
+    const char* text;
+    Keyword keyword;
+} keyword_list[] = {
+    {"function", KW_FUNCTION}, {"var", KW_VAR}, {"const", KW_CONST}, {"return", KW_RETURN},
+    {"if", KW_IF}, {"else", KW_ELSE}, {"while", KW_WHILE}, {"do", KW_DO}, {"for", KW_FOR},
+    {"switch", KW_SWITCH}, {"case", KW_CASE}, {"default", KW_DEFAULT},
+    {"break", KW_BREAK}, {"continue", KW_CONTINUE}, {"parallel", KW_PARALLEL},
+    {"true", KW_TRUE}, {"false", KW_FALSE},
+    {"sizeof", KW_SIZEOF}, {"typedef", KW_TYPEDEF},
+    {"struct", KW_STRUCT}, {"enum", KW_ENUM}, {"union", KW_UNION}, {"record", KW_RECORD},
+    {"static", KW_STATIC}, {"extern", KW_EXTERN}, {"inline", KW_INLINE},
+    {"int", KW_INT}, {"char", KW_CHAR}, {"void", KW_VOID}, {"bool", KW_BOOL},
+    {"float", KW_FLOAT}, {"double", KW_DOUBLE}, {"long", KW_LONG}, {"short", KW_SHORT},
+    {"unsigned", KW_UNSIGNED}, {"signed", KW_SIGNED},
+    {"size_t", KW_TYPE_NAME}, {"ssize_t", KW_TYPE_NAME}, {"FILE", KW_TYPE_NAME},
+    {"slice", KW_TYPE_NAME}, {"string", KW_TYPE_NAME}, {"string_builder", KW_TYPE_NAME},
+    {"int8_t", KW_TYPE_NAME}, {"int16_t", KW_TYPE_NAME}, {"int32_t", KW_TYPE_NAME}, {"int64_t", KW_TYPE_NAME},
+    {"uint8_t", KW_TYPE_NAME}, {"uint16_t", KW_TYPE_NAME}, {"uint32_t", KW_TYPE_NAME}, {"uint64_t", KW_TYPE_NAME},
+    {"i8", KW_TYPE_NAME}, {"i16", KW_TYPE_NAME}, {"i32", KW_TYPE_NAME}, {"i64", KW_TYPE_NAME},
+    {"u8", KW_TYPE_NAME}, {"u16", KW_TYPE_NAME}, {"u32", KW_TYPE_NAME}, {"u64", KW_TYPE_NAME},
+    {"f32", KW_TYPE_NAME}, {"f64", KW_TYPE_NAME},
+};
+
+#define KEYWORD_SLOTS 256
+
+static struct {
+    const char* text;
+    size_t len;
+    Keyword keyword;
+} keyword_table[KEYWORD_SLOTS];
+
+static unsigned keyword_hash(const char* text, size_t len) {
+    unsigned h = (unsigned)len * 31u;
+    h = h * 131u + (unsigned char)text[0];
+    h = h * 131u + (unsigned char)text[len - 1];
+    if (len > 2) h = h * 131u + (unsigned char)text[len / 2];
+    return h & (KEYWORD_SLOTS - 1);
+}
+
+static void init_keywords(void) {
+    for (size_t i = 0; i < sizeof(keyword_list) / sizeof(keyword_list[0]); i++) {
+        size_t len = strlen(keyword_list[i].text);
+        unsigned slot = keyword_hash(keyword_list[i].text, len);
+        while (keyword_table[slot].text) {
+            slot = (slot + 1) & (KEYWORD_SLOTS - 1);
+        }
+        keyword_table[slot].text = keyword_list[i].text;
+        keyword_table[slot].len = len;
+        keyword_table[slot].keyword = keyword_list[i].keyword;
+    }
+}
+
+Keyword lookup_keyword(const char* text, size_t len) {
+    if (len < 2 || len > 14) {
+        return KW_NONE;
+    }
+    unsigned slot = keyword_hash(text, len);
+    while (keyword_table[slot].text) {
+        if (keyword_table[slot].len == len && keyword_table[slot].text[0] == text[0] &&
+            memcmp(keyword_table[slot].text, text, len) == 0) {
+            return keyword_table[slot].keyword;
+        }
+        slot = (slot + 1) & (KEYWORD_SLOTS - 1);
+    }
+    return KW_NONE;
+}
+
+static void init_tables(void) {
+    for (int c = 'a'; c <= 'z'; c++) char_class[c] = CH_IDENT_START;
+    for (int c = 'A'; c <= 'Z'; c++) char_class[c] = CH_IDENT_START;
+    for (int c = '0'; c <= '9'; c++) char_class[c] = CH_DIGIT;
+    for (int c = 0x80; c <= 0xff; c++) char_class[c] = CH_IDENT_START;
+    char_class['_'] = CH_IDENT_START;
+    char_class[' '] = CH_SPACE;
+    char_class['\t'] = CH_SPACE;
+    char_class['\r'] = CH_SPACE;
+    char_class['\v'] = CH_SPACE;
+    char_class['\f'] = CH_SPACE;
+    init_keywords();
+    tables_ready = 1;
+}
+
+#define IS_SPACE(c) (char_class[(unsigned char)(c)] & CH_SPACE)
+#define IS_IDENT(c) (char_class[(unsigned char)(c)] & (CH_IDENT_START | CH_DIGIT))
+#define IS_DIGIT(c) (char_class[(unsigned char)(c)] & CH_DIGIT)
+
+void lexer_init(Lexer* lexer, const char* src, size_t len) {
+    if (!tables_ready) {
+        init_tables();
+    }
+    lexer->src = src;
+    lexer->cur = src;
+    lexer->end = src + len;
+    lexer->line_start = src;
+    lexer->line = 1;
+    lexer->at_line_start = 1;
+}
+
+static void newline(Lexer* lexer) {
+    lexer->cur++;
+    lexer->line++;
+    lexer->line_start = lexer->cur;
+    lexer->at_line_start = 1;
+}
+
+static void skip_space_and_comments(Lexer* lexer) {
+    const char* p = lexer->cur;
+    const char* end = lexer->end;
+
+    while (p < end) {
+        char c = *p;
+        if (c == ' ') {
+            p++;
+            /* отступы длинные: по восемь пробелов за одно сравнение */
+            while (end - p >= 8 && memcmp(p, "        ", 8) == 0) {
+                p += 8;
+            }
+        } else if (c == '\n') {
+            p++;
+            lexer->line++;
+            lexer->line_start = p;
+            lexer->at_line_start = 1;
+        } else if (IS_SPACE(c)) {
+            p++;
+        } else if (c == '/' && p + 1 < end && p[1] == '/') {
+            const char* nl = memchr(p, '\n', (size_t)(end - p));
+            p = nl ? nl : end;
+        } else if (c == '/' && p + 1 < end && p[1] == '*') {
+            p += 2;
+            while (p < end && !(p[0] == '*' && p + 1 < end && p[1] == '/')) {
+                if (*p == '\n') {
+                    lexer->line++;
+                    lexer->line_start = p + 1;
+                    lexer->at_line_start = 1;
+                }
+                p++;
+            }
+            p = p < end ? p + 2 : end;
+        } else {
+            break;
+        }
+    }
+    lexer->cur = p;
+}
+
+static void scan_quoted(Lexer* lexer, char quote) {
+    const char* end = lexer->end;
+    lexer->cur++;
+    while (lexer->cur < end && *lexer->cur != quote && *lexer->cur != '\n') {
+        if (*lexer->cur == '\\' && lexer->cur + 1 < end) {
+            lexer->cur++;
+        }
+        lexer->cur++;
+    }
+    if (lexer->cur < end && *lexer->cur == quote) {
+        lexer->cur++;
+    }
+}
+
+static TokenKind scan_number(Lexer* lexer) {
+    const char* p = lexer->cur;
+    const char* end = lexer->end;
+    TokenKind kind = TOK_INT;
+
+    if (p + 1 < end && p[0] == '0' && (p[1] == 'x' || p[1] == 'X')) {
+        p += 2;
+        while (p < end && (IS_DIGIT(*p) || (*p >= 'a' && *p <= 'f') || (*p >= 'A' && *p <= 'F'))) p++;
+    } else {
+        while (p < end && IS_DIGIT(*p)) p++;
+        if (p < end && *p == '.') {
+            kind = TOK_FLOAT;
+            p++;
+            while (p < end && IS_DIGIT(*p)) p++;
+        }
+        if (p < end && (*p == 'e' || *p == 'E')) {
+            const char* q = p + 1;
+            if (q < end && (*q == '+' || *q == '-')) q++;
+            if (q < end && IS_DIGIT(*q)) {
+                kind = TOK_FLOAT;
+                p = q;
+                while (p < end && IS_DIGIT(*p)) p++;
+            }
+        }
+    }
+    while (p < end && (*p == 'u' || *p == 'U' || *p == 'l' || *p == 'L' || *p == 'f' || *p == 'F')) {
+        if (*p == 'f' || *p == 'F') kind = TOK_FLOAT;
+        p++;
+    }
+
+    lexer->cur = p;
+    return kind;
+}
+
+static void scan_directive(Lexer* lexer) {
+    const char* end = lexer->end;
+    char quote = 0;
+    while (lexer->cur < end) {
+        char c = *lexer->cur;
+        if (c == '\n') {
+            break;
+        }
+        if (quote) {
+            if (c == '\\' && lexer->cur + 1 < end && lexer->cur[1] != '\n') {
+                lexer->cur++;
+            } else if (c == quote) {
+                quote = 0;
+            }
+        } else if (c == '"' || c == '\'') {
+            quote = c;
+        } else if (c == '/' && lexer->cur + 1 < end && (lexer->cur[1] == '/' || lexer->cur[1] == '*')) {
+            break;
+        } else if (c == '\\' && lexer->cur + 1 < end && lexer->cur[1] == '\n') {
+            lexer->cur++;
+            newline(lexer);
+            continue;
+        }
+        lexer->cur++;
+    }
+}
+
+static TokenKind scan_punct(Lexer* lexer) {
+    const char* p = lexer->cur;
+    char next = p + 1 < lexer->end ? p[1] : '\0';
+    char next2 = p + 2 < lexer->end ? p[2] : '\0';
+    TokenKind kind = TOK_UNKNOWN;
+    int len = 1;
+
+    switch (*p) {
+        case '(': kind = TOK_LPAREN; break;
+        case ')': kind = TOK_RPAREN; break;
+        case '{': kind = TOK_LBRACE; break;
+        case '}': kind = TOK_RBRACE; break;
+        case '[': kind = TOK_LBRACKET; break;
+        case ']': kind = TOK_RBRACKET; break;
+        case ';': kind = TOK_SEMI; break;
+        case ',': kind = TOK_COMMA; break;
+        case '?': kind = TOK_QUESTION; break;
+        case ':': kind = TOK_COLON; break;
+        case '~': kind = TOK_TILDE; break;
+        case '.':
+            if (next == '.' && next2 == '.') { kind = TOK_ELLIPSIS; len = 3; }
+            else kind = TOK_DOT;
+            break;
+        case '+':
+            if (next == '+') { kind = TOK_INC; len = 2; }
+            else if (next == '=') { kind = TOK_PLUS_ASSIGN; len = 2; }
+            else kind = TOK_PLUS;
+            break;
+        case '-':
+            if (next == '-') { kind = TOK_DEC; len = 2; }
+            else if (next == '=') { kind = TOK_MINUS_ASSIGN; len = 2; }
+            else if (next == '>') { kind = TOK_ARROW; len = 2; }
+            else kind = TOK_MINUS;
+            break;
+        case '*':
+            if (next == '=') { kind = TOK_STAR_ASSIGN; len = 2; }
+            else kind = TOK_STAR;
+            break;
+        case '/':
+            if (next == '=') { kind = TOK_SLASH_ASSIGN; len = 2; }
+            else kind = TOK_SLASH;
+            break;
+        case '%':
+            if (next == '=') { kind = TOK_PERCENT_ASSIGN; len = 2; }
+            else kind = TOK_PERCENT;
+            break;
+        case '&':
+            if (next == '&') { kind = TOK_ANDAND; len = 2; }
+            else if (next == '=') { kind = TOK_AMP_ASSIGN; len = 2; }
+            else kind = TOK_AMP;
+            break;
+        case '|':
+            if (next == '|') { kind = TOK_OROR; len = 2; }
+            else if (next == '=') { kind = TOK_PIPE_ASSIGN; len = 2; }
+            else kind = TOK_PIPE;
+            break;
+        case '^':
+            if (next == '=') { kind = TOK_CARET_ASSIGN; len = 2; }
+            else kind = TOK_CARET;
+            break;
+        case '!':
+            if (next == '=') { kind = TOK_NE; len = 2; }
+            else kind = TOK_BANG;
+            break;
+        case '=':
+            if (next == '=') { kind = TOK_EQ; len = 2; }
+            else kind = TOK_ASSIGN;
+            break;
+        case '<':
+            if (next == '<' && next2 == '=') { kind = TOK_SHL_ASSIGN; len = 3; }
+            else if (next == '<') { kind = TOK_SHL; len = 2; }
+            else if (next == '=') { kind = TOK_LE; len = 2; }
+            else kind = TOK_LT;
+            break;
+        case '>':
+            if (next == '>' && next2 == '=') { kind = TOK_SHR_ASSIGN; len = 3; }
+            else if (next == '>') { kind = TOK_SHR; len = 2; }
+            else if (next == '=') { kind = TOK_GE; len = 2; }
+            else kind = TOK_GT;
+            break;
+        default:
+            break;
+    }
+
+    lexer->cur += len;
+    return kind;
+}
+
+/* Токен пишется сразу в очередь парсера, без промежуточной копии */
+void lexer_next(Lexer* lexer, Token* tok) {
+    skip_space_and_comments(lexer);
+
+    tok->keyword = KW_NONE;
+    tok->start = lexer->cur;
+    tok->line = lexer->line;
+    tok->col = (int)(lexer->cur - lexer->line_start) + 1;
+
+    if (lexer->cur >= lexer->end) {
+        tok->kind = TOK_EOF;
+        tok->len = 0;
+        return;
+    }
+
+    char c = *lexer->cur;
+    if (c == '#' && lexer->at_line_start) {
+        scan_directive(lexer);
+        tok->kind = TOK_DIRECTIVE;
+    } else if (char_class[(unsigned char)c] & CH_IDENT_START) {
+        const char* p = lexer->cur + 1;
+        while (p < lexer->end && IS_IDENT(*p)) p++;
+        tok->kind = TOK_IDENT;
+        tok->keyword = lookup_keyword(lexer->cur, (size_t)(p - lexer->cur));
+        lexer->cur = p;
+    } else if (IS_DIGIT(c) || (c == '.' && lexer->cur + 1 < lexer->end && IS_DIGIT(lexer->cur[1]))) {
+        tok->kind = scan_number(lexer);
+    } else if (c == '"') {
+        scan_quoted(lexer, '"');
+        tok->kind = TOK_STRING;
+    } else if (c == '\'') {
+        scan_quoted(lexer, '\'');
+        tok->kind = TOK_CHAR;
+    } else {
+        tok->kind = scan_punct(lexer);
+    }
+
+    lexer->at_line_start = 0;
+    tok->len = (size_t)(lexer->cur - tok->start);
+    while (tok->kind == TOK_DIRECTIVE && tok->len > 0 && IS_SPACE(tok->start[tok->len - 1])) {
+        tok->len--;
+    }
+}
+
+int token_is(const Token* tok, const char* text) {
+    size_t len = strlen(text);
+    return tok->len == len && memcmp(tok->start, text, len) == 0;
+}
+
+const char* token_kind_name(TokenKind kind) {
+    static const char* names[TOK_COUNT] = {
+        [TOK_EOF] = "конец файла",
+        [TOK_IDENT] = "идентификатор",
+        [TOK_INT] = "целое число",
+        [TOK_FLOAT] = "вещественное число",
+        [TOK_STRING] = "строка",
+        [TOK_CHAR] = "символ",
+        [TOK_DIRECTIVE] = "директива",
+        [TOK_LPAREN] = "(", [TOK_RPAREN] = ")", [TOK_LBRACE] = "{", [TOK_RBRACE] = "}",
+        [TOK_LBRACKET] = "[", [TOK_RBRACKET] = "]", [TOK_SEMI] = ";", [TOK_COMMA] = ",",
+        [TOK_DOT] = ".", [TOK_ARROW] = "->", [TOK_QUESTION] = "?", [TOK_COLON] = ":",
+        [TOK_ELLIPSIS] = "...",
+        [TOK_PLUS] = "+", [TOK_MINUS] = "-", [TOK_STAR] = "*", [TOK_SLASH] = "/",
+        [TOK_PERCENT] = "%", [TOK_AMP] = "&", [TOK_PIPE] = "|", [TOK_CARET] = "^",
+        [TOK_TILDE] = "~", [TOK_BANG] = "!",
+        [TOK_LT] = "<", [TOK_GT] = ">", [TOK_LE] = "<=", [TOK_GE] = ">=",
+        [TOK_EQ] = "==", [TOK_NE] = "!=", [TOK_ANDAND] = "&&", [TOK_OROR] = "||",
+        [TOK_SHL] = "<<", [TOK_SHR] = ">>", [TOK_INC] = "++", [TOK_DEC] = "--",
+        [TOK_ASSIGN] = "=", [TOK_PLUS_ASSIGN] = "+=", [TOK_MINUS_ASSIGN] = "-=",
+        [TOK_STAR_ASSIGN] = "*=", [TOK_SLASH_ASSIGN] = "/=", [TOK_PERCENT_ASSIGN] = "%=",
+        [TOK_AMP_ASSIGN] = "&=", [TOK_PIPE_ASSIGN] = "|=", [TOK_CARET_ASSIGN] = "^=",
+        [TOK_SHL_ASSIGN] = "<<=", [TOK_SHR_ASSIGN] = ">>=",
+        [TOK_UNKNOWN] = "неизвестный символ",
+    };
+    if (kind < 0 || kind >= TOK_COUNT || !names[kind]) {
+        return "?";
+    }
+    return names[kind];
+}
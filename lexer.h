@@ -0,0 +1,73 @@
+#ifndef MIKA_LEXER_H
+#define MIKA_LEXER_H
+
+#include <stddef.h>
+
+typedef enum {
+    TOK_EOF,
+    TOK_IDENT,
+    TOK_INT,
+    TOK_FLOAT,
+    TOK_STRING,
+    TOK_CHAR,
+    TOK_DIRECTIVE,
+
+    TOK_LPAREN, TOK_RPAREN, TOK_LBRACE, TOK_RBRACE, TOK_LBRACKET, TOK_RBRACKET,
+    TOK_SEMI, TOK_COMMA, TOK_DOT, TOK_ARROW, TOK_QUESTION, TOK_COLON, TOK_ELLIPSIS,
+
+    TOK_PLUS, TOK_MINUS, TOK_STAR, TOK_SLASH, TOK_PERCENT,
+    TOK_AMP, TOK_PIPE, TOK_CARET, TOK_TILDE, TOK_BANG,
+    TOK_LT, TOK_GT, TOK_LE, TOK_GE, TOK_EQ, TOK_NE,
+    TOK_ANDAND, TOK_OROR, TOK_SHL, TOK_SHR,
+    TOK_INC, TOK_DEC,
+
+    TOK_ASSIGN, TOK_PLUS_ASSIGN, TOK_MINUS_ASSIGN, TOK_STAR_ASSIGN, TOK_SLASH_ASSIGN,
+    TOK_PERCENT_ASSIGN, TOK_AMP_ASSIGN, TOK_PIPE_ASSIGN, TOK_CARET_ASSIGN,
+    TOK_SHL_ASSIGN, TOK_SHR_ASSIGN,
+
+    TOK_UNKNOWN,
+    TOK_COUNT
+} TokenKind;
+
+typedef enum {
+    KW_NONE,
+
+    KW_FUNCTION, KW_VAR, KW_CONST, KW_RETURN,
+    KW_IF, KW_ELSE, KW_WHILE, KW_DO, KW_FOR, KW_SWITCH, KW_CASE, KW_DEFAULT,
+    KW_BREAK, KW_CONTINUE, KW_PARALLEL, KW_TRUE, KW_FALSE, KW_SIZEOF, KW_TYPEDEF,
+    KW_STRUCT, KW_ENUM, KW_UNION, KW_STATIC, KW_EXTERN, KW_INLINE, KW_RECORD,
+
+    KW_INT, KW_CHAR, KW_VOID, KW_BOOL, KW_FLOAT, KW_DOUBLE,
+    KW_LONG, KW_SHORT, KW_UNSIGNED, KW_SIGNED,
+
+    KW_TYPE_NAME,
+    KW_COUNT
+} Keyword;
+
+#define KW_IS_BASE_TYPE(kw) ((kw) >= KW_INT && (kw) <= KW_SIGNED)
+
+typedef struct {
+    TokenKind kind;
+    Keyword keyword;
+    const char* start;
+    size_t len;
+    int line;
+    int col;
+} Token;
+
+typedef struct {
+    const char* src;
+    const char* cur;
+    const char* end;
+    const char* line_start;
+    int line;
+    int at_line_start;
+} Lexer;
+
+void lexer_init(Lexer* lexer, const char* src, size_t len);
+void lexer_next(Lexer* lexer, Token* tok);
+Keyword lookup_keyword(const char* text, size_t len);
+const char* token_kind_name(TokenKind kind);
+int token_is(const Token* tok, const char* text);
+
+#endif
@@ -0,0 +1,1990 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <limits.h>
+
+#include "lower.h"
+
+#define MIKA_SUCCESS_CODE 993
+#define MIKA_POWER_UNROLL_LIMIT 16
+#define LOWER_MAX_CAPTURES 64
+
+/* Тело parallel for выносится в отдельную функцию; имена с индексом ниже
+   scope объявлены снаружи цикла и передаются ей через массив указателей. */
+typedef struct ParallelRegion {
+    struct ParallelRegion* outer;
+    int scope;
+    Node* clauses;
+    Node* captures[LOWER_MAX_CAPTURES];
+    int capture_count;
+} ParallelRegion;
+
+static void lower_error(LowerContext* ctx, const Node* node, const char* fmt, ...) {
+    va_list args;
+    fprintf(stderr, "%s:%d: ошибка: ", ctx->filename, node->line);
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
+    fputc('\n', stderr);
+    ctx->errors++;
+}
+
+static int directive_argument(const Node* node, const char* directive, const char** arg, size_t* arg_len) {
+    const char* p = node->u.lit.text + 1;
+    const char* end = node->u.lit.text + node->u.lit.len;
+    size_t dlen = strlen(directive);
+
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+    if ((size_t)(end - p) < dlen || memcmp(p, directive, dlen) != 0) {
+        return 0;
+    }
+    p += dlen;
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+    *arg = p;
+    *arg_len = (size_t)(end - p);
+    return 1;
+}
+
+static void replace_directive(Node* node, const char* text) {
+    node->u.lit.text = text;
+    node->u.lit.len = strlen(text);
+}
+
+static int arg_is(const char* arg, size_t len, const char* name) {
+    return strlen(name) == len && memcmp(arg, name, len) == 0;
+}
+
+static void process_includes(LowerContext* ctx, Node* node) {
+    const char* arg;
+    size_t len;
+
+    if (!directive_argument(node, "include", &arg, &len)) {
+        return;
+    }
+
+    if (len >= 2 && arg[0] == '"' && arg[len - 1] == '"') {
+        if (ctx->deps && deps_add_include(ctx->deps, ctx->filename, arg + 1, len - 2) < 0) {
+            fprintf(stderr, "%s:%d: предупреждение: не найден включаемый файл %.*s\n",
+                    ctx->filename, node->line, (int)len, arg);
+        }
+        return;
+    }
+
+    if (arg_is(arg, len, "<System>")) {
+        replace_directive(node,
+            "#include <stdio.h>\n"
+            "#include <stdlib.h>\n"
+            "#include <string.h>\n"
+            "#include <stdbool.h>\n"
+            "#include <stdint.h>\n"
+            "#include <mika/mika_std.h>\n");
+    } else if (arg_is(arg, len, "<Math>")) {
+        replace_directive(node, "#include <math.h>");
+    } else if (arg_is(arg, len, "<Time>")) {
+        replace_directive(node, "#include <time.h>");
+    } else if (arg_is(arg, len, "<Arena>")) {
+        replace_directive(node,
+            "#define MIKA_ARENA 1\n"
+            "#include <mika/mika_std.h>");
+    }
+}
+
+static void process_print(LowerContext* ctx, Node* call) {
+    (void)ctx;
+    Node* callee = call->u.call.callee;
+    callee->u.lit.text = "mika_print";
+    callee->u.lit.len = 10;
+}
+
+static void process_input_function(LowerContext* ctx, Node* call) {
+    if (call->u.call.args != NULL) {
+        lower_error(ctx, call, "input() не принимает аргументов");
+    }
+}
+
+static Node* new_node(LowerContext* ctx, NodeKind kind, int line) {
+    Node* node = arena_calloc(ctx->arena, sizeof(Node));
+    node->kind = kind;
+    node->line = line;
+    return node;
+}
+
+static void replace_node(Node* node, const Node* with) {
+    Node* next = node->next;
+    *node = *with;
+    node->next = next;
+}
+
+static int constant_int(const Node* node, long long* value) {
+    if (node->kind == NODE_UNARY && (node->u.unary.op == TOK_MINUS || node->u.unary.op == TOK_PLUS)) {
+        if (!constant_int(node->u.unary.operand, value)) {
+            return 0;
+        }
+        if (node->u.unary.op == TOK_MINUS) {
+            *value = -*value;
+        }
+        return *value >= INT_MIN && *value <= INT_MAX;
+    }
+    if (node->kind != NODE_INT || node->u.lit.value > INT_MAX) {
+        return 0;
+    }
+    for (size_t i = 0; i < node->u.lit.len; i++) {
+        char c = node->u.lit.text[i];
+        if (c == 'u' || c == 'U' || c == 'l' || c == 'L') {
+            return 0;
+        }
+    }
+    *value = node->u.lit.value;
+    return 1;
+}
+
+static void fold_to_constant(LowerContext* ctx, Node* call, long long value) {
+    char text[32];
+    Node* literal = new_node(ctx, NODE_INT, call->line);
+    literal->u.lit.value = value < 0 ? -value : value;
+    literal->u.lit.len = (size_t)snprintf(text, sizeof(text), "%lld", literal->u.lit.value);
+    literal->u.lit.text = arena_strndup(ctx->arena, text, literal->u.lit.len);
+
+    if (value < 0) {
+        Node* negate = new_node(ctx, NODE_UNARY, call->line);
+        negate->u.unary.op = TOK_MINUS;
+        negate->u.unary.operand = literal;
+        literal = negate;
+    }
+    replace_node(call, literal);
+}
+
+static int is_pure(const Node* node) {
+    switch (node->kind) {
+        case NODE_INT: case NODE_FLOAT: case NODE_CHAR: case NODE_BOOL: case NODE_IDENT:
+            return 1;
+        case NODE_UNARY:
+            return node->u.unary.op != TOK_INC && node->u.unary.op != TOK_DEC &&
+                   is_pure(node->u.unary.operand);
+        case NODE_BINARY:
+            for (; node->kind == NODE_BINARY; node = node->u.binary.lhs) {
+                if (node->u.binary.op == TOK_COMMA || !is_pure(node->u.binary.rhs)) {
+                    return 0;
+                }
+            }
+            return is_pure(node);
+        case NODE_TERNARY:
+            return is_pure(node->u.cond.cond) && is_pure(node->u.cond.then_branch) &&
+                   is_pure(node->u.cond.else_branch);
+        case NODE_INDEX:
+            return is_pure(node->u.index.base) && is_pure(node->u.index.index);
+        case NODE_MEMBER:
+            return is_pure(node->u.member.base);
+        case NODE_CAST:
+            return is_pure(node->u.cast.expr);
+        default:
+            return 0;
+    }
+}
+
+static Node* multiply(LowerContext* ctx, Node* lhs, Node* rhs, int line) {
+    Node* node = new_node(ctx, NODE_BINARY, line);
+    node->u.binary.op = TOK_STAR;
+    node->u.binary.lhs = lhs;
+    node->u.binary.rhs = rhs;
+    return node;
+}
+
+/* base^exponent как дерево умножений: квадраты разделяют поддерево, поэтому
+   gcc видит ровно log2(exponent) возведений в квадрат плюс умножения на base. */
+static Node* square_and_multiply(LowerContext* ctx, Node* base, long long exponent, int line) {
+    if (exponent == 1) {
+        return base;
+    }
+    Node* half = square_and_multiply(ctx, base, exponent / 2, line);
+    Node* square = multiply(ctx, half, half, line);
+    return exponent % 2 ? multiply(ctx, square, base, line) : square;
+}
+
+static void process_power_function(LowerContext* ctx, Node* call) {
+    Node* base = call->u.call.args;
+    long long base_value, exponent;
+
+    if (node_count(base) != 2) {
+        lower_error(ctx, call, "power() ожидает 2 аргумента: основание и показатель");
+        return;
+    }
+    if (!constant_int(base->next, &exponent)) {
+        return;
+    }
+
+    if (constant_int(base, &base_value)) {
+        long long result = 1;
+        if (base_value == 1 || base_value == -1) {
+            result = base_value < 0 && exponent > 0 && exponent % 2 ? -1 : 1;
+        } else {
+            for (long long i = 0; i < exponent && result != 0; i++) {
+                result *= base_value;
+                if (result < INT_MIN || result > INT_MAX) {
+                    return;
+                }
+            }
+        }
+        fold_to_constant(ctx, call, result);
+        return;
+    }
+
+    if (!is_pure(base) || exponent > MIKA_POWER_UNROLL_LIMIT) {
+        return;
+    }
+    if (exponent <= 0) {
+        fold_to_constant(ctx, call, 1);
+        return;
+    }
+
+    /* Как power() в рантайме: умножения в unsigned переполняются по модулю
+       2^32, а не становятся неопределённым поведением знакового int. */
+    Node* operand = new_node(ctx, NODE_CAST, call->line);
+    operand->u.cast.type.name = "unsigned";
+    operand->u.cast.expr = base;
+    Node* result = new_node(ctx, NODE_CAST, call->line);
+    result->u.cast.type.name = "int";
+    result->u.cast.expr = square_and_multiply(ctx, operand, exponent, call->line);
+    replace_node(call, result);
+}
+
+static void process_absolute_function(LowerContext* ctx, Node* call) {
+    long long value;
+
+    if (node_count(call->u.call.args) != 1) {
+        lower_error(ctx, call, "absolute() ожидает 1 аргумент");
+        return;
+    }
+    if (constant_int(call->u.call.args, &value) && value != INT_MIN) {
+        fold_to_constant(ctx, call, value < 0 ? -value : value);
+    }
+}
+
+static void rename_callee(Node* call, const char* name) {
+    Node* callee = call->u.call.callee;
+    callee->u.lit.text = name;
+    callee->u.lit.len = strlen(name);
+}
+
+/* ---------- Числовые типы ---------- */
+
+/* Типы, которые различает транслятор: ранг числа, вид значения и имя в C
+   (NULL — имя не меняется). Целые уже int в выражениях продвигаются до
+   int, поэтому у них ранг int. */
+typedef struct {
+    const char* name;
+    const char* c_name;
+    NumberRank rank;
+    ValueKind kind;
+} KnownType;
+
+static const KnownType known_types[] = {
+    {"int", NULL, RANK_INT, VALUE_OTHER}, {"signed", NULL, RANK_INT, VALUE_OTHER},
+    {"signed int", NULL, RANK_INT, VALUE_OTHER}, {"bool", NULL, RANK_INT, VALUE_OTHER},
+    {"char", NULL, RANK_INT, VALUE_OTHER}, {"signed char", NULL, RANK_INT, VALUE_OTHER},
+    {"unsigned char", NULL, RANK_INT, VALUE_OTHER}, {"short", NULL, RANK_INT, VALUE_OTHER},
+    {"short int", NULL, RANK_INT, VALUE_OTHER}, {"unsigned short", NULL, RANK_INT, VALUE_OTHER},
+    {"int8_t", NULL, RANK_INT, VALUE_OTHER}, {"int16_t", NULL, RANK_INT, VALUE_OTHER},
+    {"int32_t", NULL, RANK_INT, VALUE_OTHER}, {"uint8_t", NULL, RANK_INT, VALUE_OTHER},
+    {"uint16_t", NULL, RANK_INT, VALUE_OTHER},
+    {"unsigned", NULL, RANK_U32, VALUE_OTHER}, {"unsigned int", NULL, RANK_U32, VALUE_OTHER},
+    {"uint32_t", NULL, RANK_U32, VALUE_OTHER},
+    {"long", NULL, RANK_I64, VALUE_OTHER}, {"long int", NULL, RANK_I64, VALUE_OTHER},
+    {"long long", NULL, RANK_I64, VALUE_OTHER}, {"long long int", NULL, RANK_I64, VALUE_OTHER},
+    {"int64_t", NULL, RANK_I64, VALUE_OTHER}, {"ssize_t", NULL, RANK_I64, VALUE_OTHER},
+    {"unsigned long", NULL, RANK_U64, VALUE_OTHER}, {"unsigned long long", NULL, RANK_U64, VALUE_OTHER},
+    {"uint64_t", NULL, RANK_U64, VALUE_OTHER}, {"size_t", NULL, RANK_U64, VALUE_OTHER},
+    {"float", NULL, RANK_FLOAT, VALUE_OTHER}, {"double", NULL, RANK_DOUBLE, VALUE_OTHER},
+    {"long double", NULL, RANK_DOUBLE, VALUE_OTHER},
+    {"i8", "int8_t", RANK_INT, VALUE_OTHER}, {"i16", "int16_t", RANK_INT, VALUE_OTHER},
+    {"i32", "int32_t", RANK_INT, VALUE_OTHER}, {"i64", "int64_t", RANK_I64, VALUE_OTHER},
+    {"u8", "uint8_t", RANK_INT, VALUE_OTHER}, {"u16", "uint16_t", RANK_INT, VALUE_OTHER},
+    {"u32", "uint32_t", RANK_U32, VALUE_OTHER}, {"u64", "uint64_t", RANK_U64, VALUE_OTHER},
+    {"f32", "float", RANK_FLOAT, VALUE_OTHER}, {"f64", "double", RANK_DOUBLE, VALUE_OTHER},
+    {"slice", "MikaSlice", RANK_NONE, VALUE_SLICE}, {"MikaSlice", NULL, RANK_NONE, VALUE_SLICE},
+    {"string", "MikaString", RANK_NONE, VALUE_STRING}, {"MikaString", NULL, RANK_NONE, VALUE_STRING},
+    {"string_builder", "MikaStringBuilder", RANK_NONE, VALUE_BUILDER},
+    {"MikaStringBuilder", NULL, RANK_NONE, VALUE_BUILDER},
+};
+
+static const char* const rank_names[] = {
+    "int", "int", "uint32_t", "int64_t", "uint64_t", "float", "double"
+};
+
+/* Тип смотрят по нескольку раз на каждое объявление, поэтому таблица
+   открытой адресации вместо сравнения с каждой строкой подряд. */
+#define KNOWN_TYPE_SLOTS 128
+
+static const KnownType* known_type_table[KNOWN_TYPE_SLOTS];
+static int known_types_ready = 0;
+
+static unsigned known_type_hash(const char* name) {
+    unsigned h = 2166136261u;
+    for (; *name; name++) {
+        h = (h ^ (unsigned char)*name) * 16777619u;
+    }
+    return h & (KNOWN_TYPE_SLOTS - 1);
+}
+
+static const KnownType* find_known_type(const char* name) {
+    if (!known_types_ready) {
+        for (size_t i = 0; i < sizeof(known_types) / sizeof(known_types[0]); i++) {
+            unsigned slot = known_type_hash(known_types[i].name);
+            while (known_type_table[slot]) {
+                slot = (slot + 1) & (KNOWN_TYPE_SLOTS - 1);
+            }
+            known_type_table[slot] = &known_types[i];
+        }
+        known_types_ready = 1;
+    }
+    for (unsigned slot = known_type_hash(name); known_type_table[slot]; slot = (slot + 1) & (KNOWN_TYPE_SLOTS - 1)) {
+        const char* a = known_type_table[slot]->name;
+        const char* b = name;
+        while (*a && *a == *b) {
+            a++;
+            b++;
+        }
+        if (*a == *b) {
+            return known_type_table[slot];
+        }
+    }
+    return NULL;
+}
+
+static NumberRank type_rank(const TypeRef* type) {
+    if (type->is_var) {
+        return RANK_INT;
+    }
+    const KnownType* known = find_known_type(type->name);
+    return known ? known->rank : RANK_NONE;
+}
+
+static ValueKind type_value_kind(const TypeRef* type) {
+    if (type->pointers > 0) {
+        return VALUE_OTHER;
+    }
+    if (type->records) {
+        return VALUE_RECORDS;
+    }
+    const KnownType* known = find_known_type(type->name);
+    return known ? known->kind : VALUE_OTHER;
+}
+
+static NumberRank arithmetic_rank(NumberRank a, NumberRank b) {
+    if (a < RANK_INT) a = RANK_INT;
+    if (b < RANK_INT) b = RANK_INT;
+    return a > b ? a : b;
+}
+
+static NumberRank literal_rank(const Node* node) {
+    const char* text = node->u.lit.text;
+    size_t len = node->u.lit.len;
+
+    if (node->kind == NODE_FLOAT) {
+        return len > 0 && (text[len - 1] == 'f' || text[len - 1] == 'F') ? RANK_FLOAT : RANK_DOUBLE;
+    }
+    int is_unsigned = 0;
+    int is_long = (unsigned long long)node->u.lit.value > INT_MAX;
+    for (size_t i = 0; i < len; i++) {
+        is_unsigned |= text[i] == 'u' || text[i] == 'U';
+        is_long |= text[i] == 'l' || text[i] == 'L';
+    }
+    if (is_unsigned) {
+        return is_long || (unsigned long long)node->u.lit.value > UINT_MAX ? RANK_U64 : RANK_U32;
+    }
+    return is_long ? RANK_I64 : RANK_INT;
+}
+
+static int find_name(LowerContext* ctx, const Node* node);
+static NumberRank record_field_rank(LowerContext* ctx, const Node* member, int column);
+
+static NumberRank infer_rank(LowerContext* ctx, const Node* node);
+
+/* Цепочка a + b + c ... идёт сверху вниз циклом: rank копит ранги
+   правых операндов пройденных звеньев, запятая на вершине отдаёт ранг
+   своего правого операнда как есть. */
+static NumberRank infer_chain_rank(LowerContext* ctx, const Node* node) {
+    NumberRank rank = RANK_NONE;
+    int top = 1;
+
+    for (; node->kind == NODE_BINARY; node = node->u.binary.lhs, top = 0) {
+        switch (node->u.binary.op) {
+            case TOK_COMMA:
+                return top ? infer_rank(ctx, node->u.binary.rhs)
+                           : arithmetic_rank(rank, infer_rank(ctx, node->u.binary.rhs));
+            case TOK_ANDAND: case TOK_OROR: case TOK_EQ: case TOK_NE:
+            case TOK_LT: case TOK_LE: case TOK_GT: case TOK_GE:
+                return arithmetic_rank(rank, RANK_INT);
+            case TOK_SHL: case TOK_SHR:
+                rank = arithmetic_rank(rank, RANK_INT);
+                break;
+            default:
+                rank = arithmetic_rank(rank, infer_rank(ctx, node->u.binary.rhs));
+                break;
+        }
+    }
+    return arithmetic_rank(rank, infer_rank(ctx, node));
+}
+
+/* Тип выражения в тех пределах, которые видны транслятору: литералы,
+   объявленные имена, функции этого файла и приведения. Неизвестное —
+   RANK_NONE, и var получает int, как раньше. */
+static NumberRank infer_rank(LowerContext* ctx, const Node* node) {
+    int index;
+
+    switch (node->kind) {
+        case NODE_INT: case NODE_FLOAT:
+            return literal_rank(node);
+        case NODE_CHAR: case NODE_BOOL:
+            return RANK_INT;
+        case NODE_IDENT:
+            index = find_name(ctx, node);
+            return index >= 0 && ctx->names[index].depth == 0 ? ctx->names[index].number : RANK_NONE;
+        case NODE_INDEX:
+            if (node->u.index.base->kind == NODE_MEMBER) {
+                return record_field_rank(ctx, node->u.index.base, 1);
+            }
+            index = find_name(ctx, node->u.index.base);
+            return index >= 0 && ctx->names[index].depth == 1 ? ctx->names[index].number : RANK_NONE;
+        case NODE_MEMBER:
+            return record_field_rank(ctx, node, 0);
+        case NODE_CALL:
+            index = find_name(ctx, node->u.call.callee);
+            return index >= 0 && ctx->names[index].depth == 0 ? ctx->names[index].number : RANK_NONE;
+        case NODE_UNARY:
+            switch (node->u.unary.op) {
+                case TOK_BANG: return RANK_INT;
+                case TOK_MINUS: case TOK_PLUS: case TOK_TILDE:
+                    return arithmetic_rank(infer_rank(ctx, node->u.unary.operand), RANK_INT);
+                case TOK_INC: case TOK_DEC: return infer_rank(ctx, node->u.unary.operand);
+                default: return RANK_NONE;
+            }
+        case NODE_POSTFIX:
+            return infer_rank(ctx, node->u.unary.operand);
+        case NODE_BINARY:
+            return infer_chain_rank(ctx, node);
+        case NODE_ASSIGN:
+            return infer_rank(ctx, node->u.binary.lhs);
+        case NODE_TERNARY:
+            return arithmetic_rank(infer_rank(ctx, node->u.cond.then_branch),
+                                   infer_rank(ctx, node->u.cond.else_branch));
+        case NODE_CAST:
+            return node->u.cast.type.pointers == 0 ? type_rank(&node->u.cast.type) : RANK_NONE;
+        default:
+            return RANK_NONE;
+    }
+}
+
+static int find_name(LowerContext* ctx, const Node* node) {
+    for (int i = ctx->name_count - 1; i >= 0; i--) {
+        if (node_is_ident(node, ctx->names[i].name)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static ValueKind name_kind(LowerContext* ctx, const Node* node) {
+    int index = find_name(ctx, node);
+    return index < 0 ? VALUE_OTHER : ctx->names[index].kind;
+}
+
+static ValueKind value_kind(LowerContext* ctx, const Node* node) {
+    static const struct { const char* name; ValueKind kind; } results[] = {
+        {"MIKA_STRING_LITERAL", VALUE_STRING}, {"mika_string_from", VALUE_STRING},
+        {"mika_string_substring", VALUE_STRING}, {"mika_string_copy", VALUE_STRING},
+        {"mika_builder_finish", VALUE_STRING},
+        {"mika_input_line", VALUE_STRING}, {"array_slice", VALUE_SLICE}, {"slice_range", VALUE_SLICE},
+        {"array_view", VALUE_SLICE},
+    };
+
+    if (node->kind == NODE_IDENT) {
+        return name_kind(ctx, node);
+    }
+    if (node->kind != NODE_CALL) {
+        return VALUE_OTHER;
+    }
+    for (size_t i = 0; i < sizeof(results) / sizeof(results[0]); i++) {
+        if (node_is_ident(node->u.call.callee, results[i].name)) {
+            return results[i].kind;
+        }
+    }
+    return name_kind(ctx, node->u.call.callee);
+}
+
+/* Внутри функции запоминаются все локальные имена: их объявления нужны
+   для parallel for. На верхнем уровне — только срезы, строки и числа
+   шире int, а обычное имя лишь тогда, когда оно перекрывает такое же имя. */
+static int find_record(LowerContext* ctx, const char* name);
+
+static void declare_name(LowerContext* ctx, Node* decl, const char* name, ValueKind kind,
+                         const TypeRef* type, int depth) {
+    NumberRank number = type_rank(type);
+    int record = ctx->record_count > 0 && type->pointers == 0 ? find_record(ctx, type->name) : -1;
+    int fixed = decl && decl->kind == NODE_VAR ? node_count(decl->u.var.dims) : 0;
+    int plain = kind == VALUE_OTHER && number <= RANK_INT && record < 0 && fixed == 0;
+
+    if (!name || (plain && !ctx->function && ctx->name_count == 0)) {
+        return;
+    }
+    if (plain && !ctx->function) {
+        int shadows = 0;
+        for (int i = 0; i < ctx->name_count && !shadows; i++) {
+            shadows = strcmp(ctx->names[i].name, name) == 0;
+        }
+        if (!shadows) {
+            return;
+        }
+    }
+    if (strlen(name) >= LOWER_NAME_SIZE) {
+        lower_error(ctx, decl, "слишком длинное имя '%s'", name);
+        return;
+    }
+    if (ctx->name_count == ctx->name_capacity) {
+        int capacity = ctx->name_capacity > 0 ? ctx->name_capacity * 2 : 64;
+        TypedName* names = realloc(ctx->names, (size_t)capacity * sizeof(TypedName));
+        if (!names) {
+            lower_error(ctx, decl, "не хватает памяти для таблицы имён");
+            return;
+        }
+        ctx->names = names;
+        ctx->name_capacity = capacity;
+    }
+    strcpy(ctx->names[ctx->name_count].name, name);
+    ctx->names[ctx->name_count].kind = kind;
+    ctx->names[ctx->name_count].number = number;
+    ctx->names[ctx->name_count].depth = depth;
+    ctx->names[ctx->name_count].record = record;
+    ctx->names[ctx->name_count].fixed = fixed;
+    ctx->names[ctx->name_count].decl = decl;
+    ctx->name_count++;
+}
+
+static Node* field_of(LowerContext* ctx, Node* value, const char* field) {
+    Node* member = new_node(ctx, NODE_MEMBER, value->line);
+    member->u.member.base = value;
+    member->u.member.name = field;
+    member->next = value->next;
+    return member;
+}
+
+static void pass_by_address(LowerContext* ctx, Node* call) {
+    Node* target = call->u.call.args;
+    Node* address = new_node(ctx, NODE_UNARY, target->line);
+    address->u.unary.op = TOK_AMP;
+    address->u.unary.operand = target;
+    address->next = target->next;
+    call->u.call.args = address;
+}
+
+static void wrap_in_call(LowerContext* ctx, Node* node, const char* function) {
+    Node* inner = new_node(ctx, node->kind, node->line);
+    Node* callee = new_node(ctx, NODE_IDENT, node->line);
+    Node* call = new_node(ctx, NODE_CALL, node->line);
+
+    *inner = *node;
+    inner->next = NULL;
+    callee->u.lit.text = function;
+    callee->u.lit.len = strlen(function);
+    call->u.call.callee = callee;
+    call->u.call.args = inner;
+    replace_node(node, call);
+}
+
+static void convert_to_string(LowerContext* ctx, Node* node) {
+    if (node->kind == NODE_STRING) {
+        wrap_in_call(ctx, node, "MIKA_STRING_LITERAL");
+    } else if (value_kind(ctx, node) != VALUE_STRING) {
+        wrap_in_call(ctx, node, "mika_string_from");
+    }
+}
+
+/* Новую строку возвращают только вызовы; имя, элемент массива или срез
+   лишь заимствуют чужой буфер, и при записи в переменную их надо копировать. */
+static int borrows_string(const Node* value) {
+    if (value->kind == NODE_TERNARY) {
+        return borrows_string(value->u.cond.then_branch) || borrows_string(value->u.cond.else_branch);
+    }
+    return value->kind != NODE_CALL || node_is_ident(value->u.call.callee, "mika_string_substring") ||
+           node_is_ident(value->u.call.callee, "mika_string_from");
+}
+
+static Node* make_ident(LowerContext* ctx, const char* name, int line);
+static Node* make_int(LowerContext* ctx, int value, int line);
+static Node* make_binary(LowerContext* ctx, NodeKind kind, TokenKind op, Node* lhs, Node* rhs);
+
+/* t = s с заимствованной правой частью: mika_string_assign(&t, s)
+   копирует символы в буфер t и освобождает прежний */
+static void lower_string_assign(LowerContext* ctx, Node* assign) {
+    Node* callee = make_ident(ctx, "mika_string_assign", assign->line);
+    Node* call = new_node(ctx, NODE_CALL, assign->line);
+    Node* target = assign->u.binary.lhs;
+
+    target->next = assign->u.binary.rhs;
+    call->u.call.callee = callee;
+    call->u.call.args = target;
+    pass_by_address(ctx, call);
+    replace_node(assign, call);
+}
+
+/* Массив с размером в объявлении (int a[10]) не имеет заголовка
+   динамического массива: его длина — sizeof a / sizeof a[0]. Возвращает
+   число оставшихся измерений или 0, если это не такой массив. */
+static int fixed_dimensions(LowerContext* ctx, const Node* array) {
+    int indexes = 0;
+    while (array->kind == NODE_INDEX) {
+        array = array->u.index.base;
+        indexes++;
+    }
+    int index = array->kind == NODE_IDENT ? find_name(ctx, array) : -1;
+    if (index < 0 || ctx->names[index].fixed <= indexes) {
+        return 0;
+    }
+    return ctx->names[index].fixed - indexes;
+}
+
+static Node* fixed_length(LowerContext* ctx, const Node* array) {
+    Node* value = new_node(ctx, array->kind, array->line);
+    Node* whole = new_node(ctx, NODE_SIZEOF, array->line);
+    Node* element = new_node(ctx, NODE_SIZEOF, array->line);
+    Node* first = new_node(ctx, NODE_INDEX, array->line);
+    Node* length = new_node(ctx, NODE_CAST, array->line);
+
+    *value = *array;
+    value->next = NULL;
+    whole->u.cast.expr = value;
+    first->u.index.base = value;
+    first->u.index.index = make_int(ctx, 0, array->line);
+    element->u.cast.expr = first;
+    length->u.cast.type.name = "int";
+    length->u.cast.expr = make_binary(ctx, NODE_BINARY, TOK_SLASH, whole, element);
+    return length;
+}
+
+/* Одномерный массив фиксированного размера передаётся туда, где ждут
+   срез, через mika_fixed_view(a, длина). */
+static void view_fixed_array(LowerContext* ctx, Node* array) {
+    Node* length = fixed_length(ctx, array);
+    wrap_in_call(ctx, array, "mika_fixed_view");
+    array->u.call.args->next = length;
+}
+
+static int check_arity(LowerContext* ctx, Node* call, const char* name, int arity) {
+    if (node_count(call->u.call.args) != arity) {
+        lower_error(ctx, call, "%s() ожидает аргументов: %d", name, arity);
+        return 0;
+    }
+    return 1;
+}
+
+static void process_array_builtin(LowerContext* ctx, Node* call, const char* name, int arity) {
+    Node* array = call->u.call.args;
+
+    if (!check_arity(ctx, call, name, arity)) {
+        return;
+    }
+    if (strcmp(name, "len") == 0) {
+        ValueKind kind = value_kind(ctx, array);
+        if (fixed_dimensions(ctx, array) > 0) {
+            Node* length = fixed_length(ctx, array);
+            length->next = call->next;
+            *call = *length;
+        } else if (kind == VALUE_SLICE || kind == VALUE_RECORDS || (kind == VALUE_STRING && array->kind == NODE_IDENT)) {
+            replace_node(call, field_of(ctx, array, "length"));
+        } else {
+            rename_callee(call, kind == VALUE_STRING ? "mika_string_length" : "array_length");
+        }
+    } else if (strcmp(name, "push") == 0 || strcmp(name, "reserve") == 0) {
+        rename_callee(call, name[0] == 'p' ? "array_push" : "array_reserve");
+        pass_by_address(ctx, call);
+    } else if (strcmp(name, "pop") == 0) {
+        rename_callee(call, "array_pop");
+    } else if (value_kind(ctx, array) == VALUE_SLICE) {
+        rename_callee(call, "slice_range");
+    } else if (fixed_dimensions(ctx, array) == 1) {
+        view_fixed_array(ctx, array);
+        rename_callee(call, "slice_range");
+    }
+}
+
+/* Векторные операции рантайма принимают срезы; массив передаётся
+   целиком через array_view(). */
+static void process_array_kernel(LowerContext* ctx, Node* call) {
+    static const struct { const char* name; int arity; int arrays; } kernels[] = {
+        {"array_sum", 1, 1}, {"array_min", 1, 1}, {"array_max", 1, 1},
+        {"array_fill", 2, 1}, {"array_copy", 2, 2}, {"array_dot", 2, 2},
+        {"array_add", 3, 3}, {"array_sub", 3, 3}, {"array_mul", 3, 3},
+    };
+
+    for (size_t i = 0; i < sizeof(kernels) / sizeof(kernels[0]); i++) {
+        if (!node_is_ident(call->u.call.callee, kernels[i].name)) {
+            continue;
+        }
+        if (!check_arity(ctx, call, kernels[i].name, kernels[i].arity)) {
+            return;
+        }
+        Node* arg = call->u.call.args;
+        for (int n = 0; n < kernels[i].arrays; n++, arg = arg->next) {
+            if (fixed_dimensions(ctx, arg) == 1) {
+                view_fixed_array(ctx, arg);
+            } else if (value_kind(ctx, arg) != VALUE_SLICE) {
+                wrap_in_call(ctx, arg, "array_view");
+            }
+        }
+        return;
+    }
+}
+
+/* string_length/string_compare/string_copy над char* остаются функциями
+   из <string.h>; если хотя бы один аргумент — строка Mika, вызов
+   переводится на MikaString. */
+static void process_string_builtin(LowerContext* ctx, Node* call, const char* name, int arity) {
+    Node* first = call->u.call.args;
+
+    if (!check_arity(ctx, call, name, arity)) {
+        return;
+    }
+    ValueKind kind = arity > 0 ? value_kind(ctx, first) : VALUE_OTHER;
+
+    if (strcmp(name, "string_length") == 0) {
+        if (kind == VALUE_STRING) {
+            process_array_builtin(ctx, call, "len", 1);
+        }
+    } else if (strcmp(name, "string_compare") == 0) {
+        if (kind == VALUE_STRING || value_kind(ctx, first->next) == VALUE_STRING) {
+            convert_to_string(ctx, first);
+            convert_to_string(ctx, first->next);
+            rename_callee(call, "mika_string_compare");
+        }
+    } else if (strcmp(name, "string_copy") == 0) {
+        if (kind == VALUE_STRING) {
+            convert_to_string(ctx, first->next);
+            rename_callee(call, "mika_string_assign");
+            pass_by_address(ctx, call);
+        } else if (value_kind(ctx, first->next) == VALUE_STRING) {
+            rename_callee(call, "mika_string_write");
+        }
+    } else if (strcmp(name, "substring") == 0) {
+        convert_to_string(ctx, first);
+        rename_callee(call, "mika_string_substring");
+    } else if (strcmp(name, "input_line") == 0) {
+        rename_callee(call, "mika_input_line");
+    } else if (kind != VALUE_BUILDER && strcmp(name, "string_free") != 0) {
+        lower_error(ctx, call, "%s() ожидает построитель строк (string_builder)", name);
+    } else if (strcmp(name, "append") == 0) {
+        convert_to_string(ctx, first->next);
+        rename_callee(call, "mika_builder_append");
+        pass_by_address(ctx, call);
+    } else if (strcmp(name, "to_string") == 0) {
+        rename_callee(call, "mika_builder_finish");
+        pass_by_address(ctx, call);
+    } else if (kind == VALUE_STRING || kind == VALUE_BUILDER) {
+        rename_callee(call, kind == VALUE_STRING ? "mika_string_free" : "mika_builder_free");
+        pass_by_address(ctx, call);
+    } else {
+        lower_error(ctx, call, "string_free() ожидает строку или построитель строк");
+    }
+}
+
+/* Строки Mika печатаются через %S: в литерале формата %s заменяется на %S
+   для тех аргументов, которые являются MikaString. */
+static void process_print_strings(LowerContext* ctx, Node* call) {
+    Node* format = call->u.call.args;
+    int has_strings = 0;
+
+    if (!format || format->kind != NODE_STRING) {
+        return;
+    }
+    for (Node* arg = format->next; arg && !has_strings; arg = arg->next) {
+        has_strings = value_kind(ctx, arg) == VALUE_STRING;
+    }
+    if (!has_strings) {
+        return;
+    }
+
+    char* text = arena_strndup(ctx->arena, format->u.lit.text, format->u.lit.len);
+    Node* arg = format->next;
+    for (char* p = strchr(text, '%'); p && arg; p = strchr(p, '%')) {
+        p++;
+        if (*p == '%') {
+            p++;
+            continue;
+        }
+        while (*p && strchr("-+ #0", *p)) p++;
+        for (int part = 0; part < 2; part++) {
+            if (*p == '*') {
+                arg = arg ? arg->next : NULL;
+                p++;
+            }
+            while (*p >= '0' && *p <= '9') p++;
+            if (part == 0 && *p == '.') p++;
+        }
+        const char* conversion = p;
+        while (*p && strchr("hlLqjzt", *p)) p++;
+        if (*p == 's' && p == conversion && arg && value_kind(ctx, arg) == VALUE_STRING) {
+            *p = 'S';
+        }
+        arg = arg ? arg->next : NULL;
+    }
+    format->u.lit.text = text;
+}
+
+static void process_return(LowerContext* ctx, Node* ret) {
+    (void)ctx;
+    Node* value = ret->u.ret.value;
+    if (value && value->kind == NODE_INT && value->u.lit.value == MIKA_SUCCESS_CODE) {
+        value->u.lit.text = "0";
+        value->u.lit.len = 1;
+        value->u.lit.value = 0;
+    }
+}
+
+static void process_variables(LowerContext* ctx, TypeRef* type) {
+    if (type->is_var) {
+        type->name = "int";
+        type->is_var = 0;
+    } else if (type->records) {
+        int record = find_record(ctx, type->name);
+        if (record >= 0) {
+            type->name = ctx->records[record].collection;
+        }
+    } else {
+        const KnownType* known = find_known_type(type->name);
+        if (known && known->c_name) {
+            type->name = known->c_name;
+        }
+    }
+}
+
+/* В сборке --whole-program все модули и рантайм — одна единица
+   трансляции: функции, определённые в программе, становятся static,
+   а граф вызовов подсказывает gcc, что встраивать и что убрать в
+   холодную секцию. */
+static void apply_call_graph(LowerContext* ctx, Node* func) {
+    const CallGraphFunction* info = callgraph_find(ctx->program, func->u.func.name);
+    TypeRef* ret = &func->u.func.ret;
+
+    if (!info || !info->defined || strcmp(func->u.func.name, "main") == 0) {
+        return;
+    }
+    ret->storage = (ret->storage & ~STORAGE_EXTERN) | STORAGE_STATIC;
+    if (info->hint == CALL_HINT_INLINE) {
+        ret->storage |= STORAGE_INLINE;
+    } else if (info->hint == CALL_HINT_HOT) {
+        ret->storage |= STORAGE_HOT;
+    } else if (info->hint == CALL_HINT_COLD) {
+        ret->storage |= STORAGE_COLD;
+    }
+}
+
+static void process_function_declaration(LowerContext* ctx, Node* func) {
+    if (ctx->program) {
+        apply_call_graph(ctx, func);
+    }
+    process_variables(ctx, &func->u.func.ret);
+    for (Node* param = func->u.func.params; param; param = param->next) {
+        process_variables(ctx, &param->u.var.type);
+    }
+}
+
+static void lower_node(LowerContext* ctx, Node* node);
+static void process_records_builtin(LowerContext* ctx, Node* call, int create);
+
+static void lower_list(LowerContext* ctx, Node* list) {
+    for (; list; list = list->next) {
+        lower_node(ctx, list);
+    }
+}
+
+static void lower_call(LowerContext* ctx, Node* call) {
+    Node* callee = call->u.call.callee;
+
+    lower_node(ctx, callee);
+    lower_list(ctx, call->u.call.args);
+
+    if (node_is_ident(callee, "print")) {
+        process_print(ctx, call);
+        process_print_strings(ctx, call);
+    } else if (node_is_ident(callee, "input")) {
+        process_input_function(ctx, call);
+    } else if (node_is_ident(callee, "power")) {
+        process_power_function(ctx, call);
+    } else if (node_is_ident(callee, "absolute")) {
+        process_absolute_function(ctx, call);
+    } else if (node_is_ident(callee, "len") || node_is_ident(callee, "pop")) {
+        process_array_builtin(ctx, call, callee->u.lit.text[0] == 'l' ? "len" : "pop", 1);
+    } else if (node_is_ident(callee, "push") || node_is_ident(callee, "reserve")) {
+        process_array_builtin(ctx, call, callee->u.lit.text[0] == 'p' ? "push" : "reserve", 2);
+    } else if (node_is_ident(callee, "array_slice")) {
+        process_array_builtin(ctx, call, "array_slice", 3);
+    } else if (node_is_ident(callee, "string_length") || node_is_ident(callee, "to_string") ||
+               node_is_ident(callee, "string_free")) {
+        process_string_builtin(ctx, call, arena_strndup(ctx->arena, callee->u.lit.text, callee->u.lit.len), 1);
+    } else if (node_is_ident(callee, "string_compare") || node_is_ident(callee, "string_copy") ||
+               node_is_ident(callee, "append")) {
+        process_string_builtin(ctx, call, arena_strndup(ctx->arena, callee->u.lit.text, callee->u.lit.len), 2);
+    } else if (node_is_ident(callee, "substring")) {
+        process_string_builtin(ctx, call, "substring", 3);
+    } else if (node_is_ident(callee, "input_line")) {
+        process_string_builtin(ctx, call, "input_line", 0);
+    } else if (node_is_ident(callee, "records") || node_is_ident(callee, "records_free")) {
+        process_records_builtin(ctx, call, callee->u.lit.len == 7);
+    } else {
+        process_array_kernel(ctx, call);
+    }
+}
+
+static Node* make_ident(LowerContext* ctx, const char* name, int line) {
+    Node* ident = new_node(ctx, NODE_IDENT, line);
+    ident->u.lit.text = name;
+    ident->u.lit.len = strlen(name);
+    return ident;
+}
+
+static Node* make_int(LowerContext* ctx, int value, int line) {
+    char text[16];
+    Node* literal = new_node(ctx, NODE_INT, line);
+    literal->u.lit.value = value;
+    literal->u.lit.len = (size_t)snprintf(text, sizeof(text), "%d", value);
+    literal->u.lit.text = arena_strndup(ctx->arena, text, literal->u.lit.len);
+    return literal;
+}
+
+static Node* make_binary(LowerContext* ctx, NodeKind kind, TokenKind op, Node* lhs, Node* rhs) {
+    Node* node = new_node(ctx, kind, lhs->line);
+    node->u.binary.op = op;
+    node->u.binary.lhs = lhs;
+    node->u.binary.rhs = rhs;
+    return node;
+}
+
+static Node* make_statement(LowerContext* ctx, Node* expr) {
+    Node* statement = new_node(ctx, NODE_EXPR_STMT, expr->line);
+    statement->u.ret.value = expr;
+    return statement;
+}
+
+static Node* make_call_statement(LowerContext* ctx, const char* function, Node* args, int line) {
+    Node* call = new_node(ctx, NODE_CALL, line);
+    call->u.call.callee = make_ident(ctx, function, line);
+    call->u.call.args = args;
+    return make_statement(ctx, call);
+}
+
+static Node* make_decl(LowerContext* ctx, const TypeRef* type, const char* name, Node* init, int line) {
+    Node* decl = new_node(ctx, NODE_DECL, line);
+    Node* var = new_node(ctx, NODE_VAR, line);
+    var->u.var.name = name;
+    var->u.var.type = *type;
+    var->u.var.init = init;
+    decl->u.decl.type = *type;
+    decl->u.decl.vars = var;
+    return decl;
+}
+
+static void append_node(Node** list, Node* node) {
+    while (*list) {
+        list = &(*list)->next;
+    }
+    *list = node;
+}
+
+/* ---------- Записи ---------- */
+
+/* Коллекция Particle[] — это Particle_records: в раскладке SoA по
+   указателю на каждое поле, в AoS — указатель items на массив структур.
+   Всё выделяется одним блоком через mika_records_alloc. */
+
+static int find_record(LowerContext* ctx, const char* name) {
+    for (int i = 0; i < ctx->record_count; i++) {
+        if (strcmp(ctx->records[i].name, name) == 0 || strcmp(ctx->records[i].collection, name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int record_field(const RecordType* record, const char* name) {
+    for (int i = 0; i < record->field_count; i++) {
+        if (strcmp(record->fields[i].name, name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static const char* record_function(LowerContext* ctx, const RecordType* record, const char* suffix) {
+    size_t len = strlen(record->collection) + strlen(suffix) + 2;
+    char* name = arena_alloc(ctx->arena, len);
+    snprintf(name, len, "%s_%s", record->collection, suffix);
+    return name;
+}
+
+static int calls_record_function(const Node* call, const RecordType* record, const char* suffix) {
+    const Node* callee = call->u.call.callee;
+    size_t prefix = strlen(record->collection);
+    size_t len = strlen(suffix);
+
+    return callee->kind == NODE_IDENT && callee->u.lit.len == prefix + len + 1 &&
+           memcmp(callee->u.lit.text, record->collection, prefix) == 0 &&
+           callee->u.lit.text[prefix] == '_' && memcmp(callee->u.lit.text + prefix + 1, suffix, len) == 0;
+}
+
+/* Номер record у значения или -1; *collection — коллекция это или одна
+   запись. Понимает имена, вызовы функций, уже разобранные records(),
+   ps[i] и элементы AoS. */
+static int record_of(LowerContext* ctx, const Node* node, int* collection) {
+    int index;
+
+    *collection = 0;
+    if (ctx->record_count == 0) {
+        return -1;
+    }
+    switch (node->kind) {
+        case NODE_IDENT:
+            index = find_name(ctx, node);
+            break;
+        case NODE_CALL:
+            for (int i = 0; i < ctx->record_count; i++) {
+                if (calls_record_function(node, &ctx->records[i], "create")) {
+                    *collection = 1;
+                    return i;
+                }
+                if (calls_record_function(node, &ctx->records[i], "get")) {
+                    return i;
+                }
+            }
+            index = find_name(ctx, node->u.call.callee);
+            break;
+        case NODE_INDEX: {
+            const Node* items = node->u.index.base;
+            int record = items->kind == NODE_MEMBER && strcmp(items->u.member.name, "items") == 0
+                             ? record_of(ctx, items->u.member.base, collection) : -1;
+            if (record < 0 || !*collection) {
+                *collection = 0;
+                return -1;
+            }
+            *collection = 0;
+            return record;
+        }
+        default:
+            return -1;
+    }
+    if (index < 0 || ctx->names[index].record < 0 || ctx->names[index].depth != 0) {
+        return -1;
+    }
+    *collection = ctx->names[index].kind == VALUE_RECORDS;
+    return ctx->names[index].record;
+}
+
+/* p.x у записи или ps.x у коллекции SoA (column), которая индексируется */
+static NumberRank record_field_rank(LowerContext* ctx, const Node* member, int column) {
+    int collection;
+    int record = record_of(ctx, member->u.member.base, &collection);
+
+    if (record < 0 || collection != column) {
+        return RANK_NONE;
+    }
+    int field = record_field(&ctx->records[record], member->u.member.name);
+    return field >= 0 ? ctx->records[record].fields[field].number : RANK_NONE;
+}
+
+/* Коллекция SoA: для ps[i].x и ps[i] = p нужен номер её record. */
+static int soa_records(LowerContext* ctx, const Node* node) {
+    int collection;
+    int record = record_of(ctx, node, &collection);
+    return record >= 0 && collection && !ctx->records[record].aos ? record : -1;
+}
+
+static int aos_records(LowerContext* ctx, const Node* node) {
+    int collection;
+    int record = record_of(ctx, node, &collection);
+    return record >= 0 && collection && ctx->records[record].aos ? record : -1;
+}
+
+static Node* record_call(LowerContext* ctx, const RecordType* record, const char* suffix, Node* args, int line) {
+    Node* call = new_node(ctx, NODE_CALL, line);
+    call->u.call.callee = make_ident(ctx, record_function(ctx, record, suffix), line);
+    call->u.call.args = args;
+    return call;
+}
+
+/* ps[i].x: в SoA это ps.x[i], в AoS — ps.items[i].x */
+static int lower_record_member(LowerContext* ctx, Node* node) {
+    Node* element = node->u.member.base;
+    if (element->kind != NODE_INDEX || node->u.member.arrow) {
+        return 0;
+    }
+    Node* records = element->u.index.base;
+    Node* index = element->u.index.index;
+    int soa = soa_records(ctx, records);
+    int record = soa >= 0 ? soa : aos_records(ctx, records);
+    if (record < 0) {
+        return 0;
+    }
+
+    lower_node(ctx, records);
+    lower_node(ctx, index);
+    if (record_field(&ctx->records[record], node->u.member.name) < 0) {
+        lower_error(ctx, node, "в record %s нет поля '%s'", ctx->records[record].name, node->u.member.name);
+        return 1;
+    }
+    if (soa < 0) {
+        element->u.index.base = field_of(ctx, records, "items");
+        return 1;
+    }
+    Node* column = field_of(ctx, records, node->u.member.name);
+    node->kind = NODE_INDEX;
+    node->u.index.base = column;
+    node->u.index.index = index;
+    return 1;
+}
+
+/* ps[i] целиком: в SoA запись собирается из полей функцией _get */
+static int lower_record_index(LowerContext* ctx, Node* node) {
+    Node* records = node->u.index.base;
+    Node* index = node->u.index.index;
+    int soa = soa_records(ctx, records);
+    int record = soa >= 0 ? soa : aos_records(ctx, records);
+    if (record < 0) {
+        return 0;
+    }
+
+    lower_node(ctx, records);
+    lower_node(ctx, index);
+    if (soa < 0) {
+        node->u.index.base = field_of(ctx, records, "items");
+        return 1;
+    }
+    records->next = index;
+    index->next = NULL;
+    replace_node(node, record_call(ctx, &ctx->records[record], "get", records, node->line));
+    return 1;
+}
+
+/* ps[i] = p: в SoA запись раскладывается по полям функцией _set */
+static int lower_record_store(LowerContext* ctx, Node* node) {
+    Node* target = node->u.binary.lhs;
+    if (node->u.binary.op != TOK_ASSIGN || target->kind != NODE_INDEX) {
+        return 0;
+    }
+    int record = soa_records(ctx, target->u.index.base);
+    if (record < 0) {
+        return 0;
+    }
+
+    Node* records = target->u.index.base;
+    Node* index = target->u.index.index;
+    Node* value = node->u.binary.rhs;
+    lower_node(ctx, records);
+    lower_node(ctx, index);
+    lower_node(ctx, value);
+    records->next = index;
+    index->next = value;
+    value->next = NULL;
+    replace_node(node, record_call(ctx, &ctx->records[record], "set", records, node->line));
+    return 1;
+}
+
+/* records(Particle, n) и records_free(ps) */
+static void process_records_builtin(LowerContext* ctx, Node* call, int create) {
+    Node* arg = call->u.call.args;
+    int record = -1;
+    int collection = 0;
+
+    if (!check_arity(ctx, call, create ? "records" : "records_free", create ? 2 : 1)) {
+        return;
+    }
+    if (create) {
+        for (int i = 0; i < ctx->record_count && record < 0; i++) {
+            record = node_is_ident(arg, ctx->records[i].name) ? i : -1;
+        }
+    } else {
+        record = record_of(ctx, arg, &collection);
+    }
+    if (record < 0 || (!create && !collection)) {
+        lower_error(ctx, call, create ? "records() ожидает первым аргументом имя типа record"
+                                      : "records_free() ожидает коллекцию записей");
+        return;
+    }
+    rename_callee(call, record_function(ctx, &ctx->records[record], create ? "create" : "free"));
+    if (create) {
+        call->u.call.args = arg->next;
+    } else {
+        pass_by_address(ctx, call);
+    }
+}
+
+/* Текст типов record собирается в арене; буфер удваивается, когда
+   очередной кусок не помещается. */
+typedef struct {
+    Arena* arena;
+    char* text;
+    size_t len;
+    size_t capacity;
+} RecordText;
+
+static void record_printf(RecordText* out, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    int written = vsnprintf(out->text + out->len, out->capacity - out->len, fmt, args);
+    va_end(args);
+    if (written < 0) {
+        return;
+    }
+    if ((size_t)written >= out->capacity - out->len) {
+        size_t capacity = out->capacity * 2;
+        while (capacity - out->len <= (size_t)written) {
+            capacity *= 2;
+        }
+        char* text = arena_alloc(out->arena, capacity);
+        memcpy(text, out->text, out->len);
+        out->text = text;
+        out->capacity = capacity;
+        va_start(args, fmt);
+        vsnprintf(out->text + out->len, out->capacity - out->len, fmt, args);
+        va_end(args);
+    }
+    out->len += (size_t)written;
+}
+
+static void record_field_type(RecordText* out, const Node* field) {
+    record_printf(out, "%s", field->u.var.type.name);
+    for (int i = 0; i < field->u.var.type.pointers; i++) {
+        record_printf(out, "*");
+    }
+}
+
+static void emit_record_type(RecordText* out, const RecordType* record, const Node* fields) {
+    const char* name = record->name;
+    const char* type = record->collection;
+
+    record_printf(out, "typedef struct %s {\n", name);
+    for (const Node* field = fields; field; field = field->next) {
+        record_printf(out, "    ");
+        record_field_type(out, field);
+        record_printf(out, " %s;\n", field->u.var.name);
+    }
+    record_printf(out, "} %s;\n\n", name);
+
+    if (record->aos) {
+        record_printf(out, "typedef struct {\n    %s* items;\n    int length;\n} %s;\n\n", name, type);
+        record_printf(out, "static inline %s %s_create(int length) {\n", type, type);
+        record_printf(out, "    static const size_t sizes[] = {sizeof(%s)};\n", name);
+        record_printf(out, "    void* fields[1];\n    %s records;\n", type);
+        record_printf(out, "    records.length = mika_records_alloc(length, sizes, 1, fields);\n");
+        record_printf(out, "    records.items = fields[0];\n    return records;\n}\n\n");
+        record_printf(out, "static inline void %s_free(%s* records) {\n", type, type);
+        record_printf(out, "    mika_records_free(records->items);\n");
+        record_printf(out, "    records->items = NULL;\n    records->length = 0;\n}");
+        return;
+    }
+
+    /* поля разных столбцов не пересекаются: restrict разрешает векторизацию */
+    record_printf(out, "typedef struct {\n");
+    for (const Node* field = fields; field; field = field->next) {
+        record_printf(out, "    ");
+        record_field_type(out, field);
+        record_printf(out, "* restrict %s;\n", field->u.var.name);
+    }
+    record_printf(out, "    int length;\n} %s;\n\n", type);
+
+    record_printf(out, "static inline %s %s_create(int length) {\n", type, type);
+    record_printf(out, "    static const size_t sizes[] = {");
+    for (const Node* field = fields; field; field = field->next) {
+        record_printf(out, "sizeof(");
+        record_field_type(out, field);
+        record_printf(out, field->next ? "), " : ")");
+    }
+    record_printf(out, "};\n    void* fields[%d];\n    %s records;\n", record->field_count, type);
+    record_printf(out, "    records.length = mika_records_alloc(length, sizes, %d, fields);\n", record->field_count);
+    int column = 0;
+    for (const Node* field = fields; field; field = field->next) {
+        record_printf(out, "    records.%s = fields[%d];\n", field->u.var.name, column++);
+    }
+    record_printf(out, "    return records;\n}\n\n");
+
+    record_printf(out, "static inline %s %s_get(%s records, int index) {\n    %s value;\n", name, type, type, name);
+    for (const Node* field = fields; field; field = field->next) {
+        record_printf(out, "    value.%s = records.%s[index];\n", field->u.var.name, field->u.var.name);
+    }
+    record_printf(out, "    return value;\n}\n\n");
+
+    record_printf(out, "static inline void %s_set(%s records, int index, %s value) {\n", type, type, name);
+    for (const Node* field = fields; field; field = field->next) {
+        record_printf(out, "    records.%s[index] = value.%s;\n", field->u.var.name, field->u.var.name);
+    }
+    record_printf(out, "}\n\n");
+
+    record_printf(out, "static inline void %s_free(%s* records) {\n", type, type);
+    record_printf(out, "    mika_records_free(records->%s);\n", fields->u.var.name);
+    for (const Node* field = fields; field; field = field->next) {
+        record_printf(out, "    records->%s = NULL;\n", field->u.var.name);
+    }
+    record_printf(out, "    records->length = 0;\n}");
+}
+
+/* Объявление record запоминается до конца файла и заменяется на текст C. */
+static void lower_record(LowerContext* ctx, Node* node) {
+    const char* name = node->u.record.name;
+    Node* fields = node->u.record.fields;
+
+    if (ctx->record_count >= LOWER_MAX_RECORDS) {
+        lower_error(ctx, node, "слишком много типов record");
+        return;
+    }
+    if (strlen(name) + sizeof("_records") > LOWER_NAME_SIZE) {
+        lower_error(ctx, node, "слишком длинное имя record %s", name);
+        return;
+    }
+    if (find_record(ctx, name) >= 0) {
+        lower_error(ctx, node, "record %s уже объявлен", name);
+        return;
+    }
+
+    RecordType* record = &ctx->records[ctx->record_count];
+    snprintf(record->name, sizeof(record->name), "%s", name);
+    snprintf(record->collection, sizeof(record->collection), "%s_records", name);
+    record->aos = node->u.record.aos;
+    record->field_count = 0;
+    for (Node* field = fields; field; field = field->next) {
+        const char* field_name = field->u.var.name;
+        process_variables(ctx, &field->u.var.type);
+        if (field->u.var.dims || field->u.var.init || field->u.var.type.is_const) {
+            lower_error(ctx, field, "поле %s.%s: в record нельзя объявлять массивы, const и начальные значения",
+                        name, field_name);
+            return;
+        }
+        if (!record->aos && strcmp(field_name, "length") == 0) {
+            lower_error(ctx, field, "поле %s.length занято длиной коллекции SoA", name);
+            return;
+        }
+        if (record_field(record, field_name) >= 0) {
+            lower_error(ctx, field, "поле %s.%s объявлено дважды", name, field_name);
+            return;
+        }
+        if (record->field_count >= LOWER_MAX_FIELDS || strlen(field_name) >= LOWER_NAME_SIZE) {
+            lower_error(ctx, field, "слишком много полей в record %s", name);
+            return;
+        }
+        RecordField* slot = &record->fields[record->field_count++];
+        strcpy(slot->name, field_name);
+        slot->number = field->u.var.type.pointers == 0 ? type_rank(&field->u.var.type) : RANK_NONE;
+    }
+    if (record->field_count == 0) {
+        lower_error(ctx, node, "record %s без полей", name);
+        return;
+    }
+    ctx->record_count++;
+
+    RecordText out;
+    out.arena = ctx->arena;
+    out.capacity = 1024 + (size_t)record->field_count * 256;
+    out.text = arena_alloc(ctx->arena, out.capacity);
+    out.len = 0;
+    out.text[0] = '\0';
+    emit_record_type(&out, record, fields);
+    node->kind = NODE_RAW;
+    node->u.lit.text = out.text;
+    node->u.lit.len = out.len;
+}
+
+/* (T*)mika_shared[slot] или *(T*)mika_shared[slot]. */
+static Node* shared_slot(LowerContext* ctx, const TypeRef* type, int slot, int deref, int line) {
+    Node* index = new_node(ctx, NODE_INDEX, line);
+    Node* cast = new_node(ctx, NODE_CAST, line);
+    index->u.index.base = make_ident(ctx, "mika_shared", line);
+    index->u.index.index = make_int(ctx, slot, line);
+    cast->u.cast.type = *type;
+    cast->u.cast.type.pointers++;
+    cast->u.cast.expr = index;
+    if (!deref) {
+        return cast;
+    }
+    Node* value = new_node(ctx, NODE_UNARY, line);
+    value->u.unary.op = TOK_STAR;
+    value->u.unary.operand = cast;
+    return value;
+}
+
+static Node* shared_address(LowerContext* ctx, const Node* decl, int line) {
+    Node* cast = new_node(ctx, NODE_CAST, line);
+    Node* value = make_ident(ctx, decl->u.var.name, line);
+    cast->u.cast.type.name = "void";
+    cast->u.cast.type.pointers = 1;
+    if (!decl->u.var.dims) {
+        Node* address = new_node(ctx, NODE_UNARY, line);
+        address->u.unary.op = TOK_AMP;
+        address->u.unary.operand = value;
+        value = address;
+    }
+    cast->u.cast.expr = value;
+    return cast;
+}
+
+static const Node* reduction_for(const ParallelRegion* region, const Node* ident) {
+    for (const Node* clause = region->clauses; clause; clause = clause->next) {
+        const Node* var = clause->u.call.args;
+        if (var->u.lit.len == ident->u.lit.len && memcmp(var->u.lit.text, ident->u.lit.text, var->u.lit.len) == 0) {
+            return clause;
+        }
+    }
+    return NULL;
+}
+
+static void capture_name(LowerContext* ctx, Node* ident) {
+    int index = find_name(ctx, ident);
+    if (index < ctx->global_names) {
+        return;
+    }
+    for (ParallelRegion* region = ctx->region; region && index < region->scope; region = region->outer) {
+        Node* decl = ctx->names[index].decl;
+        int known = 0;
+        for (int i = 0; i < region->capture_count && !known; i++) {
+            known = region->captures[i] == decl;
+        }
+        if (known) {
+            continue;
+        }
+        if (region->capture_count >= LOWER_MAX_CAPTURES) {
+            lower_error(ctx, ident, "слишком много внешних переменных в parallel for");
+            return;
+        }
+        region->captures[region->capture_count++] = decl;
+    }
+}
+
+/* Итерации выполняются в разных потоках, поэтому внешние переменные видны
+   в теле копиями; писать можно только в переменные редукции. */
+static void check_shared_write(LowerContext* ctx, const Node* target) {
+    if (!ctx->region || target->kind != NODE_IDENT) {
+        return;
+    }
+    int index = find_name(ctx, target);
+    if (index < ctx->global_names || index >= ctx->region->scope || reduction_for(ctx->region, target)) {
+        return;
+    }
+    lower_error(ctx, target, "переменная '%s' объявлена вне parallel for: в цикле её можно только читать "
+                "или указать в редукции", ctx->names[index].name);
+}
+
+static void check_parallel_body(LowerContext* ctx, const Node* node, int in_loop) {
+    if (!node) {
+        return;
+    }
+    switch (node->kind) {
+        case NODE_BLOCK:
+            for (const Node* item = node->u.list.items; item; item = item->next) {
+                check_parallel_body(ctx, item, in_loop);
+            }
+            break;
+        case NODE_IF:
+            check_parallel_body(ctx, node->u.cond.then_branch, in_loop);
+            check_parallel_body(ctx, node->u.cond.else_branch, in_loop);
+            break;
+        case NODE_WHILE: case NODE_DO: case NODE_FOR: case NODE_PARALLEL_FOR: case NODE_SWITCH:
+            check_parallel_body(ctx, node->u.loop.body, 1);
+            break;
+        case NODE_RETURN:
+            lower_error(ctx, node, "return внутри parallel for не поддерживается");
+            break;
+        case NODE_BREAK:
+            if (!in_loop) {
+                lower_error(ctx, node, "break внутри parallel for не поддерживается");
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+static int is_unit_step(const Node* step, const char* name) {
+    long long value;
+    if (!step) {
+        return 0;
+    }
+    if (step->kind == NODE_POSTFIX || step->kind == NODE_UNARY) {
+        return step->u.unary.op == TOK_INC && node_is_ident(step->u.unary.operand, name);
+    }
+    return step->kind == NODE_ASSIGN && step->u.binary.op == TOK_PLUS_ASSIGN &&
+           node_is_ident(step->u.binary.lhs, name) && constant_int(step->u.binary.rhs, &value) && value == 1;
+}
+
+static Node* parallel_index(LowerContext* ctx, Node* loop) {
+    Node* init = loop->u.loop.init;
+    Node* cond = loop->u.loop.cond;
+    Node* index = NULL;
+
+    if (init && init->kind == NODE_DECL && !init->u.decl.vars->next) {
+        index = init->u.decl.vars;
+    }
+    if (index && (index->u.var.dims || !index->u.var.init || !cond || cond->kind != NODE_BINARY ||
+                  (cond->u.binary.op != TOK_LT && cond->u.binary.op != TOK_LE) ||
+                  !node_is_ident(cond->u.binary.lhs, index->u.var.name) ||
+                  !is_unit_step(loop->u.loop.step, index->u.var.name))) {
+        index = NULL;
+    }
+    if (!index) {
+        lower_error(ctx, loop, "parallel for поддерживает только циклы вида "
+                    "for (var i = начало; i < конец; i++)");
+    }
+    return index;
+}
+
+static Node* reduction_decl(LowerContext* ctx, Node* clause) {
+    int index = find_name(ctx, clause->u.call.args);
+    Node* decl = index >= ctx->global_names ? ctx->names[index].decl : NULL;
+    if (!decl || decl->kind == NODE_FUNCTION || decl->u.var.dims) {
+        lower_error(ctx, clause, "редукция должна относиться к локальной переменной, "
+                    "объявленной до parallel for");
+        return NULL;
+    }
+    return decl;
+}
+
+/* Вынесенное тело: копии внешних переменных, частичные результаты
+   редукций, цикл по своему отрезку и слияние результатов под блокировкой. */
+static Node* parallel_worker(LowerContext* ctx, ParallelRegion* region, Node* loop, Node* index,
+                             Node** reduced, int reductions, const char* name) {
+    int line = loop->line;
+    Node* func = new_node(ctx, NODE_FUNCTION, line);
+    Node* body = new_node(ctx, NODE_BLOCK, line);
+    Node* items = NULL;
+    TypeRef shared_type = {"void", 0, 0, 2, 0, 0};
+    TypeRef bound_type = {"int", 0, 0, 0, 0, 0};
+
+    func->u.func.name = name;
+    func->u.func.ret.name = "void";
+    func->u.func.ret.storage = STORAGE_STATIC;
+    func->u.func.body = body;
+    append_node(&func->u.func.params, make_decl(ctx, &shared_type, "mika_shared", NULL, line)->u.decl.vars);
+    append_node(&func->u.func.params, make_decl(ctx, &bound_type, "mika_from", NULL, line)->u.decl.vars);
+    append_node(&func->u.func.params, make_decl(ctx, &bound_type, "mika_to", NULL, line)->u.decl.vars);
+    for (Node* param = func->u.func.params; param; param = param->next) {
+        param->kind = NODE_PARAM;
+    }
+
+    for (int i = 0; i < region->capture_count; i++) {
+        Node* decl = region->captures[i];
+        TypeRef type = decl->u.var.type;
+        Node* init;
+        int skip = 0;
+
+        for (int r = 0; r < reductions; r++) {
+            skip = skip || reduced[r] == decl;
+        }
+        if (skip) {
+            continue;
+        }
+        type.storage = 0;
+        if (decl->u.var.dims && decl->u.var.dims->next) {
+            lower_error(ctx, loop, "многомерный массив '%s' нельзя использовать внутри parallel for",
+                        decl->u.var.name);
+        }
+        if (decl->u.var.dims) {
+            init = shared_slot(ctx, &type, i, 0, line);
+            type.pointers++;
+        } else {
+            init = shared_slot(ctx, &type, i, 1, line);
+        }
+        append_node(&items, make_decl(ctx, &type, decl->u.var.name, init, line));
+    }
+
+    Node* start = NULL;
+    Node* merge = NULL;
+    Node* clause = region->clauses;
+    for (int r = 0; r < reductions; r++, clause = clause->next) {
+        TypeRef type = reduced[r]->u.var.type;
+        const char* var = reduced[r]->u.var.name;
+        int slot = 0;
+        while (region->captures[slot] != reduced[r]) {
+            slot++;
+        }
+        type.storage = 0;
+
+        if (node_is_ident(clause->u.call.callee, "sum")) {
+            append_node(&items, make_decl(ctx, &type, var, make_int(ctx, 0, line), line));
+            append_node(&merge, make_statement(ctx, make_binary(ctx, NODE_ASSIGN, TOK_PLUS_ASSIGN,
+                shared_slot(ctx, &type, slot, 1, line), make_ident(ctx, var, line))));
+            continue;
+        }
+        TokenKind better = node_is_ident(clause->u.call.callee, "min") ? TOK_LT : TOK_GT;
+        Node* update = new_node(ctx, NODE_IF, line);
+        update->u.cond.cond = make_binary(ctx, NODE_BINARY, better, make_ident(ctx, var, line),
+                                          shared_slot(ctx, &type, slot, 1, line));
+        update->u.cond.then_branch = make_statement(ctx, make_binary(ctx, NODE_ASSIGN, TOK_ASSIGN,
+            shared_slot(ctx, &type, slot, 1, line), make_ident(ctx, var, line)));
+        append_node(&items, make_decl(ctx, &type, var, NULL, line));
+        append_node(&start, make_statement(ctx, make_binary(ctx, NODE_ASSIGN, TOK_ASSIGN,
+            make_ident(ctx, var, line), shared_slot(ctx, &type, slot, 1, line))));
+        append_node(&merge, update);
+    }
+    if (start) {
+        append_node(&items, make_call_statement(ctx, "mika_parallel_lock", NULL, line));
+        append_node(&items, start);
+        append_node(&items, make_call_statement(ctx, "mika_parallel_unlock", NULL, line));
+    }
+
+    Node* range = new_node(ctx, NODE_FOR, line);
+    range->u.loop.init = make_decl(ctx, &index->u.var.type, index->u.var.name, make_ident(ctx, "mika_from", line), line);
+    range->u.loop.cond = make_binary(ctx, NODE_BINARY, TOK_LT, make_ident(ctx, index->u.var.name, line),
+                                     make_ident(ctx, "mika_to", line));
+    range->u.loop.step = new_node(ctx, NODE_POSTFIX, line);
+    range->u.loop.step->u.unary.op = TOK_INC;
+    range->u.loop.step->u.unary.operand = make_ident(ctx, index->u.var.name, line);
+    range->u.loop.body = loop->u.loop.body;
+    append_node(&items, range);
+
+    if (merge) {
+        append_node(&items, make_call_statement(ctx, "mika_parallel_lock", NULL, line));
+        append_node(&items, merge);
+        append_node(&items, make_call_statement(ctx, "mika_parallel_unlock", NULL, line));
+    }
+    body->u.list.items = items;
+    return func;
+}
+
+/* parallel(sum: s) for (var i = a; i < b; i++) тело
+   ->
+   { void* mika_shared_N[] = {...}; mika_parallel_for(a, b, mika_parallel_f_N, mika_shared_N); } */
+static void lower_parallel_for(LowerContext* ctx, Node* loop) {
+    ParallelRegion region;
+    Node* reduced[LOWER_MAX_CAPTURES];
+    int reductions = 0;
+    int scope = ctx->name_count;
+    int line = loop->line;
+
+    memset(&region, 0, sizeof(region));
+    region.outer = ctx->region;
+    region.clauses = loop->u.loop.clauses;
+    check_parallel_body(ctx, loop->u.loop.body, 0);
+
+    Node* index = parallel_index(ctx, loop);
+    if (!index) {
+        return;
+    }
+    for (Node* clause = region.clauses; clause; clause = clause->next) {
+        if (reductions >= LOWER_MAX_CAPTURES || !(reduced[reductions] = reduction_decl(ctx, clause))) {
+            return;
+        }
+        for (int r = 0; r < reductions; r++) {
+            if (reduced[r] == reduced[reductions]) {
+                lower_error(ctx, clause, "переменная '%s' указана в нескольких редукциях",
+                            reduced[r]->u.var.name);
+                return;
+            }
+        }
+        capture_name(ctx, clause->u.call.args);
+        region.captures[region.capture_count++] = reduced[reductions++];
+    }
+
+    Node* end = loop->u.loop.cond->u.binary.rhs;
+    lower_node(ctx, loop->u.loop.init);
+    lower_node(ctx, end);
+    if (loop->u.loop.cond->u.binary.op == TOK_LE) {
+        end = make_binary(ctx, NODE_BINARY, TOK_PLUS, end, make_int(ctx, 1, line));
+    }
+
+    region.scope = scope;
+    ctx->region = &region;
+    lower_node(ctx, loop->u.loop.body);
+    ctx->region = region.outer;
+    ctx->name_count = scope;
+
+    char name[LOWER_NAME_SIZE * 2];
+    int number = ++ctx->parallel_count;
+    snprintf(name, sizeof(name), "mika_parallel_%s_%d", ctx->function->u.func.name, number);
+    Node* worker = parallel_worker(ctx, &region, loop, index, reduced, reductions,
+                                   arena_strndup(ctx->arena, name, strlen(name)));
+    append_node(&ctx->hoisted, worker);
+
+    Node* block = new_node(ctx, NODE_BLOCK, line);
+    Node* args = index->u.var.init;
+    Node* shared;
+    args->next = end;
+    end->next = make_ident(ctx, worker->u.func.name, line);
+
+    if (region.capture_count == 0) {
+        shared = make_ident(ctx, "NULL", line);
+    } else {
+        TypeRef pointer = {"void", 0, 0, 1, 0, 0};
+        Node* list = new_node(ctx, NODE_INIT_LIST, line);
+        for (int i = 0; i < region.capture_count; i++) {
+            append_node(&list->u.list.items, shared_address(ctx, region.captures[i], line));
+        }
+        snprintf(name, sizeof(name), "mika_shared_%d", number);
+        Node* decl = make_decl(ctx, &pointer, arena_strndup(ctx->arena, name, strlen(name)), list, line);
+        decl->u.decl.vars->u.var.dims = new_node(ctx, NODE_EMPTY, line);
+        block->u.list.items = decl;
+        shared = make_ident(ctx, decl->u.decl.vars->u.var.name, line);
+    }
+    end->next->next = shared;
+    append_node(&block->u.list.items, make_call_statement(ctx, "mika_parallel_for", args, line));
+    replace_node(loop, block);
+}
+
+/* var с инициализатором получает его тип: запись, строку Mika, срез или число
+   по правилам арифметики C. Без инициализатора var — это int. */
+static void infer_variable_type(LowerContext* ctx, Node* var) {
+    TypeRef* type = &var->u.var.type;
+    ValueKind kind = value_kind(ctx, var->u.var.init);
+    int collection;
+    int record = record_of(ctx, var->u.var.init, &collection);
+
+    if (record >= 0) {
+        type->name = collection ? ctx->records[record].collection : ctx->records[record].name;
+        type->records = collection;
+    } else if (kind == VALUE_STRING) {
+        type->name = "MikaString";
+    } else if (kind == VALUE_SLICE) {
+        type->name = "MikaSlice";
+    } else {
+        type->name = rank_names[infer_rank(ctx, var->u.var.init)];
+    }
+}
+
+/* C пишет тип один раз на объявление, поэтому переменные одного var
+   получают общий тип; массивы и указатели в таком объявлении остаются int. */
+static void unify_declaration(LowerContext* ctx, Node* decl, int first) {
+    Node* vars = decl->u.decl.vars;
+    const char* name = vars->u.var.type.name;
+    NumberRank rank = RANK_NONE;
+    int same = 1;
+    int numeric = 1;
+
+    for (Node* var = vars; var; var = var->next) {
+        NumberRank number = type_rank(&var->u.var.type);
+        same = same && strcmp(var->u.var.type.name, name) == 0;
+        numeric = numeric && number != RANK_NONE && !var->u.var.dims && var->u.var.type.pointers == 0;
+        rank = number > rank ? number : rank;
+    }
+    if (!same && !numeric) {
+        lower_error(ctx, decl, "переменные одного объявления var получили разные типы, объявите их отдельно");
+        return;
+    }
+    if (!same) {
+        name = rank_names[rank];
+        for (Node* var = vars; var; var = var->next) {
+            var->u.var.type.name = name;
+            for (int i = ctx->name_count - 1; i >= first; i--) {
+                if (ctx->names[i].decl == var) {
+                    ctx->names[i].number = rank;
+                }
+            }
+        }
+    }
+    decl->u.decl.type.name = name;
+}
+
+static void lower_variable(LowerContext* ctx, Node* var) {
+    int inferred = var->kind == NODE_VAR && var->u.var.type.is_var && var->u.var.init &&
+                   !var->u.var.dims && var->u.var.type.pointers == 0;
+    int depth = var->u.var.type.pointers + node_count(var->u.var.dims);
+
+    process_variables(ctx, &var->u.var.type);
+    lower_list(ctx, var->u.var.dims);
+    lower_node(ctx, var->u.var.init);
+    if (inferred) {
+        infer_variable_type(ctx, var);
+    }
+    ValueKind kind = var->u.var.dims ? VALUE_OTHER : type_value_kind(&var->u.var.type);
+    declare_name(ctx, var, var->u.var.name, kind, &var->u.var.type, depth);
+
+    if (var->kind != NODE_VAR || (kind != VALUE_STRING && kind != VALUE_BUILDER)) {
+        return;
+    }
+    if (var->u.var.init == NULL) {
+        Node* zero = new_node(ctx, NODE_INT, var->line);
+        zero->u.lit.text = "0";
+        zero->u.lit.len = 1;
+        var->u.var.init = new_node(ctx, NODE_INIT_LIST, var->line);
+        var->u.var.init->u.list.items = zero;
+    } else if (kind == VALUE_STRING && var->u.var.init->kind != NODE_INIT_LIST) {
+        convert_to_string(ctx, var->u.var.init);
+        if (borrows_string(var->u.var.init)) {
+            wrap_in_call(ctx, var->u.var.init, "mika_string_copy");
+        }
+    }
+}
+
+/* MIKA_INSTRUMENT("имя"); первой инструкцией тела функции */
+static void instrument_function(LowerContext* ctx, Node* func) {
+    Node* body = func->u.func.body;
+    size_t len = strlen(func->u.func.name) + 2;
+    int line = body->line;
+
+    Node* name = new_node(ctx, NODE_STRING, line);
+    char* text = arena_alloc(ctx->arena, len + 1);
+    snprintf(text, len + 1, "\"%s\"", func->u.func.name);
+    name->u.lit.text = text;
+    name->u.lit.len = len;
+    Node* probe = make_call_statement(ctx, "MIKA_INSTRUMENT", name, line);
+    probe->next = body->u.list.items;
+    body->u.list.items = probe;
+}
+
+static void lower_binary(LowerContext* ctx, Node* node) {
+    BinaryChain chain;
+
+    if (!binary_chain_init(&chain, node)) {
+        lower_error(ctx, node, "не хватает памяти для цепочки операторов");
+        return;
+    }
+    lower_node(ctx, (Node*)binary_chain_first(&chain));
+    for (size_t i = chain.count; i > 0; i--) {
+        lower_node(ctx, chain.links[i - 1]->u.binary.rhs);
+    }
+    binary_chain_free(&chain);
+}
+
+static void lower_node(LowerContext* ctx, Node* node) {
+    if (!node) {
+        return;
+    }
+
+    switch (node->kind) {
+        case NODE_INT: case NODE_FLOAT: case NODE_STRING: case NODE_CHAR:
+        case NODE_BOOL: case NODE_RAW:
+        case NODE_BREAK: case NODE_CONTINUE: case NODE_EMPTY:
+            break;
+        case NODE_IDENT:
+            if (ctx->region) {
+                capture_name(ctx, node);
+            }
+            break;
+        case NODE_DIRECTIVE:
+            process_includes(ctx, node);
+            break;
+        case NODE_UNARY: case NODE_POSTFIX:
+            lower_node(ctx, node->u.unary.operand);
+            if (node->u.unary.op == TOK_INC || node->u.unary.op == TOK_DEC) {
+                check_shared_write(ctx, node->u.unary.operand);
+            }
+            break;
+        case NODE_BINARY:
+            lower_binary(ctx, node);
+            break;
+        case NODE_ASSIGN:
+            if (lower_record_store(ctx, node)) {
+                break;
+            }
+            lower_node(ctx, node->u.binary.lhs);
+            lower_node(ctx, node->u.binary.rhs);
+            check_shared_write(ctx, node->u.binary.lhs);
+            if (node->u.binary.op == TOK_ASSIGN && value_kind(ctx, node->u.binary.lhs) == VALUE_STRING) {
+                convert_to_string(ctx, node->u.binary.rhs);
+                if (borrows_string(node->u.binary.rhs)) {
+                    lower_string_assign(ctx, node);
+                }
+            }
+            break;
+        case NODE_TERNARY: case NODE_IF:
+            lower_node(ctx, node->u.cond.cond);
+            lower_node(ctx, node->u.cond.then_branch);
+            lower_node(ctx, node->u.cond.else_branch);
+            break;
+        case NODE_CALL:
+            lower_call(ctx, node);
+            break;
+        case NODE_INDEX:
+            if (lower_record_index(ctx, node)) {
+                break;
+            }
+            lower_node(ctx, node->u.index.base);
+            lower_node(ctx, node->u.index.index);
+            if (value_kind(ctx, node->u.index.base) == VALUE_SLICE) {
+                node->u.index.base = field_of(ctx, node->u.index.base, "data");
+            }
+            break;
+        case NODE_MEMBER:
+            if (!lower_record_member(ctx, node)) {
+                lower_node(ctx, node->u.member.base);
+            }
+            break;
+        case NODE_CAST: case NODE_SIZEOF:
+            process_variables(ctx, &node->u.cast.type);
+            lower_node(ctx, node->u.cast.expr);
+            break;
+        case NODE_INIT_LIST:
+            lower_list(ctx, node->u.list.items);
+            break;
+        case NODE_BLOCK: {
+            int scope = ctx->name_count;
+            lower_list(ctx, node->u.list.items);
+            ctx->name_count = scope;
+            break;
+        }
+        case NODE_DECL: {
+            int inferred = node->u.decl.type.is_var;
+            int first = ctx->name_count;
+            process_variables(ctx, &node->u.decl.type);
+            lower_list(ctx, node->u.decl.vars);
+            if (inferred) {
+                unify_declaration(ctx, node, first);
+            }
+            break;
+        }
+        case NODE_VAR: case NODE_PARAM:
+            lower_variable(ctx, node);
+            break;
+        case NODE_WHILE: case NODE_DO: case NODE_FOR: case NODE_SWITCH: {
+            int scope = ctx->name_count;
+            lower_node(ctx, node->u.loop.init);
+            lower_node(ctx, node->u.loop.cond);
+            lower_node(ctx, node->u.loop.step);
+            lower_node(ctx, node->u.loop.body);
+            ctx->name_count = scope;
+            break;
+        }
+        case NODE_PARALLEL_FOR:
+            lower_parallel_for(ctx, node);
+            break;
+        case NODE_RECORD:
+            lower_record(ctx, node);
+            break;
+        case NODE_RETURN:
+            process_return(ctx, node);
+            lower_node(ctx, node->u.ret.value);
+            break;
+        case NODE_EXPR_STMT: case NODE_CASE:
+            lower_node(ctx, node->u.ret.value);
+            break;
+        case NODE_FUNCTION:
+            ctx->function = node;
+            process_function_declaration(ctx, node);
+            lower_list(ctx, node->u.func.params);
+            lower_node(ctx, node->u.func.body);
+            if (ctx->instrument && node->u.func.body) {
+                instrument_function(ctx, node);
+            }
+            break;
+    }
+}
+
+/* AST сбрасывается после каждого элемента: глобальные имена не должны
+   хранить указатели на свои узлы. */
+static void keep_global_names(LowerContext* ctx) {
+    for (int i = ctx->global_names; i < ctx->name_count; i++) {
+        ctx->names[i].decl = NULL;
+    }
+    ctx->global_names = ctx->name_count;
+}
+
+int lower_item(LowerContext* ctx, Node* item) {
+    int errors = ctx->errors;
+    ctx->name_count = ctx->global_names;
+    ctx->function = NULL;
+    ctx->hoisted = NULL;
+    ctx->region = NULL;
+    if (item->kind == NODE_FUNCTION) {
+        declare_name(ctx, item, item->u.func.name, type_value_kind(&item->u.func.ret),
+                     &item->u.func.ret, item->u.func.ret.pointers);
+        keep_global_names(ctx);
+    }
+    lower_node(ctx, item);
+    if (item->kind == NODE_DECL) {
+        keep_global_names(ctx);
+    }
+    return ctx->errors == errors ? 0 : -1;
+}
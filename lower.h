@@ -0,0 +1,81 @@
+#ifndef MIKA_LOWER_H
+#define MIKA_LOWER_H
+
+#include "arena.h"
+#include "ast.h"
+#include "callgraph.h"
+#include "deps.h"
+
+#define LOWER_NAME_SIZE 64
+#define LOWER_MAX_RECORDS 32
+#define LOWER_MAX_FIELDS 32
+
+typedef enum {
+    VALUE_OTHER,
+    VALUE_SLICE,
+    VALUE_STRING,
+    VALUE_BUILDER,
+    VALUE_RECORDS
+} ValueKind;
+
+/* Числовой тип значения для вывода типа var; порядок — как в обычных
+   арифметических преобразованиях C (LP64). */
+typedef enum {
+    RANK_NONE,
+    RANK_INT,
+    RANK_U32,
+    RANK_I64,
+    RANK_U64,
+    RANK_FLOAT,
+    RANK_DOUBLE
+} NumberRank;
+
+typedef struct {
+    char name[LOWER_NAME_SIZE];
+    ValueKind kind;
+    NumberRank number;
+    int depth;
+    int record;
+    int fixed;
+    Node* decl;
+} TypedName;
+
+typedef struct {
+    char name[LOWER_NAME_SIZE];
+    NumberRank number;
+} RecordField;
+
+/* Записи живут до конца файла, а AST сбрасывается после каждого
+   элемента, поэтому поля копируются сюда. */
+typedef struct {
+    char name[LOWER_NAME_SIZE];
+    char collection[LOWER_NAME_SIZE];
+    int aos;
+    RecordField fields[LOWER_MAX_FIELDS];
+    int field_count;
+} RecordType;
+
+struct ParallelRegion;
+
+typedef struct {
+    const char* filename;
+    Arena* arena;
+    DependencyList* deps;
+    int errors;
+    TypedName* names;
+    int name_count;
+    int name_capacity;
+    int global_names;
+    RecordType records[LOWER_MAX_RECORDS];
+    int record_count;
+    Node* function;
+    Node* hoisted;
+    int parallel_count;
+    int instrument;
+    const CallGraph* program;
+    struct ParallelRegion* region;
+} LowerContext;
+
+int lower_item(LowerContext* ctx, Node* item);
+
+#endif
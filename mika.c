@@ -0,0 +1,106 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+#include "parser.h"
+#include "source.h"
+#include "bytecode.h"
+#include "translate.h"
+#include "vm.h"
+
+void show_help(void);
+
+void show_help(void) {
+    printf("Mika Language Runner v%s\n", MIKA_VERSION);
+    printf("Запуск программ Mika без компилятора C\n\n");
+    printf("Использование: mika <команда> <файл.mk | ->\n\n");
+    printf("Команды:\n");
+    printf("  run <файл>   Выполнить программу в интерпретаторе байт-кода\n");
+    printf("  dump <файл>  Показать байт-код программы\n");
+    printf("  help         Показать эту справку\n\n");
+    printf("Программы с конструкциями C, которых нет в интерпретаторе (struct,\n");
+    printf("указатели, #include файлов C), собирайте через mikac.\n\n");
+    printf("Примеры:\n");
+    printf("  mika run hello.mk           # Выполнить сразу, без gcc\n");
+    printf("  mika run - < prog.mk        # Прочитать программу из stdin\n");
+    printf("  mika dump prog.mk           # Посмотреть байт-код\n");
+}
+
+/* Каждый верхнеуровневый элемент переводится в байт-код сразу после
+   разбора, и арена AST сбрасывается, как в трансляторе. */
+static int compile_program(const char* path, Program* program) {
+    SourceFile source;
+    Arena arena;
+    Parser parser;
+    Node* item;
+    int status = 0;
+    int failed = 0;
+    const char* name = strcmp(path, "-") == 0 ? "<stdin>" : path;
+
+    if (source_open(&source, path) != 0) {
+        return -1;
+    }
+    arena_init(&arena, ARENA_DEFAULT_CHUNK);
+    parser_init(&parser, &arena, source.data, source.len, name);
+    BytecodeCompiler* compiler = bytecode_compiler_new(program, name);
+    if (!compiler) {
+        status = -1;
+        goto done;
+    }
+
+    ArenaMark start = arena_mark(&arena);
+    while ((item = parse_item(&parser, &status)) != NULL) {
+        if (bytecode_compile_item(compiler, item) != 0) {
+            failed = 1;
+        }
+        arena_reset(&arena, start);
+    }
+    if (failed) {
+        status = -1;
+    }
+    if (status == 0 && bytecode_finish(compiler) != 0) {
+        status = -1;
+    }
+
+done:
+    bytecode_compiler_free(compiler);
+    arena_free(&arena);
+    source_close(&source);
+    return status;
+}
+
+int main(int argc, char* argv[]) {
+    Program program;
+
+    if (argc < 2 || strcmp(argv[1], "help") == 0 || strcmp(argv[1], "-h") == 0) {
+        show_help();
+        return argc < 2 ? 1 : 0;
+    }
+    int run = strcmp(argv[1], "run") == 0;
+    if (!run && strcmp(argv[1], "dump") != 0) {
+        fprintf(stderr, " Ошибка: Неизвестная команда '%s'\n\n", argv[1]);
+        show_help();
+        return 1;
+    }
+    if (argc < 3) {
+        fprintf(stderr, " Ошибка: Не указан входной файл\n\n");
+        show_help();
+        return 1;
+    }
+
+    program_init(&program);
+    if (compile_program(argv[2], &program) != 0) {
+        fprintf(stderr, "❌ Программа не запущена из-за ошибок\n");
+        program_free(&program);
+        return 1;
+    }
+    if (!run) {
+        program_dump(&program, stdout);
+        program_free(&program);
+        return 0;
+    }
+
+    /* exit, а не return: рантайм сбрасывает буфер print в atexit */
+    exit(vm_run(&program));
+}
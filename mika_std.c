@@ -1,44 +1,2122 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdarg.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include <signal.h>
+#include <stdint.h>
+#include <elf.h>
+#include <execinfo.h>
+#include <sys/auxv.h>
+#include <sys/time.h>
+
 #include "mika_std.h"
 
+#define MIKA_IO_BUFFER_SIZE (1 << 16)
+
+typedef struct {
+    char data[MIKA_IO_BUFFER_SIZE];
+    size_t pos;
+    size_t len;
+    int eof;
+    int at_line_start;
+    int interactive;
+} MikaInputBuffer;
+
+typedef struct {
+    char data[MIKA_IO_BUFFER_SIZE];
+    size_t used;
+    int initialized;
+    int interactive;
+} MikaOutputBuffer;
+
+static MikaInputBuffer mika_in = {.at_line_start = 1, .interactive = -1};
+static MikaOutputBuffer mika_out;
+
+/* Пока пул потоков не запущен, блокировки не берутся. */
+static int mika_threads_running;
+static pthread_mutex_t mika_runtime_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void mika_runtime_lock(void) {
+    if (mika_threads_running) {
+        pthread_mutex_lock(&mika_runtime_mutex);
+    }
+}
+
+static void mika_runtime_unlock(void) {
+    if (mika_threads_running) {
+        pthread_mutex_unlock(&mika_runtime_mutex);
+    }
+}
+
+/* ---------- Вывод ---------- */
+
+static void mika_write_all(const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t put = write(STDOUT_FILENO, data, len);
+        if (put < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        data += put;
+        len -= (size_t)put;
+    }
+}
+
+void flush_output(void) {
+    mika_write_all(mika_out.data, mika_out.used);
+    mika_out.used = 0;
+}
+
+static void mika_output_init(void) {
+    fflush(stdout);
+    mika_out.interactive = isatty(STDOUT_FILENO);
+    mika_out.initialized = 1;
+    atexit(flush_output);
+}
+
+static void mika_put_bytes(const char* data, size_t len) {
+    if (mika_out.used + len > MIKA_IO_BUFFER_SIZE) {
+        flush_output();
+        if (len > MIKA_IO_BUFFER_SIZE) {
+            mika_write_all(data, len);
+            return;
+        }
+    }
+    memcpy(mika_out.data + mika_out.used, data, len);
+    mika_out.used += len;
+}
+
+static size_t mika_format_unsigned(char* end, unsigned long long value, unsigned base) {
+    char* p = end;
+    do {
+        *--p = "0123456789abcdef"[value % base];
+        value /= base;
+    } while (value > 0);
+    return (size_t)(end - p);
+}
+
+static size_t mika_put_integer(long long value, int is_signed, unsigned base) {
+    char digits[24];
+    char* end = digits + sizeof(digits);
+    unsigned long long magnitude = (unsigned long long)value;
+
+    if (is_signed && value < 0) {
+        magnitude = 0ULL - magnitude;
+    }
+    size_t len = mika_format_unsigned(end, magnitude, base);
+    if (is_signed && value < 0) {
+        digits[sizeof(digits) - ++len] = '-';
+    }
+    mika_put_bytes(end - len, len);
+    return len;
+}
+
+static size_t mika_put_formatted(const char* spec, ...) {
+    char small[256];
+    va_list args, copy;
+
+    va_start(args, spec);
+    va_copy(copy, args);
+    int len = vsnprintf(small, sizeof(small), spec, copy);
+    va_end(copy);
+    if (len > 0 && (size_t)len < sizeof(small)) {
+        mika_put_bytes(small, (size_t)len);
+    } else if (len > 0) {
+        char* large = malloc((size_t)len + 1);
+        if (large) {
+            vsnprintf(large, (size_t)len + 1, spec, args);
+            mika_put_bytes(large, (size_t)len);
+            free(large);
+        }
+    }
+    va_end(args);
+    return len > 0 ? (size_t)len : 0;
+}
+
+static int mika_copy_number(const char** cursor, char* spec, size_t* used, va_list* args) {
+    const char* p = *cursor;
+    if (*p == '*') {
+        *used += (size_t)snprintf(spec + *used, 12, "%d", va_arg(*args, int));
+        *cursor = p + 1;
+        return 1;
+    }
+    while (*p >= '0' && *p <= '9') {
+        if (*used < 32) spec[(*used)++] = *p;
+        p++;
+    }
+    int found = p != *cursor;
+    *cursor = p;
+    return found;
+}
+
+/* Частые %d %i %u %x %c %s %S без флагов и ширины форматируются напрямую;
+   остальное — по одному преобразованию через snprintf. %S печатает MikaString. */
+static size_t mika_print_conversion(const char** cursor, va_list* args) {
+    const char* p = *cursor;
+    char spec[64];
+    size_t used = 1;
+    int plain = 1;
+
+    spec[0] = '%';
+    while (*p && strchr("-+ #0", *p)) {
+        if (used < 8) spec[used++] = *p;
+        p++;
+        plain = 0;
+    }
+    if (mika_copy_number(&p, spec, &used, args)) {
+        plain = 0;
+    }
+    if (*p == '.') {
+        spec[used++] = *p++;
+        mika_copy_number(&p, spec, &used, args);
+        plain = 0;
+    }
+
+    const char* length = p;
+    while (*p && strchr("hlLqjzt", *p)) p++;
+    size_t length_len = (size_t)(p - length) < 2 ? (size_t)(p - length) : 2;
+    int longs = length_len && length[0] == 'l' ? (int)length_len : (length_len && strchr("jzt", length[0]) ? 2 : 0);
+    char conversion = *p ? *p++ : '\0';
+    *cursor = p;
+
+    if (conversion == 'S') {
+        MikaString str = va_arg(*args, MikaString);
+        const char* data = mika_string_data(&str);
+        if (plain) {
+            mika_put_bytes(data, (size_t)str.length);
+            return (size_t)str.length;
+        }
+        memcpy(spec + used, ".*s", 4);
+        return mika_put_formatted(spec, str.length, data);
+    }
+    if (plain && (conversion == 'd' || conversion == 'i')) {
+        return mika_put_integer(longs >= 2 ? va_arg(*args, long long) :
+                           longs == 1 ? va_arg(*args, long) : va_arg(*args, int), 1, 10);
+    }
+    if (plain && (conversion == 'u' || conversion == 'x')) {
+        unsigned long long value = longs >= 2 ? va_arg(*args, unsigned long long) :
+                                   longs == 1 ? va_arg(*args, unsigned long) : va_arg(*args, unsigned int);
+        return mika_put_integer((long long)value, 0, conversion == 'x' ? 16 : 10);
+    }
+    if (plain && conversion == 'c') {
+        char c = (char)va_arg(*args, int);
+        mika_put_bytes(&c, 1);
+        return 1;
+    }
+    if (plain && conversion == 's') {
+        const char* str = va_arg(*args, const char*);
+        str = str ? str : "(null)";
+        size_t len = strlen(str);
+        mika_put_bytes(str, len);
+        return len;
+    }
+
+    memcpy(spec + used, length, length_len);
+    used += length_len;
+    spec[used++] = conversion;
+    spec[used] = '\0';
+
+    switch (conversion) {
+        case 'd': case 'i':
+            return longs >= 2 ? mika_put_formatted(spec, va_arg(*args, long long)) :
+                   longs == 1 ? mika_put_formatted(spec, va_arg(*args, long)) :
+                   mika_put_formatted(spec, va_arg(*args, int));
+        case 'u': case 'o': case 'x': case 'X':
+            return longs >= 2 ? mika_put_formatted(spec, va_arg(*args, unsigned long long)) :
+                   longs == 1 ? mika_put_formatted(spec, va_arg(*args, unsigned long)) :
+                   mika_put_formatted(spec, va_arg(*args, unsigned int));
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            return length_len && length[0] == 'L' ? mika_put_formatted(spec, va_arg(*args, long double)) :
+                   mika_put_formatted(spec, va_arg(*args, double));
+        case 'c':
+            return mika_put_formatted(spec, va_arg(*args, int));
+        case 's':
+            return mika_put_formatted(spec, va_arg(*args, const char*));
+        case 'p':
+            return mika_put_formatted(spec, va_arg(*args, void*));
+        case 'n':
+            (void)va_arg(*args, int*);
+            return 0;
+        default:
+            mika_put_bytes("%", 1);
+            return 1;
+    }
+}
+
+static int mika_print_formatted(const char* format, va_list* args) {
+    size_t total = 0;
+    const char* p = format;
+
+    while (*p) {
+        const char* percent = strchr(p, '%');
+        size_t literal = percent ? (size_t)(percent - p) : strlen(p);
+        mika_put_bytes(p, literal);
+        total += literal;
+        if (!percent) {
+            break;
+        }
+        p = percent + 1;
+        if (*p == '%') {
+            mika_put_bytes("%", 1);
+            total++;
+            p++;
+            continue;
+        }
+        total += mika_print_conversion(&p, args);
+    }
+    return (int)total;
+}
+
+int mika_print(const char* format, ...) {
+    va_list args;
+
+    mika_runtime_lock();
+    if (!mika_out.initialized) {
+        mika_output_init();
+    }
+    va_start(args, format);
+    int len = mika_print_formatted(format, &args);
+    va_end(args);
+
+    if (mika_out.interactive && memchr(format, '\n', strlen(format))) {
+        flush_output();
+    }
+    mika_runtime_unlock();
+    return len;
+}
+
+/* ---------- Ввод ---------- */
+
+static int mika_fill_input(void) {
+    ssize_t got;
+
+    if (mika_in.eof) {
+        return 0;
+    }
+    do {
+        got = read(STDIN_FILENO, mika_in.data, sizeof(mika_in.data));
+    } while (got < 0 && errno == EINTR);
+
+    if (got <= 0) {
+        mika_in.eof = 1;
+        return 0;
+    }
+    mika_in.pos = 0;
+    mika_in.len = (size_t)got;
+    return 1;
+}
+
+static inline int mika_peek_char(void) {
+    if (mika_in.pos == mika_in.len && !mika_fill_input()) {
+        return EOF;
+    }
+    return (unsigned char)mika_in.data[mika_in.pos];
+}
+
+static void mika_prompt(void) {
+    if (mika_in.interactive < 0) {
+        mika_in.interactive = isatty(STDIN_FILENO);
+    }
+    if (mika_in.interactive) {
+        if (!mika_out.initialized) {
+            mika_output_init();
+        }
+        mika_put_bytes(" ", 1);
+        flush_output();
+    }
+}
+
+static int mika_skip_spaces(void) {
+    int c;
+    while ((c = mika_peek_char()) == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f') {
+        if (c == '\n') {
+            mika_in.at_line_start = 1;
+        }
+        mika_in.pos++;
+    }
+    return c;
+}
+
 int input(void) {
-    int value;
-    printf(" ");
-    scanf("%d", &value);
-    return value;
+    unsigned int value = 0;
+    int negative = 0;
+
+    mika_prompt();
+    int c = mika_skip_spaces();
+    if (c == '-' || c == '+') {
+        negative = c == '-';
+        mika_in.pos++;
+        c = mika_peek_char();
+    }
+    while (c >= '0' && c <= '9') {
+        value = value * 10 + (unsigned int)(c - '0');
+        mika_in.pos++;
+        c = mika_peek_char();
+    }
+    mika_in.at_line_start = 0;
+    return negative ? (int)(0u - value) : (int)value;
+}
+
+int input_token(char* buffer, int size) {
+    int len = 0;
+    int c = mika_skip_spaces();
+
+    while (c != EOF && c != ' ' && c != '\n' && c != '\t' && c != '\r' && c != '\v' && c != '\f') {
+        if (len < size - 1) {
+            buffer[len++] = (char)c;
+        }
+        mika_in.pos++;
+        c = mika_peek_char();
+    }
+    if (size > 0) {
+        buffer[len] = '\0';
+    }
+    mika_in.at_line_start = 0;
+    return len;
 }
 
 void input_string(char* buffer, int size) {
-    printf("");
     int c;
-    while ((c = getchar()) != '\n' && c != EOF);
+    int len = 0;
+
+    if (!mika_in.at_line_start) {
+        while ((c = mika_peek_char()) != EOF) {
+            mika_in.pos++;
+            if (c == '\n') break;
+        }
+    }
 
-    fgets(buffer, size, stdin);
-    size_t len = strlen(buffer);
-    if (len > 0 && buffer[len-1] == '\n') {
-        buffer[len-1] = '\0';
+    while (len < size - 1 && (c = mika_peek_char()) != EOF) {
+        mika_in.pos++;
+        if (c == '\n') {
+            mika_in.at_line_start = 1;
+            buffer[len] = '\0';
+            return;
+        }
+        buffer[len++] = (char)c;
+    }
+    mika_in.at_line_start = 0;
+    if (size > 0) {
+        buffer[len] = '\0';
     }
 }
 
-int power(int base, int exponent) {
-    int result = 1;
-    for (int i = 0; i < exponent; i++) {
-        result *= base;
+/* ---------- Строки ---------- */
+
+#define MIKA_BUILDER_MIN_CAPACITY 32
+
+static void mika_out_of_memory(size_t size) {
+    flush_output();
+    fprintf(stderr, "Mika: не удалось выделить %zu байт\n", size);
+    exit(1);
+}
+
+MikaString mika_string_literal(const char* text, int length) {
+    MikaString string;
+    string.length = length;
+    string.capacity = -1;
+    string.u.ptr = text;
+    return string;
+}
+
+MikaString mika_string_from(const char* text) {
+    return mika_string_literal(text ? text : "", text ? (int)strlen(text) : 0);
+}
+
+static MikaString mika_small_string(const char* data, int length) {
+    MikaString string;
+    string.length = length;
+    string.capacity = 0;
+    memcpy(string.u.small, data, (size_t)length);
+    string.u.small[length] = '\0';
+    return string;
+}
+
+/* Короткая строка передаётся по значению, поэтому её подстрока копируется;
+   подстрока буфера в куче или литерала — это срез без копирования. */
+MikaString mika_string_substring(MikaString string, int from, int to) {
+    if (from < 0) from = 0;
+    if (to > string.length) to = string.length;
+    if (from > to) from = to;
+
+    if (string.capacity == 0) {
+        return mika_small_string(string.u.small + from, to - from);
+    }
+    return mika_string_literal(string.u.ptr + from, to - from);
+}
+
+int mika_string_compare(MikaString a, MikaString b) {
+    int common = a.length < b.length ? a.length : b.length;
+    int order = memcmp(mika_string_data(&a), mika_string_data(&b), (size_t)common);
+    if (order != 0) {
+        return order;
+    }
+    return (a.length > b.length) - (a.length < b.length);
+}
+
+MikaString mika_string_copy(MikaString source) {
+    MikaString string = {0, 0, {{0}}};
+    mika_string_assign(&string, source);
+    return string;
+}
+
+void mika_string_assign(MikaString* target, MikaString source) {
+    const char* data = mika_string_data(&source);
+    int length = source.length;
+
+    if (length <= MIKA_STRING_INLINE) {
+        char* owned = target->capacity > 0 ? (char*)target->u.ptr : NULL;
+        memmove(target->u.small, data, (size_t)length);
+        target->u.small[length] = '\0';
+        target->capacity = 0;
+        free(owned);
+    } else if (target->capacity > length) {
+        char* owned = (char*)target->u.ptr;
+        memmove(owned, data, (size_t)length);
+        owned[length] = '\0';
+    } else {
+        char* owned = malloc((size_t)length + 1);
+        if (!owned) {
+            mika_out_of_memory((size_t)length + 1);
+        }
+        memcpy(owned, data, (size_t)length);
+        owned[length] = '\0';
+        if (target->capacity > 0) {
+            free((char*)target->u.ptr);
+        }
+        target->u.ptr = owned;
+        target->capacity = length + 1;
     }
+    target->length = length;
+}
+
+void mika_string_write(char* buffer, MikaString source) {
+    memcpy(buffer, mika_string_data(&source), (size_t)source.length);
+    buffer[source.length] = '\0';
+}
+
+void mika_string_free(MikaString* string) {
+    if (string->capacity > 0) {
+        free((char*)string->u.ptr);
+    }
+    string->length = 0;
+    string->capacity = 0;
+    string->u.small[0] = '\0';
+}
+
+static void mika_builder_reserve(MikaStringBuilder* builder, size_t extra) {
+    size_t needed = (size_t)builder->length + extra + 1;
+    if (needed <= (size_t)builder->capacity) {
+        return;
+    }
+    size_t capacity = builder->capacity > 0 ? (size_t)builder->capacity : MIKA_BUILDER_MIN_CAPACITY;
+    while (capacity < needed) {
+        capacity *= 2;
+    }
+    char* data = realloc(builder->data, capacity);
+    if (!data) {
+        mika_out_of_memory(capacity);
+    }
+    builder->data = data;
+    builder->capacity = (int)capacity;
+}
+
+static void mika_builder_put(MikaStringBuilder* builder, const char* data, size_t length) {
+    mika_builder_reserve(builder, length);
+    memcpy(builder->data + builder->length, data, length);
+    builder->length += (int)length;
+    builder->data[builder->length] = '\0';
+}
+
+void mika_builder_append(MikaStringBuilder* builder, MikaString piece) {
+    mika_builder_put(builder, mika_string_data(&piece), (size_t)piece.length);
+}
+
+/* Буфер построителя переходит строке целиком; короткий результат
+   копируется внутрь строки, а буфер остаётся для следующей сборки. */
+MikaString mika_builder_finish(MikaStringBuilder* builder) {
+    if (builder->length <= MIKA_STRING_INLINE) {
+        MikaString string = mika_small_string(builder->data ? builder->data : "", builder->length);
+        builder->length = 0;
+        return string;
+    }
+
+    MikaString string;
+    string.length = builder->length;
+    string.capacity = builder->capacity;
+    string.u.ptr = builder->data;
+    builder->data = NULL;
+    builder->length = 0;
+    builder->capacity = 0;
+    return string;
+}
+
+void mika_builder_free(MikaStringBuilder* builder) {
+    free(builder->data);
+    builder->data = NULL;
+    builder->length = 0;
+    builder->capacity = 0;
+}
+
+MikaString mika_input_line(void) {
+    MikaStringBuilder line = {NULL, 0, 0};
+    int c;
+
+    if (!mika_in.at_line_start) {
+        while ((c = mika_peek_char()) != EOF) {
+            mika_in.pos++;
+            if (c == '\n') break;
+        }
+    }
+
+    mika_in.at_line_start = 0;
+    while ((c = mika_peek_char()) != EOF) {
+        const char* start = mika_in.data + mika_in.pos;
+        const char* newline = memchr(start, '\n', mika_in.len - mika_in.pos);
+        size_t chunk = newline ? (size_t)(newline - start) : mika_in.len - mika_in.pos;
+        mika_builder_put(&line, start, chunk);
+        mika_in.pos += chunk;
+        if (newline) {
+            mika_in.pos++;
+            mika_in.at_line_start = 1;
+            break;
+        }
+    }
+
+    MikaString string = mika_builder_finish(&line);
+    mika_builder_free(&line);
+    return string;
+}
+
+extern const char* mika_string_data(const MikaString* string);
+
+extern int mika_string_length(MikaString string);
+
+extern int power(int base, int exponent);
+
+extern int absolute(int number);
+
+/* ---------- Память ---------- */
+
+#define MIKA_ARRAY_MIN_CAPACITY 8
+#define MIKA_ARRAY_ARENA 1
+#define MIKA_ARENA_CHUNK (1 << 20)
+#define MIKA_ARENA_ALIGN 16
+#define MIKA_ARENA_MAX_DEPTH 256
+
+typedef struct MikaArenaChunk {
+    struct MikaArenaChunk* next;
+    size_t size;
+    size_t used;
+} MikaArenaChunk;
+
+typedef struct {
+    MikaArenaChunk* chunk;
+    size_t used;
+} MikaArenaMark;
+
+typedef struct {
+    int enabled;
+    MikaArenaChunk* head;
+    MikaArenaChunk* current;
+    size_t reserved;
+    size_t in_use;
+    MikaArenaMark marks[MIKA_ARENA_MAX_DEPTH];
+    int depth;
+} MikaRuntimeArena;
+
+typedef struct {
+    int checked;
+    int enabled;
+    unsigned long long allocations;
+    size_t heap_live;
+    size_t peak;
+    size_t arena_peak;
+} MikaAllocStats;
+
+static MikaRuntimeArena mika_arena;
+static MikaAllocStats mika_stats;
+
+static void mika_report_stats(void) {
+    flush_output();
+    fprintf(stderr, "Mika: выделений памяти: %llu, пик: %zu байт\n", mika_stats.allocations, mika_stats.peak);
+    if (mika_arena.enabled) {
+        fprintf(stderr, "Mika: арена: зарезервировано %zu байт, пик использования %zu байт (%.1f%%)\n",
+                mika_arena.reserved, mika_stats.arena_peak,
+                mika_arena.reserved ? 100.0 * (double)mika_stats.arena_peak / (double)mika_arena.reserved : 0.0);
+    }
+}
+
+static void mika_update_peak(void) {
+    if (mika_arena.in_use > mika_stats.arena_peak) {
+        mika_stats.arena_peak = mika_arena.in_use;
+    }
+    if (mika_stats.heap_live + mika_arena.in_use > mika_stats.peak) {
+        mika_stats.peak = mika_stats.heap_live + mika_arena.in_use;
+    }
+}
+
+static void mika_count_allocation(size_t old_size, size_t new_size, int heap) {
+    if (!mika_stats.checked) {
+        const char* env = getenv("MIKA_STATS");
+        mika_stats.checked = 1;
+        mika_stats.enabled = env && strcmp(env, "1") == 0;
+        if (mika_stats.enabled) {
+            atexit(mika_report_stats);
+        }
+    }
+    mika_stats.allocations++;
+    if (heap) {
+        mika_stats.heap_live += new_size - old_size;
+    }
+    mika_update_peak();
+}
+
+static void mika_release_arena(void) {
+    MikaArenaChunk* chunk = mika_arena.head;
+    while (chunk) {
+        MikaArenaChunk* next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    mika_arena.head = mika_arena.current = NULL;
+}
+
+void mika_arena_enable(void) {
+    if (!mika_arena.enabled) {
+        mika_arena.enabled = 1;
+        atexit(mika_release_arena);
+    }
+}
+
+static char* mika_chunk_data(MikaArenaChunk* chunk) {
+    return (char*)chunk + ((sizeof(MikaArenaChunk) + MIKA_ARENA_ALIGN - 1) & ~(size_t)(MIKA_ARENA_ALIGN - 1));
+}
+
+static MikaArenaChunk* mika_new_chunk(size_t min_size) {
+    size_t size = MIKA_ARENA_CHUNK;
+    while (size < min_size) {
+        size *= 2;
+    }
+    MikaArenaChunk* chunk = malloc(MIKA_ARENA_ALIGN + sizeof(MikaArenaChunk) + size);
+    if (!chunk) {
+        fprintf(stderr, "Mika: не удалось выделить блок арены (%zu байт)\n", size);
+        exit(1);
+    }
+    chunk->size = size;
+    chunk->used = 0;
+    mika_arena.reserved += size;
+    return chunk;
+}
+
+static void* mika_arena_alloc(size_t size) {
+    size = (size + MIKA_ARENA_ALIGN - 1) & ~(size_t)(MIKA_ARENA_ALIGN - 1);
+
+    MikaArenaChunk* chunk = mika_arena.current;
+    if (!chunk || chunk->used + size > chunk->size) {
+        MikaArenaChunk* next = chunk ? chunk->next : mika_arena.head;
+        if (next && next->size >= size) {
+            next->used = 0;
+        } else {
+            next = mika_new_chunk(size);
+            if (chunk) {
+                next->next = chunk->next;
+                chunk->next = next;
+            } else {
+                next->next = mika_arena.head;
+                mika_arena.head = next;
+            }
+        }
+        if (chunk) {
+            mika_arena.in_use += chunk->size - chunk->used;
+        }
+        chunk = mika_arena.current = next;
+    }
+
+    void* result = mika_chunk_data(chunk) + chunk->used;
+    chunk->used += size;
+    mika_arena.in_use += size;
     return result;
 }
 
-int absolute(int number) {
-    return (number < 0) ? -number : number;
+/* Последний блок текущего чанка можно расширить на месте, не копируя. */
+static int mika_arena_extend(void* block, size_t old_size, size_t new_size) {
+    MikaArenaChunk* chunk = mika_arena.current;
+    old_size = (old_size + MIKA_ARENA_ALIGN - 1) & ~(size_t)(MIKA_ARENA_ALIGN - 1);
+    new_size = (new_size + MIKA_ARENA_ALIGN - 1) & ~(size_t)(MIKA_ARENA_ALIGN - 1);
+    if (!chunk || (char*)block + old_size != mika_chunk_data(chunk) + chunk->used ||
+        chunk->used - old_size + new_size > chunk->size) {
+        return 0;
+    }
+    chunk->used += new_size - old_size;
+    mika_arena.in_use += new_size - old_size;
+    return 1;
+}
+
+void arena_enter(void) {
+    if (!mika_arena.enabled) {
+        return;
+    }
+    if (mika_arena.depth >= MIKA_ARENA_MAX_DEPTH) {
+        flush_output();
+        fprintf(stderr, "Mika: слишком глубокая вложенность arena_enter()\n");
+        exit(1);
+    }
+    mika_arena.marks[mika_arena.depth].chunk = mika_arena.current;
+    mika_arena.marks[mika_arena.depth].used = mika_arena.current ? mika_arena.current->used : 0;
+    mika_arena.depth++;
+}
+
+void arena_leave(void) {
+    if (!mika_arena.enabled || mika_arena.depth == 0) {
+        return;
+    }
+    MikaArenaMark mark = mika_arena.marks[--mika_arena.depth];
+    size_t in_use = 0;
+    if (mark.chunk) {
+        for (MikaArenaChunk* chunk = mika_arena.head; chunk != mark.chunk; chunk = chunk->next) {
+            in_use += chunk->size;
+        }
+        mark.chunk->used = mark.used;
+        in_use += mark.used;
+    }
+    mika_arena.in_use = in_use;
+    mika_arena.current = mark.chunk;
+}
+
+static size_t mika_array_bytes(int capacity) {
+    return sizeof(MikaArrayHeader) + (size_t)capacity * sizeof(int);
+}
+
+static int* mika_array_realloc(int* array, int capacity) {
+    MikaArrayHeader* header = array ? MIKA_ARRAY_HEADER(array) : NULL;
+    int length = header ? header->length : 0;
+    int old_capacity = header ? header->capacity : 0;
+    int heap = !(header ? header->flags & MIKA_ARRAY_ARENA : mika_arena.enabled);
+
+    mika_runtime_lock();
+    if (header && (header->flags & MIKA_ARRAY_ARENA)) {
+        if (!mika_arena_extend(header, mika_array_bytes(old_capacity), mika_array_bytes(capacity))) {
+            MikaArrayHeader* moved = mika_arena_alloc(mika_array_bytes(capacity));
+            memcpy(moved, header, mika_array_bytes(length));
+            header = moved;
+        }
+    } else if (!header && mika_arena.enabled) {
+        header = mika_arena_alloc(mika_array_bytes(capacity));
+        header->flags = MIKA_ARRAY_ARENA;
+    } else {
+        header = realloc(header, mika_array_bytes(capacity));
+        if (header && !array) {
+            header->flags = 0;
+        }
+    }
+    if (!header) {
+        fprintf(stderr, "Mika: не удалось выделить память под массив из %d элементов\n", capacity);
+        exit(1);
+    }
+    mika_count_allocation(mika_array_bytes(old_capacity), mika_array_bytes(capacity), heap);
+    mika_runtime_unlock();
+    header->length = length;
+    header->capacity = capacity;
+    return (int*)(header + 1);
 }
 
 int* array_create(int size) {
-    return (int*)malloc(size * sizeof(int));
+    if (size < 0) {
+        size = 0;
+    }
+    mika_runtime_lock();
+    MikaArrayHeader* header = mika_arena.enabled ? mika_arena_alloc(mika_array_bytes(size)) :
+                              malloc(mika_array_bytes(size));
+    if (header) {
+        mika_count_allocation(0, mika_array_bytes(size), !mika_arena.enabled);
+    }
+    mika_runtime_unlock();
+    if (!header) {
+        return NULL;
+    }
+    header->length = size;
+    header->capacity = size;
+    header->flags = mika_arena.enabled ? MIKA_ARRAY_ARENA : 0;
+    return (int*)(header + 1);
 }
 
 void array_free(int* array) {
-    free(array);
+    if (!array) {
+        return;
+    }
+    MikaArrayHeader* header = MIKA_ARRAY_HEADER(array);
+    if (header->flags & MIKA_ARRAY_ARENA) {
+        return;
+    }
+    mika_runtime_lock();
+    mika_stats.heap_live -= mika_array_bytes(header->capacity);
+    mika_runtime_unlock();
+    free(header);
 }
 
 int array_size(int* array, int size) {
-    return size;
+    return array ? array_length(array) : size;
+}
+
+void array_reserve(int** array, int capacity) {
+    if (capacity > (*array ? MIKA_ARRAY_HEADER(*array)->capacity : -1)) {
+        *array = mika_array_realloc(*array, capacity);
+    }
+}
+
+void array_grow(int** array) {
+    int capacity = *array ? MIKA_ARRAY_HEADER(*array)->capacity : 0;
+    *array = mika_array_realloc(*array, capacity < MIKA_ARRAY_MIN_CAPACITY ? MIKA_ARRAY_MIN_CAPACITY : capacity * 2);
+}
+
+void array_pop_empty(void) {
+    flush_output();
+    fprintf(stderr, "Mika: pop() из пустого массива\n");
+    exit(1);
+}
+
+static MikaSlice mika_make_slice(int* data, int length, int from, int to) {
+    MikaSlice slice;
+    if (from < 0) from = 0;
+    if (to > length) to = length;
+    if (from > to) from = to;
+    slice.data = data + from;
+    slice.length = to - from;
+    return slice;
+}
+
+MikaSlice array_slice(int* array, int from, int to) {
+    return mika_make_slice(array, array_length(array), from, to);
+}
+
+MikaSlice slice_range(MikaSlice slice, int from, int to) {
+    return mika_make_slice(slice.data, slice.length, from, to);
+}
+
+/* ---------- Коллекции записей ---------- */
+
+#define MIKA_RECORDS_ALIGN 64
+
+/* Все поля коллекции лежат в одном блоке, каждое с начала кэш-линии:
+   проход по одному полю читает только его строки кэша. Первая линия
+   блока хранит его размер для статистики; fields[0] указывает сразу за
+   ней, по нему блок и освобождается. */
+int mika_records_alloc(int length, const size_t* sizes, int count, void** fields) {
+    size_t offsets[MIKA_RECORDS_MAX_FIELDS];
+    size_t total = MIKA_RECORDS_ALIGN;
+    void* block;
+
+    for (int i = 0; i < count; i++) {
+        fields[i] = NULL;
+    }
+    if (length <= 0 || count <= 0 || count > MIKA_RECORDS_MAX_FIELDS) {
+        return 0;
+    }
+    for (int i = 0; i < count; i++) {
+        if (sizes[i] > SIZE_MAX / 4 / (size_t)length || total > SIZE_MAX / 4) {
+            mika_out_of_memory(SIZE_MAX);
+        }
+        offsets[i] = total;
+        total += (sizes[i] * (size_t)length + MIKA_RECORDS_ALIGN - 1) & ~(size_t)(MIKA_RECORDS_ALIGN - 1);
+    }
+    if (posix_memalign(&block, MIKA_RECORDS_ALIGN, total) != 0) {
+        mika_out_of_memory(total);
+    }
+    memset(block, 0, total);
+    *(size_t*)block = total;
+    mika_runtime_lock();
+    mika_count_allocation(0, total, 1);
+    mika_runtime_unlock();
+
+    for (int i = 0; i < count; i++) {
+        fields[i] = (char*)block + offsets[i];
+    }
+    return length;
+}
+
+void mika_records_free(void* first) {
+    if (!first) {
+        return;
+    }
+    char* block = (char*)first - MIKA_RECORDS_ALIGN;
+    mika_runtime_lock();
+    mika_stats.heap_live -= *(size_t*)block;
+    mika_runtime_unlock();
+    free(block);
+}
+
+/* ---------- Векторные операции ---------- */
+
+/* Ядра пишутся один раз на векторных расширениях GCC и собираются под
+   каждый набор инструкций через target; нужный вариант выбирается при
+   запуске по cpuid. Арифметика беззнаковая: переполнение int даёт тот же
+   результат, что и обычный цикл. */
+
+typedef struct {
+    const char* name;
+    unsigned (*sum)(const int* data, int count);
+    int (*min)(const int* data, int count);
+    int (*max)(const int* data, int count);
+    void (*fill)(int* data, int count, int value);
+    unsigned (*dot)(const int* a, const int* b, int count);
+    void (*add)(int* target, const int* a, const int* b, int count);
+    void (*sub)(int* target, const int* a, const int* b, int count);
+    void (*mul)(int* target, const int* a, const int* b, int count);
+} MikaKernels;
+
+static unsigned mika_scalar_sum(const int* data, int count) {
+    unsigned sum = 0;
+    for (int i = 0; i < count; i++) sum += (unsigned)data[i];
+    return sum;
 }
+
+static int mika_scalar_min(const int* data, int count) {
+    int min = data[0];
+    for (int i = 1; i < count; i++) min = data[i] < min ? data[i] : min;
+    return min;
+}
+
+static int mika_scalar_max(const int* data, int count) {
+    int max = data[0];
+    for (int i = 1; i < count; i++) max = data[i] > max ? data[i] : max;
+    return max;
+}
+
+static void mika_scalar_fill(int* data, int count, int value) {
+    for (int i = 0; i < count; i++) data[i] = value;
+}
+
+static unsigned mika_scalar_dot(const int* a, const int* b, int count) {
+    unsigned sum = 0;
+    for (int i = 0; i < count; i++) sum += (unsigned)a[i] * (unsigned)b[i];
+    return sum;
+}
+
+static void mika_scalar_add(int* target, const int* a, const int* b, int count) {
+    for (int i = 0; i < count; i++) target[i] = (int)((unsigned)a[i] + (unsigned)b[i]);
+}
+
+static void mika_scalar_sub(int* target, const int* a, const int* b, int count) {
+    for (int i = 0; i < count; i++) target[i] = (int)((unsigned)a[i] - (unsigned)b[i]);
+}
+
+static void mika_scalar_mul(int* target, const int* a, const int* b, int count) {
+    for (int i = 0; i < count; i++) target[i] = (int)((unsigned)a[i] * (unsigned)b[i]);
+}
+
+static const MikaKernels mika_scalar_kernels = {
+    "scalar", mika_scalar_sum, mika_scalar_min, mika_scalar_max, mika_scalar_fill,
+    mika_scalar_dot, mika_scalar_add, mika_scalar_sub, mika_scalar_mul
+};
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MIKA_SIMD_DISPATCH 1
+
+/* Хвост короче вектора дорабатывает скалярное ядро. */
+#define MIKA_VECTOR_KERNELS(isa, feature, lanes) \
+    typedef unsigned mika_##isa##_vector __attribute__((vector_size((lanes) * 4))); \
+    typedef int mika_##isa##_signed __attribute__((vector_size((lanes) * 4))); \
+    \
+    __attribute__((target(feature))) static mika_##isa##_vector mika_##isa##_load(const int* data) { \
+        mika_##isa##_vector v; \
+        memcpy(&v, data, sizeof(v)); \
+        return v; \
+    } \
+    \
+    __attribute__((target(feature))) static unsigned mika_##isa##_reduce(mika_##isa##_vector v) { \
+        unsigned lane[lanes], sum = 0; \
+        memcpy(lane, &v, sizeof(v)); \
+        for (int i = 0; i < (lanes); i++) sum += lane[i]; \
+        return sum; \
+    } \
+    \
+    __attribute__((target(feature))) static unsigned mika_##isa##_sum(const int* data, int count) { \
+        mika_##isa##_vector acc0 = {0}, acc1 = {0}; \
+        int i = 0; \
+        for (; i + 2 * (lanes) <= count; i += 2 * (lanes)) { \
+            acc0 += mika_##isa##_load(data + i); \
+            acc1 += mika_##isa##_load(data + i + (lanes)); \
+        } \
+        for (; i + (lanes) <= count; i += (lanes)) acc0 += mika_##isa##_load(data + i); \
+        return mika_##isa##_reduce(acc0 + acc1) + mika_scalar_sum(data + i, count - i); \
+    } \
+    \
+    MIKA_VECTOR_EXTREME(isa, feature, lanes, min, <) \
+    MIKA_VECTOR_EXTREME(isa, feature, lanes, max, >) \
+    \
+    __attribute__((target(feature))) static void mika_##isa##_fill(int* data, int count, int value) { \
+        mika_##isa##_vector v = {0}; \
+        v += (unsigned)value; \
+        int i = 0; \
+        for (; i + (lanes) <= count; i += (lanes)) memcpy(data + i, &v, sizeof(v)); \
+        mika_scalar_fill(data + i, count - i, value); \
+    } \
+    \
+    __attribute__((target(feature))) static unsigned mika_##isa##_dot(const int* a, const int* b, int count) { \
+        mika_##isa##_vector acc = {0}; \
+        int i = 0; \
+        for (; i + (lanes) <= count; i += (lanes)) acc += mika_##isa##_load(a + i) * mika_##isa##_load(b + i); \
+        return mika_##isa##_reduce(acc) + mika_scalar_dot(a + i, b + i, count - i); \
+    } \
+    \
+    MIKA_VECTOR_BINARY(isa, feature, lanes, add, +) \
+    MIKA_VECTOR_BINARY(isa, feature, lanes, sub, -) \
+    MIKA_VECTOR_BINARY(isa, feature, lanes, mul, *) \
+    \
+    static const MikaKernels mika_##isa##_kernels = { \
+        #isa, mika_##isa##_sum, mika_##isa##_min, mika_##isa##_max, mika_##isa##_fill, \
+        mika_##isa##_dot, mika_##isa##_add, mika_##isa##_sub, mika_##isa##_mul \
+    };
+
+#define MIKA_VECTOR_EXTREME(isa, feature, lanes, name, op) \
+    __attribute__((target(feature))) static int mika_##isa##_##name(const int* data, int count) { \
+        if (count < (lanes)) { \
+            return mika_scalar_##name(data, count); \
+        } \
+        mika_##isa##_signed best = (mika_##isa##_signed)mika_##isa##_load(data); \
+        int i = (lanes); \
+        for (; i + (lanes) <= count; i += (lanes)) { \
+            mika_##isa##_signed v = (mika_##isa##_signed)mika_##isa##_load(data + i); \
+            mika_##isa##_signed take = v op best; \
+            best = (v & take) | (best & ~take); \
+        } \
+        int lane[lanes]; \
+        memcpy(lane, &best, sizeof(best)); \
+        int result = mika_scalar_##name(lane, (lanes)); \
+        for (; i < count; i++) { \
+            if (data[i] op result) result = data[i]; \
+        } \
+        return result; \
+    }
+
+#define MIKA_VECTOR_BINARY(isa, feature, lanes, name, op) \
+    __attribute__((target(feature))) static void mika_##isa##_##name(int* target, const int* a, const int* b, \
+                                                                    int count) { \
+        int i = 0; \
+        for (; i + (lanes) <= count; i += (lanes)) { \
+            mika_##isa##_vector v = mika_##isa##_load(a + i) op mika_##isa##_load(b + i); \
+            memcpy(target + i, &v, sizeof(v)); \
+        } \
+        mika_scalar_##name(target + i, a + i, b + i, count - i); \
+    }
+
+MIKA_VECTOR_KERNELS(sse2, "sse2", 4)
+MIKA_VECTOR_KERNELS(avx2, "avx2", 8)
+MIKA_VECTOR_KERNELS(avx512, "avx512f", 16)
+#endif
+
+static const MikaKernels* mika_kernels = &mika_scalar_kernels;
+
+/* MIKA_SIMD=scalar|sse2|avx2|avx512 ограничивает выбор сверху. */
+__attribute__((constructor)) static void mika_select_kernels(void) {
+#ifdef MIKA_SIMD_DISPATCH
+    const MikaKernels* available[] = {&mika_avx512_kernels, &mika_avx2_kernels, &mika_sse2_kernels,
+                                      &mika_scalar_kernels};
+    const char* features[] = {"avx512f", "avx2", "sse2", NULL};
+    const char* limit = getenv("MIKA_SIMD");
+    int allowed = limit == NULL;
+
+    __builtin_cpu_init();
+    for (int i = 0; i < 4; i++) {
+        allowed = allowed || strcmp(limit, available[i]->name) == 0;
+        if (!allowed) {
+            continue;
+        }
+        if (!features[i] ||
+            (i == 0 && __builtin_cpu_supports("avx512f")) ||
+            (i == 1 && __builtin_cpu_supports("avx2")) ||
+            (i == 2 && __builtin_cpu_supports("sse2"))) {
+            mika_kernels = available[i];
+            return;
+        }
+    }
+#endif
+}
+
+const char* array_simd_level(void) {
+    return mika_kernels->name;
+}
+
+static void mika_array_empty(const char* operation) {
+    flush_output();
+    fprintf(stderr, "Mika: %s() от пустого массива\n", operation);
+    exit(1);
+}
+
+static int mika_common_length(MikaSlice a, MikaSlice b) {
+    return a.length < b.length ? a.length : b.length;
+}
+
+int array_sum(MikaSlice array) {
+    return (int)mika_kernels->sum(array.data, array.length);
+}
+
+int array_min(MikaSlice array) {
+    if (array.length == 0) {
+        mika_array_empty("array_min");
+    }
+    return mika_kernels->min(array.data, array.length);
+}
+
+int array_max(MikaSlice array) {
+    if (array.length == 0) {
+        mika_array_empty("array_max");
+    }
+    return mika_kernels->max(array.data, array.length);
+}
+
+void array_fill(MikaSlice array, int value) {
+    mika_kernels->fill(array.data, array.length, value);
+}
+
+void array_copy(MikaSlice target, MikaSlice source) {
+    int count = mika_common_length(target, source);
+    if (count > 0) {
+        memmove(target.data, source.data, (size_t)count * sizeof(int));
+    }
+}
+
+int array_dot(MikaSlice a, MikaSlice b) {
+    return (int)mika_kernels->dot(a.data, b.data, mika_common_length(a, b));
+}
+
+static int mika_elementwise_length(MikaSlice target, MikaSlice a, MikaSlice b) {
+    int count = mika_common_length(a, b);
+    return target.length < count ? target.length : count;
+}
+
+void array_add(MikaSlice target, MikaSlice a, MikaSlice b) {
+    mika_kernels->add(target.data, a.data, b.data, mika_elementwise_length(target, a, b));
+}
+
+void array_sub(MikaSlice target, MikaSlice a, MikaSlice b) {
+    mika_kernels->sub(target.data, a.data, b.data, mika_elementwise_length(target, a, b));
+}
+
+void array_mul(MikaSlice target, MikaSlice a, MikaSlice b) {
+    mika_kernels->mul(target.data, a.data, b.data, mika_elementwise_length(target, a, b));
+}
+
+/* ---------- Потоки ---------- */
+
+#define MIKA_MAX_THREADS 256
+#define MIKA_CHUNKS_PER_THREAD 8
+
+/* Отрезок итераций потока упакован в одно слово: начало в младших 32 битах,
+   конец в старших. Владелец отрезает порции с начала, свободный поток
+   забирает себе вторую половину чужого отрезка. */
+typedef struct {
+    unsigned long long range;
+    char padding[56];
+} MikaWorkQueue;
+
+static struct {
+    pthread_once_t once;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t done;
+    int threads;
+    unsigned generation;
+    int active;
+    MikaParallelBody body;
+    void** shared;
+    int from;
+    unsigned chunk;
+    MikaWorkQueue queues[MIKA_MAX_THREADS];
+} mika_pool = {
+    .once = PTHREAD_ONCE_INIT,
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .wake = PTHREAD_COND_INITIALIZER,
+    .done = PTHREAD_COND_INITIALIZER
+};
+
+static pthread_mutex_t mika_reduction_mutex = PTHREAD_MUTEX_INITIALIZER;
+static __thread int mika_in_parallel;
+
+static unsigned long long mika_pack_range(unsigned begin, unsigned end) {
+    return (unsigned long long)end << 32 | begin;
+}
+
+static int mika_take_own(MikaWorkQueue* queue, unsigned chunk, unsigned* begin, unsigned* end) {
+    unsigned long long range = __atomic_load_n(&queue->range, __ATOMIC_ACQUIRE);
+    for (;;) {
+        unsigned first = (unsigned)range, last = (unsigned)(range >> 32);
+        if (first >= last) {
+            return 0;
+        }
+        unsigned next = last - first > chunk ? first + chunk : last;
+        if (__atomic_compare_exchange_n(&queue->range, &range, mika_pack_range(next, last), 0,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            *begin = first;
+            *end = next;
+            return 1;
+        }
+    }
+}
+
+static int mika_steal(int self) {
+    for (int i = 1; i < mika_pool.threads; i++) {
+        MikaWorkQueue* victim = &mika_pool.queues[(self + i) % mika_pool.threads];
+        unsigned long long range = __atomic_load_n(&victim->range, __ATOMIC_ACQUIRE);
+        for (;;) {
+            unsigned first = (unsigned)range, last = (unsigned)(range >> 32);
+            if (first >= last) {
+                break;
+            }
+            unsigned middle = first + (last - first) / 2;
+            if (__atomic_compare_exchange_n(&victim->range, &range, mika_pack_range(first, middle), 0,
+                                            __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                __atomic_store_n(&mika_pool.queues[self].range, mika_pack_range(middle, last), __ATOMIC_RELEASE);
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+static void mika_run_share(int self) {
+    unsigned begin, end;
+    do {
+        while (mika_take_own(&mika_pool.queues[self], mika_pool.chunk, &begin, &end)) {
+            mika_pool.body(mika_pool.shared, mika_pool.from + (int)begin, mika_pool.from + (int)end);
+        }
+    } while (mika_steal(self));
+}
+
+static void* mika_worker_main(void* arg) {
+    int self = (int)(size_t)arg;
+    unsigned seen = 0;
+
+    mika_in_parallel = 1;
+    for (;;) {
+        pthread_mutex_lock(&mika_pool.lock);
+        while (mika_pool.generation == seen) {
+            pthread_cond_wait(&mika_pool.wake, &mika_pool.lock);
+        }
+        seen = mika_pool.generation;
+        pthread_mutex_unlock(&mika_pool.lock);
+
+        mika_run_share(self);
+
+        pthread_mutex_lock(&mika_pool.lock);
+        if (--mika_pool.active == 0) {
+            pthread_cond_signal(&mika_pool.done);
+        }
+        pthread_mutex_unlock(&mika_pool.lock);
+    }
+    return NULL;
+}
+
+/* Пул запускается при первом parallel for; MIKA_THREADS задаёт число
+   потоков вместе с основным. */
+static void mika_start_pool(void) {
+    const char* setting = getenv("MIKA_THREADS");
+    long threads = setting ? strtol(setting, NULL, 10) : sysconf(_SC_NPROCESSORS_ONLN);
+    pthread_attr_t attr;
+
+    if (threads < 1) threads = 1;
+    if (threads > MIKA_MAX_THREADS) threads = MIKA_MAX_THREADS;
+    mika_pool.threads = 1;
+    if (threads == 1) {
+        return;
+    }
+    mika_threads_running = 1;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    for (long i = 1; i < threads; i++) {
+        pthread_t thread;
+        if (pthread_create(&thread, &attr, mika_worker_main, (void*)(size_t)i) != 0) {
+            break;
+        }
+        mika_pool.threads++;
+    }
+    pthread_attr_destroy(&attr);
+}
+
+int mika_thread_count(void) {
+    pthread_once(&mika_pool.once, mika_start_pool);
+    return mika_pool.threads;
+}
+
+void mika_parallel_for(int from, int to, MikaParallelBody body, void** shared) {
+    if (to <= from) {
+        return;
+    }
+    if (mika_in_parallel || to - from == 1 || mika_thread_count() == 1) {
+        body(shared, from, to);
+        return;
+    }
+
+    unsigned count = (unsigned)((long long)to - from);
+    unsigned chunk = count / ((unsigned)mika_pool.threads * MIKA_CHUNKS_PER_THREAD);
+    mika_pool.body = body;
+    mika_pool.shared = shared;
+    mika_pool.from = from;
+    mika_pool.chunk = chunk > 0 ? chunk : 1;
+    for (int t = 0; t < mika_pool.threads; t++) {
+        unsigned first = (unsigned)((unsigned long long)count * t / mika_pool.threads);
+        unsigned last = (unsigned)((unsigned long long)count * (t + 1) / mika_pool.threads);
+        mika_pool.queues[t].range = mika_pack_range(first, last);
+    }
+
+    pthread_mutex_lock(&mika_pool.lock);
+    mika_pool.active = mika_pool.threads - 1;
+    mika_pool.generation++;
+    pthread_cond_broadcast(&mika_pool.wake);
+    pthread_mutex_unlock(&mika_pool.lock);
+
+    mika_in_parallel = 1;
+    mika_run_share(0);
+    mika_in_parallel = 0;
+
+    pthread_mutex_lock(&mika_pool.lock);
+    while (mika_pool.active > 0) {
+        pthread_cond_wait(&mika_pool.done, &mika_pool.lock);
+    }
+    pthread_mutex_unlock(&mika_pool.lock);
+}
+
+void mika_parallel_lock(void) {
+    pthread_mutex_lock(&mika_reduction_mutex);
+}
+
+void mika_parallel_unlock(void) {
+    pthread_mutex_unlock(&mika_reduction_mutex);
+}
+
+/* ---------- Профилирование ---------- */
+
+static MikaFunctionStats* mika_instrumented;
+static __thread MikaCall* mika_current_call;
+
+static unsigned long long mika_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ull + (unsigned long long)ts.tv_nsec;
+}
+
+static int mika_compare_self_time(const void* a, const void* b) {
+    const MikaFunctionStats* x = a;
+    const MikaFunctionStats* y = b;
+    if (x->self_ns != y->self_ns) {
+        return x->self_ns < y->self_ns ? 1 : -1;
+    }
+    return strcmp(x->name, y->name);
+}
+
+static void mika_report_functions(void) {
+    int count = 0;
+    unsigned long long program_ns = 0;
+    MikaFunctionStats* table = NULL;
+
+    flush_output();
+    mika_runtime_lock();
+    for (MikaFunctionStats* f = mika_instrumented; f; f = f->next) {
+        count++;
+    }
+    table = calloc((size_t)count, sizeof(MikaFunctionStats));
+    if (!table) {
+        mika_runtime_unlock();
+        return;
+    }
+    /* Складываем счётчики одной функции из разных потоков */
+    count = 0;
+    for (MikaFunctionStats* f = mika_instrumented; f; f = f->next) {
+        int i = 0;
+        while (i < count && (table[i].line != f->line || strcmp(table[i].name, f->name) != 0 ||
+                             strcmp(table[i].file, f->file) != 0)) {
+            i++;
+        }
+        if (i == count) {
+            table[count++] = *f;
+            table[i].calls = table[i].self_ns = table[i].total_ns = 0;
+        }
+        table[i].calls += f->calls;
+        table[i].self_ns += f->self_ns;
+        table[i].total_ns += f->total_ns;
+        program_ns += f->self_ns;
+    }
+    mika_runtime_unlock();
+
+    qsort(table, (size_t)count, sizeof(MikaFunctionStats), mika_compare_self_time);
+    fprintf(stderr, "\nMika: профиль функций (по собственному времени)\n");
+    /* Ширина колонок задана вручную: printf считает байты, а не буквы */
+    fprintf(stderr, "%s\n", "функция                       вызовов     своё, мс       %    всего, мс  место");
+    for (int i = 0; i < count; i++) {
+        fprintf(stderr, "%-24s %12llu %12.3f %6.1f%% %12.3f  %s:%d\n", table[i].name, table[i].calls,
+                (double)table[i].self_ns / 1e6,
+                program_ns ? 100.0 * (double)table[i].self_ns / (double)program_ns : 0.0,
+                (double)table[i].total_ns / 1e6, table[i].file, table[i].line);
+    }
+    free(table);
+}
+
+static void mika_register_function(MikaFunctionStats* function) {
+    mika_runtime_lock();
+    if (!mika_instrumented) {
+        atexit(mika_report_functions);
+    }
+    function->next = mika_instrumented;
+    mika_instrumented = function;
+    function->registered = 1;
+    mika_runtime_unlock();
+}
+
+void mika_instrument_enter(MikaCall* call, MikaFunctionStats* function) {
+    if (!function->registered) {
+        mika_register_function(function);
+    }
+    function->calls++;
+    function->depth++;
+    call->function = function;
+    call->children = 0;
+    call->parent = mika_current_call;
+    mika_current_call = call;
+    call->start = mika_now_ns();
+}
+
+/* Полное время считается только у внешнего вызова, чтобы рекурсия
+   не учитывалась дважды. */
+void mika_instrument_leave(MikaCall* call) {
+    unsigned long long elapsed = mika_now_ns() - call->start;
+    MikaFunctionStats* function = call->function;
+
+    function->self_ns += elapsed - call->children;
+    if (--function->depth == 0) {
+        function->total_ns += elapsed;
+    }
+    if (call->parent) {
+        call->parent->children += elapsed;
+    }
+    mika_current_call = call->parent;
+}
+
+/* ---------- Профилировщик ---------- */
+
+/* В сборке --fast-start профилировщика нет: его конструктор запускается
+   при каждом старте и тянет в статический файл backtrace и чтение ELF. */
+#ifndef MIKA_FAST_START
+
+/* MIKA_PROFILE=файл включает выборку стеков по SIGPROF. Стеки копятся
+   в заранее выделенной таблице, а при выходе переводятся в имена функций
+   и строки .mk (по #line, если программа собрана с -g) и записываются
+   в свёрнутом формате flamegraph: "main;solve;fib (fib.mk:6) 42". */
+
+#define MIKA_PROFILE_DEPTH 64
+#define MIKA_PROFILE_SLOTS (1 << 16)
+#define MIKA_PROFILE_POOL (1 << 20)
+#define MIKA_PROFILE_HZ 1000
+/* backtrace() из обработчика начинается с самого обработчика и трамплина сигнала */
+#define MIKA_PROFILE_SKIP 2
+
+typedef struct {
+    unsigned long long count;
+    unsigned hash;
+    unsigned depth;
+    size_t offset;
+} MikaStackSlot;
+
+static struct {
+    const char* path;
+    MikaStackSlot* slots;
+    void** pool;
+    size_t pool_used;
+    int busy;
+    unsigned long long samples;
+    unsigned long long dropped;
+} mika_profiler;
+
+typedef struct {
+    uintptr_t start;
+    uintptr_t size;
+    const char* name;
+} MikaFunctionSymbol;
+
+typedef struct {
+    uintptr_t address;
+    const char* file;
+    int line;
+} MikaLineRow;
+
+typedef struct {
+    unsigned char* image;
+    uintptr_t bias;
+    MikaFunctionSymbol* symbols;
+    size_t symbol_count;
+    MikaLineRow* rows;
+    size_t row_count;
+    size_t row_capacity;
+} MikaSymbolizer;
+
+static void mika_record_stack(void** frames, int depth) {
+    unsigned hash = 2166136261u;
+    for (int i = 0; i < depth; i++) {
+        hash = (hash ^ (unsigned)((uintptr_t)frames[i] >> 4)) * 16777619u;
+    }
+    for (unsigned probe = 0; probe < MIKA_PROFILE_SLOTS; probe++) {
+        MikaStackSlot* slot = &mika_profiler.slots[(hash + probe) & (MIKA_PROFILE_SLOTS - 1)];
+        if (slot->count == 0) {
+            if (mika_profiler.pool_used + (size_t)depth > MIKA_PROFILE_POOL) {
+                break;
+            }
+            slot->hash = hash;
+            slot->depth = (unsigned)depth;
+            slot->offset = mika_profiler.pool_used;
+            memcpy(mika_profiler.pool + slot->offset, frames, (size_t)depth * sizeof(void*));
+            mika_profiler.pool_used += (size_t)depth;
+            slot->count = 1;
+            return;
+        }
+        if (slot->hash == hash && slot->depth == (unsigned)depth &&
+            memcmp(mika_profiler.pool + slot->offset, frames, (size_t)depth * sizeof(void*)) == 0) {
+            slot->count++;
+            return;
+        }
+    }
+    mika_profiler.dropped++;
+}
+
+static void mika_profile_signal(int signo) {
+    void* frames[MIKA_PROFILE_DEPTH + MIKA_PROFILE_SKIP];
+    int saved_errno = errno;
+
+    (void)signo;
+    /* Сигнал может прийти в два потока сразу: второй сэмпл теряется */
+    if (__atomic_exchange_n(&mika_profiler.busy, 1, __ATOMIC_ACQUIRE)) {
+        __atomic_add_fetch(&mika_profiler.dropped, 1, __ATOMIC_RELAXED);
+        errno = saved_errno;
+        return;
+    }
+    int depth = backtrace(frames, MIKA_PROFILE_DEPTH + MIKA_PROFILE_SKIP) - MIKA_PROFILE_SKIP;
+    if (depth > 0) {
+        mika_profiler.samples++;
+        mika_record_stack(frames + MIKA_PROFILE_SKIP, depth);
+    }
+    __atomic_store_n(&mika_profiler.busy, 0, __ATOMIC_RELEASE);
+    errno = saved_errno;
+}
+
+static unsigned long long mika_read_uleb(const unsigned char** p, const unsigned char* end) {
+    unsigned long long value = 0;
+    int shift = 0;
+    while (*p < end) {
+        unsigned char byte = *(*p)++;
+        if (shift < 64) {
+            value |= (unsigned long long)(byte & 0x7f) << shift;
+        }
+        shift += 7;
+        if (!(byte & 0x80)) {
+            break;
+        }
+    }
+    return value;
+}
+
+static long long mika_read_sleb(const unsigned char** p, const unsigned char* end) {
+    long long value = 0;
+    int shift = 0;
+    unsigned char byte = 0;
+    while (*p < end) {
+        byte = *(*p)++;
+        if (shift < 64) {
+            value |= (long long)(byte & 0x7f) << shift;
+        }
+        shift += 7;
+        if (!(byte & 0x80)) {
+            break;
+        }
+    }
+    if (shift < 64 && (byte & 0x40)) {
+        value |= -(1LL << shift);
+    }
+    return value;
+}
+
+static unsigned long long mika_read_fixed(const unsigned char** p, int size) {
+    unsigned long long value = 0;
+    for (int i = 0; i < size; i++) {
+        value |= (unsigned long long)(*p)[i] << (8 * i);
+    }
+    *p += size;
+    return value;
+}
+
+typedef struct {
+    const unsigned char* line_str;
+    size_t line_str_size;
+    const unsigned char* str;
+    size_t str_size;
+} MikaDwarfStrings;
+
+/* Читает атрибут записи каталога или файла DWARF 5; для путей
+   возвращает строку, остальное пропускает. */
+static int mika_read_form(const unsigned char** p, const unsigned char* end, unsigned form, int offset_size,
+                     const MikaDwarfStrings* strings, const char** text) {
+    unsigned long long offset;
+    *text = NULL;
+    switch (form) {
+        case 0x08: /* DW_FORM_string */
+            *text = (const char*)*p;
+            *p += strnlen(*text, (size_t)(end - *p)) + 1;
+            return 0;
+        case 0x1f: /* DW_FORM_line_strp */
+        case 0x0e: /* DW_FORM_strp */
+            offset = mika_read_fixed(p, offset_size);
+            if (form == 0x1f && offset < strings->line_str_size) {
+                *text = (const char*)strings->line_str + offset;
+            } else if (form == 0x0e && offset < strings->str_size) {
+                *text = (const char*)strings->str + offset;
+            }
+            return 0;
+        case 0x0b: *p += 1; return 0;
+        case 0x05: *p += 2; return 0;
+        case 0x06: *p += 4; return 0;
+        case 0x07: *p += 8; return 0;
+        case 0x1e: *p += 16; return 0;
+        case 0x0f: mika_read_uleb(p, end); return 0;
+        case 0x0d: mika_read_sleb(p, end); return 0;
+        case 0x09: *p += mika_read_uleb(p, end); return 0;
+        default: return -1;
+    }
+}
+
+static void mika_add_row(MikaSymbolizer* sym, uintptr_t address, const char* file, int line) {
+    if (sym->row_count == sym->row_capacity) {
+        size_t capacity = sym->row_capacity ? sym->row_capacity * 2 : 4096;
+        MikaLineRow* rows = realloc(sym->rows, capacity * sizeof(MikaLineRow));
+        if (!rows) {
+            return;
+        }
+        sym->rows = rows;
+        sym->row_capacity = capacity;
+    }
+    sym->rows[sym->row_count++] = (MikaLineRow){address, file, line};
+}
+
+/* Таблица строк одной единицы компиляции (.debug_line, DWARF 2-5) */
+static const unsigned char* mika_read_line_unit(MikaSymbolizer* sym, const unsigned char* p, const unsigned char* end,
+                                           const MikaDwarfStrings* strings) {
+    const char* files[1024];
+    int file_count = 0;
+    int offset_size = 4;
+    unsigned long long length = mika_read_fixed(&p, 4);
+    if (length == 0xffffffffu) {
+        length = mika_read_fixed(&p, 8);
+        offset_size = 8;
+    }
+    if (length > (unsigned long long)(end - p)) {
+        return end;
+    }
+    const unsigned char* unit_end = p + length;
+    int version = (int)mika_read_fixed(&p, 2);
+    int address_size = 8;
+    if (version < 2 || version > 5) {
+        return unit_end;
+    }
+    if (version >= 5) {
+        address_size = (int)mika_read_fixed(&p, 1);
+        p += 1;
+    }
+    unsigned long long header_length = mika_read_fixed(&p, offset_size);
+    const unsigned char* program = p + header_length;
+    int min_length = *p++;
+    if (version >= 4) {
+        p++;
+    }
+    p++;
+    int line_base = (signed char)*p++;
+    int line_range = *p++;
+    int opcode_base = *p++;
+    const unsigned char* opcode_lengths = p;
+    p += opcode_base - 1;
+    if (line_range == 0 || program > unit_end) {
+        return unit_end;
+    }
+
+    if (version < 5) {
+        files[file_count++] = NULL;
+        while (p < program && *p) {
+            p += strnlen((const char*)p, (size_t)(program - p)) + 1;
+        }
+        p++;
+        while (p < program && *p) {
+            const char* name = (const char*)p;
+            p += strnlen(name, (size_t)(program - p)) + 1;
+            mika_read_uleb(&p, program);
+            mika_read_uleb(&p, program);
+            mika_read_uleb(&p, program);
+            if (file_count < 1024) {
+                files[file_count++] = name;
+            }
+        }
+    } else {
+        for (int table = 0; table < 2; table++) {
+            unsigned formats[16][2];
+            int format_count = *p++;
+            if (format_count > 16) {
+                return unit_end;
+            }
+            for (int f = 0; f < format_count; f++) {
+                formats[f][0] = (unsigned)mika_read_uleb(&p, program);
+                formats[f][1] = (unsigned)mika_read_uleb(&p, program);
+            }
+            unsigned long long count = mika_read_uleb(&p, program);
+            for (unsigned long long e = 0; e < count && p < program; e++) {
+                const char* path = NULL;
+                for (int f = 0; f < format_count; f++) {
+                    const char* text;
+                    if (mika_read_form(&p, program, formats[f][1], offset_size, strings, &text) != 0) {
+                        return unit_end;
+                    }
+                    if (formats[f][0] == 1) { /* DW_LNCT_path */
+                        path = text;
+                    }
+                }
+                if (table == 1 && file_count < 1024) {
+                    files[file_count++] = path;
+                }
+            }
+        }
+    }
+
+    uintptr_t address = 0;
+    unsigned long long file = 1;
+    long long line = 1;
+    p = program;
+    while (p < unit_end) {
+        int op = *p++;
+        if (op >= opcode_base) {
+            int adjusted = op - opcode_base;
+            address += (uintptr_t)(adjusted / line_range * min_length);
+            line += line_base + adjusted % line_range;
+            mika_add_row(sym, address, file < (unsigned long long)file_count ? files[file] : NULL, (int)line);
+        } else if (op == 0) {
+            unsigned long long size = mika_read_uleb(&p, unit_end);
+            const unsigned char* next = p + size;
+            if (size == 0 || next > unit_end) {
+                break;
+            }
+            int sub = *p++;
+            if (sub == 1) { /* DW_LNE_end_sequence */
+                mika_add_row(sym, address, NULL, 0);
+                address = 0;
+                file = 1;
+                line = 1;
+            } else if (sub == 2) { /* DW_LNE_set_address */
+                address = (uintptr_t)mika_read_fixed(&p, version >= 5 ? address_size : (int)size - 1);
+            }
+            p = next;
+        } else {
+            switch (op) {
+                case 1:
+                    mika_add_row(sym, address, file < (unsigned long long)file_count ? files[file] : NULL, (int)line);
+                    break;
+                case 2: address += (uintptr_t)(mika_read_uleb(&p, unit_end) * (unsigned)min_length); break;
+                case 3: line += mika_read_sleb(&p, unit_end); break;
+                case 4: file = mika_read_uleb(&p, unit_end); break;
+                case 8: address += (uintptr_t)((255 - opcode_base) / line_range * min_length); break;
+                case 9: address += (uintptr_t)mika_read_fixed(&p, 2); break;
+                default:
+                    for (int i = 0; i < opcode_lengths[op - 1]; i++) {
+                        mika_read_uleb(&p, unit_end);
+                    }
+                    break;
+            }
+        }
+    }
+    return unit_end;
+}
+
+static int mika_compare_symbols(const void* a, const void* b) {
+    const MikaFunctionSymbol* x = a;
+    const MikaFunctionSymbol* y = b;
+    return x->start < y->start ? -1 : x->start > y->start;
+}
+
+/* Конец последовательности идёт раньше строки с тем же адресом:
+   следующая функция может начинаться сразу за предыдущей. */
+static int mika_compare_rows(const void* a, const void* b) {
+    const MikaLineRow* x = a;
+    const MikaLineRow* y = b;
+    if (x->address != y->address) {
+        return x->address < y->address ? -1 : 1;
+    }
+    return (x->line != 0) - (y->line != 0);
+}
+
+static int mika_load_symbols(MikaSymbolizer* sym) {
+    FILE* file = fopen("/proc/self/exe", "rb");
+    long size;
+    if (!file) {
+        return -1;
+    }
+    if (fseek(file, 0, SEEK_END) != 0 || (size = ftell(file)) < (long)sizeof(Elf64_Ehdr) ||
+        fseek(file, 0, SEEK_SET) != 0 || !(sym->image = malloc((size_t)size)) ||
+        fread(sym->image, 1, (size_t)size, file) != (size_t)size) {
+        fclose(file);
+        return -1;
+    }
+    fclose(file);
+
+    const Elf64_Ehdr* header = (const Elf64_Ehdr*)sym->image;
+    if (memcmp(header->e_ident, ELFMAG, SELFMAG) != 0 || header->e_ident[EI_CLASS] != ELFCLASS64 ||
+        header->e_shoff + (unsigned long long)header->e_shnum * sizeof(Elf64_Shdr) > (unsigned long long)size ||
+        header->e_phoff + (unsigned long long)header->e_phnum * sizeof(Elf64_Phdr) > (unsigned long long)size ||
+        header->e_shstrndx >= header->e_shnum) {
+        return -1;
+    }
+
+    /* Сдвиг загрузки PIE: заголовки программы в памяти против адреса в файле */
+    const Elf64_Phdr* phdrs = (const Elf64_Phdr*)(sym->image + header->e_phoff);
+    for (int i = 0; i < header->e_phnum; i++) {
+        if (phdrs[i].p_type == PT_PHDR) {
+            sym->bias = (uintptr_t)getauxval(AT_PHDR) - (uintptr_t)phdrs[i].p_vaddr;
+        }
+    }
+
+    const Elf64_Shdr* sections = (const Elf64_Shdr*)(sym->image + header->e_shoff);
+    const char* names = (const char*)sym->image + sections[header->e_shstrndx].sh_offset;
+    const Elf64_Shdr* debug_line = NULL;
+    MikaDwarfStrings strings = {0};
+    for (int i = 0; i < header->e_shnum; i++) {
+        const Elf64_Shdr* section = &sections[i];
+        const char* name = names + section->sh_name;
+        if (section->sh_type == SHT_NOBITS || section->sh_offset + section->sh_size > (unsigned long long)size ||
+            (section->sh_flags & SHF_COMPRESSED)) {
+            continue;
+        }
+        if (section->sh_type == SHT_SYMTAB && section->sh_link < header->e_shnum) {
+            const Elf64_Sym* symbols = (const Elf64_Sym*)(sym->image + section->sh_offset);
+            const char* symbol_names = (const char*)sym->image + sections[section->sh_link].sh_offset;
+            size_t count = section->sh_size / sizeof(Elf64_Sym);
+            sym->symbols = malloc(count * sizeof(MikaFunctionSymbol));
+            for (size_t s = 0; sym->symbols && s < count; s++) {
+                if (ELF64_ST_TYPE(symbols[s].st_info) == STT_FUNC && symbols[s].st_value && symbols[s].st_size) {
+                    sym->symbols[sym->symbol_count++] = (MikaFunctionSymbol){
+                        symbols[s].st_value, symbols[s].st_size, symbol_names + symbols[s].st_name};
+                }
+            }
+        } else if (strcmp(name, ".debug_line") == 0) {
+            debug_line = section;
+        } else if (strcmp(name, ".debug_line_str") == 0) {
+            strings.line_str = sym->image + section->sh_offset;
+            strings.line_str_size = section->sh_size;
+        } else if (strcmp(name, ".debug_str") == 0) {
+            strings.str = sym->image + section->sh_offset;
+            strings.str_size = section->sh_size;
+        }
+    }
+    qsort(sym->symbols, sym->symbol_count, sizeof(MikaFunctionSymbol), mika_compare_symbols);
+
+    if (debug_line) {
+        const unsigned char* p = sym->image + debug_line->sh_offset;
+        const unsigned char* end = p + debug_line->sh_size;
+        while (p + 4 <= end) {
+            p = mika_read_line_unit(sym, p, end, &strings);
+        }
+        qsort(sym->rows, sym->row_count, sizeof(MikaLineRow), mika_compare_rows);
+    }
+    return 0;
+}
+
+static const MikaFunctionSymbol* mika_find_symbol(const MikaSymbolizer* sym, uintptr_t address) {
+    size_t low = 0, high = sym->symbol_count;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (sym->symbols[middle].start <= address) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    if (low == 0 || address >= sym->symbols[low - 1].start + sym->symbols[low - 1].size) {
+        return NULL;
+    }
+    return &sym->symbols[low - 1];
+}
+
+static const MikaLineRow* mika_find_row(const MikaSymbolizer* sym, uintptr_t address) {
+    size_t low = 0, high = sym->row_count;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (sym->rows[middle].address <= address) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    if (low == 0 || sym->rows[low - 1].line == 0 || !sym->rows[low - 1].file) {
+        return NULL;
+    }
+    return &sym->rows[low - 1];
+}
+
+/* Стек от корня к листу; кадры вне программы (libc) пропускаются,
+   всё, что вызвало main, отбрасывается. */
+static size_t mika_fold_stack(const MikaSymbolizer* sym, const MikaStackSlot* slot, char* text, size_t size) {
+    void** frames = mika_profiler.pool + slot->offset;
+    size_t used = 0;
+    int root = (int)slot->depth - 1;
+
+    for (int i = root; i >= 0; i--) {
+        const MikaFunctionSymbol* function = mika_find_symbol(sym, (uintptr_t)frames[i] - sym->bias);
+        if (function && strcmp(function->name, "main") == 0) {
+            root = i;
+            break;
+        }
+    }
+    for (int i = root; i >= 0; i--) {
+        /* Кроме листа, в стеке адреса возврата: сама инструкция вызова на байт раньше */
+        uintptr_t address = (uintptr_t)frames[i] - sym->bias - (i > 0);
+        const MikaFunctionSymbol* function = mika_find_symbol(sym, address);
+        if (!function) {
+            continue;
+        }
+        const MikaLineRow* row = mika_find_row(sym, address);
+        const char* sep = used ? ";" : "";
+        int len;
+        if (row) {
+            const char* base = strrchr(row->file, '/');
+            len = snprintf(text + used, size - used, "%s%s (%s:%d)", sep, function->name,
+                           base ? base + 1 : row->file, row->line);
+        } else {
+            len = snprintf(text + used, size - used, "%s%s", sep, function->name);
+        }
+        if (len < 0 || (size_t)len >= size - used) {
+            break;
+        }
+        used += (size_t)len;
+    }
+    return used;
+}
+
+typedef struct {
+    char* stack;
+    unsigned long long count;
+} MikaFoldedStack;
+
+static int mika_compare_folded(const void* a, const void* b) {
+    return strcmp(((const MikaFoldedStack*)a)->stack, ((const MikaFoldedStack*)b)->stack);
+}
+
+static void mika_write_profile(void) {
+    struct itimerval stop = {{0, 0}, {0, 0}};
+    MikaSymbolizer sym = {0};
+    MikaFoldedStack* folded = NULL;
+    size_t count = 0;
+    char text[8192];
+    FILE* output = NULL;
+
+    setitimer(ITIMER_PROF, &stop, NULL);
+    signal(SIGPROF, SIG_IGN);
+    while (__atomic_exchange_n(&mika_profiler.busy, 1, __ATOMIC_ACQUIRE)) {
+        continue;
+    }
+
+    if (mika_load_symbols(&sym) != 0) {
+        fprintf(stderr, "Mika: профиль: не удалось прочитать символы программы\n");
+    }
+    folded = malloc(MIKA_PROFILE_SLOTS * sizeof(MikaFoldedStack));
+    if (!folded) {
+        goto done;
+    }
+    for (size_t i = 0; i < MIKA_PROFILE_SLOTS; i++) {
+        const MikaStackSlot* slot = &mika_profiler.slots[i];
+        size_t len;
+        if (slot->count == 0 || (len = mika_fold_stack(&sym, slot, text, sizeof(text))) == 0) {
+            continue;
+        }
+        if (!(folded[count].stack = malloc(len + 1))) {
+            break;
+        }
+        memcpy(folded[count].stack, text, len + 1);
+        folded[count++].count = slot->count;
+    }
+    /* Разные адреса одной строки дают одинаковые стеки: складываем их */
+    qsort(folded, count, sizeof(MikaFoldedStack), mika_compare_folded);
+
+    output = fopen(mika_profiler.path, "w");
+    if (!output) {
+        fprintf(stderr, "Mika: профиль: не удалось создать %s: %s\n", mika_profiler.path, strerror(errno));
+        goto done;
+    }
+    for (size_t i = 0; i < count; ) {
+        unsigned long long total = 0;
+        size_t j = i;
+        while (j < count && strcmp(folded[j].stack, folded[i].stack) == 0) {
+            total += folded[j++].count;
+        }
+        fprintf(output, "%s %llu\n", folded[i].stack, total);
+        i = j;
+    }
+    if (fclose(output) != 0) {
+        fprintf(stderr, "Mika: профиль: ошибка записи %s\n", mika_profiler.path);
+        goto done;
+    }
+    flush_output();
+    fprintf(stderr, "Mika: профиль: %llu сэмплов (потеряно %llu) записано в %s\n",
+            mika_profiler.samples, mika_profiler.dropped, mika_profiler.path);
+
+done:
+    for (size_t i = 0; i < count; i++) {
+        free(folded[i].stack);
+    }
+    free(folded);
+    free(sym.rows);
+    free(sym.symbols);
+    free(sym.image);
+}
+
+/* Без MIKA_PROFILE профилировщик ничего не делает: ни таймера, ни обработчика. */
+__attribute__((constructor)) static void mika_start_profiler(void) {
+    const char* path = getenv("MIKA_PROFILE");
+    const char* rate = getenv("MIKA_PROFILE_HZ");
+    long hz = rate ? strtol(rate, NULL, 10) : MIKA_PROFILE_HZ;
+    struct sigaction action;
+    struct itimerval timer;
+    void* warmup[1];
+
+    if (!path || !*path) {
+        return;
+    }
+    if (hz < 1) hz = 1;
+    if (hz > 10000) hz = 10000;
+    mika_profiler.path = path;
+    mika_profiler.slots = calloc(MIKA_PROFILE_SLOTS, sizeof(MikaStackSlot));
+    mika_profiler.pool = malloc(MIKA_PROFILE_POOL * sizeof(void*));
+    if (!mika_profiler.slots || !mika_profiler.pool) {
+        fprintf(stderr, "Mika: профиль: не удалось выделить память\n");
+        return;
+    }
+    /* Первый вызов backtrace подгружает libgcc: делаем его вне обработчика */
+    backtrace(warmup, 1);
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = mika_profile_signal;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    timer.it_interval.tv_sec = 0;
+    timer.it_interval.tv_usec = 1000000 / hz;
+    timer.it_value = timer.it_interval;
+    if (sigaction(SIGPROF, &action, NULL) != 0 || setitimer(ITIMER_PROF, &timer, NULL) != 0) {
+        fprintf(stderr, "Mika: профиль: не удалось запустить таймер: %s\n", strerror(errno));
+        return;
+    }
+    atexit(mika_write_profile);
+}
+
+#endif
+
+extern int array_length(const int* array);
+
+extern void array_push(int** array, int value);
+
+extern int array_pop(int* array);
+
+extern MikaSlice array_view(int* array);
+
+extern MikaSlice mika_fixed_view(int* array, int length);
@@ -6,15 +6,93 @@
 #include <string.h>
 #include <stdbool.h>
 
-#define print printf
+#define print mika_print
+
+int mika_print(const char* format, ...);
+
+void flush_output(void);
 
 int input(void);
 
+int input_token(char* buffer, int size);
+
 void input_string(char* buffer, int size);
 
-int power(int base, int exponent);
+inline int power(int base, int exponent) {
+    unsigned int result = 1;
+    unsigned int factor = (unsigned int)base;
+    while (exponent > 0) {
+        if (exponent & 1) {
+            result *= factor;
+        }
+        exponent >>= 1;
+        if (exponent) {
+            factor *= factor;
+        }
+    }
+    return (int)result;
+}
+
+inline int absolute(int number) {
+    int mask = number >> (sizeof(int) * 8 - 1);
+    return (number ^ mask) - mask;
+}
+
+#define MIKA_STRING_INLINE 15
+
+/* capacity == 0: символы лежат в small; capacity < 0: чужой буфер (литерал
+   или срез другой строки); capacity > 0: собственный буфер в куче.
+   Срез только заимствует буфер: при записи в переменную строка копируется
+   (mika_string_copy, mika_string_assign), поэтому у каждой переменной
+   свой буфер и string_free освобождает его ровно один раз. */
+typedef struct {
+    int length;
+    int capacity;
+    union {
+        char small[MIKA_STRING_INLINE + 1];
+        const char* ptr;
+    } u;
+} MikaString;
+
+typedef struct {
+    char* data;
+    int length;
+    int capacity;
+} MikaStringBuilder;
+
+#define MIKA_STRING_LITERAL(text) mika_string_literal((text), (int)sizeof(text) - 1)
+
+MikaString mika_string_literal(const char* text, int length);
+
+MikaString mika_string_from(const char* text);
+
+MikaString mika_string_substring(MikaString string, int from, int to);
+
+int mika_string_compare(MikaString a, MikaString b);
+
+MikaString mika_string_copy(MikaString source);
+
+void mika_string_assign(MikaString* target, MikaString source);
+
+void mika_string_write(char* buffer, MikaString source);
+
+void mika_string_free(MikaString* string);
 
-int absolute(int number);
+void mika_builder_append(MikaStringBuilder* builder, MikaString piece);
+
+MikaString mika_builder_finish(MikaStringBuilder* builder);
+
+void mika_builder_free(MikaStringBuilder* builder);
+
+MikaString mika_input_line(void);
+
+inline const char* mika_string_data(const MikaString* string) {
+    return string->capacity == 0 ? string->u.small : string->u.ptr;
+}
+
+inline int mika_string_length(MikaString string) {
+    return string.length;
+}
 
 #define string_length strlen
 
@@ -22,10 +100,144 @@ int absolute(int number);
 
 #define string_copy strcpy
 
+typedef struct {
+    int length;
+    int capacity;
+    int flags;
+    int reserved;
+} MikaArrayHeader;
+
+typedef struct {
+    int* data;
+    int length;
+} MikaSlice;
+
+#define MIKA_ARRAY_HEADER(array) ((MikaArrayHeader*)(array) - 1)
+
 int* array_create(int size);
 
 void array_free(int* array);
 
 int array_size(int* array, int size);
 
+void array_reserve(int** array, int capacity);
+
+void array_grow(int** array);
+
+void array_pop_empty(void);
+
+MikaSlice array_slice(int* array, int from, int to);
+
+MikaSlice slice_range(MikaSlice slice, int from, int to);
+
+/* Коллекции record: столбцы полей в одном выровненном блоке */
+#define MIKA_RECORDS_MAX_FIELDS 32
+
+int mika_records_alloc(int length, const size_t* sizes, int count, void** fields);
+
+void mika_records_free(void* first);
+
+const char* array_simd_level(void);
+
+int array_sum(MikaSlice array);
+
+int array_min(MikaSlice array);
+
+int array_max(MikaSlice array);
+
+void array_fill(MikaSlice array, int value);
+
+void array_copy(MikaSlice target, MikaSlice source);
+
+int array_dot(MikaSlice a, MikaSlice b);
+
+void array_add(MikaSlice target, MikaSlice a, MikaSlice b);
+
+void array_sub(MikaSlice target, MikaSlice a, MikaSlice b);
+
+void array_mul(MikaSlice target, MikaSlice a, MikaSlice b);
+
+typedef void (*MikaParallelBody)(void** shared, int from, int to);
+
+void mika_parallel_for(int from, int to, MikaParallelBody body, void** shared);
+
+void mika_parallel_lock(void);
+
+void mika_parallel_unlock(void);
+
+int mika_thread_count(void);
+
+/* Счётчики функции заведены отдельно в каждом потоке, отчёт их суммирует. */
+typedef struct MikaFunctionStats {
+    const char* name;
+    const char* file;
+    int line;
+    int registered;
+    int depth;
+    unsigned long long calls;
+    unsigned long long self_ns;
+    unsigned long long total_ns;
+    struct MikaFunctionStats* next;
+} MikaFunctionStats;
+
+typedef struct MikaCall {
+    MikaFunctionStats* function;
+    unsigned long long start;
+    unsigned long long children;
+    struct MikaCall* parent;
+} MikaCall;
+
+void mika_instrument_enter(MikaCall* call, MikaFunctionStats* function);
+
+void mika_instrument_leave(MikaCall* call);
+
+#define MIKA_INSTRUMENT(name) \
+    static __thread MikaFunctionStats mika_function_stats = {name, __FILE__, __LINE__, 0, 0, 0, 0, 0, NULL}; \
+    __attribute__((cleanup(mika_instrument_leave))) MikaCall mika_call; \
+    mika_instrument_enter(&mika_call, &mika_function_stats)
+
+void mika_arena_enable(void);
+
+void arena_enter(void);
+
+void arena_leave(void);
+
+inline int array_length(const int* array) {
+    return array ? ((const MikaArrayHeader*)array - 1)->length : 0;
+}
+
+inline MikaSlice array_view(int* array) {
+    MikaSlice slice = {array, array_length(array)};
+    return slice;
+}
+
+/* срез массива фиксированного размера: у него нет заголовка с длиной */
+inline MikaSlice mika_fixed_view(int* array, int length) {
+    MikaSlice slice = {array, length};
+    return slice;
+}
+
+inline void array_push(int** array, int value) {
+    if (!*array || MIKA_ARRAY_HEADER(*array)->length == MIKA_ARRAY_HEADER(*array)->capacity) {
+        array_grow(array);
+    }
+    MikaArrayHeader* header = MIKA_ARRAY_HEADER(*array);
+    (*array)[header->length++] = value;
+}
+
+inline int array_pop(int* array) {
+    if (array_length(array) == 0) {
+        array_pop_empty();
+    }
+    MikaArrayHeader* header = MIKA_ARRAY_HEADER(array);
+    return array[--header->length];
+}
+
+#endif
+
+#if defined(MIKA_ARENA) && !defined(MIKA_ARENA_STARTUP)
+#define MIKA_ARENA_STARTUP
+__attribute__((constructor)) static void mika_arena_startup(void) {
+    mika_arena_enable();
+}
 #endif
@@ -1,40 +1,58 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <signal.h>
+#include <getopt.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include <sys/stat.h>
-#include <sys/wait.h>
-
-#define MIKA_VERSION "1.1.0"
-#define MAX_FILENAME_LENGTH 256
-#define MAX_CMD_LENGTH 512
-
-typedef struct {
-    char* input_file;
-    char* output_file;
-    int verbose;
-    int debug;
-    int keep_files;
-    int compile_only;
-    char* compiler_flags;
-} CompileContext;
+
+#include "translate.h"
+#include "process.h"
+#include "runtime.h"
+#include "cache.h"
+#include "hash.h"
+#include "build.h"
+#include "watch.h"
+#include "daemon.h"
 
 void show_help(void);
 int file_exists(const char* filename);
-int execute_command(const char* cmd, int verbose);
 int compile_mika(CompileContext* ctx);
-void cleanup_files(const char* c_file, const char* o_file, int keep_files);
+int compile_many(CompileContext* ctx);
+int compile_whole(CompileContext* ctx);
+int compile_pgo(CompileContext* ctx);
 
 void show_help(void) {
     printf("🐧 Mika Language Compiler v%s\n", MIKA_VERSION);
-    printf("Использование: mikac [ОПЦИИ] <файл.mk>\n\n");
+    printf("Использование: mikac [ОПЦИИ] <файл.mk> [файл2.mk ...]\n\n");
     printf("Опции:\n");
     printf("  -o <файл>    Указать имя выходного исполняемого файла\n");
     printf("  -c           Только компиляция, без линковки\n");
+    printf("  -j <N>       Число параллельных задач при сборке нескольких файлов\n");
+    printf("  -O <0-3|s>   Уровень оптимизации (по умолчанию -O2, с -g: -O0)\n");
     printf("  -g           Включить отладочную информацию\n");
-    printf("  -k           Сохранять промежуточные файлы\n");
+    printf("  -k           Сохранять промежуточный .c файл\n");
+    printf("  -n           Оптимизировать под текущий процессор (-march=native)\n");
     printf("  -v           Подробный вывод\n");
     printf("  -h           Показать эту справку\n");
+    printf("  --lto        Оптимизация при линковке программы и библиотеки (-flto)\n");
+    printf("  --pgo=<файл> Сборка с профилем: обучающий запуск с файлом на stdin\n");
+    printf("  --whole-program  Собрать все модули и рантайм одной единицей трансляции\n");
+    printf("  --fast-start Статический исполняемый файл без PIE для быстрого запуска\n");
+    printf("  --arena      Выделять массивы из арены (как #include <Arena>)\n");
+    printf("  --instrument Замерять вызовы и время каждой функции, отчёт в stderr при выходе\n");
+    printf("  --no-cache   Не использовать кэш сборки\n");
+    printf("  --cache-stats  Показать статистику кэша сборки\n");
+    printf("  --time-report  Показать время, ЦП и память по этапам сборки\n");
+    printf("  --report-json=<файл>  Записать те же замеры по каждому файлу в JSON\n");
+    printf("  --watch      Пересобирать после каждого сохранения входных файлов\n");
+    printf("  --daemon     Запустить демон сборки с прогретой библиотекой и объектами\n");
+    printf("  --connect    Собрать через демон (без демона — как обычно)\n");
 }
 
 int file_exists(const char* filename) {
@@ -42,278 +60,506 @@ int file_exists(const char* filename) {
     return stat(filename, &st) == 0;
 }
 
-int execute_command(const char* cmd, int verbose) {
-    if (verbose) {
-        printf("💻 Выполняем: %s\n", cmd);
+static int write_c_file(CompileContext* ctx, const char* c_file) {
+    if (ctx->verbose) {
+        printf("\n🚀 Этап 2: Трансляция Mika -> C (%s)\n", c_file);
     }
-    int result = system(cmd);
-    if (verbose) {
-        if (result == 0) {
-            printf("   ✅ Команда выполнена успешно\n");
-        } else {
-            printf("   ❌ Ошибка выполнения команды (код: %d)\n", result);
-        }
+    FILE* c_out = fopen(c_file, "w");
+    if (!c_out) {
+        perror("❌ Не удалось создать C файл");
+        return -1;
     }
-    return result;
+    StageClock clock;
+    telemetry_start(&clock);
+    int failed = translate_input(ctx, ctx->input_file, NULL, c_out) != 0;
+    failed |= fclose(c_out) != 0;
+    telemetry_stop(ctx->telemetry, 0, STAGE_TRANSLATE, &clock, TIME_SELF);
+    if (failed) {
+        fprintf(stderr, "❌ Ошибка на этапе трансляции Mika -> C\n");
+        return -1;
+    }
+    return 0;
 }
 
-void cleanup_files(const char* c_file, const char* o_file, int keep_files) {
-    if (!keep_files) {
-        if (c_file && file_exists(c_file)) {
-            remove(c_file);
+static void report_success(CompileContext* ctx, const char* o_file) {
+    if (ctx->compile_only) {
+        if (ctx->verbose) {
+            printf("\n✅ Компиляция завершена (создан %s)\n", o_file);
         }
-        if (o_file && file_exists(o_file)) {
-            remove(o_file);
+        return;
+    }
+
+    if (ctx->verbose) {
+        printf("\n🎉 Компиляция успешно завершена!\n");
+        printf("   Создан исполняемый файл: %s\n", ctx->output_file);
+
+        struct stat st;
+        if (stat(ctx->output_file, &st) == 0) {
+            printf("   Размер файла: %ld байт\n", (long)st.st_size);
         }
+    } else {
+        printf("✅ Успешно: %s -> %s\n", ctx->input_file, ctx->output_file);
     }
 }
 
-char* create_temp_stdlib(void) {
-    char* temp_file = malloc(MAX_FILENAME_LENGTH);
-    if (!temp_file) return NULL;
-
-    strcpy(temp_file, "/tmp/mika_std_");
-
-    char random_part[10];
-    sprintf(random_part, "%d", rand() % 10000);
-    strcat(temp_file, random_part);
-    strcat(temp_file, ".c");
-
-    FILE* lib = fopen(temp_file, "w");
-    if (!lib) {
-        free(temp_file);
-        return NULL;
-    }
-
-    fprintf(lib, "#include <stdio.h>\n");
-    fprintf(lib, "#include <string.h>\n");
-    fprintf(lib, "#include <stdlib.h>\n\n");
-
-    fprintf(lib, "int input(void) {\n");
-    fprintf(lib, "    int value;\n");
-    fprintf(lib, "    scanf(\"%%d\", &value);\n");
-    fprintf(lib, "    return value;\n");
-    fprintf(lib, "}\n\n");
-
-    fprintf(lib, "int power(int base, int exponent) {\n");
-    fprintf(lib, "    int result = 1;\n");
-    fprintf(lib, "    for (int i = 0; i < exponent; i++) {\n");
-    fprintf(lib, "        result *= base;\n");
-    fprintf(lib, "    }\n");
-    fprintf(lib, "    return result;\n");
-    fprintf(lib, "}\n\n");
-
-    fprintf(lib, "int absolute(int number) {\n");
-    fprintf(lib, "    return (number < 0) ? -number : number;\n");
-    fprintf(lib, "}\n\n");
-
-    fprintf(lib, "int* array_create(int size) {\n");
-    fprintf(lib, "    return (int*)malloc(size * sizeof(int));\n");
-    fprintf(lib, "}\n\n");
-
-    fprintf(lib, "void array_free(int* array) {\n");
-    fprintf(lib, "    free(array);\n");
-    fprintf(lib, "}\n\n");
-
-    fprintf(lib, "int array_size(int* array, int size) {\n");
-    fprintf(lib, "    return size;\n");
-    fprintf(lib, "}\n\n");
-
-    fprintf(lib, "void input_string(char* buffer, int size) {\n");
-    fprintf(lib, "    int c;\n");
-    fprintf(lib, "    while ((c = getchar()) != '\\n' && c != EOF);\n");
-    fprintf(lib, "    fgets(buffer, size, stdin);\n");
-    fprintf(lib, "    size_t len = strlen(buffer);\n");
-    fprintf(lib, "    if (len > 0 && buffer[len-1] == '\\n') {\n");
-    fprintf(lib, "        buffer[len-1] = '\\0';\n");
-    fprintf(lib, "    }\n");
-    fprintf(lib, "}\n");
-
-    fclose(lib);
-    return temp_file;
-}
+/* Найденная библиотека запоминается на время жизни процесса: в режиме
+   --watch и в демоне повторные сборки не хэшируют исходники рантайма. */
+static RuntimeLibrary warm_runtimes[RUNTIME_FAST + 1];
+static int warm_ready[RUNTIME_FAST + 1];
 
-int compile_mika(CompileContext* ctx) {
-    char c_file[MAX_FILENAME_LENGTH] = {0};
-    char o_file[MAX_FILENAME_LENGTH] = {0};
+static int resolve_warm(RuntimeVariant variant, int verbose, RuntimeLibrary* runtime) {
+    if (warm_ready[variant] && file_exists(warm_runtimes[variant].library)) {
+        *runtime = warm_runtimes[variant];
+        return 0;
+    }
+    if (runtime_resolve(variant, verbose, runtime) != 0) {
+        return -1;
+    }
+    warm_runtimes[variant] = *runtime;
+    warm_ready[variant] = 1;
+    return 0;
+}
 
-    strcpy(c_file, ctx->input_file);
-    char* dot = strrchr(c_file, '.');
-    if (dot) *dot = '\0';
-    strcat(c_file, ".c");
+static int prepare_runtime(CompileContext* ctx, RuntimeLibrary* runtime) {
+    RuntimeVariant variant = ctx->lto ? RUNTIME_LTO : ctx->fast_start ? RUNTIME_FAST :
+                             ctx->debug ? RUNTIME_DEBUG : ctx->native ? RUNTIME_NATIVE : RUNTIME_RELEASE;
+    StageClock clock;
+    telemetry_start(&clock);
+    int failed = resolve_warm(variant, ctx->verbose, runtime) != 0;
+    telemetry_stop(ctx->telemetry, -1, STAGE_STDLIB, &clock, TIME_SELF | TIME_CHILDREN);
+    if (failed) {
+        fprintf(stderr, "❌ Ошибка подготовки стандартной библиотеки\n");
+        return -1;
+    }
+    return 0;
+}
 
-    strcpy(o_file, ctx->input_file);
-    dot = strrchr(o_file, '.');
-    if (dot) *dot = '\0';
-    strcat(o_file, ".o");
+int compile_mika(CompileContext* ctx) {
+    char* c_file = NULL;
+    char* o_file = NULL;
+    ArgList args = {0};
+    int result = 1;
 
-    if (ctx->verbose) {
-        printf("\n🚀 Этап 1: Трансляция Mika -> C\n");
+    if (!ctx->output_file && !ctx->compile_only) {
+        ctx->output_file = replace_extension(ctx->input_file, "");
+    }
+    if (ctx->keep_files) {
+        c_file = replace_extension(ctx->input_file, ".c");
+    }
+    if (ctx->compile_only) {
+        o_file = ctx->output_file ? strdup(ctx->output_file) : replace_extension(ctx->input_file, ".o");
+    }
+    if ((!ctx->compile_only && !ctx->output_file) || (ctx->keep_files && !c_file) ||
+        (ctx->compile_only && !o_file)) {
+        fprintf(stderr, "❌ Ошибка выделения памяти\n");
+        goto done;
     }
 
-    char transpile_cmd[MAX_CMD_LENGTH];
     if (ctx->verbose) {
-        sprintf(transpile_cmd, "mika2c -v '%s'", ctx->input_file);
-    } else {
-        sprintf(transpile_cmd, "mika2c '%s'", ctx->input_file);
+        printf("\n📦 Этап 1: Стандартная библиотека Mika\n");
+    }
+    RuntimeLibrary runtime;
+    if (prepare_runtime(ctx, &runtime) != 0) {
+        goto done;
     }
 
-    if (execute_command(transpile_cmd, ctx->verbose) != 0) {
-        fprintf(stderr, "❌ Ошибка на этапе трансляции Mika -> C\n");
-        return 1;
+    const char* target = ctx->compile_only ? o_file : ctx->output_file;
+    BuildCache cache;
+    char key[HASH_HEX_SIZE];
+    int cacheable = ctx->use_cache && build_cache_init(&cache, ctx->verbose) == 0 &&
+                    compute_build_key(ctx, ctx->input_file, !ctx->compile_only, &runtime, key) == 0;
+
+    if (cacheable && build_cache_fetch(&cache, key, target)) {
+        telemetry_mark_cached(ctx->telemetry, 0);
+        if (ctx->verbose) {
+            printf("\n⚡ Найдено в кэше сборки: %s\n", key);
+        }
+        if (ctx->keep_files && write_c_file(ctx, c_file) != 0) {
+            goto done;
+        }
+        report_success(ctx, o_file);
+        result = 0;
+        goto done;
     }
 
-    if (!file_exists(c_file)) {
-        fprintf(stderr, "❌ Не удалось создать C файл: %s\n", c_file);
-        return 1;
+    if (ctx->keep_files) {
+        if (write_c_file(ctx, c_file) != 0) {
+            goto done;
+        }
+    } else if (ctx->verbose) {
+        printf("\n🚀 Этап 2: Трансляция Mika -> C (в памяти, поток в gcc)\n");
     }
 
     if (ctx->verbose) {
-        printf("\n🔧 Этап 2: Компиляция C -> объектный файл\n");
+        if (ctx->compile_only) {
+            printf("\n🔧 Этап 3: Компиляция C -> объектный файл\n");
+        } else {
+            printf("\n🔗 Этап 3: Компиляция и линковка исполняемого файла\n");
+        }
     }
 
-    char compile_cmd[MAX_CMD_LENGTH];
-    if (ctx->debug) {
-        sprintf(compile_cmd, "gcc -c %s -o %s -g -I/usr/local/include", c_file, o_file);
+    char runtime_include[PATH_MAX + 2];
+    args_add(&args, "gcc");
+    args_add(&args, "-x");
+    args_add(&args, "c");
+    args_add(&args, ctx->keep_files ? c_file : "-");
+    args_add(&args, "-x");
+    args_add(&args, "none");
+    if (ctx->compile_only) {
+        args_add(&args, "-c");
     } else {
-        sprintf(compile_cmd, "gcc -c %s -o %s -I/usr/local/include", c_file, o_file);
+        args_add(&args, runtime.library);
+    }
+    args_add(&args, "-o");
+    args_add(&args, target);
+    char quote_dir[PATH_MAX];
+    add_quote_dir(&args, ctx->input_file, quote_dir, sizeof(quote_dir));
+    add_common_flags(&args, ctx, &runtime, runtime_include, sizeof(runtime_include));
+
+    double started = telemetry_now();
+    int stdin_fd = -1;
+    pid_t pid = spawn_process(&args, ctx->keep_files ? NULL : &stdin_fd, ctx->verbose);
+    if (pid < 0) {
+        goto done;
     }
 
-    if (execute_command(compile_cmd, ctx->verbose) != 0) {
-        fprintf(stderr, "❌ Ошибка компиляции C кода\n");
-        cleanup_files(c_file, NULL, ctx->keep_files);
-        return 1;
+    int stream_failed = 0;
+    if (!ctx->keep_files) {
+        FILE* stream = fdopen(stdin_fd, "w");
+        if (!stream) {
+            perror("❌ Ошибка открытия канала");
+            close(stdin_fd);
+            stream_failed = 1;
+        } else {
+            StageClock clock;
+            telemetry_start(&clock);
+            stream_failed = translate_input(ctx, ctx->input_file, NULL, stream) != 0;
+            telemetry_stop(ctx->telemetry, 0, STAGE_TRANSLATE, &clock, TIME_SELF);
+            if (stream_failed) {
+                kill(pid, SIGTERM);
+            }
+            if (fclose(stream) != 0) {
+                stream_failed = 1;
+            }
+        }
     }
 
-    if (!file_exists(o_file)) {
-        fprintf(stderr, "❌ Не удалось создать объектный файл: %s\n", o_file);
-        cleanup_files(c_file, NULL, ctx->keep_files);
-        return 1;
+    struct rusage usage;
+    int status = wait_process_usage(pid, ctx->verbose, &usage);
+    if (status >= 0) {
+        telemetry_add_process(ctx->telemetry, 0, ctx->compile_only ? STAGE_COMPILE : STAGE_COMPILE_LINK,
+                              telemetry_now() - started, &usage);
+    }
+    if (stream_failed) {
+        fprintf(stderr, "❌ Ошибка на этапе трансляции Mika -> C\n");
+        goto done;
+    }
+    if (status != 0) {
+        fprintf(stderr, ctx->compile_only ? "❌ Ошибка компиляции C кода\n" : "❌ Ошибка компиляции или линковки\n");
+        goto done;
     }
 
-    if (ctx->compile_only) {
-        if (ctx->verbose) {
-            printf("\n✅ Компиляция завершена (создан %s)\n", o_file);
-        }
-        if (!ctx->keep_files) {
-            remove(c_file);
-        }
-        return 0;
+    if (cacheable && build_cache_store(&cache, key, target) != 0 && ctx->verbose) {
+        printf("   ⚠️  Не удалось сохранить результат в кэш\n");
     }
 
+    report_success(ctx, o_file);
+    result = 0;
+
+done:
+    args_free(&args);
+    free(c_file);
+    free(o_file);
+    return result;
+}
+
+int compile_many(CompileContext* ctx) {
+    RuntimeLibrary runtime;
+
     if (ctx->verbose) {
-        printf("\n🔗 Этап 3: Компиляция стандартной библиотеки\n");
+        printf("\n📦 Стандартная библиотека Mika\n");
+    }
+    if (prepare_runtime(ctx, &runtime) != 0) {
+        return 1;
+    }
+    if (!ctx->output_file && !ctx->compile_only) {
+        ctx->output_file = replace_extension(ctx->input_files[0], "");
+        if (!ctx->output_file) {
+            fprintf(stderr, "❌ Ошибка выделения памяти\n");
+            return 1;
+        }
     }
+    return build_project(ctx, &runtime);
+}
 
-    char lib_o_file[MAX_FILENAME_LENGTH] = "/tmp/mika_std.o";
-    char* lib_c_file = NULL;
-    char* temp_lib_file = NULL;
+/* Все модули и рантайм — одна единица трансляции: gcc видит программу
+   целиком и встраивает вызовы между модулями без LTO. */
+int compile_whole(CompileContext* ctx) {
+    RuntimeLibrary runtime;
 
-    if (file_exists("/usr/local/include/mika/mika_std.c")) {
-        lib_c_file = "/usr/local/include/mika/mika_std.c";
-        if (ctx->verbose) {
-            printf("   Используем системную библиотеку: %s\n", lib_c_file);
+    if (ctx->verbose) {
+        printf("\n📦 Стандартная библиотека Mika\n");
+    }
+    if (prepare_runtime(ctx, &runtime) != 0) {
+        return 1;
+    }
+    if (!ctx->output_file) {
+        ctx->output_file = replace_extension(ctx->input_files[0], "");
+        if (!ctx->output_file) {
+            fprintf(stderr, "❌ Ошибка выделения памяти\n");
+            return 1;
         }
-    } else {
-        temp_lib_file = create_temp_stdlib();
-        if (temp_lib_file) {
-            lib_c_file = temp_lib_file;
-            if (ctx->verbose) {
-                printf("   Создана временная библиотека: %s\n", lib_c_file);
+    }
+    return build_whole_program(ctx, &runtime);
+}
+
+static void remove_work_dir(const char* dir) {
+    char path[PATH_MAX];
+    DIR* handle = opendir(dir);
+    if (handle) {
+        struct dirent* entry;
+        while ((entry = readdir(handle)) != NULL) {
+            if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+            int len = snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+            if (len > 0 && (size_t)len < sizeof(path) && unlink(path) != 0 && errno == EISDIR) {
+                remove_work_dir(path);
             }
-        } else {
-            fprintf(stderr, "❌ Не удалось создать временную библиотеку\n");
-            cleanup_files(c_file, o_file, ctx->keep_files);
-            return 1;
         }
+        closedir(handle);
     }
+    rmdir(dir);
+}
 
-    char lib_compile_cmd[MAX_CMD_LENGTH];
-    sprintf(lib_compile_cmd, "gcc -c %s -o %s", lib_c_file, lib_o_file);
+int compile_pgo(CompileContext* ctx) {
+    RuntimeLibrary runtime;
+    char work[PATH_MAX], instrumented[PATH_MAX];
+    const char* tmp = getenv("TMPDIR");
+    int result = 1;
 
-    if (execute_command(lib_compile_cmd, ctx->verbose) != 0) {
-        fprintf(stderr, "❌ Ошибка компиляции стандартной библиотеки\n");
-        cleanup_files(c_file, o_file, ctx->keep_files);
-        if (temp_lib_file) {
-            remove(temp_lib_file);
-            free(temp_lib_file);
-        }
+    int len = snprintf(work, sizeof(work), "%s/mikac-pgo-XXXXXX", tmp && *tmp ? tmp : "/tmp");
+    if (len < 0 || (size_t)len >= sizeof(work) || !mkdtemp(work)) {
+        perror("❌ Не удалось создать временный каталог");
         return 1;
     }
-
-    if (temp_lib_file) {
-        remove(temp_lib_file);
-        free(temp_lib_file);
+    len = snprintf(instrumented, sizeof(instrumented), "%s/instrumented", work);
+    if (len < 0 || (size_t)len >= sizeof(instrumented)) {
+        rmdir(work);
+        return 1;
     }
 
+    if (prepare_runtime(ctx, &runtime) != 0) {
+        goto done;
+    }
     if (!ctx->output_file) {
-        ctx->output_file = malloc(strlen(ctx->input_file) + 1);
+        ctx->output_file = replace_extension(ctx->input_files[0], "");
         if (!ctx->output_file) {
             fprintf(stderr, "❌ Ошибка выделения памяти\n");
-            cleanup_files(c_file, o_file, ctx->keep_files);
-            remove(lib_o_file);
-            return 1;
+            goto done;
         }
-        strcpy((char*)ctx->output_file, ctx->input_file);
-        dot = strrchr((char*)ctx->output_file, '.');
-        if (dot) *dot = '\0';
     }
 
+    char* final_output = ctx->output_file;
+    ctx->object_dir = work;
+
     if (ctx->verbose) {
-        printf("   Выходной файл: %s\n", ctx->output_file);
+        printf("\n📈 PGO этап 1: инструментированная сборка\n");
+    }
+    ctx->pgo_phase = PGO_GENERATE;
+    ctx->output_file = instrumented;
+    int failed = build_project(ctx, &runtime) != 0;
+    ctx->output_file = final_output;
+    if (failed) {
+        goto done;
     }
 
     if (ctx->verbose) {
-        printf("\n🔗 Этап 4: Линковка исполняемого файла\n");
+        printf("\n📈 PGO этап 2: обучающий запуск (%s)\n", ctx->pgo_training);
     }
-
-    char link_cmd[MAX_CMD_LENGTH];
-    if (ctx->debug) {
-        sprintf(link_cmd, "gcc %s %s -o '%s' -g", o_file, lib_o_file, ctx->output_file);
-    } else {
-        sprintf(link_cmd, "gcc %s %s -o '%s'", o_file, lib_o_file, ctx->output_file);
+    ArgList run = {0};
+    struct rusage usage;
+    args_add(&run, instrumented);
+    double started = telemetry_now();
+    int status = run_process_redirected(&run, ctx->pgo_training, "/dev/null", ctx->verbose, &usage);
+    args_free(&run);
+    if (status >= 0) {
+        telemetry_add_process(ctx->telemetry, -1, STAGE_TRAINING, telemetry_now() - started, &usage);
     }
-
-    if (execute_command(link_cmd, ctx->verbose) != 0) {
-        fprintf(stderr, "❌ Ошибка линковки\n");
-        cleanup_files(c_file, o_file, ctx->keep_files);
-        remove(lib_o_file);
-        return 1;
+    if (status < 0) {
+        goto done;
+    }
+    if (status != 0) {
+        fprintf(stderr, "⚠️  Обучающий запуск завершился с кодом %d, используем собранный профиль\n", status);
     }
 
-    remove(lib_o_file);
+    if (ctx->verbose) {
+        printf("\n📈 PGO этап 3: сборка с профилем\n");
+    }
+    ctx->pgo_phase = PGO_USE;
+    result = build_project(ctx, &runtime);
 
-    cleanup_files(c_file, o_file, ctx->keep_files);
+done:
+    ctx->object_dir = NULL;
+    remove_work_dir(work);
+    return result;
+}
 
-    if (ctx->verbose) {
-        printf("\n🎉 Компиляция успешно завершена!\n");
-        printf("   Создан исполняемый файл: %s\n", ctx->output_file);
+static int build_once(CompileContext* ctx) {
+    if (ctx->pgo_training) {
+        return compile_pgo(ctx);
+    }
+    if (ctx->whole_program) {
+        return compile_whole(ctx);
+    }
+    if (ctx->input_count == 1 && !ctx->compile_only) {
+        return compile_mika(ctx);
+    }
+    return compile_many(ctx);
+}
 
-        struct stat st;
-        if (stat(ctx->output_file, &st) == 0) {
-            printf("   Размер файла: %ld байт\n", st.st_size);
+/* Между пересборками объектные файлы остаются во временном каталоге,
+   так что после правки одного модуля компилируется только он. */
+static int run_watch(CompileContext* ctx) {
+    char work[PATH_MAX];
+    const char* tmp = getenv("TMPDIR");
+    int incremental = !ctx->compile_only && !ctx->keep_files;
+
+    if (incremental) {
+        int len = snprintf(work, sizeof(work), "%s/mikac-watch-XXXXXX", tmp && *tmp ? tmp : "/tmp");
+        if (len < 0 || (size_t)len >= sizeof(work) || !mkdtemp(work)) {
+            perror("❌ Не удалось создать временный каталог");
+            return 1;
         }
-    } else {
-        printf("✅ Успешно: %s -> %s\n", ctx->input_file, ctx->output_file);
+        ctx->object_dir = work;
+        ctx->incremental = 1;
     }
+    int result = watch_project(ctx, build_once);
+    if (incremental) {
+        ctx->object_dir = NULL;
+        remove_work_dir(work);
+    }
+    return result;
+}
 
-    return 0;
+/* Объекты проекта живут в каталоге демона между запросами; ключ —
+   каталог клиента и аргументы. Одновременные сборки одного проекта
+   выполняются по очереди. */
+static int run_in_daemon(CompileContext* ctx, const char* daemon_dir, int argc, char** argv) {
+    char cwd[PATH_MAX];
+    char dir[PATH_MAX];
+    char lock_path[PATH_MAX + 8];
+    char key[HASH_HEX_SIZE];
+    Hasher hasher;
+
+    if (ctx->compile_only || ctx->keep_files || ctx->pgo_training) {
+        return build_once(ctx);
+    }
+    if (!getcwd(cwd, sizeof(cwd))) {
+        perror("❌ Не удалось определить текущий каталог");
+        return 1;
+    }
+    hasher_init(&hasher);
+    hasher_update_string(&hasher, cwd);
+    for (int i = 1; i < argc; i++) {
+        hasher_update_u64(&hasher, strlen(argv[i]));
+        hasher_update_string(&hasher, argv[i]);
+    }
+    hasher_hex(&hasher, key);
+
+    int len = snprintf(dir, sizeof(dir), "%s/%s", daemon_dir, key);
+    if (len < 0 || (size_t)len >= sizeof(dir) || (mkdir(dir, 0700) != 0 && errno != EEXIST)) {
+        perror("❌ Не удалось создать каталог объектов");
+        return 1;
+    }
+    snprintf(lock_path, sizeof(lock_path), "%s/lock", dir);
+    int lock_fd = open(lock_path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    struct flock lock = {0};
+    lock.l_type = F_WRLCK;
+    lock.l_whence = SEEK_SET;
+    if (lock_fd < 0 || fcntl(lock_fd, F_SETLKW, &lock) != 0) {
+        perror("❌ Не удалось заблокировать каталог объектов");
+        if (lock_fd >= 0) close(lock_fd);
+        return 1;
+    }
+
+    ctx->object_dir = dir;
+    ctx->incremental = 1;
+    int result = build_once(ctx);
+    ctx->object_dir = NULL;
+    close(lock_fd);
+    return result;
 }
 
-int main(int argc, char* argv[]) {
+static int run_daemon(int verbose);
+
+static int run_mikac(int argc, char* argv[], const char* daemon_dir) {
     CompileContext ctx = {0};
-    ctx.compiler_flags = "";
     ctx.verbose = 0;
     ctx.debug = 0;
     ctx.keep_files = 0;
     ctx.compile_only = 0;
-
+    ctx.use_cache = 1;
+    ctx.jobs = 1;
+
+    static const char* const opt_flags[] = {"-O0", "-O1", "-O2", "-O3", "-Os"};
+    static const struct option long_options[] = {
+        {"lto", no_argument, NULL, 'L'},
+        {"pgo", required_argument, NULL, 'P'},
+        {"whole-program", no_argument, NULL, 'U'},
+        {"fast-start", no_argument, NULL, 'F'},
+        {"arena", no_argument, NULL, 'A'},
+        {"instrument", no_argument, NULL, 'I'},
+        {"no-cache", no_argument, NULL, 'C'},
+        {"cache-stats", no_argument, NULL, 'S'},
+        {"time-report", no_argument, NULL, 'T'},
+        {"report-json", required_argument, NULL, 'J'},
+        {"watch", no_argument, NULL, 'W'},
+        {"daemon", no_argument, NULL, 'D'},
+        {"connect", no_argument, NULL, 'N'},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0}
+    };
+
+    int watch = 0;
+    int daemon = 0;
     int opt;
-    while ((opt = getopt(argc, argv, "o:cgkvh")) != -1) {
+    optind = 0;
+    while ((opt = getopt_long(argc, argv, "o:j:O:cgknvh", long_options, NULL)) != -1) {
         switch (opt) {
             case 'o':
                 ctx.output_file = optarg;
                 break;
+            case 'j':
+                ctx.jobs = atoi(optarg);
+                if (ctx.jobs < 1) {
+                    fprintf(stderr, "❌ Ошибка: Некорректное число задач '%s'\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'O':
+                if (strlen(optarg) != 1 || !strchr("0123s", optarg[0])) {
+                    fprintf(stderr, "❌ Ошибка: Неизвестный уровень оптимизации '-O%s'\n", optarg);
+                    return 1;
+                }
+                ctx.opt_flag = opt_flags[strchr("0123s", optarg[0]) - "0123s"];
+                break;
+            case 'L':
+                ctx.lto = 1;
+                break;
+            case 'P':
+                ctx.pgo_training = optarg;
+                break;
+            case 'U':
+                ctx.whole_program = 1;
+                break;
+            case 'F':
+                ctx.fast_start = 1;
+                break;
+            case 'A':
+                ctx.arena = 1;
+                break;
+            case 'I':
+                ctx.instrument = 1;
+                break;
             case 'c':
                 ctx.compile_only = 1;
                 break;
@@ -323,9 +569,32 @@ int main(int argc, char* argv[]) {
             case 'k':
                 ctx.keep_files = 1;
                 break;
+            case 'n':
+                ctx.native = 1;
+                break;
             case 'v':
                 ctx.verbose = 1;
                 break;
+            case 'C':
+                ctx.use_cache = 0;
+                break;
+            case 'S':
+                ctx.cache_stats = 1;
+                break;
+            case 'T':
+                ctx.time_report = 1;
+                break;
+            case 'J':
+                ctx.report_json = optarg;
+                break;
+            case 'W':
+                watch = 1;
+                break;
+            case 'D':
+                daemon = 1;
+                break;
+            case 'N':
+                break;
             case 'h':
                 show_help();
                 return 0;
@@ -335,35 +604,181 @@ int main(int argc, char* argv[]) {
         }
     }
 
+    if ((daemon || watch) && daemon_dir) {
+        fprintf(stderr, "❌ Ошибка: --daemon и --watch нельзя передавать демону сборки\n");
+        return 1;
+    }
+    if (daemon) {
+        return run_daemon(ctx.verbose);
+    }
+
+    if (ctx.cache_stats && optind >= argc) {
+        BuildCache cache;
+        if (build_cache_init(&cache, 0) != 0) {
+            return 1;
+        }
+        build_cache_print_stats(&cache);
+        return 0;
+    }
+
     if (optind >= argc) {
         fprintf(stderr, "❌ Ошибка: Не указан входной файл\n\n");
         show_help();
         return 1;
     }
 
-    ctx.input_file = argv[optind];
+    ctx.input_files = &argv[optind];
+    ctx.input_count = argc - optind;
+    ctx.input_file = ctx.input_files[0];
+
+    for (int i = 0; i < ctx.input_count; i++) {
+        const char* input = ctx.input_files[i];
+        if (!file_exists(input)) {
+            fprintf(stderr, "❌ Ошибка: Файл '%s' не существует\n", input);
+            return 1;
+        }
+
+        const char* ext = strrchr(input, '.');
+        if (!ext || strcmp(ext, ".mk") != 0) {
+            fprintf(stderr, "❌ Ошибка: Файл '%s' должен иметь расширение .mk\n", input);
+            return 1;
+        }
+    }
+
+    if (!ctx.opt_flag) {
+        ctx.opt_flag = ctx.debug ? "-O0" : "-O2";
+    }
 
-    if (!file_exists(ctx.input_file)) {
-        fprintf(stderr, "❌ Ошибка: Файл '%s' не существует\n", ctx.input_file);
+    if (ctx.pgo_training && ctx.compile_only) {
+        fprintf(stderr, "❌ Ошибка: --pgo нельзя использовать с -c\n");
+        return 1;
+    }
+    if (ctx.whole_program && (ctx.compile_only || ctx.pgo_training || ctx.lto)) {
+        fprintf(stderr, "❌ Ошибка: --whole-program нельзя использовать с -c, --pgo и --lto\n");
+        return 1;
+    }
+    if (ctx.fast_start && ctx.lto) {
+        /* библиотека для LTO собрана без -ffunction-sections и с профилировщиком */
+        fprintf(stderr, "❌ Ошибка: --fast-start нельзя использовать с --lto\n");
+        return 1;
+    }
+    if (ctx.pgo_training && !file_exists(ctx.pgo_training)) {
+        fprintf(stderr, "❌ Ошибка: Обучающий файл '%s' не существует\n", ctx.pgo_training);
         return 1;
     }
 
-    const char* ext = strrchr(ctx.input_file, '.');
-    if (!ext || strcmp(ext, ".mk") != 0) {
-        fprintf(stderr, "❌ Ошибка: Файл должен иметь расширение .mk\n");
+    if (ctx.compile_only && ctx.output_file && ctx.input_count > 1) {
+        fprintf(stderr, "❌ Ошибка: -o нельзя использовать с -c для нескольких файлов\n");
+        return 1;
+    }
+    if (watch && (ctx.pgo_training || ctx.time_report || ctx.report_json)) {
+        fprintf(stderr, "❌ Ошибка: --watch нельзя использовать с --pgo, --time-report и --report-json\n");
         return 1;
     }
 
     if (ctx.verbose) {
         printf("🐧 Mika Language Compiler v%s\n", MIKA_VERSION);
-        printf("📁 Компилируем файл: %s\n", ctx.input_file);
+        if (ctx.input_count == 1) {
+            printf("📁 Компилируем файл: %s\n", ctx.input_file);
+        } else {
+            printf("📁 Компилируем файлов: %d\n", ctx.input_count);
+        }
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+
+    BuildTelemetry telemetry;
+    if ((ctx.time_report || ctx.report_json) && telemetry_init(&telemetry, ctx.input_files, ctx.input_count) == 0) {
+        ctx.telemetry = &telemetry;
+    }
+
+    char* given_output = ctx.output_file;
+    int result;
+    if (watch) {
+        result = run_watch(&ctx);
+    } else if (daemon_dir) {
+        result = run_in_daemon(&ctx, daemon_dir, argc, argv);
+    } else {
+        result = build_once(&ctx);
     }
 
-    int result = compile_mika(&ctx);
+    if (ctx.cache_stats) {
+        BuildCache cache;
+        if (build_cache_init(&cache, 0) == 0) {
+            build_cache_print_stats(&cache);
+        }
+    }
 
-    if (ctx.output_file && ctx.output_file != argv[optind]) {
-        free((char*)ctx.output_file);
+    if (ctx.telemetry) {
+        if (ctx.time_report) {
+            telemetry_print(ctx.telemetry, stdout);
+        }
+        if (ctx.report_json && telemetry_write_json(ctx.telemetry, ctx.report_json, result) != 0) {
+            fprintf(stderr, "❌ Не удалось записать отчёт %s\n", ctx.report_json);
+            result = 1;
+        }
+        telemetry_free(ctx.telemetry);
+    }
+
+    if (ctx.output_file != given_output) {
+        free(ctx.output_file);
     }
 
     return result;
 }
+
+static int daemon_request(int argc, char** argv, void* data) {
+    return run_mikac(argc, argv, data);
+}
+
+static int run_daemon(int verbose) {
+    char socket_path[PATH_MAX];
+    char work[PATH_MAX];
+    RuntimeLibrary runtime;
+    const char* tmp = getenv("TMPDIR");
+
+    if (daemon_socket_path(socket_path, sizeof(socket_path)) != 0) {
+        return 1;
+    }
+    int len = snprintf(work, sizeof(work), "%s/mikac-daemon-XXXXXX", tmp && *tmp ? tmp : "/tmp");
+    if (len < 0 || (size_t)len >= sizeof(work) || !mkdtemp(work)) {
+        perror("❌ Не удалось создать временный каталог");
+        return 1;
+    }
+
+    /* Обычная и отладочная библиотеки готовятся заранее: каждая сборка
+       выполняется в копии процесса демона и получает их готовыми. */
+    if (resolve_warm(RUNTIME_RELEASE, verbose, &runtime) != 0 ||
+        resolve_warm(RUNTIME_DEBUG, verbose, &runtime) != 0) {
+        fprintf(stderr, "❌ Ошибка подготовки стандартной библиотеки\n");
+        remove_work_dir(work);
+        return 1;
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+    int result = daemon_serve(socket_path, daemon_request, work);
+    remove_work_dir(work);
+    return result;
+}
+
+int main(int argc, char* argv[]) {
+    /* --connect: отдать сборку демону, если он запущен */
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--") == 0) {
+            break;
+        }
+        if (strcmp(argv[i], "--connect") != 0) {
+            continue;
+        }
+        char socket_path[PATH_MAX];
+        int status;
+        memmove(&argv[i], &argv[i + 1], (size_t)(argc - i) * sizeof(char*));
+        argc--;
+        if (daemon_socket_path(socket_path, sizeof(socket_path)) == 0 &&
+            daemon_forward(socket_path, argc, argv, &status) == 0) {
+            return status;
+        }
+        break;
+    }
+    return run_mikac(argc, argv, NULL);
+}
@@ -0,0 +1,928 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+#include "parser.h"
+
+void parser_init(Parser* parser, Arena* arena, const char* src, size_t len, const char* filename) {
+    lexer_init(&parser->lexer, src, len);
+    parser->arena = arena;
+    parser->filename = filename;
+    parser->pos = 0;
+    parser->count = 0;
+    parser->typedef_count = 0;
+    parser->depth = 0;
+}
+
+static void refill(Parser* p) {
+    int keep = p->count - p->pos;
+    memmove(p->tokens, p->tokens + p->pos, (size_t)keep * sizeof(Token));
+    p->pos = 0;
+    p->count = keep;
+    while (p->count < PARSER_TOKEN_BATCH) {
+        lexer_next(&p->lexer, &p->tokens[p->count++]);
+    }
+}
+
+static inline Token* peek_at(Parser* p, int n) {
+    if (p->pos + n >= p->count) {
+        refill(p);
+    }
+    return &p->tokens[p->pos + n];
+}
+
+static inline Token* peek(Parser* p) {
+    return peek_at(p, 0);
+}
+
+static inline Token advance(Parser* p) {
+    Token tok = *peek(p);
+    p->pos++;
+    return tok;
+}
+
+static int check(Parser* p, TokenKind kind) {
+    return peek(p)->kind == kind;
+}
+
+static int match(Parser* p, TokenKind kind) {
+    if (check(p, kind)) {
+        advance(p);
+        return 1;
+    }
+    return 0;
+}
+
+static int check_keyword(Parser* p, Keyword keyword) {
+    return peek(p)->keyword == keyword;
+}
+
+static void parse_error(Parser* p, const Token* tok, const char* fmt, ...) {
+    va_list args;
+    fprintf(stderr, "%s:%d:%d: ошибка: ", p->filename, tok->line, tok->col);
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
+    if (tok->kind == TOK_EOF) {
+        fprintf(stderr, " (найден конец файла)\n");
+    } else {
+        fprintf(stderr, " (найдено '%.*s')\n", (int)tok->len, tok->start);
+    }
+    longjmp(p->on_error, 1);
+}
+
+static Token expect(Parser* p, TokenKind kind) {
+    if (!check(p, kind)) {
+        parse_error(p, peek(p), "ожидалось '%s'", token_kind_name(kind));
+    }
+    return advance(p);
+}
+
+static void enter_nesting(Parser* p) {
+    if (p->depth >= PARSER_MAX_DEPTH) {
+        parse_error(p, peek(p), "слишком глубокая вложенность: больше %d уровней", PARSER_MAX_DEPTH);
+    }
+    p->depth++;
+}
+
+static Node* parse_nested(Parser* p, Node* (*parse)(Parser*)) {
+    enter_nesting(p);
+    Node* node = parse(p);
+    p->depth--;
+    return node;
+}
+
+static Node* new_node(Parser* p, NodeKind kind, int line) {
+    Node* node = arena_alloc(p->arena, sizeof(Node));
+    memset(node, 0, sizeof(Node));
+    node->kind = kind;
+    node->line = line;
+    return node;
+}
+
+static const char* token_text(Parser* p, const Token* tok) {
+    return arena_strndup(p->arena, tok->start, tok->len);
+}
+
+typedef struct {
+    Node* head;
+    Node* tail;
+} NodeBuilder;
+
+static void builder_add(NodeBuilder* b, Node* node) {
+    if (!node) return;
+    if (b->tail) {
+        b->tail->next = node;
+    } else {
+        b->head = node;
+    }
+    b->tail = node;
+    while (b->tail->next) {
+        b->tail = b->tail->next;
+    }
+}
+
+/* ---------- Типы ---------- */
+
+static int find_typedef(Parser* p, const Token* tok) {
+    for (int i = 0; i < p->typedef_count; i++) {
+        if (p->typedefs[i].len == tok->len && memcmp(p->typedefs[i].start, tok->start, tok->len) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int is_typedef_name(Parser* p, const Token* tok) {
+    return find_typedef(p, tok) >= 0;
+}
+
+static void add_typedef(Parser* p, const Token* name, int record) {
+    if (p->typedef_count < PARSER_MAX_TYPEDEFS) {
+        p->typedefs[p->typedef_count].start = name->start;
+        p->typedefs[p->typedef_count].len = name->len;
+        p->typedefs[p->typedef_count].record = record;
+        p->typedef_count++;
+    }
+}
+
+static int is_type_start_token(Parser* p, const Token* tok) {
+    if (tok->kind != TOK_IDENT) {
+        return 0;
+    }
+    switch (tok->keyword) {
+        case KW_VAR: case KW_CONST: case KW_STATIC: case KW_EXTERN: case KW_INLINE:
+        case KW_STRUCT: case KW_ENUM: case KW_UNION: case KW_TYPE_NAME:
+            return 1;
+        case KW_NONE:
+            return p->typedef_count > 0 && is_typedef_name(p, tok);
+        default:
+            return KW_IS_BASE_TYPE(tok->keyword);
+    }
+}
+
+static int is_type_start(Parser* p) {
+    return is_type_start_token(p, peek(p));
+}
+
+static void parse_type_spec(Parser* p, TypeRef* type) {
+    char name[128];
+    size_t name_len = 0;
+    const Token* start = peek(p);
+    int have_base = 0;
+
+    memset(type, 0, sizeof(*type));
+
+    for (;;) {
+        Token* tok = peek(p);
+        if (tok->kind != TOK_IDENT) {
+            break;
+        }
+
+        Keyword kw = tok->keyword;
+        if (kw == KW_STATIC) {
+            type->storage |= STORAGE_STATIC;
+        } else if (kw == KW_EXTERN) {
+            type->storage |= STORAGE_EXTERN;
+        } else if (kw == KW_INLINE) {
+            type->storage |= STORAGE_INLINE;
+        } else if (kw == KW_CONST) {
+            type->is_const = 1;
+        } else if (kw == KW_VAR && !have_base) {
+            type->is_var = 1;
+            have_base = 1;
+            advance(p);
+            break;
+        } else if (KW_IS_BASE_TYPE(kw)) {
+            if (name_len + tok->len + 2 > sizeof(name)) {
+                parse_error(p, tok, "слишком длинное имя типа");
+            }
+            if (name_len > 0) name[name_len++] = ' ';
+            memcpy(name + name_len, tok->start, tok->len);
+            name_len += tok->len;
+            have_base = 1;
+        } else if (!have_base && (kw == KW_STRUCT || kw == KW_ENUM || kw == KW_UNION)) {
+            Token keyword = advance(p);
+            Token tag = expect(p, TOK_IDENT);
+            name_len = (size_t)snprintf(name, sizeof(name), "%.*s %.*s",
+                                        (int)keyword.len, keyword.start, (int)tag.len, tag.start);
+            have_base = 1;
+            continue;
+        } else if (!have_base && (kw == KW_TYPE_NAME || (kw == KW_NONE && is_typedef_name(p, tok)))) {
+            int index = kw == KW_NONE ? find_typedef(p, tok) : -1;
+            memcpy(name, tok->start, tok->len);
+            name_len = tok->len;
+            have_base = 1;
+            advance(p);
+            /* Particle[] — коллекция записей */
+            if (index >= 0 && p->typedefs[index].record && check(p, TOK_LBRACKET) &&
+                peek_at(p, 1)->kind == TOK_RBRACKET) {
+                advance(p);
+                advance(p);
+                type->records = 1;
+            }
+            break;
+        } else {
+            break;
+        }
+        advance(p);
+    }
+
+    while (check_keyword(p, KW_CONST)) {
+        type->is_const = 1;
+        advance(p);
+    }
+
+    if (type->is_var) {
+        type->name = "var";
+    } else if (have_base) {
+        type->name = arena_strndup(p->arena, name, name_len);
+    } else if (type->is_const) {
+        type->is_var = 1;
+        type->name = "var";
+    } else {
+        parse_error(p, start, "ожидался тип");
+    }
+}
+
+static void parse_pointers(Parser* p, TypeRef* type) {
+    while (match(p, TOK_STAR)) {
+        type->pointers++;
+        while (check_keyword(p, KW_CONST)) {
+            advance(p);
+        }
+    }
+}
+
+/* ---------- Выражения ---------- */
+
+static Node* parse_expr(Parser* p);
+static Node* parse_assign(Parser* p);
+static Node* parse_unary(Parser* p);
+static Node* parse_initializer(Parser* p);
+
+static long long parse_int_value(const Token* tok) {
+    if (tok->start[0] != '0') {
+        unsigned long long value = 0;
+        for (size_t i = 0; i < tok->len && tok->start[i] >= '0' && tok->start[i] <= '9'; i++) {
+            value = value * 10 + (unsigned long long)(tok->start[i] - '0');
+        }
+        return (long long)value;
+    }
+
+    char buf[64];
+    size_t len = tok->len < sizeof(buf) - 1 ? tok->len : sizeof(buf) - 1;
+    memcpy(buf, tok->start, len);
+    buf[len] = '\0';
+    return (long long)strtoull(buf, NULL, 0);
+}
+
+static Node* parse_primary(Parser* p) {
+    Token* tok = peek(p);
+    Node* node;
+
+    switch (tok->kind) {
+        case TOK_INT:
+            node = new_node(p, NODE_INT, tok->line);
+            node->u.lit.text = tok->start;
+            node->u.lit.len = tok->len;
+            node->u.lit.value = parse_int_value(tok);
+            advance(p);
+            return node;
+        case TOK_FLOAT:
+            node = new_node(p, NODE_FLOAT, tok->line);
+            node->u.lit.text = tok->start;
+            node->u.lit.len = tok->len;
+            advance(p);
+            return node;
+        case TOK_CHAR:
+            node = new_node(p, NODE_CHAR, tok->line);
+            node->u.lit.text = tok->start;
+            node->u.lit.len = tok->len;
+            advance(p);
+            return node;
+        case TOK_STRING: {
+            Token first = advance(p);
+            Token last = first;
+            while (check(p, TOK_STRING)) {
+                last = advance(p);
+            }
+            node = new_node(p, NODE_STRING, first.line);
+            node->u.lit.text = first.start;
+            node->u.lit.len = (size_t)(last.start + last.len - first.start);
+            return node;
+        }
+        case TOK_IDENT:
+            if (tok->keyword == KW_TRUE || tok->keyword == KW_FALSE) {
+                node = new_node(p, NODE_BOOL, tok->line);
+                node->u.lit.value = tok->keyword == KW_TRUE;
+                node->u.lit.text = tok->start;
+                node->u.lit.len = tok->len;
+                advance(p);
+                return node;
+            }
+            node = new_node(p, NODE_IDENT, tok->line);
+            node->u.lit.text = tok->start;
+            node->u.lit.len = tok->len;
+            advance(p);
+            return node;
+        case TOK_LPAREN: {
+            advance(p);
+            node = parse_nested(p, parse_expr);
+            expect(p, TOK_RPAREN);
+            return node;
+        }
+        default:
+            parse_error(p, tok, "ожидалось выражение");
+            return NULL;
+    }
+}
+
+/* Цепочки a.b.c, f()() и a[i][j] растут влево, как a + b + c, но
+   проходы идут по ним рекурсией: каждое звено — уровень вложенности */
+static Node* parse_postfix(Parser* p) {
+    Node* node = parse_primary(p);
+    int depth = p->depth;
+
+    for (;;) {
+        Token* tok = peek(p);
+        if (tok->kind == TOK_LPAREN || tok->kind == TOK_LBRACKET || tok->kind == TOK_DOT ||
+            tok->kind == TOK_ARROW || tok->kind == TOK_INC || tok->kind == TOK_DEC) {
+            enter_nesting(p);
+        }
+        if (tok->kind == TOK_LPAREN) {
+            Node* call = new_node(p, NODE_CALL, tok->line);
+            NodeBuilder args = {NULL, NULL};
+            advance(p);
+            if (!check(p, TOK_RPAREN)) {
+                do {
+                    builder_add(&args, parse_nested(p, parse_assign));
+                } while (match(p, TOK_COMMA));
+            }
+            expect(p, TOK_RPAREN);
+            call->u.call.callee = node;
+            call->u.call.args = args.head;
+            node = call;
+        } else if (tok->kind == TOK_LBRACKET) {
+            Node* index = new_node(p, NODE_INDEX, tok->line);
+            advance(p);
+            index->u.index.base = node;
+            index->u.index.index = parse_nested(p, parse_expr);
+            expect(p, TOK_RBRACKET);
+            node = index;
+        } else if (tok->kind == TOK_DOT || tok->kind == TOK_ARROW) {
+            Node* member = new_node(p, NODE_MEMBER, tok->line);
+            Token op = advance(p);
+            Token name = expect(p, TOK_IDENT);
+            member->u.member.base = node;
+            member->u.member.name = token_text(p, &name);
+            member->u.member.arrow = op.kind == TOK_ARROW;
+            node = member;
+        } else if (tok->kind == TOK_INC || tok->kind == TOK_DEC) {
+            Node* postfix = new_node(p, NODE_POSTFIX, tok->line);
+            postfix->u.unary.op = advance(p).kind;
+            postfix->u.unary.operand = node;
+            node = postfix;
+        } else {
+            p->depth = depth;
+            return node;
+        }
+    }
+}
+
+static Node* parse_unary(Parser* p) {
+    Token* tok = peek(p);
+
+    switch (tok->kind) {
+        case TOK_MINUS: case TOK_PLUS: case TOK_BANG: case TOK_TILDE:
+        case TOK_STAR: case TOK_AMP: case TOK_INC: case TOK_DEC: {
+            Node* node = new_node(p, NODE_UNARY, tok->line);
+            node->u.unary.op = advance(p).kind;
+            node->u.unary.operand = parse_nested(p, parse_unary);
+            return node;
+        }
+        case TOK_LPAREN:
+            if (is_type_start_token(p, peek_at(p, 1))) {
+                Node* node = new_node(p, NODE_CAST, tok->line);
+                advance(p);
+                parse_type_spec(p, &node->u.cast.type);
+                parse_pointers(p, &node->u.cast.type);
+                expect(p, TOK_RPAREN);
+                if (check(p, TOK_LBRACE)) {
+                    parse_error(p, peek(p), "составные литералы не поддерживаются");
+                }
+                node->u.cast.expr = parse_nested(p, parse_unary);
+                return node;
+            }
+            return parse_postfix(p);
+        case TOK_IDENT:
+            if (tok->keyword == KW_SIZEOF) {
+                Node* node = new_node(p, NODE_SIZEOF, tok->line);
+                advance(p);
+                if (check(p, TOK_LPAREN) && is_type_start_token(p, peek_at(p, 1))) {
+                    advance(p);
+                    parse_type_spec(p, &node->u.cast.type);
+                    parse_pointers(p, &node->u.cast.type);
+                    expect(p, TOK_RPAREN);
+                } else {
+                    node->u.cast.expr = parse_nested(p, parse_unary);
+                }
+                return node;
+            }
+            return parse_postfix(p);
+        default:
+            return parse_postfix(p);
+    }
+}
+
+static Node* parse_binary(Parser* p, int min_prec) {
+    Node* lhs = parse_unary(p);
+
+    for (;;) {
+        Token* tok = peek(p);
+        int prec = binary_precedence(tok->kind);
+        if (prec <= PREC_TERNARY || prec < min_prec) {
+            return lhs;
+        }
+        Node* node = new_node(p, NODE_BINARY, tok->line);
+        node->u.binary.op = advance(p).kind;
+        node->u.binary.lhs = lhs;
+        node->u.binary.rhs = parse_binary(p, prec + 1);
+        lhs = node;
+    }
+}
+
+static Node* parse_ternary(Parser* p) {
+    Node* cond = parse_binary(p, PREC_OROR);
+    if (!check(p, TOK_QUESTION)) {
+        return cond;
+    }
+    Node* node = new_node(p, NODE_TERNARY, peek(p)->line);
+    advance(p);
+    node->u.cond.cond = cond;
+    node->u.cond.then_branch = parse_nested(p, parse_expr);
+    expect(p, TOK_COLON);
+    node->u.cond.else_branch = parse_nested(p, parse_ternary);
+    return node;
+}
+
+static Node* parse_assign(Parser* p) {
+    Node* lhs = parse_ternary(p);
+    Token* tok = peek(p);
+    if (!is_assign_op(tok->kind)) {
+        return lhs;
+    }
+    Node* node = new_node(p, NODE_ASSIGN, tok->line);
+    node->u.binary.op = advance(p).kind;
+    node->u.binary.lhs = lhs;
+    node->u.binary.rhs = parse_nested(p, parse_assign);
+    return node;
+}
+
+static Node* parse_expr(Parser* p) {
+    Node* lhs = parse_assign(p);
+    while (check(p, TOK_COMMA)) {
+        Node* node = new_node(p, NODE_BINARY, peek(p)->line);
+        node->u.binary.op = advance(p).kind;
+        node->u.binary.lhs = lhs;
+        node->u.binary.rhs = parse_assign(p);
+        lhs = node;
+    }
+    return lhs;
+}
+
+static Node* parse_initializer(Parser* p) {
+    if (!check(p, TOK_LBRACE)) {
+        return parse_assign(p);
+    }
+    Node* node = new_node(p, NODE_INIT_LIST, peek(p)->line);
+    NodeBuilder items = {NULL, NULL};
+    advance(p);
+    while (!check(p, TOK_RBRACE)) {
+        builder_add(&items, parse_nested(p, parse_initializer));
+        if (!match(p, TOK_COMMA)) {
+            break;
+        }
+    }
+    expect(p, TOK_RBRACE);
+    node->u.list.items = items.head;
+    return node;
+}
+
+/* ---------- Объявления ---------- */
+
+static Node* parse_declarator(Parser* p, const TypeRef* base, NodeKind kind, int name_optional) {
+    Node* var = new_node(p, kind, peek(p)->line);
+    NodeBuilder dims = {NULL, NULL};
+
+    var->u.var.type = *base;
+    parse_pointers(p, &var->u.var.type);
+
+    if (check(p, TOK_IDENT)) {
+        Token name = advance(p);
+        var->u.var.name = token_text(p, &name);
+    } else if (!name_optional) {
+        parse_error(p, peek(p), "ожидалось имя переменной");
+    }
+
+    while (check(p, TOK_LBRACKET)) {
+        Token open = advance(p);
+        if (check(p, TOK_RBRACKET)) {
+            builder_add(&dims, new_node(p, NODE_EMPTY, open.line));
+        } else {
+            builder_add(&dims, parse_expr(p));
+        }
+        expect(p, TOK_RBRACKET);
+    }
+    var->u.var.dims = dims.head;
+
+    if (kind == NODE_VAR && match(p, TOK_ASSIGN)) {
+        var->u.var.init = parse_initializer(p);
+    }
+    return var;
+}
+
+static Node* parse_declaration_rest(Parser* p, const TypeRef* base, Node* first, int line) {
+    Node* decl = new_node(p, NODE_DECL, line);
+    NodeBuilder vars = {NULL, NULL};
+
+    decl->u.decl.type = *base;
+    builder_add(&vars, first);
+    while (match(p, TOK_COMMA)) {
+        builder_add(&vars, parse_declarator(p, base, NODE_VAR, 0));
+    }
+    expect(p, TOK_SEMI);
+    decl->u.decl.vars = vars.head;
+    return decl;
+}
+
+static Node* parse_declaration(Parser* p) {
+    TypeRef base;
+    int line = peek(p)->line;
+    parse_type_spec(p, &base);
+    Node* first = parse_declarator(p, &base, NODE_VAR, 0);
+    return parse_declaration_rest(p, &base, first, line);
+}
+
+/* ---------- Операторы ---------- */
+
+static Node* parse_statement(Parser* p);
+
+static Node* parse_block(Parser* p) {
+    Node* block = new_node(p, NODE_BLOCK, peek(p)->line);
+    NodeBuilder items = {NULL, NULL};
+    expect(p, TOK_LBRACE);
+    while (!check(p, TOK_RBRACE)) {
+        if (check(p, TOK_EOF)) {
+            parse_error(p, peek(p), "не закрыт блок '{'");
+        }
+        builder_add(&items, parse_nested(p, parse_statement));
+    }
+    advance(p);
+    block->u.list.items = items.head;
+    return block;
+}
+
+static Node* parse_paren_expr(Parser* p) {
+    expect(p, TOK_LPAREN);
+    Node* expr = parse_expr(p);
+    expect(p, TOK_RPAREN);
+    return expr;
+}
+
+static Node* parse_statement(Parser* p) {
+    Token* tok = peek(p);
+    int line = tok->line;
+    Node* node;
+
+    switch (tok->kind) {
+        case TOK_LBRACE:
+            return parse_block(p);
+        case TOK_SEMI:
+            advance(p);
+            return new_node(p, NODE_EMPTY, line);
+        case TOK_DIRECTIVE:
+            node = new_node(p, NODE_DIRECTIVE, line);
+            node->u.lit.text = tok->start;
+            node->u.lit.len = tok->len;
+            advance(p);
+            return node;
+        case TOK_IDENT:
+            break;
+        default:
+            goto expression;
+    }
+
+    switch (tok->keyword) {
+        case KW_IF: case KW_WHILE: case KW_DO: case KW_FOR: case KW_SWITCH: case KW_CASE:
+        case KW_DEFAULT: case KW_RETURN: case KW_BREAK: case KW_CONTINUE: case KW_PARALLEL:
+            break;
+        default:
+            if (is_type_start(p)) {
+                return parse_declaration(p);
+            }
+            goto expression;
+    }
+
+    if (tok->keyword == KW_IF) {
+        advance(p);
+        node = new_node(p, NODE_IF, line);
+        node->u.cond.cond = parse_paren_expr(p);
+        node->u.cond.then_branch = parse_nested(p, parse_statement);
+        if (check_keyword(p, KW_ELSE)) {
+            advance(p);
+            node->u.cond.else_branch = parse_nested(p, parse_statement);
+        }
+        return node;
+    }
+    if (tok->keyword == KW_WHILE) {
+        advance(p);
+        node = new_node(p, NODE_WHILE, line);
+        node->u.loop.cond = parse_paren_expr(p);
+        node->u.loop.body = parse_nested(p, parse_statement);
+        return node;
+    }
+    if (tok->keyword == KW_DO) {
+        advance(p);
+        node = new_node(p, NODE_DO, line);
+        node->u.loop.body = parse_nested(p, parse_statement);
+        if (!check_keyword(p, KW_WHILE)) {
+            parse_error(p, peek(p), "ожидалось 'while' после тела do");
+        }
+        advance(p);
+        node->u.loop.cond = parse_paren_expr(p);
+        expect(p, TOK_SEMI);
+        return node;
+    }
+    if (tok->keyword == KW_FOR) {
+        advance(p);
+        node = new_node(p, NODE_FOR, line);
+        expect(p, TOK_LPAREN);
+        if (is_type_start(p)) {
+            node->u.loop.init = parse_declaration(p);
+        } else {
+            if (!check(p, TOK_SEMI)) {
+                node->u.loop.init = parse_expr(p);
+            }
+            expect(p, TOK_SEMI);
+        }
+        if (!check(p, TOK_SEMI)) {
+            node->u.loop.cond = parse_expr(p);
+        }
+        expect(p, TOK_SEMI);
+        if (!check(p, TOK_RPAREN)) {
+            node->u.loop.step = parse_expr(p);
+        }
+        expect(p, TOK_RPAREN);
+        node->u.loop.body = parse_nested(p, parse_statement);
+        return node;
+    }
+    if (tok->keyword == KW_PARALLEL) {
+        NodeBuilder clauses = {NULL, NULL};
+        advance(p);
+        if (match(p, TOK_LPAREN)) {
+            do {
+                Token* op = peek(p);
+                if (!token_is(op, "sum") && !token_is(op, "min") && !token_is(op, "max")) {
+                    parse_error(p, op, "ожидалась редукция sum, min или max");
+                }
+                Node* clause = new_node(p, NODE_CALL, op->line);
+                clause->u.call.callee = parse_primary(p);
+                expect(p, TOK_COLON);
+                if (!check(p, TOK_IDENT)) {
+                    parse_error(p, peek(p), "ожидалось имя переменной");
+                }
+                clause->u.call.args = parse_primary(p);
+                builder_add(&clauses, clause);
+            } while (match(p, TOK_COMMA));
+            expect(p, TOK_RPAREN);
+        }
+        if (!check_keyword(p, KW_FOR)) {
+            parse_error(p, peek(p), "ожидалось 'for' после parallel");
+        }
+        node = parse_statement(p);
+        node->kind = NODE_PARALLEL_FOR;
+        node->u.loop.clauses = clauses.head;
+        return node;
+    }
+    if (tok->keyword == KW_SWITCH) {
+        advance(p);
+        node = new_node(p, NODE_SWITCH, line);
+        node->u.loop.cond = parse_paren_expr(p);
+        node->u.loop.body = parse_nested(p, parse_statement);
+        return node;
+    }
+    if (tok->keyword == KW_CASE || tok->keyword == KW_DEFAULT) {
+        int is_default = tok->keyword == KW_DEFAULT;
+        advance(p);
+        node = new_node(p, NODE_CASE, line);
+        if (!is_default) {
+            node->u.ret.value = parse_ternary(p);
+        }
+        expect(p, TOK_COLON);
+        return node;
+    }
+    if (tok->keyword == KW_RETURN) {
+        advance(p);
+        node = new_node(p, NODE_RETURN, line);
+        if (!check(p, TOK_SEMI)) {
+            node->u.ret.value = parse_expr(p);
+        }
+        expect(p, TOK_SEMI);
+        return node;
+    }
+    node = new_node(p, tok->keyword == KW_BREAK ? NODE_BREAK : NODE_CONTINUE, line);
+    advance(p);
+    expect(p, TOK_SEMI);
+    return node;
+
+expression:
+    node = new_node(p, NODE_EXPR_STMT, line);
+    node->u.ret.value = parse_expr(p);
+    expect(p, TOK_SEMI);
+    return node;
+}
+
+/* ---------- Верхний уровень ---------- */
+
+static Node* parse_raw_until_semicolon(Parser* p, int record_typedef) {
+    Token first = *peek(p);
+    Token last = first;
+    Token name = first;
+    name.kind = TOK_EOF;
+    int depth = 0;
+
+    for (;;) {
+        Token tok = advance(p);
+        if (tok.kind == TOK_EOF) {
+            parse_error(p, &tok, "ожидалось ';'");
+        }
+        last = tok;
+        if (tok.kind == TOK_LBRACE || tok.kind == TOK_LPAREN || tok.kind == TOK_LBRACKET) {
+            depth++;
+        } else if (tok.kind == TOK_RBRACE || tok.kind == TOK_RPAREN || tok.kind == TOK_RBRACKET) {
+            depth--;
+        } else if (tok.kind == TOK_IDENT && depth == 0) {
+            name = tok;
+        } else if (tok.kind == TOK_SEMI && depth == 0) {
+            break;
+        }
+    }
+
+    if (record_typedef && name.kind == TOK_IDENT) {
+        add_typedef(p, &name, 0);
+    }
+
+    Node* node = new_node(p, NODE_RAW, first.line);
+    node->u.lit.text = first.start;
+    node->u.lit.len = (size_t)(last.start + last.len - first.start);
+    return node;
+}
+
+/* record Name { поля } или record(aos) Name { ... }: по умолчанию
+   коллекции записей раскладываются по полям (SoA). */
+static Node* parse_record(Parser* p) {
+    Node* node = new_node(p, NODE_RECORD, peek(p)->line);
+    NodeBuilder fields = {NULL, NULL};
+
+    advance(p);
+    if (match(p, TOK_LPAREN)) {
+        Token* layout = peek(p);
+        if (token_is(layout, "aos")) {
+            node->u.record.aos = 1;
+        } else if (!token_is(layout, "soa")) {
+            parse_error(p, layout, "ожидалась раскладка soa или aos");
+        }
+        advance(p);
+        expect(p, TOK_RPAREN);
+    }
+    Token name = expect(p, TOK_IDENT);
+    node->u.record.name = token_text(p, &name);
+    add_typedef(p, &name, 1);
+
+    expect(p, TOK_LBRACE);
+    while (!match(p, TOK_RBRACE)) {
+        TypeRef base;
+        parse_type_spec(p, &base);
+        do {
+            builder_add(&fields, parse_declarator(p, &base, NODE_VAR, 0));
+        } while (match(p, TOK_COMMA));
+        expect(p, TOK_SEMI);
+    }
+    match(p, TOK_SEMI);
+    node->u.record.fields = fields.head;
+    return node;
+}
+
+static Node* parse_params(Parser* p, Node* func) {
+    NodeBuilder params = {NULL, NULL};
+
+    expect(p, TOK_LPAREN);
+    if (check_keyword(p, KW_VOID) && peek_at(p, 1)->kind == TOK_RPAREN) {
+        advance(p);
+    }
+    while (!check(p, TOK_RPAREN)) {
+        if (match(p, TOK_ELLIPSIS)) {
+            func->u.func.variadic = 1;
+            break;
+        }
+        TypeRef base;
+        parse_type_spec(p, &base);
+        builder_add(&params, parse_declarator(p, &base, NODE_PARAM, 1));
+        if (!match(p, TOK_COMMA)) {
+            break;
+        }
+    }
+    expect(p, TOK_RPAREN);
+    return params.head;
+}
+
+static Node* parse_function_rest(Parser* p, Node* func) {
+    func->u.func.params = parse_params(p, func);
+    if (func->u.func.mika_syntax && match(p, TOK_COLON)) {
+        parse_type_spec(p, &func->u.func.ret);
+        parse_pointers(p, &func->u.func.ret);
+    }
+    if (!match(p, TOK_SEMI)) {
+        func->u.func.body = parse_block(p);
+    }
+    return func;
+}
+
+static Node* parse_top_level(Parser* p) {
+    Token* tok = peek(p);
+    int line = tok->line;
+
+    if (tok->kind == TOK_DIRECTIVE) {
+        Node* node = new_node(p, NODE_DIRECTIVE, line);
+        node->u.lit.text = tok->start;
+        node->u.lit.len = tok->len;
+        advance(p);
+        return node;
+    }
+    if (tok->kind == TOK_SEMI) {
+        advance(p);
+        return NULL;
+    }
+    if (tok->kind != TOK_IDENT) {
+        parse_error(p, tok, "ожидалось объявление функции или переменной");
+    }
+
+    if (tok->keyword == KW_TYPEDEF) {
+        return parse_raw_until_semicolon(p, 1);
+    }
+    if ((tok->keyword == KW_STRUCT || tok->keyword == KW_ENUM || tok->keyword == KW_UNION) &&
+        (peek_at(p, 1)->kind == TOK_LBRACE ||
+         (peek_at(p, 1)->kind == TOK_IDENT && peek_at(p, 2)->kind == TOK_LBRACE))) {
+        return parse_raw_until_semicolon(p, 0);
+    }
+
+    if (tok->keyword == KW_RECORD &&
+        (peek_at(p, 1)->kind == TOK_LPAREN ||
+         (peek_at(p, 1)->kind == TOK_IDENT && peek_at(p, 2)->kind == TOK_LBRACE))) {
+        return parse_record(p);
+    }
+
+    if (tok->keyword == KW_FUNCTION) {
+        Node* func = new_node(p, NODE_FUNCTION, line);
+        advance(p);
+        Token name = expect(p, TOK_IDENT);
+        func->u.func.name = token_text(p, &name);
+        func->u.func.ret.name = "function";
+        func->u.func.ret.is_var = 1;
+        func->u.func.mika_syntax = 1;
+        return parse_function_rest(p, func);
+    }
+
+    if (!is_type_start(p)) {
+        parse_error(p, tok, "ожидалось объявление функции или переменной");
+    }
+
+    TypeRef base;
+    parse_type_spec(p, &base);
+    Node* first = parse_declarator(p, &base, NODE_VAR, 0);
+    if (check(p, TOK_LPAREN) && first->u.var.dims == NULL && first->u.var.init == NULL) {
+        Node* func = new_node(p, NODE_FUNCTION, line);
+        func->u.func.name = first->u.var.name;
+        func->u.func.ret = first->u.var.type;
+        return parse_function_rest(p, func);
+    }
+    return parse_declaration_rest(p, &base, first, line);
+}
+
+Node* parse_item(Parser* parser, int* status) {
+    volatile Node* item = NULL;
+
+    *status = 0;
+    parser->depth = 0;
+    if (setjmp(parser->on_error)) {
+        *status = -1;
+        return NULL;
+    }
+
+    while (!item && !check(parser, TOK_EOF)) {
+        item = parse_top_level(parser);
+    }
+    return (Node*)item;
+}
@@ -0,0 +1,32 @@
+#ifndef MIKA_PARSER_H
+#define MIKA_PARSER_H
+
+#include <setjmp.h>
+
+#include "arena.h"
+#include "ast.h"
+#include "lexer.h"
+
+#define PARSER_TOKEN_BATCH 1024
+#define PARSER_MAX_TYPEDEFS 256
+/* Скобки, операторы и блоки глубже этого — ошибка разбора: дерево
+   обходят рекурсивно и парсер, и все следующие проходы */
+#define PARSER_MAX_DEPTH 1000
+
+typedef struct {
+    Lexer lexer;
+    Arena* arena;
+    const char* filename;
+    Token tokens[PARSER_TOKEN_BATCH];
+    int pos;
+    int count;
+    struct { const char* start; size_t len; int record; } typedefs[PARSER_MAX_TYPEDEFS];
+    int typedef_count;
+    int depth;
+    jmp_buf on_error;
+} Parser;
+
+void parser_init(Parser* parser, Arena* arena, const char* src, size_t len, const char* filename);
+Node* parse_item(Parser* parser, int* status);
+
+#endif
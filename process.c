@@ -0,0 +1,167 @@
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <spawn.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+#include "process.h"
+
+extern char** environ;
+
+void args_add(ArgList* args, const char* arg) {
+    if (args->argc + 1 >= args->capacity) {
+        int capacity = args->capacity ? args->capacity * 2 : 32;
+        const char** grown = realloc(args->argv, (size_t)capacity * sizeof(const char*));
+        if (!grown) {
+            args->failed = 1;
+            return;
+        }
+        args->argv = grown;
+        args->capacity = capacity;
+    }
+    args->argv[args->argc++] = arg;
+    args->argv[args->argc] = NULL;
+}
+
+void args_free(ArgList* args) {
+    free(args->argv);
+    args->argv = NULL;
+    args->argc = 0;
+    args->capacity = 0;
+    args->failed = 0;
+}
+
+static int args_ready(const ArgList* args) {
+    if (args->failed || args->argc == 0) {
+        fprintf(stderr, "❌ Ошибка выделения памяти для аргументов команды\n");
+        return 0;
+    }
+    return 1;
+}
+
+pid_t spawn_process(const ArgList* args, int* stdin_fd, int verbose) {
+    posix_spawn_file_actions_t actions;
+    int pipe_fds[2] = {-1, -1};
+    pid_t pid;
+
+    if (!args_ready(args)) {
+        return -1;
+    }
+    if (verbose) {
+        printf("💻 Выполняем:");
+        for (int i = 0; i < args->argc; i++) {
+            printf(" %s", args->argv[i]);
+        }
+        printf("\n");
+        fflush(stdout);
+    }
+
+    posix_spawn_file_actions_init(&actions);
+    if (stdin_fd) {
+        if (pipe(pipe_fds) != 0) {
+            perror("❌ Ошибка создания канала");
+            posix_spawn_file_actions_destroy(&actions);
+            return -1;
+        }
+        /* При -j канал остаётся открытым, пока запускаются следующие gcc:
+           без FD_CLOEXEC они унаследуют его, и этот gcc не дождётся EOF */
+        fcntl(pipe_fds[0], F_SETFD, FD_CLOEXEC);
+        fcntl(pipe_fds[1], F_SETFD, FD_CLOEXEC);
+        posix_spawn_file_actions_adddup2(&actions, pipe_fds[0], STDIN_FILENO);
+        posix_spawn_file_actions_addclose(&actions, pipe_fds[0]);
+        posix_spawn_file_actions_addclose(&actions, pipe_fds[1]);
+    }
+
+    int err = posix_spawnp(&pid, args->argv[0], &actions, NULL, (char* const*)args->argv, environ);
+    posix_spawn_file_actions_destroy(&actions);
+
+    if (stdin_fd) {
+        close(pipe_fds[0]);
+        if (err != 0) {
+            close(pipe_fds[1]);
+        } else {
+            *stdin_fd = pipe_fds[1];
+        }
+    }
+
+    if (err != 0) {
+        fprintf(stderr, "❌ Не удалось запустить %s: %s\n", args->argv[0], strerror(err));
+        return -1;
+    }
+    return pid;
+}
+
+int wait_process(pid_t pid, int verbose) {
+    return wait_process_usage(pid, verbose, NULL);
+}
+
+int wait_process_usage(pid_t pid, int verbose, struct rusage* usage) {
+    int status;
+    if (wait4(pid, &status, 0, usage) < 0) {
+        perror("❌ Ошибка ожидания процесса");
+        return -1;
+    }
+
+    int result = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+    if (verbose) {
+        if (result == 0) {
+            printf("   ✅ Команда выполнена успешно\n");
+        } else {
+            printf("   ❌ Ошибка выполнения команды (код: %d)\n", result);
+        }
+    }
+    return result;
+}
+
+/* waitpid, который заодно возвращает ресурсы, потраченные процессом */
+pid_t reap_process(pid_t pid, int* status, int options, struct rusage* usage) {
+    return wait4(pid, status, options, usage);
+}
+
+int run_process(const ArgList* args, int verbose) {
+    pid_t pid = spawn_process(args, NULL, verbose);
+    if (pid < 0) {
+        return -1;
+    }
+    return wait_process(pid, verbose);
+}
+
+int run_process_redirected(const ArgList* args, const char* stdin_path, const char* stdout_path, int verbose,
+                           struct rusage* usage) {
+    posix_spawn_file_actions_t actions;
+    pid_t pid;
+
+    if (!args_ready(args)) {
+        return -1;
+    }
+    if (verbose) {
+        printf("💻 Выполняем:");
+        for (int i = 0; i < args->argc; i++) {
+            printf(" %s", args->argv[i]);
+        }
+        printf(" < %s > %s\n", stdin_path ? stdin_path : "-", stdout_path ? stdout_path : "-");
+        fflush(stdout);
+    }
+
+    posix_spawn_file_actions_init(&actions);
+    if (stdin_path) {
+        posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, stdin_path, O_RDONLY, 0);
+    }
+    if (stdout_path) {
+        posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, stdout_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    }
+
+    int err = posix_spawnp(&pid, args->argv[0], &actions, NULL, (char* const*)args->argv, environ);
+    posix_spawn_file_actions_destroy(&actions);
+    if (err != 0) {
+        fprintf(stderr, "❌ Не удалось запустить %s: %s\n", args->argv[0], strerror(err));
+        return -1;
+    }
+    return wait_process_usage(pid, verbose, usage);
+}
@@ -0,0 +1,26 @@
+#ifndef MIKA_PROCESS_H
+#define MIKA_PROCESS_H
+
+#include <sys/types.h>
+#include <sys/resource.h>
+
+/* argv растёт по мере добавления: при линковке в нём все объектные
+   файлы проекта. Пустой список — ArgList args = {0}. */
+typedef struct {
+    const char** argv;
+    int argc;
+    int capacity;
+    int failed;
+} ArgList;
+
+void args_add(ArgList* args, const char* arg);
+void args_free(ArgList* args);
+pid_t spawn_process(const ArgList* args, int* stdin_fd, int verbose);
+int wait_process(pid_t pid, int verbose);
+int wait_process_usage(pid_t pid, int verbose, struct rusage* usage);
+pid_t reap_process(pid_t pid, int* status, int options, struct rusage* usage);
+int run_process(const ArgList* args, int verbose);
+int run_process_redirected(const ArgList* args, const char* stdin_path, const char* stdout_path, int verbose,
+                           struct rusage* usage);
+
+#endif
@@ -0,0 +1,207 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "runtime.h"
+#include "cache.h"
+#include "hash.h"
+#include "process.h"
+#include "translate.h"
+
+extern const char mika_std_header_source[];
+extern const char mika_std_library_source[];
+
+typedef struct {
+    const char* name;
+    const char* library;
+    const char* flags[5];
+} VariantInfo;
+
+static const VariantInfo variants[] = {
+    [RUNTIME_RELEASE] = {"release", "libmika_std.a", {"-O2", NULL}},
+    [RUNTIME_DEBUG] = {"debug", "libmika_std_debug.a", {"-O0", "-g", NULL}},
+    [RUNTIME_NATIVE] = {"native", "libmika_std_native.a", {"-O2", "-march=native", NULL}},
+    [RUNTIME_LTO] = {"lto", "libmika_std_lto.a", {"-O2", "-flto", "-ffat-lto-objects", NULL}},
+    [RUNTIME_FAST] = {"fast", "libmika_std_fast.a", {"-O2", "-ffunction-sections", "-fdata-sections",
+                                                     "-DMIKA_FAST_START", NULL}},
+};
+
+static int path_exists(const char* path) {
+    struct stat st;
+    return stat(path, &st) == 0;
+}
+
+static int join_path(char* buffer, size_t size, const char* dir, const char* suffix) {
+    int len = snprintf(buffer, size, "%s%s", dir, suffix);
+    return (len < 0 || (size_t)len >= size) ? -1 : 0;
+}
+
+static int write_text_file(const char* path, const char* text) {
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        return -1;
+    }
+    int failed = fputs(text, file) == EOF;
+    return (fclose(file) != 0 || failed) ? -1 : 0;
+}
+
+static void remove_entry(const char* dir) {
+    char path[PATH_MAX];
+    static const char* const parts[] = {
+        "/include/mika/mika_std.h", "/include/mika/mika_std.c", "/mika_std.o",
+        "/include/mika", "/include", ""
+    };
+    for (size_t i = 0; i < sizeof(parts) / sizeof(parts[0]); i++) {
+        snprintf(path, sizeof(path), "%s%s", dir, parts[i]);
+        remove(path);
+    }
+}
+
+static int build_entry(const VariantInfo* info, const char* entry, int verbose) {
+    char tmp[PATH_MAX], path[PATH_MAX], source[PATH_MAX], include[PATH_MAX], object[PATH_MAX];
+
+    if (join_path(tmp, sizeof(tmp), entry, ".tmpXXXXXX") != 0 || !mkdtemp(tmp)) {
+        perror("❌ Не удалось создать временный каталог кэша");
+        return -1;
+    }
+
+    char header[PATH_MAX];
+    if (join_path(include, sizeof(include), tmp, "/include") != 0 ||
+        join_path(path, sizeof(path), tmp, "/include/mika") != 0 ||
+        join_path(header, sizeof(header), path, "/mika_std.h") != 0 ||
+        join_path(source, sizeof(source), path, "/mika_std.c") != 0 ||
+        join_path(object, sizeof(object), tmp, "/mika_std.o") != 0 ||
+        make_directories(path) != 0) {
+        perror("❌ Не удалось создать каталог кэша");
+        remove_entry(tmp);
+        return -1;
+    }
+
+    if (write_text_file(header, mika_std_header_source) != 0 ||
+        write_text_file(source, mika_std_library_source) != 0) {
+        perror("❌ Не удалось записать исходники библиотеки");
+        remove_entry(tmp);
+        return -1;
+    }
+
+    char include_flag[PATH_MAX + 2];
+    snprintf(include_flag, sizeof(include_flag), "-I%s", include);
+
+    ArgList args = {0};
+    args_add(&args, "gcc");
+    args_add(&args, "-c");
+    args_add(&args, source);
+    args_add(&args, "-o");
+    args_add(&args, object);
+    args_add(&args, include_flag);
+    for (int i = 0; info->flags[i]; i++) {
+        args_add(&args, info->flags[i]);
+    }
+
+    int status = run_process(&args, verbose);
+    args_free(&args);
+    if (status != 0) {
+        fprintf(stderr, "❌ Ошибка компиляции стандартной библиотеки\n");
+        remove_entry(tmp);
+        return -1;
+    }
+
+    if (rename(tmp, entry) != 0) {
+        remove_entry(tmp);
+        if (!path_exists(entry)) {
+            perror("❌ Не удалось опубликовать запись кэша");
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int resolve_cached(const VariantInfo* info, int verbose, RuntimeLibrary* runtime) {
+    char cache[PATH_MAX], entry[PATH_MAX], lock_path[PATH_MAX + 8];
+
+    if (cache_directory(cache, sizeof(cache)) != 0) {
+        return -1;
+    }
+
+    Hasher hasher;
+    char hash[HASH_HEX_SIZE];
+    hasher_init(&hasher);
+    hasher_update_string(&hasher, MIKA_VERSION);
+    hasher_update_string(&hasher, info->name);
+    for (int i = 0; info->flags[i]; i++) {
+        hasher_update_string(&hasher, info->flags[i]);
+    }
+    hasher_update_string(&hasher, mika_std_header_source);
+    hasher_update_string(&hasher, mika_std_library_source);
+    hasher_hex(&hasher, hash);
+
+    char name[64];
+    snprintf(name, sizeof(name), "/mika_std-%s-%.16s", info->name, hash);
+    if (join_path(entry, sizeof(entry), cache, name) != 0 ||
+        join_path(runtime->library, sizeof(runtime->library), entry, "/mika_std.o") != 0 ||
+        join_path(runtime->include_dir, sizeof(runtime->include_dir), entry, "/include") != 0) {
+        fprintf(stderr, "❌ Слишком длинный путь к кэшу: %s\n", cache);
+        return -1;
+    }
+    runtime->cached = 1;
+
+    if (path_exists(runtime->library)) {
+        if (verbose) {
+            printf("   Используем библиотеку из кэша: %s\n", runtime->library);
+        }
+        return 0;
+    }
+
+    join_path(lock_path, sizeof(lock_path), entry, ".lock");
+    int lock_fd = open(lock_path, O_RDWR | O_CREAT, 0644);
+    if (lock_fd < 0) {
+        perror("❌ Не удалось открыть файл блокировки кэша");
+        return -1;
+    }
+
+    struct flock lock = {0};
+    lock.l_type = F_WRLCK;
+    lock.l_whence = SEEK_SET;
+    while (fcntl(lock_fd, F_SETLKW, &lock) != 0) {
+        if (errno != EINTR) {
+            perror("❌ Не удалось заблокировать запись кэша");
+            close(lock_fd);
+            return -1;
+        }
+    }
+
+    int result = 0;
+    if (!path_exists(runtime->library)) {
+        if (verbose) {
+            printf("   Собираем библиотеку (%s) в кэш: %s\n", info->name, entry);
+        }
+        result = build_entry(info, entry, verbose);
+    } else if (verbose) {
+        printf("   Используем библиотеку из кэша: %s\n", runtime->library);
+    }
+
+    close(lock_fd);
+    return result;
+}
+
+int runtime_resolve(RuntimeVariant variant, int verbose, RuntimeLibrary* runtime) {
+    const VariantInfo* info = &variants[variant];
+
+    snprintf(runtime->library, sizeof(runtime->library), "%s/%s", MIKA_LIB_DIR, info->library);
+    runtime->include_dir[0] = '\0';
+    runtime->cached = 0;
+
+    if (path_exists(runtime->library)) {
+        if (verbose) {
+            printf("   Используем предсобранную библиотеку: %s\n", runtime->library);
+        }
+        return 0;
+    }
+    return resolve_cached(info, verbose, runtime);
+}
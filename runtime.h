@@ -0,0 +1,25 @@
+#ifndef MIKA_RUNTIME_H
+#define MIKA_RUNTIME_H
+
+#include <stddef.h>
+#include <limits.h>
+
+#define MIKA_LIB_DIR "/usr/local/lib/mika"
+
+typedef enum {
+    RUNTIME_RELEASE,
+    RUNTIME_DEBUG,
+    RUNTIME_NATIVE,
+    RUNTIME_LTO,
+    RUNTIME_FAST
+} RuntimeVariant;
+
+typedef struct {
+    char library[PATH_MAX];
+    char include_dir[PATH_MAX];
+    int cached;
+} RuntimeLibrary;
+
+int runtime_resolve(RuntimeVariant variant, int verbose, RuntimeLibrary* runtime);
+
+#endif
@@ -0,0 +1,106 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "source.h"
+
+/* Вход из канала или терминала: mmap невозможен, читаем в растущий буфер */
+static char* read_stream(int fd, size_t* out_len) {
+    size_t cap = 64 * 1024;
+    size_t len = 0;
+    char* buf = malloc(cap);
+    if (!buf) {
+        perror("Ошибка выделения памяти");
+        return NULL;
+    }
+    for (;;) {
+        if (len == cap) {
+            char* grown = realloc(buf, cap * 2);
+            if (!grown) {
+                perror("Ошибка выделения памяти");
+                free(buf);
+                return NULL;
+            }
+            buf = grown;
+            cap *= 2;
+        }
+        ssize_t got = read(fd, buf + len, cap - len);
+        if (got == 0) {
+            break;
+        }
+        if (got < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("Ошибка чтения входного файла");
+            free(buf);
+            return NULL;
+        }
+        len += (size_t)got;
+    }
+    *out_len = len;
+    return buf;
+}
+
+int source_open(SourceFile* source, const char* path) {
+    int from_stdin = strcmp(path, "-") == 0;
+    int fd = from_stdin ? STDIN_FILENO : open(path, O_RDONLY);
+    int result = -1;
+
+    source->data = NULL;
+    source->len = 0;
+    source->mapped = 0;
+    if (fd < 0) {
+        perror("Ошибка открытия входного файла");
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        perror("Ошибка чтения входного файла");
+        goto done;
+    }
+
+    /* Обычный файл отображаем в память: лексер сканирует токены прямо в
+       страницах файла, без копии в куче */
+    if (S_ISREG(st.st_mode) && st.st_size > 0) {
+        void* mapped = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped != MAP_FAILED) {
+            posix_madvise(mapped, (size_t)st.st_size, POSIX_MADV_SEQUENTIAL);
+            source->data = mapped;
+            source->len = (size_t)st.st_size;
+            source->mapped = 1;
+        }
+    }
+    if (!source->data) {
+        source->data = read_stream(fd, &source->len);
+        if (!source->data) {
+            goto done;
+        }
+    }
+    result = 0;
+
+done:
+    if (!from_stdin) {
+        close(fd);
+    }
+    return result;
+}
+
+void source_close(SourceFile* source) {
+    if (source->mapped) {
+        munmap((void*)source->data, source->len);
+    } else {
+        free((void*)source->data);
+    }
+    source->data = NULL;
+    source->len = 0;
+    source->mapped = 0;
+}
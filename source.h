@@ -0,0 +1,17 @@
+#ifndef MIKA_SOURCE_H
+#define MIKA_SOURCE_H
+
+#include <stddef.h>
+
+/* Исходный текст целиком в памяти: обычный файл отображается через mmap,
+   канал или терминал дочитывается в буфер. Путь "-" — стандартный ввод. */
+typedef struct {
+    const char* data;
+    size_t len;
+    int mapped;
+} SourceFile;
+
+int source_open(SourceFile* source, const char* path);
+void source_close(SourceFile* source);
+
+#endif
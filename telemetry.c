@@ -0,0 +1,254 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "telemetry.h"
+#include "translate.h"
+
+static const char* const stage_keys[STAGE_COUNT] = {
+    [STAGE_STDLIB] = "stdlib",
+    [STAGE_TRANSLATE] = "translate",
+    [STAGE_COMPILE] = "compile",
+    [STAGE_COMPILE_LINK] = "compile_link",
+    [STAGE_LINK] = "link",
+    [STAGE_TRAINING] = "pgo_training",
+};
+
+static const char* const stage_names[STAGE_COUNT] = {
+    [STAGE_STDLIB] = "стандартная библиотека",
+    [STAGE_TRANSLATE] = "трансляция Mika -> C",
+    [STAGE_COMPILE] = "компиляция C",
+    [STAGE_COMPILE_LINK] = "компиляция и линковка",
+    [STAGE_LINK] = "линковка",
+    [STAGE_TRAINING] = "обучающий запуск PGO",
+};
+
+static double seconds(struct timeval tv) {
+    return (double)tv.tv_sec + (double)tv.tv_usec / 1e6;
+}
+
+double telemetry_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+int telemetry_init(BuildTelemetry* telemetry, char** inputs, int count) {
+    memset(telemetry, 0, sizeof(*telemetry));
+    telemetry->start = telemetry_now();
+    telemetry->inputs = calloc((size_t)count, sizeof(InputTiming));
+    if (!telemetry->inputs) {
+        return -1;
+    }
+    telemetry->input_count = count;
+    for (int i = 0; i < count; i++) {
+        telemetry->inputs[i].input = inputs[i];
+    }
+    return 0;
+}
+
+void telemetry_free(BuildTelemetry* telemetry) {
+    free(telemetry->inputs);
+    telemetry->inputs = NULL;
+}
+
+/* input < 0 — этап всей сборки, а не отдельного файла */
+static StageTiming* stage_slot(BuildTelemetry* telemetry, int input, BuildStage stage) {
+    if (input >= 0 && input < telemetry->input_count) {
+        return &telemetry->inputs[input].stages[stage];
+    }
+    return &telemetry->project.stages[stage];
+}
+
+void telemetry_start(StageClock* clock) {
+    clock->wall = telemetry_now();
+    getrusage(RUSAGE_SELF, &clock->self);
+    getrusage(RUSAGE_CHILDREN, &clock->children);
+}
+
+static void add_usage(StageTiming* timing, const struct rusage* now, const struct rusage* before) {
+    timing->user += seconds(now->ru_utime) - (before ? seconds(before->ru_utime) : 0.0);
+    timing->system += seconds(now->ru_stime) - (before ? seconds(before->ru_stime) : 0.0);
+    timing->minor_faults += now->ru_minflt - (before ? before->ru_minflt : 0);
+    timing->major_faults += now->ru_majflt - (before ? before->ru_majflt : 0);
+    if (now->ru_maxrss > timing->max_rss_kb) {
+        timing->max_rss_kb = now->ru_maxrss;
+    }
+}
+
+/* ru_maxrss дочерних процессов — пик самого большого из них за всё время,
+   поэтому для участка с дочерними процессами это оценка сверху. */
+void telemetry_stop(BuildTelemetry* telemetry, int input, BuildStage stage, const StageClock* clock, int who) {
+    if (!telemetry) {
+        return;
+    }
+    StageTiming* timing = stage_slot(telemetry, input, stage);
+    struct rusage now;
+
+    timing->runs++;
+    timing->wall += telemetry_now() - clock->wall;
+    if (who & TIME_SELF) {
+        getrusage(RUSAGE_SELF, &now);
+        add_usage(timing, &now, &clock->self);
+    }
+    if (who & TIME_CHILDREN) {
+        getrusage(RUSAGE_CHILDREN, &now);
+        add_usage(timing, &now, &clock->children);
+    }
+}
+
+void telemetry_add_process(BuildTelemetry* telemetry, int input, BuildStage stage, double wall,
+                           const struct rusage* usage) {
+    if (!telemetry) {
+        return;
+    }
+    StageTiming* timing = stage_slot(telemetry, input, stage);
+    timing->runs++;
+    timing->wall += wall;
+    add_usage(timing, usage, NULL);
+}
+
+void telemetry_mark_cached(BuildTelemetry* telemetry, int input) {
+    if (telemetry && input >= 0 && input < telemetry->input_count) {
+        telemetry->inputs[input].cached = 1;
+    }
+}
+
+static void merge_timing(StageTiming* total, const StageTiming* part) {
+    total->runs += part->runs;
+    total->wall += part->wall;
+    total->user += part->user;
+    total->system += part->system;
+    total->minor_faults += part->minor_faults;
+    total->major_faults += part->major_faults;
+    if (part->max_rss_kb > total->max_rss_kb) {
+        total->max_rss_kb = part->max_rss_kb;
+    }
+}
+
+static void stage_totals(const BuildTelemetry* telemetry, StageTiming totals[STAGE_COUNT]) {
+    memcpy(totals, telemetry->project.stages, sizeof(StageTiming) * STAGE_COUNT);
+    for (int i = 0; i < telemetry->input_count; i++) {
+        for (int s = 0; s < STAGE_COUNT; s++) {
+            merge_timing(&totals[s], &telemetry->inputs[i].stages[s]);
+        }
+    }
+}
+
+static void print_row(FILE* out, const StageTiming* timing, const char* label, const char* input) {
+    fprintf(out, "%10.1f %10.1f %10.1f %12ld %9ld/%-6ld %s%s%s\n",
+            timing->wall * 1e3, timing->user * 1e3, timing->system * 1e3,
+            timing->max_rss_kb, timing->minor_faults, timing->major_faults,
+            label, input ? ": " : "", input ? input : "");
+}
+
+void telemetry_print(const BuildTelemetry* telemetry, FILE* out) {
+    StageTiming totals[STAGE_COUNT];
+    StageTiming whole = {0};
+    struct rusage usage;
+
+    stage_totals(telemetry, totals);
+    whole.wall = telemetry_now() - telemetry->start;
+    getrusage(RUSAGE_SELF, &usage);
+    add_usage(&whole, &usage, NULL);
+    getrusage(RUSAGE_CHILDREN, &usage);
+    add_usage(&whole, &usage, NULL);
+
+    /* Подписи выровнены вручную: printf считает байты, а не буквы */
+    fprintf(out, "\n⏱️  Время по этапам сборки\n");
+    fprintf(out, "  стена,мс  польз.,мс   сист.,мс  макс.RSS,КБ  сбои мин/макс  этап\n");
+    for (int s = 0; s < STAGE_COUNT; s++) {
+        if (totals[s].runs > 0) {
+            print_row(out, &totals[s], stage_names[s], NULL);
+        }
+    }
+    if (telemetry->input_count > 1) {
+        for (int i = 0; i < telemetry->input_count; i++) {
+            for (int s = 0; s < STAGE_COUNT; s++) {
+                if (telemetry->inputs[i].stages[s].runs > 0) {
+                    print_row(out, &telemetry->inputs[i].stages[s], stage_names[s], telemetry->inputs[i].input);
+                }
+            }
+        }
+    }
+    print_row(out, &whole, "всего, mikac и дочерние процессы", NULL);
+
+    int cached = 0;
+    for (int i = 0; i < telemetry->input_count; i++) {
+        cached += telemetry->inputs[i].cached;
+    }
+    if (cached > 0) {
+        fprintf(out, "   Из кэша сборки: %d из %d файлов\n", cached, telemetry->input_count);
+    }
+}
+
+static void write_json_string(FILE* out, const char* text) {
+    fputc('"', out);
+    for (const unsigned char* c = (const unsigned char*)text; *c; c++) {
+        if (*c == '"' || *c == '\\') {
+            fprintf(out, "\\%c", *c);
+        } else if (*c < 0x20) {
+            fprintf(out, "\\u%04x", *c);
+        } else {
+            fputc(*c, out);
+        }
+    }
+    fputc('"', out);
+}
+
+static void write_json_timing(FILE* out, const StageTiming* timing) {
+    fprintf(out, "{\"runs\": %d, \"wall_ms\": %.3f, \"user_ms\": %.3f, \"system_ms\": %.3f, "
+            "\"max_rss_kb\": %ld, \"minor_faults\": %ld, \"major_faults\": %ld}",
+            timing->runs, timing->wall * 1e3, timing->user * 1e3, timing->system * 1e3,
+            timing->max_rss_kb, timing->minor_faults, timing->major_faults);
+}
+
+static void write_json_stages(FILE* out, const StageTiming stages[STAGE_COUNT], const char* indent) {
+    const char* separator = "";
+    fputc('{', out);
+    for (int s = 0; s < STAGE_COUNT; s++) {
+        if (stages[s].runs > 0) {
+            fprintf(out, "%s\n%s  \"%s\": ", separator, indent, stage_keys[s]);
+            write_json_timing(out, &stages[s]);
+            separator = ",";
+        }
+    }
+    fprintf(out, "%s%s}", *separator ? "\n" : "", *separator ? indent : "");
+}
+
+int telemetry_write_json(const BuildTelemetry* telemetry, const char* path, int status) {
+    StageTiming totals[STAGE_COUNT];
+    StageTiming whole = {0};
+    struct rusage usage;
+    FILE* out = fopen(path, "w");
+
+    if (!out) {
+        return -1;
+    }
+    stage_totals(telemetry, totals);
+    whole.runs = 1;
+    whole.wall = telemetry_now() - telemetry->start;
+    getrusage(RUSAGE_SELF, &usage);
+    add_usage(&whole, &usage, NULL);
+    getrusage(RUSAGE_CHILDREN, &usage);
+    add_usage(&whole, &usage, NULL);
+
+    fprintf(out, "{\n  \"version\": \"%s\",\n  \"status\": %d,\n  \"total\": ", MIKA_VERSION, status);
+    write_json_timing(out, &whole);
+    fprintf(out, ",\n  \"stages\": ");
+    write_json_stages(out, totals, "  ");
+    fprintf(out, ",\n  \"inputs\": [");
+    for (int i = 0; i < telemetry->input_count; i++) {
+        const InputTiming* input = &telemetry->inputs[i];
+        fprintf(out, "%s\n    {\"file\": ", i ? "," : "");
+        write_json_string(out, input->input);
+        fprintf(out, ", \"cached\": %s, \"stages\": ", input->cached ? "true" : "false");
+        write_json_stages(out, input->stages, "    ");
+        fputc('}', out);
+    }
+    fprintf(out, "%s]\n}\n", telemetry->input_count ? "\n  " : "");
+    return fclose(out) != 0 ? -1 : 0;
+}
@@ -0,0 +1,61 @@
+#ifndef MIKA_TELEMETRY_H
+#define MIKA_TELEMETRY_H
+
+#include <stdio.h>
+#include <sys/resource.h>
+
+typedef enum {
+    STAGE_STDLIB,
+    STAGE_TRANSLATE,
+    STAGE_COMPILE,
+    STAGE_COMPILE_LINK,
+    STAGE_LINK,
+    STAGE_TRAINING,
+    STAGE_COUNT
+} BuildStage;
+
+/* Какие процессы учитывать при замере участка */
+#define TIME_SELF 1
+#define TIME_CHILDREN 2
+
+typedef struct {
+    int runs;
+    double wall;
+    double user;
+    double system;
+    long max_rss_kb;
+    long minor_faults;
+    long major_faults;
+} StageTiming;
+
+typedef struct {
+    const char* input;
+    int cached;
+    StageTiming stages[STAGE_COUNT];
+} InputTiming;
+
+typedef struct {
+    double start;
+    InputTiming project;
+    InputTiming* inputs;
+    int input_count;
+} BuildTelemetry;
+
+typedef struct {
+    double wall;
+    struct rusage self;
+    struct rusage children;
+} StageClock;
+
+double telemetry_now(void);
+int telemetry_init(BuildTelemetry* telemetry, char** inputs, int count);
+void telemetry_free(BuildTelemetry* telemetry);
+void telemetry_start(StageClock* clock);
+void telemetry_stop(BuildTelemetry* telemetry, int input, BuildStage stage, const StageClock* clock, int who);
+void telemetry_add_process(BuildTelemetry* telemetry, int input, BuildStage stage, double wall,
+                           const struct rusage* usage);
+void telemetry_mark_cached(BuildTelemetry* telemetry, int input);
+void telemetry_print(const BuildTelemetry* telemetry, FILE* out);
+int telemetry_write_json(const BuildTelemetry* telemetry, const char* path, int status);
+
+#endif
@@ -0,0 +1,43 @@
+#include <System>
+
+// char, short, bool и float в mika run сужаются при записи так же, как в C
+
+function to_bool(var x): bool {
+    return x;
+}
+
+function half(float x): float {
+    return x / 3;
+}
+
+function main() {
+    bool b = 5;
+    bool z = 0.25;
+    var big = 300;
+    char ch = big;
+    short s = 40000;
+    float f = 0.1;
+    print("%d %d %d %d %.10f\n", b, z, ch, s, f);
+
+    ch += 100;
+    s *= 3;
+    b--;
+    f = f * 3 + 1;
+    print("%d %d %d %.10f\n", ch, s, b, f);
+
+    ch = 127;
+    ch++;
+    s = -32768;
+    s--;
+    f += 16777216;
+    print("%d %d %.1f %d\n", ch, s, f, f == 16777217);
+
+    float third = half(1);
+    float sum = 0;
+    for (var i = 0; i < 10; i++) {
+        sum += third;
+    }
+    print("%.10f %.10f %d %d\n", third, sum, to_bool(-7), (char)200 + (short)70000);
+    print("%d %.10f\n", (bool)0.5 + !f, (float)1 / 7);
+    return 0;
+}
@@ -0,0 +1,11 @@
+#include <System>
+
+// len() массива фиксированного размера — его объявленная длина
+
+int fixed[10];
+
+function main() {
+    int local[4];
+    print("%d %d\n", len(local), len(fixed));
+    return 0;
+}
@@ -0,0 +1,14 @@
+#include <System>
+
+// power() с постоянным показателем переполняется по модулю 2^32, как в рантайме
+
+function main() {
+    var x = input();
+    var h = 0;
+    for (var i = 0; i < 4; i++) {
+        h = h * 31 + power(x + i, 16);
+    }
+    print("%d %d %d %d\n", power(x, 16), power(x, 3), power(-x, 11), h);
+    print("%d %d\n", power(7, 16), power(x, 1));
+    return 0;
+}
@@ -0,0 +1,63 @@
+#include <System>
+
+// Записи: раскладка по столбцам и AoS, копирование и параллельная сумма
+
+record Particle {
+    f64 x, y;
+    f64 vx, vy;
+    i32 alive;
+}
+
+record(aos) Cell {
+    i64 count;
+    f32 weight;
+}
+
+function advance(Particle[] ps, f64 dt) {
+    for (var i = 0; i < len(ps); i++) {
+        ps[i].x += ps[i].vx * dt;
+        ps[i].y += ps[i].vy * dt;
+    }
+}
+
+function sum_x(Particle[] ps): f64 {
+    var total = 0.0;
+    for (var i = 0; i < len(ps); i++) {
+        total += ps[i].x;
+    }
+    return total;
+}
+
+function main() {
+    var n = 1000;
+    var ps = records(Particle, n);
+    for (var i = 0; i < n; i++) {
+        ps[i].x = i;
+        ps[i].vx = 1.0;
+        ps[i].vy = -0.5;
+        ps[i].alive = i % 2;
+    }
+    advance(ps, 2.0);
+    var p = ps[10];
+    var px = p.x;
+    var first = ps[3].y;
+    ps[0] = p;
+    print("%.1f %.1f %.1f %.1f %d\n", sum_x(ps), px, first, ps[0].x, ps[0].alive);
+
+    var cells = records(Cell, 4);
+    cells[2].count = 5000000000;
+    cells[2].weight = 1.5f;
+    var c = cells[2];
+    var big = cells[2].count;
+    print("%lld %.1f %lld %d\n", (long long)c.count, cells[2].weight, (long long)big, len(cells));
+
+    var partial = 0.0;
+    parallel(sum: partial) for (var i = 0; i < n; i++) {
+        partial += ps[i].vx;
+    }
+    print("%.1f\n", partial);
+    records_free(ps);
+    records_free(cells);
+    print("%d\n", len(ps));
+    return 0;
+}
@@ -0,0 +1,23 @@
+#include <System>
+
+// Имена, занятые внутри рантайма, свободны для программы и с --whole-program
+
+var stats = 0;
+var arena = 1;
+var kernels = 2;
+var instrumented = 3;
+
+function prompt(var x) { return x + 1; }
+function steal(var x) { return x * 2; }
+function now_ns() { return 7; }
+function skip_spaces(var x) { return x - 1; }
+function add_row(var x) { return x + 10; }
+function worker_main(var x) { return x + 100; }
+
+function main() {
+    var in = input();
+    var out = in + stats + arena + kernels + instrumented;
+    out += prompt(1) + steal(2) + now_ns() + skip_spaces(3) + add_row(4) + worker_main(5);
+    print("%d\n", out);
+    return 0;
+}
@@ -0,0 +1,31 @@
+#include <System>
+
+// i8, i16 и f32 в mika run сужаются при записи так же, как в скомпилированной программе
+
+function wrap(i8 x): i8 {
+    return x + 1;
+}
+
+function main() {
+    f32 x = 0.1;
+    i16 h = 40000;
+    i8 a = 120;
+    a += 10;
+    print("%.10f %d %d\n", x, h, a);
+
+    i8 m = wrap(127);
+    i16 n = h * 2;
+    n -= 1;
+    f32 y = x * x;
+    var widened = a;
+    widened += 1000;
+    print("%d %d %.12f %d\n", m, n, y, widened);
+
+    f32 acc = 0;
+    for (var i = 0; i < 1000; i++) {
+        acc += x;
+    }
+    i8 c = acc;
+    print("%.6f %d %d\n", acc, c, (i8)255 + (i16)65535);
+    return 0;
+}
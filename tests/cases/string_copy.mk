@@ -0,0 +1,22 @@
+#include <System>
+
+// Копия строки владеет своим буфером: освобождение исходной её не портит
+
+function main() {
+    string_builder b;
+    append(b, "a long string ");
+    append(b, "that does not fit inline");
+    string s = to_string(b);
+    string t = s;
+    var u = s;
+    string v;
+    v = s;
+    string w = substring(s, 2, 6);
+    string_free(s);
+    print("%s|%s|%s|%s\n", t, u, v, w);
+    string_free(t);
+    string_free(u);
+    string_free(v);
+    string_free(w);
+    return 0;
+}
@@ -0,0 +1,12 @@
+#include <System>
+
+// Тип var в main не должен зависеть от глобальных объявлений с общим адресом в арене
+
+var g = 3000000000;
+var a = 1, b = 2.5;
+
+function main() {
+    var z = g * 2;
+    print("%lld\n", z);
+    return 0;
+}
@@ -0,0 +1,253 @@
+#!/bin/sh
+# Регрессионные тесты: каждая программа собирается mikac (раздельно и с
+# --whole-program) и выполняется в mika run, вывод всех трёх запусков
+# сравнивается с ожидаемым.
+#   tests/bench/<имя>.in, .out  — программы из bench/programs на малых входах
+#   tests/cases/<имя>.mk, .out  — повторы исправленных ошибок (.in по желанию)
+# Большие исходники (длинные цепочки, глубокая вложенность, сотни функций и
+# модулей) генерируются здесь же.
+# Использование: run.sh [имя ...]
+
+here=$(cd "$(dirname "$0")" && pwd)
+root=$(cd "$here/.." && pwd)
+mikac=${MIKAC:-$root/mikac}
+mika=${MIKA:-$root/mika}
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+# record в mika run не поддерживается
+compiled_only="records wide_record"
+
+passed=0
+failed=0
+
+selected() {
+    [ $# -eq 1 ] && return 0
+    name=$1
+    shift
+    for want in "$@"; do
+        [ "$want" = "$name" ] && return 0
+    done
+    return 1
+}
+
+fail() {
+    echo "❌ $1: $2"
+    ok=0
+}
+
+count() {
+    if [ $ok -eq 1 ]; then
+        passed=$((passed + 1))
+    else
+        failed=$((failed + 1))
+    fi
+}
+
+# run <имя> <вход> <ожидаемый вывод> <файл.mk> [файл.mk ...]
+run() {
+    name=$1
+    input=$2
+    expected=$3
+    shift 3
+    ok=1
+    for mode in separate whole vm; do
+        built=0
+        case $mode in
+        separate)
+            "$mikac" --no-cache -j 80 -o "$work/$name" "$@" > "$work/$name.build" 2>&1
+            built=$? ;;
+        whole)
+            "$mikac" --no-cache --whole-program -o "$work/$name" "$@" > "$work/$name.build" 2>&1
+            built=$? ;;
+        vm)
+            case " $compiled_only " in *" $name "*) continue ;; esac
+            [ $# -eq 1 ] || continue ;;
+        esac
+        if [ $built -ne 0 ]; then
+            fail "$name" "сборка ($mode) не удалась"
+            sed 's/^/    /' "$work/$name.build"
+            continue
+        fi
+        if [ $mode = vm ]; then
+            "$mika" run "$1" < "$input" > "$work/$name.out"
+        else
+            "$work/$name" < "$input" > "$work/$name.out"
+        fi
+        status=$?
+        if [ $status -ne 0 ]; then
+            fail "$name" "код возврата $status ($mode)"
+        elif ! diff -u "$expected" "$work/$name.out" > "$work/$name.diff"; then
+            fail "$name" "вывод не совпадает с ожидаемым ($mode)"
+            sed 's/^/    /' "$work/$name.diff"
+        fi
+    done
+    count
+}
+
+# reject <имя> <текст ошибки> <файл.mk>: и mikac, и mika run должны отказать
+reject() {
+    name=$1
+    message=$2
+    source=$3
+    ok=1
+    "$mikac" --no-cache -o "$work/$name" "$source" > "$work/$name.err" 2>&1 < /dev/null
+    compiled=$?
+    "$mika" run "$source" >> "$work/$name.err" 2>&1 < /dev/null
+    interpreted=$?
+    if [ $compiled -eq 0 ] || [ $interpreted -eq 0 ]; then
+        fail "$name" "программа с ошибкой принята"
+    elif [ "$(grep -c "$message" "$work/$name.err")" -ne 2 ]; then
+        fail "$name" "нет сообщения «$message»"
+        sed 's/^/    /' "$work/$name.err"
+    fi
+    count
+}
+
+for source in "$root"/bench/programs/*.mk; do
+    name=$(basename "$source" .mk)
+    selected "$name" "$@" || continue
+    run "$name" "$here/bench/$name.in" "$here/bench/$name.out" "$source"
+done
+
+for source in "$here"/cases/*.mk; do
+    name=$(basename "$source" .mk)
+    selected "$name" "$@" || continue
+    input=/dev/null
+    [ -f "$here/cases/$name.in" ] && input=$here/cases/$name.in
+    run "$name" "$input" "$here/cases/$name.out" "$source"
+done
+
+# Цепочки из 50000 операторов разбираются без рекурсии
+if selected chains "$@"; then
+    awk 'BEGIN {
+        print "#include <System>\n\nfunction main() {"
+        printf "    var x = 0"
+        for (i = 0; i < 50000; i++) printf " + 1"
+        printf ";\n    if (x"
+        for (i = 0; i < 50000; i++) printf " && 1"
+        print ") print(\"%d\\n\", x);\n    return 0;\n}"
+    }' > "$work/chains.mk"
+    echo 50000 > "$work/chains.expected"
+    run chains /dev/null "$work/chains.expected" "$work/chains.mk"
+fi
+
+# Слишком глубокая вложенность — ошибка с позицией, а не переполнение стека
+if selected nesting "$@"; then
+    awk 'BEGIN {
+        printf "#include <System>\n\nfunction main() {\n    var x = "
+        for (i = 0; i < 30000; i++) printf "("
+        printf "1"
+        for (i = 0; i < 30000; i++) printf ")"
+        print ";\n    return x;\n}"
+    }' > "$work/nesting.mk"
+    reject nesting "nesting.mk:4:1013: ошибка: слишком глубокая вложенность" "$work/nesting.mk"
+fi
+
+# Сотни функций с типом результата: таблица имён не ограничена
+if selected many_typed "$@"; then
+    awk 'BEGIN {
+        print "#include <System>\n"
+        for (i = 0; i < 600; i++) {
+            print "function f" i "(var x): f64 {\n    return x * " i " + 0.5;\n}\n"
+        }
+        print "function main() {\n    var total = 0.0;"
+        for (i = 0; i < 600; i++) print "    total += f" i "(1);"
+        print "    print(\"%.1f\\n\", total);\n    return 0;\n}"
+    }' > "$work/many_typed.mk"
+    echo 180000.0 > "$work/many_typed.expected"
+    run many_typed /dev/null "$work/many_typed.expected" "$work/many_typed.mk"
+fi
+
+# Запись с предельным числом полей и длинными именами: буфер текста растёт
+if selected wide_record "$@"; then
+    awk 'BEGIN {
+        long = "with_a_rather_long_name_that_fills_the_limit_"
+        print "#include <System>\n\nrecord Wide {"
+        for (i = 0; i < 32; i++) print "    i64 field_" long i ";"
+        print "}\n\nfunction main() {\n    var w = records(Wide, 3);"
+        for (i = 0; i < 32; i++) print "    w[1].field_" long i " = " i ";"
+        print "    var total = 0;"
+        for (i = 0; i < 32; i++) print "    total += w[1].field_" long i ";"
+        print "    print(\"%d\\n\", total);\n    records_free(w);\n    return 0;\n}"
+    }' > "$work/wide_record.mk"
+    echo 496 > "$work/wide_record.expected"
+    run wide_record /dev/null "$work/wide_record.expected" "$work/wide_record.mk"
+fi
+
+# Проект из 70 модулей: объектов и задач больше, чем аргументов по умолчанию
+if selected modules "$@"; then
+    mkdir "$work/modules.src"
+    awk -v dir="$work/modules.src" 'BEGIN {
+        main = dir "/main.mk"
+        print "#include <System>\n" > main
+        for (i = 0; i < 70; i++) {
+            part = dir "/part_" i ".mk"
+            print "function part_" i "(var x) {\n    return x + " i ";\n}" > part
+            close(part)
+            print "function part_" i "(var x);" > main
+        }
+        print "\nfunction main() {\n    var total = 0;" > main
+        for (i = 0; i < 70; i++) print "    total += part_" i "(1);" > main
+        print "    print(\"%d\\n\", total);\n    return 0;\n}" > main
+    }'
+    echo 2485 > "$work/modules.expected"
+    run modules /dev/null "$work/modules.expected" "$work/modules.src/main.mk" "$work"/modules.src/part_*.mk
+fi
+
+# При -j каждый gcc видит только свой канал на stdin, а не каналы соседей
+if selected parallel_fds "$@"; then
+    mkdir "$work/fds.bin" "$work/fds.src"
+    cat > "$work/fds.bin/gcc" <<SH
+#!/bin/sh
+for fd in /proc/\$\$/fd/*; do
+    [ "\${fd##*/}" -gt 2 ] || continue
+    readlink "\$fd" | grep '^pipe:' >> "$work/fds.inherited"
+done
+readlink /proc/\$\$/fd/0 >> "$work/fds.stdin"
+sleep 0.2
+exec $(command -v gcc) "\$@"
+SH
+    chmod +x "$work/fds.bin/gcc"
+    : > "$work/fds.inherited"
+    : > "$work/fds.stdin"
+    # модули больше буфера канала, чтобы запись в gcc не успевала закончиться
+    awk -v dir="$work/fds.src" 'BEGIN {
+        for (i = 0; i < 8; i++) {
+            part = dir "/part_" i ".mk"
+            for (j = 0; j < 2000; j++) {
+                print "function part_" i "_" j "(var x) {\n    return x * " j " + " i ";\n}\n" > part
+            }
+            close(part)
+        }
+    }'
+    printf '#include <System>\n\nfunction main() {\n    return 0;\n}\n' > "$work/fds.src/main.mk"
+    ok=1
+    if ! PATH="$work/fds.bin:$PATH" "$mikac" --no-cache -O 0 -j 8 -o "$work/fds" \
+            "$work/fds.src/main.mk" "$work"/fds.src/part_*.mk < /dev/null > "$work/fds.build" 2>&1; then
+        fail parallel_fds "сборка не удалась"
+        sed 's/^/    /' "$work/fds.build"
+    elif [ "$(grep -c '^pipe:' "$work/fds.stdin")" -ne 9 ]; then
+        fail parallel_fds "не все модули собраны через канал на stdin"
+    elif grep -qxFf "$work/fds.stdin" "$work/fds.inherited"; then
+        fail parallel_fds "gcc унаследовал канал stdin другого модуля"
+    fi
+    count
+fi
+
+# Несовместимые флаги отвергаются, а не собираются молча другой библиотекой
+if selected fast_start_lto "$@"; then
+    ok=1
+    printf '#include <System>\n\nfunction main() {\n    return 0;\n}\n' > "$work/fast_start_lto.mk"
+    if "$mikac" --no-cache --lto --fast-start -o "$work/fast_start_lto" "$work/fast_start_lto.mk" \
+            > "$work/fast_start_lto.err" 2>&1; then
+        fail fast_start_lto "--lto --fast-start принято"
+    elif ! grep -q -- "--fast-start нельзя использовать с --lto" "$work/fast_start_lto.err"; then
+        fail fast_start_lto "нет сообщения о несовместимых флагах"
+        sed 's/^/    /' "$work/fast_start_lto.err"
+    fi
+    count
+fi
+
+echo "Пройдено: $passed, не пройдено: $failed"
+[ $failed -eq 0 ]
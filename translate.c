@@ -0,0 +1,99 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "translate.h"
+#include "arena.h"
+#include "parser.h"
+#include "lower.h"
+#include "codegen.h"
+#include "source.h"
+
+static void write_banner(Emitter* emitter, const char* input_name) {
+    char banner[1024];
+    int len = snprintf(banner, sizeof(banner),
+        "// ============================================================================\n"
+        "// Автоматически сгенерировано Mika Language Transpiler v%s\n"
+        "// Исходный файл: %s\n"
+        "// Время генерации: %s\n"
+        "// ВНИМАНИЕ: Этот файл создан автоматически, не редактируйте вручную!\n"
+        "// ============================================================================\n\n",
+        MIKA_VERSION, input_name, __TIME__);
+    if (len > (int)sizeof(banner) - 1) {
+        len = (int)sizeof(banner) - 1;
+    }
+    emitter_write(emitter, banner, (size_t)len);
+}
+
+int translate_buffer(const char* src, size_t len, const TranslateOptions* opts, FILE* output, TranslateStats* stats) {
+    Arena arena;
+    Parser parser;
+    LowerContext lower;
+    int status = 0;
+
+    arena_init(&arena, ARENA_DEFAULT_CHUNK);
+    parser_init(&parser, &arena, src, len, opts->input_name);
+    lower.filename = opts->input_name;
+    lower.arena = &arena;
+    lower.deps = opts->deps;
+    lower.errors = 0;
+    lower.names = NULL;
+    lower.name_count = 0;
+    lower.name_capacity = 0;
+    lower.global_names = 0;
+    lower.record_count = 0;
+    lower.parallel_count = 0;
+    lower.instrument = opts->instrument;
+    lower.program = opts->program;
+
+    Emitter* emitter = malloc(sizeof(Emitter));
+    if (!emitter) {
+        perror("Ошибка выделения памяти");
+        return -1;
+    }
+    emitter_init(emitter, output, opts->line_directives ? opts->input_name : NULL);
+
+    write_banner(emitter, opts->input_name);
+
+    ArenaMark start = arena_mark(&arena);
+    Node* item;
+    while ((item = parse_item(&parser, &status)) != NULL) {
+        if (lower_item(&lower, item) == 0) {
+            for (Node* helper = lower.hoisted; helper; helper = helper->next) {
+                emit_item(emitter, helper);
+            }
+            emit_item(emitter, item);
+        }
+        arena_reset(&arena, start);
+    }
+
+    if (emitter_flush(emitter) != 0 || ferror(output)) {
+        perror("Ошибка записи выходного файла");
+        status = -1;
+    }
+    if (lower.errors > 0) {
+        status = -1;
+    }
+
+    if (stats) {
+        stats->lines = parser.lexer.line;
+        stats->bytes = len;
+        stats->arena_bytes = arena.total_bytes;
+    }
+    free(emitter);
+    free(lower.names);
+    arena_free(&arena);
+    return status;
+}
+
+int translate_file(const char* path, const TranslateOptions* opts, FILE* output, TranslateStats* stats) {
+    SourceFile source;
+    if (source_open(&source, path) != 0) {
+        return -1;
+    }
+    int result = translate_buffer(source.data, source.len, opts, output, stats);
+    source_close(&source);
+    return result;
+}
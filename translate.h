@@ -0,0 +1,29 @@
+#ifndef MIKA_TRANSLATE_H
+#define MIKA_TRANSLATE_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+#include "callgraph.h"
+#include "deps.h"
+
+#define MIKA_VERSION "1.1.0"
+
+typedef struct {
+    const char* input_name;
+    DependencyList* deps;
+    int line_directives;
+    int instrument;
+    const CallGraph* program;
+} TranslateOptions;
+
+typedef struct {
+    int lines;
+    size_t bytes;
+    size_t arena_bytes;
+} TranslateStats;
+
+int translate_buffer(const char* src, size_t len, const TranslateOptions* opts, FILE* output, TranslateStats* stats);
+int translate_file(const char* path, const TranslateOptions* opts, FILE* output, TranslateStats* stats);
+
+#endif
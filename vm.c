@@ -0,0 +1,665 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "vm.h"
+#include "mika_std.h"
+
+/* Строки, срезы и построители лежат в регистрах побайтно как структуры
+   рантайма и передаются в mika_std.c через memcpy. */
+typedef char vm_string_fits[sizeof(MikaString) == 3 * sizeof(Slot) ? 1 : -1];
+typedef char vm_slice_fits[sizeof(MikaSlice) == 2 * sizeof(Slot) ? 1 : -1];
+typedef char vm_builder_fits[sizeof(MikaStringBuilder) == 2 * sizeof(Slot) ? 1 : -1];
+
+typedef struct {
+    const Instr* ip;
+    Slot* regs;
+    const Function* function;
+} Frame;
+
+typedef struct {
+    Program* program;
+    Slot* globals;
+    Slot* stack;
+    Slot* stack_end;
+    Frame* frames;
+} Vm;
+
+static MikaString load_string(const Slot* slots) {
+    MikaString string;
+    memcpy(&string, slots, sizeof(string));
+    return string;
+}
+
+static MikaSlice load_slice(const Slot* slots) {
+    MikaSlice slice;
+    memcpy(&slice, slots, sizeof(slice));
+    return slice;
+}
+
+static MikaStringBuilder load_builder(const Slot* slots) {
+    MikaStringBuilder builder;
+    memcpy(&builder, slots, sizeof(builder));
+    return builder;
+}
+
+#define STORE(slots, value) memcpy((slots), &(value), sizeof(value))
+
+static void stack_overflow(void) {
+    flush_output();
+    fprintf(stderr, "Mika: переполнение стека\n");
+    exit(1);
+}
+
+/* Аргументы читаются целиком до записи результата: регистр результата
+   может совпадать с первым аргументом. */
+static void call_native(int id, Slot* args, Slot* result) {
+    switch ((NativeId)id) {
+        case NATIVE_INPUT:
+            result->i = input();
+            break;
+        case NATIVE_POWER:
+            result->i = power((int)args[0].i, (int)args[1].i);
+            break;
+        case NATIVE_ABSOLUTE:
+            result->i = absolute((int)args[0].i);
+            break;
+        case NATIVE_FLUSH_OUTPUT:
+            flush_output();
+            break;
+        case NATIVE_ARRAY_CREATE:
+            result->p = array_create((int)args[0].i);
+            break;
+        case NATIVE_ARRAY_FREE:
+            array_free(args[0].p);
+            break;
+        case NATIVE_ARRAY_SIZE:
+            result->i = array_size(args[0].p, (int)args[1].i);
+            break;
+        case NATIVE_ARRAY_RESERVE: {
+            int* array = args[0].p;
+            array_reserve(&array, (int)args[1].i);
+            args[0].p = array;
+            break;
+        }
+        case NATIVE_ARRAY_SLICE: {
+            MikaSlice slice = array_slice(args[0].p, (int)args[1].i, (int)args[2].i);
+            STORE(result, slice);
+            break;
+        }
+        case NATIVE_SLICE_RANGE: {
+            MikaSlice slice = slice_range(load_slice(args), (int)args[2].i, (int)args[3].i);
+            STORE(result, slice);
+            break;
+        }
+        case NATIVE_ARRAY_SUM:
+            result->i = array_sum(load_slice(args));
+            break;
+        case NATIVE_ARRAY_MIN:
+            result->i = array_min(load_slice(args));
+            break;
+        case NATIVE_ARRAY_MAX:
+            result->i = array_max(load_slice(args));
+            break;
+        case NATIVE_ARRAY_FILL:
+            array_fill(load_slice(args), (int)args[2].i);
+            break;
+        case NATIVE_ARRAY_COPY:
+            array_copy(load_slice(args), load_slice(args + 2));
+            break;
+        case NATIVE_ARRAY_DOT:
+            result->i = array_dot(load_slice(args), load_slice(args + 2));
+            break;
+        case NATIVE_ARRAY_ADD:
+            array_add(load_slice(args), load_slice(args + 2), load_slice(args + 4));
+            break;
+        case NATIVE_ARRAY_SUB:
+            array_sub(load_slice(args), load_slice(args + 2), load_slice(args + 4));
+            break;
+        case NATIVE_ARRAY_MUL:
+            array_mul(load_slice(args), load_slice(args + 2), load_slice(args + 4));
+            break;
+        case NATIVE_ARRAY_SIMD_LEVEL:
+            result->s = array_simd_level();
+            break;
+        case NATIVE_THREAD_COUNT:
+            result->i = mika_thread_count();
+            break;
+        case NATIVE_ARENA_ENTER:
+            arena_enter();
+            break;
+        case NATIVE_ARENA_LEAVE:
+            arena_leave();
+            break;
+        case NATIVE_STRING_FROM: {
+            MikaString string = mika_string_from(args[0].s);
+            STORE(result, string);
+            break;
+        }
+        case NATIVE_SUBSTRING: {
+            MikaString string = mika_string_substring(load_string(args), (int)args[3].i, (int)args[4].i);
+            STORE(result, string);
+            break;
+        }
+        case NATIVE_STRING_COMPARE:
+            result->i = mika_string_compare(load_string(args), load_string(args + 3));
+            break;
+        case NATIVE_STRCMP:
+            result->i = strcmp(args[0].s, args[1].s);
+            break;
+        case NATIVE_STRLEN:
+            result->i = (int)strlen(args[0].s);
+            break;
+        case NATIVE_STRING_ASSIGN: {
+            MikaString target = load_string(args);
+            mika_string_assign(&target, load_string(args + 3));
+            STORE(args, target);
+            break;
+        }
+        case NATIVE_STRING_COPY: {
+            MikaString string = mika_string_copy(load_string(args));
+            STORE(result, string);
+            break;
+        }
+        case NATIVE_STRING_FREE: {
+            MikaString string = load_string(args);
+            mika_string_free(&string);
+            STORE(args, string);
+            break;
+        }
+        case NATIVE_BUILDER_APPEND: {
+            MikaStringBuilder builder = load_builder(args);
+            mika_builder_append(&builder, load_string(args + 2));
+            STORE(args, builder);
+            break;
+        }
+        case NATIVE_BUILDER_FINISH: {
+            MikaStringBuilder builder = load_builder(args);
+            MikaString string = mika_builder_finish(&builder);
+            STORE(args, builder);
+            STORE(result, string);
+            break;
+        }
+        case NATIVE_BUILDER_FREE: {
+            MikaStringBuilder builder = load_builder(args);
+            mika_builder_free(&builder);
+            STORE(args, builder);
+            break;
+        }
+        case NATIVE_INPUT_LINE: {
+            MikaString string = mika_input_line();
+            STORE(result, string);
+            break;
+        }
+        case NATIVE_ABS:
+            result->i = abs((int)args[0].i);
+            break;
+        case NATIVE_RAND:
+            result->i = rand();
+            break;
+        case NATIVE_SRAND:
+            srand((unsigned)args[0].i);
+            break;
+        case NATIVE_EXIT:
+            exit((int)args[0].i);
+        case NATIVE_SQRT:
+            result->d = sqrt(args[0].d);
+            break;
+        case NATIVE_POW:
+            result->d = pow(args[0].d, args[1].d);
+            break;
+        case NATIVE_SIN:
+            result->d = sin(args[0].d);
+            break;
+        case NATIVE_COS:
+            result->d = cos(args[0].d);
+            break;
+        case NATIVE_TAN:
+            result->d = tan(args[0].d);
+            break;
+        case NATIVE_ATAN:
+            result->d = atan(args[0].d);
+            break;
+        case NATIVE_ATAN2:
+            result->d = atan2(args[0].d, args[1].d);
+            break;
+        case NATIVE_EXP:
+            result->d = exp(args[0].d);
+            break;
+        case NATIVE_LOG:
+            result->d = log(args[0].d);
+            break;
+        case NATIVE_LOG10:
+            result->d = log10(args[0].d);
+            break;
+        case NATIVE_FLOOR:
+            result->d = floor(args[0].d);
+            break;
+        case NATIVE_CEIL:
+            result->d = ceil(args[0].d);
+            break;
+        case NATIVE_FABS:
+            result->d = fabs(args[0].d);
+            break;
+        case NATIVE_FMOD:
+            result->d = fmod(args[0].d, args[1].d);
+            break;
+        case NATIVE_COUNT:
+            break;
+    }
+}
+
+/* Каждая часть формата печатается отдельным вызовом mika_print с
+   аргументом его настоящего типа C; ширина и точность через * идут
+   перед ним, как в обычном printf. */
+#define PRINT_PART(value) \
+    (part->stars == 0 ? mika_print(part->text, value) : \
+     part->stars == 1 ? mika_print(part->text, widths[0], value) : \
+     mika_print(part->text, widths[0], widths[1], value))
+
+static int print_part(const PrintPart* part, const Slot* args) {
+    int widths[2] = {0, 0};
+    for (int i = 0; i < part->stars && i < 2; i++) {
+        widths[i] = (int)args[part->star_args[i]].i;
+    }
+    const Slot* arg = args + (part->arg >= 0 ? part->arg : 0);
+
+    switch (part->type) {
+        case TYPE_INT:
+            return PRINT_PART((int)arg->i);
+        case TYPE_LONG:
+            return PRINT_PART((long long)arg->i);
+        case TYPE_DOUBLE:
+            return PRINT_PART(arg->d);
+        case TYPE_ARRAY:
+            return PRINT_PART(arg->p);
+        case TYPE_CSTRING:
+            return PRINT_PART(arg->s);
+        case TYPE_STRING:
+            return PRINT_PART(load_string(arg));
+        default:
+            return mika_print(part->text);
+    }
+}
+
+static int print_format(const PrintFormat* format, const Slot* args) {
+    int total = 0;
+    for (int i = 0; i < format->count; i++) {
+        total += print_part(&format->parts[i], args);
+    }
+    return total;
+}
+
+static void free_arrays(const Function* fn, Slot* regs) {
+    for (int i = 0; i < fn->array_count; i++) {
+        array_free(regs[fn->array_base + i].p);
+    }
+}
+
+/* Прямой шитый код: поле op каждой инструкции один раз заменяется
+   смещением метки её обработчика, и переход к следующей инструкции —
+   один косвенный jmp без таблицы и проверки границ. */
+static void execute(Vm* vm, int function, Slot* result) {
+#define LABEL_OFFSET(name) (int)((char*)&&op_##name - (char*)&&op_MOVE),
+    static const int offsets[] = { OPCODES(LABEL_OFFSET) };
+#undef LABEL_OFFSET
+#define DISPATCH() goto *(void*)((char*)&&op_MOVE + ip->op)
+#define NEXT() do { ip++; DISPATCH(); } while (0)
+#define R(n) regs[ip->n]
+
+    Program* program = vm->program;
+    const Slot* constants = program->constants;
+    Slot* globals = vm->globals;
+    Frame* frames = vm->frames;
+    int depth = 0;
+
+    if (!program->threaded) {
+        for (int f = 0; f < program->function_count; f++) {
+            Function* fn = &program->functions[f];
+            for (int i = 0; i < fn->code_len; i++) {
+                fn->code[i].op = offsets[fn->code[i].op];
+            }
+        }
+        program->threaded = 1;
+    }
+
+    const Function* fn = &program->functions[function];
+    Slot* regs = vm->stack;
+    const Instr* ip = fn->code;
+    if (regs + fn->nregs > vm->stack_end) {
+        stack_overflow();
+    }
+    memset(regs + fn->array_base, 0, sizeof(Slot) * (size_t)fn->array_count);
+    DISPATCH();
+
+op_MOVE:
+    R(a) = R(b);
+    NEXT();
+op_COPY:
+    memmove(&R(a), &R(b), sizeof(Slot) * (size_t)ip->c);
+    NEXT();
+op_LOADI:
+    R(a).i = ip->b;
+    NEXT();
+op_LOADK:
+    R(a) = constants[ip->b];
+    NEXT();
+op_GETG:
+    memcpy(&R(a), globals + ip->b, sizeof(Slot) * (size_t)ip->c);
+    NEXT();
+op_SETG:
+    memcpy(globals + ip->a, &R(b), sizeof(Slot) * (size_t)ip->c);
+    NEXT();
+
+op_ADD:
+    R(a).i = (int32_t)(R(b).i + R(c).i);
+    NEXT();
+op_SUB:
+    R(a).i = (int32_t)(R(b).i - R(c).i);
+    NEXT();
+op_MUL:
+    R(a).i = (int32_t)(R(b).i * R(c).i);
+    NEXT();
+op_DIV:
+    R(a).i = (int32_t)R(b).i / (int32_t)R(c).i;
+    NEXT();
+op_MOD:
+    R(a).i = (int32_t)R(b).i % (int32_t)R(c).i;
+    NEXT();
+op_ADDK:
+    R(a).i = (int32_t)(R(b).i + ip->c);
+    NEXT();
+op_LADD:
+    R(a).i = (int64_t)((uint64_t)R(b).i + (uint64_t)R(c).i);
+    NEXT();
+op_LSUB:
+    R(a).i = (int64_t)((uint64_t)R(b).i - (uint64_t)R(c).i);
+    NEXT();
+op_LMUL:
+    R(a).i = (int64_t)((uint64_t)R(b).i * (uint64_t)R(c).i);
+    NEXT();
+op_LDIV:
+    R(a).i = R(b).i / R(c).i;
+    NEXT();
+op_LMOD:
+    R(a).i = R(b).i % R(c).i;
+    NEXT();
+op_DADD:
+    R(a).d = R(b).d + R(c).d;
+    NEXT();
+op_DSUB:
+    R(a).d = R(b).d - R(c).d;
+    NEXT();
+op_DMUL:
+    R(a).d = R(b).d * R(c).d;
+    NEXT();
+op_DDIV:
+    R(a).d = R(b).d / R(c).d;
+    NEXT();
+
+op_AND:
+    R(a).i = R(b).i & R(c).i;
+    NEXT();
+op_OR:
+    R(a).i = R(b).i | R(c).i;
+    NEXT();
+op_XOR:
+    R(a).i = R(b).i ^ R(c).i;
+    NEXT();
+op_SHL:
+    R(a).i = (int32_t)((uint32_t)R(b).i << (R(c).i & 31));
+    NEXT();
+op_SHR:
+    R(a).i = (int32_t)R(b).i >> (R(c).i & 31);
+    NEXT();
+op_LSHL:
+    R(a).i = (int64_t)((uint64_t)R(b).i << (R(c).i & 63));
+    NEXT();
+op_LSHR:
+    R(a).i = R(b).i >> (R(c).i & 63);
+    NEXT();
+op_NEG:
+    R(a).i = (int32_t)(0u - (uint32_t)R(b).i);
+    NEXT();
+op_LNEG:
+    R(a).i = (int64_t)(0u - (uint64_t)R(b).i);
+    NEXT();
+op_DNEG:
+    R(a).d = -R(b).d;
+    NEXT();
+op_NOT:
+    R(a).i = ~R(b).i;
+    NEXT();
+op_LNOT:
+    R(a).i = R(b).i == 0;
+    NEXT();
+
+op_EQ:
+    R(a).i = R(b).i == R(c).i;
+    NEXT();
+op_NE:
+    R(a).i = R(b).i != R(c).i;
+    NEXT();
+op_LT:
+    R(a).i = R(b).i < R(c).i;
+    NEXT();
+op_LE:
+    R(a).i = R(b).i <= R(c).i;
+    NEXT();
+op_DEQ:
+    R(a).i = R(b).d == R(c).d;
+    NEXT();
+op_DNE:
+    R(a).i = R(b).d != R(c).d;
+    NEXT();
+op_DLT:
+    R(a).i = R(b).d < R(c).d;
+    NEXT();
+op_DLE:
+    R(a).i = R(b).d <= R(c).d;
+    NEXT();
+
+op_TRUNC:
+    R(a).i = (int32_t)R(b).i;
+    NEXT();
+op_I2D:
+    R(a).d = (double)R(b).i;
+    NEXT();
+op_D2I:
+    R(a).i = (int32_t)R(b).d;
+    NEXT();
+op_D2L:
+    R(a).i = (int64_t)R(b).d;
+    NEXT();
+op_I2C:
+    R(a).i = (int8_t)R(b).i;
+    NEXT();
+op_I2S:
+    R(a).i = (int16_t)R(b).i;
+    NEXT();
+op_I2B:
+    R(a).i = R(b).i != 0;
+    NEXT();
+op_D2B:
+    R(a).i = R(b).d != 0.0;
+    NEXT();
+op_I2F:
+    R(a).d = (float)R(b).i;
+    NEXT();
+op_D2F:
+    R(a).d = (float)R(b).d;
+    NEXT();
+
+op_JUMP:
+    ip += ip->b;
+    DISPATCH();
+op_JZ:
+    ip += R(a).i == 0 ? ip->b : 1;
+    DISPATCH();
+op_JNZ:
+    ip += R(a).i != 0 ? ip->b : 1;
+    DISPATCH();
+op_JEQ:
+    ip += R(a).i == R(b).i ? ip->c : 1;
+    DISPATCH();
+op_JNE:
+    ip += R(a).i != R(b).i ? ip->c : 1;
+    DISPATCH();
+op_JLT:
+    ip += R(a).i < R(b).i ? ip->c : 1;
+    DISPATCH();
+op_JLE:
+    ip += R(a).i <= R(b).i ? ip->c : 1;
+    DISPATCH();
+op_JEQK:
+    ip += R(a).i == ip->b ? ip->c : 1;
+    DISPATCH();
+op_JNEK:
+    ip += R(a).i != ip->b ? ip->c : 1;
+    DISPATCH();
+op_JLTK:
+    ip += R(a).i < ip->b ? ip->c : 1;
+    DISPATCH();
+op_JLEK:
+    ip += R(a).i <= ip->b ? ip->c : 1;
+    DISPATCH();
+op_JGTK:
+    ip += R(a).i > ip->b ? ip->c : 1;
+    DISPATCH();
+op_JGEK:
+    ip += R(a).i >= ip->b ? ip->c : 1;
+    DISPATCH();
+
+op_LOADX:
+    R(a).i = ((int*)R(b).p)[R(c).i];
+    NEXT();
+op_STOREX:
+    ((int*)R(a).p)[R(b).i] = (int)R(c).i;
+    NEXT();
+op_LEN:
+    R(a).i = array_length(R(b).p);
+    NEXT();
+op_PUSH: {
+    int* array = R(a).p;
+    array_push(&array, (int)R(b).i);
+    R(a).p = array;
+    NEXT();
+}
+op_POP:
+    R(a).i = array_pop(R(b).p);
+    NEXT();
+op_NEWARRAY: {
+    /* c — регистр-владелец локального массива: при повторном входе в
+       объявление прежний массив освобождается, как кадр стека в C */
+    int size = (int)R(b).i;
+    if (ip->c >= 0) {
+        array_free(R(c).p);
+    }
+    int* array = array_create(size);
+    if (array && size > 0) {
+        memset(array, 0, sizeof(int) * (size_t)size);
+    }
+    R(a).p = array;
+    if (ip->c >= 0) {
+        R(c).p = array;
+    }
+    NEXT();
+}
+op_VIEW: {
+    MikaSlice slice = array_view(R(b).p);
+    STORE(&R(a), slice);
+    NEXT();
+}
+op_FIELD:
+    switch (ip->c) {
+        case FIELD_STRING_LENGTH:
+            R(a).i = load_string(&R(b)).length;
+            break;
+        case FIELD_SLICE_LENGTH:
+            R(a).i = load_slice(&R(b)).length;
+            break;
+        default:
+            R(a).i = load_builder(&R(b)).length;
+            break;
+    }
+    NEXT();
+op_STRLIT: {
+    MikaString string = mika_string_literal(constants[ip->b].s, ip->c);
+    STORE(&R(a), string);
+    NEXT();
+}
+
+op_CALL: {
+    const Function* callee = &program->functions[ip->b];
+    Slot* base = regs + ip->c;
+    if (depth == VM_MAX_FRAMES || base + callee->nregs > vm->stack_end) {
+        stack_overflow();
+    }
+    frames[depth].ip = ip;
+    frames[depth].regs = regs;
+    frames[depth].function = fn;
+    depth++;
+    fn = callee;
+    regs = base;
+    memset(regs + fn->array_base, 0, sizeof(Slot) * (size_t)fn->array_count);
+    ip = fn->code;
+    DISPATCH();
+}
+op_NATIVE:
+    call_native(ip->b, &R(c), &R(a));
+    NEXT();
+op_PRINT:
+    R(a).i = print_format(&program->formats[ip->b], &R(c));
+    NEXT();
+op_RET: {
+    Slot value[3];
+    int slots = ip->b;
+    memcpy(value, &R(a), sizeof(Slot) * (size_t)slots);
+    free_arrays(fn, regs);
+    if (depth == 0) {
+        memcpy(result, value, sizeof(Slot) * (size_t)slots);
+        return;
+    }
+    depth--;
+    ip = frames[depth].ip;
+    regs = frames[depth].regs;
+    fn = frames[depth].function;
+    memcpy(&R(a), value, sizeof(Slot) * (size_t)slots);
+    NEXT();
+}
+
+#undef R
+#undef NEXT
+#undef DISPATCH
+}
+
+int vm_run(Program* program) {
+    Vm vm;
+    Slot result;
+    int status = 1;
+
+    vm.program = program;
+    vm.globals = calloc((size_t)program->global_slots + 1, sizeof(Slot));
+    vm.stack = calloc(VM_STACK_SLOTS, sizeof(Slot));
+    vm.frames = malloc(sizeof(Frame) * VM_MAX_FRAMES);
+    if (!vm.globals || !vm.stack || !vm.frames) {
+        perror("Ошибка выделения памяти");
+        goto done;
+    }
+    vm.stack_end = vm.stack + VM_STACK_SLOTS;
+
+    if (program->arena_mode) {
+        mika_arena_enable();
+    }
+    result.i = 0;
+    execute(&vm, program->init, &result);
+    execute(&vm, program->main, &result);
+    status = (int)result.i;
+
+done:
+    free(vm.globals);
+    free(vm.stack);
+    free(vm.frames);
+    return status;
+}
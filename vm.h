@@ -0,0 +1,13 @@
+#ifndef MIKA_VM_H
+#define MIKA_VM_H
+
+#include "bytecode.h"
+
+#define VM_STACK_SLOTS (1 << 22)
+#define VM_MAX_FRAMES (1 << 18)
+
+/* Выполняет инициализаторы глобальных переменных и main; возвращает
+   значение main как код выхода программы. */
+int vm_run(Program* program);
+
+#endif
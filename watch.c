@@ -0,0 +1,222 @@
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+
+#include "watch.h"
+#include "deps.h"
+#include "telemetry.h"
+
+/* Редактор часто сохраняет файл в несколько приёмов (запись во временный
+   файл, переименование, смена прав), поэтому после первого события ждём,
+   пока каталог успокоится, и собираем один раз. */
+#define WATCH_SETTLE_MS 80
+#define WATCH_EVENTS (IN_CLOSE_WRITE | IN_MOVED_TO | IN_ATTRIB)
+
+typedef struct {
+    int wd;
+    char* name;
+} WatchedFile;
+
+typedef struct {
+    int fd;
+    WatchedFile* files;
+    int count;
+    int capacity;
+} Watcher;
+
+static volatile sig_atomic_t watch_stop = 0;
+
+static void on_stop_signal(int sig) {
+    (void)sig;
+    watch_stop = 1;
+}
+
+static void watcher_clear(Watcher* watcher) {
+    for (int i = 0; i < watcher->count; i++) {
+        free(watcher->files[i].name);
+    }
+    watcher->count = 0;
+}
+
+/* inotify следит за каталогами: для одного каталога ядро возвращает тот
+   же wd, а файл узнаём по имени в событии. */
+static int watcher_add(Watcher* watcher, const char* path) {
+    const char* slash = strrchr(path, '/');
+    char dir[4096];
+    const char* name = slash ? slash + 1 : path;
+
+    if (slash == path) {
+        snprintf(dir, sizeof(dir), "/");
+    } else if (slash) {
+        snprintf(dir, sizeof(dir), "%.*s", (int)(slash - path), path);
+    } else {
+        snprintf(dir, sizeof(dir), ".");
+    }
+
+    int wd = inotify_add_watch(watcher->fd, dir, WATCH_EVENTS);
+    if (wd < 0) {
+        fprintf(stderr, "❌ Не удалось следить за каталогом %s: %s\n", dir, strerror(errno));
+        return -1;
+    }
+    for (int i = 0; i < watcher->count; i++) {
+        if (watcher->files[i].wd == wd && strcmp(watcher->files[i].name, name) == 0) {
+            return 0;
+        }
+    }
+
+    if (watcher->count == watcher->capacity) {
+        int capacity = watcher->capacity ? watcher->capacity * 2 : 16;
+        WatchedFile* grown = realloc(watcher->files, (size_t)capacity * sizeof(WatchedFile));
+        if (!grown) {
+            return -1;
+        }
+        watcher->files = grown;
+        watcher->capacity = capacity;
+    }
+    watcher->files[watcher->count].wd = wd;
+    watcher->files[watcher->count].name = strdup(name);
+    if (!watcher->files[watcher->count].name) {
+        return -1;
+    }
+    watcher->count++;
+    return 0;
+}
+
+/* Список файлов пересобирается после каждой сборки: #include мог
+   появиться или исчезнуть. */
+static int watcher_refresh(Watcher* watcher, const CompileContext* ctx) {
+    DependencyList deps;
+    int result = 0;
+
+    watcher_clear(watcher);
+    deps_init(&deps);
+    for (int i = 0; i < ctx->input_count; i++) {
+        deps_add(&deps, ctx->input_files[i]);
+        deps_scan_file(&deps, ctx->input_files[i]);
+    }
+    for (int i = 0; i < deps.count && result == 0; i++) {
+        result = watcher_add(watcher, deps.paths[i]);
+    }
+    deps_free(&deps);
+    return result;
+}
+
+/* Вычитывает накопившиеся события; возвращает имя первого изменённого
+   файла из списка или NULL. */
+static const char* watcher_drain(Watcher* watcher, char* changed, size_t size) {
+    char buffer[16 * 1024] __attribute__((aligned(__alignof__(struct inotify_event))));
+    const char* result = NULL;
+
+    for (;;) {
+        ssize_t len = read(watcher->fd, buffer, sizeof(buffer));
+        if (len <= 0) {
+            break;
+        }
+        for (char* p = buffer; p < buffer + len;) {
+            const struct inotify_event* event = (const struct inotify_event*)p;
+            p += sizeof(struct inotify_event) + event->len;
+            if (event->len == 0 || result) {
+                continue;
+            }
+            for (int i = 0; i < watcher->count; i++) {
+                if (watcher->files[i].wd == event->wd && strcmp(watcher->files[i].name, event->name) == 0) {
+                    snprintf(changed, size, "%s", event->name);
+                    result = changed;
+                    break;
+                }
+            }
+        }
+    }
+    return result;
+}
+
+/* ждёт изменения одного из файлов; 0 — есть изменение, -1 — остановка */
+static int watcher_wait(Watcher* watcher, char* changed, size_t size) {
+    struct pollfd pfd = {watcher->fd, POLLIN, 0};
+
+    while (!watch_stop) {
+        int ready = poll(&pfd, 1, -1);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            perror("❌ Ошибка ожидания изменений");
+            return -1;
+        }
+        if (!watcher_drain(watcher, changed, size)) {
+            continue;
+        }
+        while (!watch_stop && poll(&pfd, 1, WATCH_SETTLE_MS) > 0) {
+            char more[256];
+            watcher_drain(watcher, more, sizeof(more));
+        }
+        return watch_stop ? -1 : 0;
+    }
+    return -1;
+}
+
+int watch_project(CompileContext* ctx, WatchBuild build) {
+    Watcher watcher;
+    struct sigaction action;
+    struct sigaction old_int;
+    struct sigaction old_term;
+    char changed[256];
+    int result = 1;
+
+    memset(&watcher, 0, sizeof(watcher));
+    watcher.fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (watcher.fd < 0) {
+        perror("❌ inotify недоступен");
+        return 1;
+    }
+
+    /* poll прерывается сигналом и с SA_RESTART, а ожидание gcc внутри
+       сборки — нет: Ctrl+C дожидается конца текущего шага. */
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = on_stop_signal;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, &old_int);
+    sigaction(SIGTERM, &action, &old_term);
+
+    for (;;) {
+        double start = telemetry_now();
+        result = build(ctx);
+        double elapsed = telemetry_now() - start;
+        if (watch_stop) {
+            break;
+        }
+        if (result == 0) {
+            printf("✅ Готово за %.0f мс\n", elapsed * 1000.0);
+        } else {
+            printf("❌ Сборка не удалась (%.0f мс)\n", elapsed * 1000.0);
+        }
+
+        if (watcher_refresh(&watcher, ctx) != 0) {
+            result = 1;
+            break;
+        }
+        printf("👀 Ждём изменений в %d файл(ах)... (Ctrl+C — выход)\n", watcher.count);
+        fflush(stdout);
+
+        if (watcher_wait(&watcher, changed, sizeof(changed)) != 0) {
+            break;
+        }
+        printf("🔄 Изменён %s, пересобираем\n", changed);
+        fflush(stdout);
+    }
+
+    printf("\n👋 Наблюдение остановлено\n");
+    sigaction(SIGINT, &old_int, NULL);
+    sigaction(SIGTERM, &old_term, NULL);
+    watcher_clear(&watcher);
+    free(watcher.files);
+    close(watcher.fd);
+    return result;
+}
@@ -0,0 +1,13 @@
+#ifndef MIKA_WATCH_H
+#define MIKA_WATCH_H
+
+#include "build.h"
+
+typedef int (*WatchBuild)(CompileContext* ctx);
+
+/* Собирает проект и пересобирает его после каждого сохранения входных
+   файлов или подключаемых через #include. Возвращает код последней
+   сборки, когда наблюдение прервано сигналом. */
+int watch_project(CompileContext* ctx, WatchBuild build);
+
+#endif